@@ -0,0 +1,208 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+namespace rlx_money {
+
+/// @brief 异步操作在开始执行前被取消时，get() / co_await 抛出的异常
+class AsyncCancelledError : public std::runtime_error {
+public:
+    AsyncCancelledError() : std::runtime_error("异步操作已取消") {}
+};
+
+/// @brief 异步操作状态
+enum class AsyncStatus {
+    Pending,   // 排队中
+    Running,   // 正在执行
+    Completed, // 已完成（成功或抛出异常）
+    Cancelled  // 已取消
+};
+
+namespace detail {
+
+/// @brief 协程恢复调度函数：把恢复动作投递到游戏线程
+using ResumeDispatcher = void (*)(std::coroutine_handle<>);
+
+/// @brief 异步操作共享状态（由执行线程写入结果，由句柄读取）
+template <typename T>
+class AsyncState {
+public:
+    explicit AsyncState(ResumeDispatcher dispatcher) : mDispatcher(dispatcher) {}
+
+    /// @brief 执行线程开始执行前调用
+    /// @return false 表示已被取消，不应再执行
+    bool tryStart() {
+        std::lock_guard lock(mMutex);
+        if (mStatus != AsyncStatus::Pending) {
+            return false;
+        }
+        mStatus = AsyncStatus::Running;
+        return true;
+    }
+
+    /// @brief 取消尚未开始执行的操作
+    /// @return 是否取消成功
+    bool cancel() {
+        std::coroutine_handle<> continuation;
+        {
+            std::lock_guard lock(mMutex);
+            if (mStatus != AsyncStatus::Pending) {
+                return false;
+            }
+            mStatus      = AsyncStatus::Cancelled;
+            continuation = std::exchange(mContinuation, nullptr);
+        }
+        finish(continuation);
+        return true;
+    }
+
+    /// @brief 写入结果
+    template <typename... Args>
+    void setValue(Args&&... args) {
+        std::coroutine_handle<> continuation;
+        {
+            std::lock_guard lock(mMutex);
+            mValue.emplace(std::forward<Args>(args)...);
+            mStatus      = AsyncStatus::Completed;
+            continuation = std::exchange(mContinuation, nullptr);
+        }
+        finish(continuation);
+    }
+
+    /// @brief 写入异常
+    void setException(std::exception_ptr error) {
+        std::coroutine_handle<> continuation;
+        {
+            std::lock_guard lock(mMutex);
+            mError       = std::move(error);
+            mStatus      = AsyncStatus::Completed;
+            continuation = std::exchange(mContinuation, nullptr);
+        }
+        finish(continuation);
+    }
+
+    [[nodiscard]] AsyncStatus status() const {
+        std::lock_guard lock(mMutex);
+        return mStatus;
+    }
+
+    [[nodiscard]] bool isDone() const {
+        auto current = status();
+        return current == AsyncStatus::Completed || current == AsyncStatus::Cancelled;
+    }
+
+    void wait() const {
+        std::unique_lock lock(mMutex);
+        mDone.wait(lock, [this] { return mStatus == AsyncStatus::Completed || mStatus == AsyncStatus::Cancelled; });
+    }
+
+    template <typename Rep, typename Period>
+    bool waitFor(const std::chrono::duration<Rep, Period>& timeout) const {
+        std::unique_lock lock(mMutex);
+        return mDone.wait_for(lock, timeout, [this] {
+            return mStatus == AsyncStatus::Completed || mStatus == AsyncStatus::Cancelled;
+        });
+    }
+
+    /// @brief 注册完成后要恢复的协程
+    /// @return false 表示操作已完成，调用方不应挂起
+    bool setContinuation(std::coroutine_handle<> continuation) {
+        std::lock_guard lock(mMutex);
+        if (mStatus == AsyncStatus::Completed || mStatus == AsyncStatus::Cancelled) {
+            return false;
+        }
+        mContinuation = continuation;
+        return true;
+    }
+
+    /// @brief 取出结果（完成后调用）
+    T take() {
+        std::lock_guard lock(mMutex);
+        if (mStatus == AsyncStatus::Cancelled) {
+            throw AsyncCancelledError();
+        }
+        if (mError) {
+            std::rethrow_exception(mError);
+        }
+        return std::move(*mValue);
+    }
+
+private:
+    void finish(std::coroutine_handle<> continuation) {
+        mDone.notify_all();
+        if (continuation) {
+            mDispatcher(continuation);
+        }
+    }
+
+    mutable std::mutex              mMutex;
+    mutable std::condition_variable mDone;
+    AsyncStatus                     mStatus = AsyncStatus::Pending;
+    std::optional<T>                mValue;
+    std::exception_ptr              mError;
+    std::coroutine_handle<>         mContinuation;
+    ResumeDispatcher                mDispatcher;
+};
+
+} // namespace detail
+
+/// @brief 异步操作句柄
+/// @note 既可以像 std::future 一样 wait() / get()，也可以在协程中 co_await；
+///       co_await 挂起的协程在操作完成后于游戏线程恢复（由插件每 tick 调度）。
+///       get() 与 co_await 只能调用一次
+template <typename T>
+class AsyncResult {
+public:
+    AsyncResult() = default;
+    explicit AsyncResult(std::shared_ptr<detail::AsyncState<T>> state) : mState(std::move(state)) {}
+
+    /// @brief 句柄是否关联了异步操作
+    [[nodiscard]] bool valid() const { return mState != nullptr; }
+
+    /// @brief 获取操作状态
+    [[nodiscard]] AsyncStatus status() const { return mState->status(); }
+
+    /// @brief 操作是否已结束（完成或取消）
+    [[nodiscard]] bool isReady() const { return mState->isDone(); }
+
+    /// @brief 阻塞等待操作结束
+    void wait() const { mState->wait(); }
+
+    /// @brief 在超时时间内等待操作结束
+    /// @param timeout 超时时间
+    /// @return 操作是否已结束
+    template <typename Rep, typename Period>
+    bool waitFor(const std::chrono::duration<Rep, Period>& timeout) const {
+        return mState->waitFor(timeout);
+    }
+
+    /// @brief 阻塞等待并获取结果
+    /// @return 操作结果
+    /// @throw AsyncCancelledError 操作已取消时；操作自身抛出的异常会原样重新抛出
+    T get() {
+        mState->wait();
+        return mState->take();
+    }
+
+    /// @brief 取消尚未开始执行的操作
+    /// @return 是否取消成功（已开始或已完成的操作无法取消）
+    bool cancel() { return mState->cancel(); }
+
+    // 协程等待接口
+    [[nodiscard]] bool await_ready() const { return mState->isDone(); }
+    bool               await_suspend(std::coroutine_handle<> handle) { return mState->setContinuation(handle); }
+    T                  await_resume() { return mState->take(); }
+
+private:
+    std::shared_ptr<detail::AsyncState<T>> mState;
+};
+
+} // namespace rlx_money
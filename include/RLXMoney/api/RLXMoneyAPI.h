@@ -1,7 +1,10 @@
 #pragma once
 
+#include <RLXMoney/api/AsyncResult.h>
 #include <RLXMoney/data/DataStructures.h>
+#include <cstdint>
 #include <optional>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -84,6 +87,18 @@ class RLXMONEY_API RLXMoneyAPI {
         const std::string& description = ""
     );
 
+    /// @brief 批量执行余额操作（适用于批量发放工资、奖励等场景）
+    /// @param ops 操作列表
+    /// @return 与 ops 一一对应的执行结果
+    /// @note 所有条目先统一校验，再在同一个事务中执行；单个条目失败不影响其他条目
+    static std::vector<MoneyOpResult> applyBatch(std::span<const MoneyOp> ops);
+
+    /// @brief 以单个原子事务执行多个余额操作（适用于商店结算等需要同时成功的多笔扣款/入账）
+    /// @param legs 操作条目（可跨玩家、跨币种），按顺序执行
+    /// @return 执行结果，success 为 false 时没有任何条目生效，failedLeg 指出失败的条目
+    /// @note 通常通过 TxBuilder 构造条目；不支持写后模式币种
+    static MoneyTxResult applyAtomic(std::span<const MoneyOp> legs);
+
     /// @brief 检查余额是否充足
     /// @param xuid 玩家XUID
     /// @param currencyId 币种ID
@@ -97,6 +112,29 @@ class RLXMONEY_API RLXMoneyAPI {
     /// @return 财富排行榜
     [[nodiscard]] static std::vector<TopBalanceEntry> getTopBalanceList(const std::string& currencyId, int limit);
 
+    /// @brief 按名次分页获取财富排行榜
+    /// @param currencyId 币种ID
+    /// @param offset 跳过的名次数量（0 表示从第一名开始）
+    /// @param limit 返回数量限制（1-1000）
+    /// @return 财富排行榜
+    [[nodiscard]] static std::vector<TopBalanceEntry>
+    getTopBalanceRange(const std::string& currencyId, int offset, int limit);
+
+    /// @brief 获取玩家财富排名
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @return 排名（从 1 开始），玩家没有该币种余额时返回 std::nullopt
+    /// @note 排名由内存排行榜提供，适合频繁查询（如为每个在线玩家刷新侧边栏）
+    [[nodiscard]] static std::optional<int> getPlayerRank(const std::string& xuid, const std::string& currencyId);
+
+    /// @brief 获取玩家名次前后的一段排行榜
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @param radius 玩家前后各返回的条目数量（0-500）
+    /// @return 财富排行榜（包含玩家本人）
+    [[nodiscard]] static std::vector<TopBalanceEntry>
+    getRankNeighbors(const std::string& xuid, const std::string& currencyId, int radius);
+
     /// @brief 获取玩家交易历史
     /// @param xuid 玩家XUID
     /// @param currencyId 币种ID（可选，为空则查询所有币种）
@@ -106,6 +144,20 @@ class RLXMONEY_API RLXMoneyAPI {
     [[nodiscard]] static std::vector<TransactionRecord>
     getPlayerTransactions(const std::string& xuid, const std::string& currencyId = "", int page = 1, int pageSize = 10);
 
+    /// @brief 按游标分页获取玩家交易历史
+    /// @param xuid 玩家XUID
+    /// @param filter 查询条件（币种、交易类型、时间范围，均可为空）
+    /// @param cursor 上一页返回的 nextCursor（为空表示第一页）
+    /// @param pageSize 每页大小（1-1000）
+    /// @return 本页交易记录与下一页游标
+    /// @note 游标是不透明字符串，只能原样传回；翻到任意深度每页的查询代价相同，适合浏览大量交易记录
+    [[nodiscard]] static TransactionPage getPlayerTransactionsPage(
+        const std::string&       xuid,
+        const TransactionFilter& filter   = {},
+        const std::string&       cursor   = "",
+        int                      pageSize = 10
+    );
+
     /// @brief 获取玩家交易记录总数
     /// @param xuid 玩家XUID
     /// @return 记录总数
@@ -114,7 +166,7 @@ class RLXMONEY_API RLXMoneyAPI {
     /// @brief 获取服务器总财富（按币种）
     /// @param currencyId 币种ID
     /// @return 总财富
-    [[nodiscard]] static int getTotalWealth(const std::string& currencyId);
+    [[nodiscard]] static int64_t getTotalWealth(const std::string& currencyId);
 
     /// @brief 获取玩家总数
     /// @return 玩家总数
@@ -133,6 +185,126 @@ class RLXMONEY_API RLXMoneyAPI {
     /// @return 默认币种ID
     [[nodiscard]] static std::string getDefaultCurrencyId();
 
+    // ------------------------------------------------------------------------
+    // 异步 API：在后台线程执行，返回可 wait()/get() 或 co_await 的句柄。
+    // 同一玩家的异步操作按提交顺序执行（先提交的异步写入对之后的异步读取可见）；
+    // co_await 挂起的协程在操作完成后于游戏线程恢复。
+    // ------------------------------------------------------------------------
+
+    /// @brief 异步获取玩家余额
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @return 玩家余额句柄
+    [[nodiscard]] static AsyncResult<std::optional<int>>
+    getBalanceAsync(const std::string& xuid, const std::string& currencyId);
+
+    /// @brief 异步获取玩家所有币种余额
+    /// @param xuid 玩家XUID
+    /// @return 玩家余额列表句柄
+    [[nodiscard]] static AsyncResult<std::vector<PlayerBalance>> getAllBalancesAsync(const std::string& xuid);
+
+    /// @brief 异步设置玩家余额
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @param amount 新余额
+    /// @param description 操作描述
+    /// @return 是否操作成功的句柄
+    static AsyncResult<bool> setBalanceAsync(
+        const std::string& xuid,
+        const std::string& currencyId,
+        int                amount,
+        const std::string& description = ""
+    );
+
+    /// @brief 异步增加玩家金钱
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @param amount 增加金额
+    /// @param description 操作描述
+    /// @return 是否操作成功的句柄
+    static AsyncResult<bool> addMoneyAsync(
+        const std::string& xuid,
+        const std::string& currencyId,
+        int                amount,
+        const std::string& description = ""
+    );
+
+    /// @brief 异步扣除玩家金钱
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @param amount 扣除金额
+    /// @param description 操作描述
+    /// @return 是否操作成功的句柄
+    static AsyncResult<bool> reduceMoneyAsync(
+        const std::string& xuid,
+        const std::string& currencyId,
+        int                amount,
+        const std::string& description = ""
+    );
+
+    /// @brief 异步玩家间转账（同币种）
+    /// @param fromXuid 转出玩家XUID
+    /// @param toXuid 转入玩家XUID
+    /// @param currencyId 币种ID
+    /// @param amount 转账金额
+    /// @param description 转账描述
+    /// @return 是否转账成功的句柄
+    static AsyncResult<bool> transferMoneyAsync(
+        const std::string& fromXuid,
+        const std::string& toXuid,
+        const std::string& currencyId,
+        int                amount,
+        const std::string& description = ""
+    );
+
+    /// @brief 异步批量执行余额操作
+    /// @param ops 操作列表（按值传入，调用返回后即可释放原列表）
+    /// @return 逐条执行结果句柄
+    static AsyncResult<std::vector<MoneyOpResult>> applyBatchAsync(std::vector<MoneyOp> ops);
+
+    /// @brief 异步以单个原子事务执行多个余额操作
+    /// @param legs 操作条目（按值传入，调用返回后即可释放原列表）
+    /// @return 执行结果句柄
+    static AsyncResult<MoneyTxResult> applyAtomicAsync(std::vector<MoneyOp> legs);
+
+    /// @brief 异步获取财富排行榜（按币种）
+    /// @param currencyId 币种ID
+    /// @param limit 返回数量限制
+    /// @return 财富排行榜句柄
+    [[nodiscard]] static AsyncResult<std::vector<TopBalanceEntry>>
+    getTopBalanceListAsync(const std::string& currencyId, int limit);
+
+    /// @brief 异步获取玩家交易历史
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID（可选，为空则查询所有币种）
+    /// @param page 页码
+    /// @param pageSize 每页大小
+    /// @return 交易记录列表句柄
+    [[nodiscard]] static AsyncResult<std::vector<TransactionRecord>> getPlayerTransactionsAsync(
+        const std::string& xuid,
+        const std::string& currencyId = "",
+        int                page       = 1,
+        int                pageSize   = 10
+    );
+
+    /// @brief 异步按游标分页获取玩家交易历史
+    /// @param xuid 玩家XUID
+    /// @param filter 查询条件
+    /// @param cursor 上一页返回的 nextCursor（为空表示第一页）
+    /// @param pageSize 每页大小（1-1000）
+    /// @return 本页交易记录与下一页游标句柄
+    [[nodiscard]] static AsyncResult<TransactionPage> getPlayerTransactionsPageAsync(
+        const std::string& xuid,
+        TransactionFilter  filter   = {},
+        std::string        cursor   = "",
+        int                pageSize = 10
+    );
+
+    /// @brief 在游戏线程上恢复已完成异步操作的等待协程
+    /// @return 恢复的协程数量
+    /// @note RLXMoney 插件每 tick 自动调用；单独使用 SDK 时由调用方在主线程定期调用
+    static size_t runMainThreadTasks();
+
     /// @brief 初始化系统（加载配置、初始化数据库等）
     /// @param configName 配置文件名（仅文件名，默认 "rlx_money.json"）
     ///                    配置文件将自动放置在固定路径：plugins/RLXModeResources/config/{configName}
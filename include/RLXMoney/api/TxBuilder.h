@@ -0,0 +1,109 @@
+#pragma once
+
+#include <RLXMoney/api/RLXMoneyAPI.h>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace rlx_money {
+
+/// @brief 多条目原子事务构造器
+/// @note 收集跨玩家、跨币种的扣款/入账/转账条目，commit() 时整体校验并在同一个事务中执行，
+///       全部成功或全部不生效。例如商店结算：
+///       @code
+///       auto result = TxBuilder()
+///                         .debit(buyer, "gold", 100, "购买物品")
+///                         .credit(seller, "gold", 95, "出售物品")
+///                         .credit(taxAccount, "gold", 5, "交易税")
+///                         .credit(buyer, "points", 10, "购物积分")
+///                         .commit();
+///       @endcode
+class TxBuilder {
+public:
+    /// @brief 添加扣款条目
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @param amount 扣除金额
+    /// @param description 操作描述
+    /// @return 构造器自身
+    TxBuilder& debit(std::string xuid, std::string currencyId, int amount, std::string description = "") {
+        mLegs.emplace_back(
+            TransactionType::REDUCE,
+            std::move(xuid),
+            std::move(currencyId),
+            amount,
+            std::move(description)
+        );
+        return *this;
+    }
+
+    /// @brief 添加入账条目
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @param amount 增加金额
+    /// @param description 操作描述
+    /// @return 构造器自身
+    TxBuilder& credit(std::string xuid, std::string currencyId, int amount, std::string description = "") {
+        mLegs.emplace_back(
+            TransactionType::ADD,
+            std::move(xuid),
+            std::move(currencyId),
+            amount,
+            std::move(description)
+        );
+        return *this;
+    }
+
+    /// @brief 添加转账条目（同币种，按币种配置收取手续费）
+    /// @param fromXuid 转出玩家XUID
+    /// @param toXuid 转入玩家XUID
+    /// @param currencyId 币种ID
+    /// @param amount 转账金额
+    /// @param description 转账描述
+    /// @return 构造器自身
+    TxBuilder& transfer(
+        std::string fromXuid,
+        std::string toXuid,
+        std::string currencyId,
+        int         amount,
+        std::string description = ""
+    ) {
+        mLegs.emplace_back(
+            TransactionType::TRANSFER,
+            std::move(fromXuid),
+            std::move(currencyId),
+            amount,
+            std::move(description),
+            std::move(toXuid)
+        );
+        return *this;
+    }
+
+    /// @brief 获取已添加的条目
+    [[nodiscard]] std::span<const MoneyOp> legs() const { return mLegs; }
+
+    /// @brief 获取条目数量
+    [[nodiscard]] size_t size() const { return mLegs.size(); }
+
+    /// @brief 是否没有任何条目
+    [[nodiscard]] bool empty() const { return mLegs.empty(); }
+
+    /// @brief 清空条目以便复用
+    void clear() { mLegs.clear(); }
+
+    /// @brief 提交全部条目
+    /// @return 执行结果，success 为 false 时没有任何条目生效
+    [[nodiscard]] MoneyTxResult commit() const { return RLXMoneyAPI::applyAtomic(mLegs); }
+
+    /// @brief 异步提交全部条目
+    /// @return 执行结果句柄
+    [[nodiscard]] AsyncResult<MoneyTxResult> commitAsync() const { return RLXMoneyAPI::applyAtomicAsync(mLegs); }
+
+private:
+    std::vector<MoneyOp> mLegs;
+};
+
+} // namespace rlx_money
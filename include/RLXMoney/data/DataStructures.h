@@ -5,6 +5,7 @@
 #include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace rlx_money {
 
@@ -102,6 +103,24 @@ struct TransactionRecord {
       transferId(transfer) {}
 };
 
+/// @brief 交易记录查询条件
+struct TransactionFilter {
+    std::string                    currencyId;              // 币种ID（为空表示所有币种）
+    std::optional<TransactionType> type;                    // 交易类型（为空表示所有类型）
+    std::optional<int64_t>         startTime;               // 开始时间戳（包含）
+    std::optional<int64_t>         endTime;                 // 结束时间戳（包含）
+    bool                           includeArchived = false; // 是否同时查询已归档到月度分段文件的记录
+};
+
+/// @brief 按游标分页的交易记录
+struct TransactionPage {
+    std::vector<TransactionRecord> records;    // 本页交易记录（按时间倒序，同一秒内按记录ID倒序）
+    std::string                    nextCursor; // 下一页游标（为空表示没有更多记录）
+
+    /// @brief 是否还有下一页
+    [[nodiscard]] bool hasMore() const { return !nextCursor.empty(); }
+};
+
 /// @brief 财富排行榜条目
 struct TopBalanceEntry {
     std::string username;   // 玩家用户名
@@ -127,6 +146,57 @@ struct TopBalanceEntry {
       rank(r) {}
 };
 
+/// @brief 批量余额操作条目
+struct MoneyOp {
+    TransactionType type;        // 操作类型（SET/ADD/REDUCE/TRANSFER）
+    std::string     xuid;        // 玩家XUID（转账时为转出玩家）
+    std::string     currencyId;  // 币种ID
+    int             amount;      // 金额（非负）
+    std::string     description; // 操作描述
+    std::string     toXuid;      // 转入玩家XUID（仅转账使用）
+
+    /// @brief 构造函数
+    MoneyOp() : type(TransactionType::ADD), amount(0) {}
+
+    /// @brief 构造函数
+    /// @param t 操作类型
+    /// @param x 玩家XUID
+    /// @param cid 币种ID
+    /// @param amt 金额
+    /// @param desc 操作描述
+    /// @param to 转入玩家XUID
+    MoneyOp(TransactionType t, std::string x, std::string cid, int amt, std::string desc = "", std::string to = "")
+    : type(t),
+      xuid(std::move(x)),
+      currencyId(std::move(cid)),
+      amount(amt),
+      description(std::move(desc)),
+      toXuid(std::move(to)) {}
+};
+
+/// @brief 批量余额操作结果
+struct MoneyOpResult {
+    bool               success; // 是否成功
+    ErrorCode          error;   // 错误码（成功时为 SUCCESS）
+    std::string        message; // 错误信息
+    std::optional<int> balance; // 操作后的余额（转账时为转出玩家余额）
+
+    /// @brief 构造函数
+    MoneyOpResult() : success(false), error(ErrorCode::SUCCESS) {}
+};
+
+/// @brief 多条目原子事务结果
+struct MoneyTxResult {
+    bool             success;   // 是否全部提交
+    ErrorCode        error;     // 错误码（成功时为 SUCCESS）
+    std::string      message;   // 错误信息
+    int              failedLeg; // 导致整个事务回滚的条目下标（-1 表示与具体条目无关或成功）
+    std::vector<int> balances;  // 与条目一一对应的操作后余额（转账时为转出玩家余额），失败时为空
+
+    /// @brief 构造函数
+    MoneyTxResult() : success(false), error(ErrorCode::SUCCESS), failedLeg(-1) {}
+};
+
 } // namespace rlx_money
 
 
@@ -5,12 +5,13 @@
 namespace rlx_money {
 
 /// @brief 交易类型枚举
+/// @note 枚举值直接存入数据库 transactions.type 列，已有取值不能修改
 enum class TransactionType {
-    SET,      // 设置余额
-    ADD,      // 增加金钱
-    REDUCE,   // 减少金钱
-    TRANSFER, // 转账
-    INITIAL   // 初始金额
+    SET      = 0, // 设置余额
+    ADD      = 1, // 增加金钱
+    REDUCE   = 2, // 减少金钱
+    TRANSFER = 3, // 转账
+    INITIAL  = 4  // 初始金额
 };
 
 /// @brief 操作者类型枚举
@@ -1,11 +1,17 @@
 #include "mod/RLXMoney.h"
+#include "ll/api/chrono/GameChrono.h"
+#include "ll/api/coro/CoroTask.h"
 #include "ll/api/mod/RegisterHelper.h"
+#include "ll/api/thread/ServerThreadExecutor.h"
 #include "mod/commands/Commands.h"
 #include "mod/config/ConfigStructures.h"
+#include "mod/core/AdminJobRunner.h"
+#include "mod/core/AsyncExecutor.h"
 #include "mod/core/SystemInitializer.h"
 #include "mod/database/DatabaseManager.h"
 #include "mod/economy/EconomyManager.h"
 #include "mod/events/PlayerEventListener.h"
+#include "mod/storage/LedgerStorageBackend.h"
 #include <exception>
 
 
@@ -51,6 +57,9 @@ bool RLXMoney::enable() {
         // 注册事件监听器
         PlayerEventListener::registerListeners();
 
+        // 启动每 tick 维护任务
+        startTickTask();
+
         logger.info("RLXMoney 插件启用完成");
         mInitialized = true;
         return true;
@@ -69,6 +78,19 @@ bool RLXMoney::disable() {
         // 取消注册事件监听器
         PlayerEventListener::unregisterListeners();
 
+        // 请求恢复、归档、整理等管理任务在下一个检查点停止并等待其退出
+        AdminJobRunner::getInstance().shutdown();
+
+        // 执行完已提交的异步任务，并恢复仍在等待结果的协程
+        AsyncExecutor::getInstance().shutdown();
+        AsyncExecutor::getInstance().runMainThreadTasks();
+
+        // 停止每 tick 维护任务
+        stopTickTask();
+
+        // 把写后模式的余额刷新到数据库，并提交组提交模式下尚未提交的写事务
+        EconomyManager::getInstance().flushForShutdown();
+
         // 清理所有组件
         cleanupComponents();
 
@@ -90,12 +112,39 @@ bool RLXMoney::initializeComponents() const {
         logger.info("初始化配置管理器...");
         MoneyConfig::initWithName("rlx_money.json");
 
-        // 初始化数据库管理器
-        logger.info("初始化数据库管理器...");
+        // 初始化数据库管理器（其他存储后端不使用数据库）
         const auto& config = MoneyConfig::getInstance().get();
-        if (!DatabaseManager::getInstance().initialize(config.database.path)) {
-            logger.error("数据库初始化失败");
-            return false;
+        if (config.database.backend == "sqlite") {
+            logger.info("初始化数据库管理器...");
+            if (!DatabaseManager::getInstance().initialize(config.database)) {
+                logger.error("数据库初始化失败");
+                return false;
+            }
+            // 旧版本创建的数据库不会自动切换为增量整理：切换要重写整个文件，只在管理员执行命令时进行
+            if (!DatabaseManager::getInstance().isIncrementalVacuumEnabled()) {
+                int64_t sizeMB = DatabaseManager::getInstance().getDatabaseSizeBytes() / (1024 * 1024);
+                logger.warn(
+                    "数据库未启用增量整理，删除的记录占用的空间不会归还给文件系统；"
+                    "可在空闲时执行 /moneyop vacuum 切换，将重写约 {} MB 的数据库文件，期间暂停所有写入，"
+                    "并需要约 {} MB 的可用磁盘空间",
+                    sizeMB,
+                    sizeMB * 2
+                );
+            }
+            // 旧版本的交易记录在服务器运行期间由 tick 任务分批移入新表，期间的查询同时读取新旧两表
+            auto migration = DatabaseManager::getInstance().getMigrationProgress();
+            if (migration.state == MigrationState::Running) {
+                logger.info(
+                    "交易记录将在运行期间迁移到新结构（旧表最大记录ID {}，已迁移到 {}），迁移完成前暂停清理与归档",
+                    migration.lastId,
+                    migration.movedId
+                );
+            }
+        } else if (config.database.backend == "ledger") {
+            auto directory = LedgerStorageBackend::directoryFor(config.database.path);
+            logger.info("使用账本存储后端，数据目录: {}", directory.string());
+        } else {
+            logger.warn("使用 {} 存储后端，数据不会持久化", config.database.backend);
         }
 
         // 初始化经济管理器
@@ -134,6 +183,81 @@ void RLXMoney::cleanupComponents() const {
     logger.info("该插件暂不支持卸载");
 }
 
+void RLXMoney::startTickTask() {
+    using namespace ll::chrono_literals;
+
+    mTickTaskRunning = std::make_shared<std::atomic<bool>>(true);
+    ll::coro::keepThis([running = mTickTaskRunning]() -> ll::coro::CoroTask<> {
+        while (running->load()) {
+            co_await 1_tick;
+            if (!running->load()) {
+                break;
+            }
+            try {
+                // 到达刷新间隔时把写后模式的余额写入数据库
+                EconomyManager::getInstance().flushWriteBehindIfDue();
+
+                // 组提交模式下把本 tick 内的写事务合并为一次提交
+                EconomyManager::getInstance().flushCommits();
+
+                // 定期更新查询优化器统计信息
+                DatabaseManager::getInstance().optimizeIfDue();
+
+                // 分批推进在线备份，结束时记录结果
+                bool wasBackingUp = DatabaseManager::getInstance().getBackupProgress().state == BackupState::Running;
+                auto progress     = DatabaseManager::getInstance().stepBackup();
+                if (wasBackingUp && progress.state == BackupState::Completed) {
+                    RLXMoney::getInstance().getSelf().getLogger().info("在线备份已完成: {}", progress.path);
+                } else if (wasBackingUp && progress.state == BackupState::Failed) {
+                    RLXMoney::getInstance().getSelf().getLogger().error("在线备份失败: {}", progress.error);
+                }
+
+                // 在时间预算内分批把旧版本的交易记录移入新表，结束时记录结果
+                auto& database     = DatabaseManager::getInstance();
+                bool  wasMigrating = database.getMigrationProgress().state == MigrationState::Running;
+                auto  migration    = database.stepMigration();
+                if (wasMigrating && migration.state == MigrationState::Completed) {
+                    RLXMoney::getInstance().getSelf().getLogger().info(
+                        "交易记录结构迁移已完成: 本次启动移动 {} 条记录",
+                        migration.movedRecords
+                    );
+                } else if (wasMigrating && migration.state == MigrationState::Failed) {
+                    RLXMoney::getInstance().getSelf().getLogger().error(
+                        "交易记录结构迁移失败（已移动的记录保留，下次启动时继续）: {}",
+                        migration.error
+                    );
+                }
+
+                // 在时间预算内分批清理过期交易记录，空闲时把空闲页归还给文件系统
+                bool wasRetaining = database.getRetentionProgress().state == RetentionState::Running;
+                auto retention    = database.stepRetention();
+                if (wasRetaining && retention.state == RetentionState::Completed) {
+                    RLXMoney::getInstance().getSelf().getLogger().info(
+                        "交易记录清理已完成: 删除 {} 条早于 {} 的记录",
+                        retention.deletedRecords,
+                        retention.cutoffTime
+                    );
+                } else if (wasRetaining && retention.state == RetentionState::Failed) {
+                    RLXMoney::getInstance().getSelf().getLogger().error("交易记录清理失败: {}", retention.error);
+                }
+
+                // 在游戏线程上恢复等待异步 API 结果的协程
+                AsyncExecutor::getInstance().runMainThreadTasks();
+            } catch (const std::exception& e) {
+                RLXMoney::getInstance().getSelf().getLogger().error("tick 维护任务执行失败: {}", e.what());
+            }
+        }
+        co_return;
+    }).launch(ll::thread::ServerThreadExecutor::getDefault());
+}
+
+void RLXMoney::stopTickTask() {
+    if (mTickTaskRunning) {
+        mTickTaskRunning->store(false);
+        mTickTaskRunning.reset();
+    }
+}
+
 } // namespace rlx_money
 
 LL_REGISTER_MOD(rlx_money::RLXMoney, rlx_money::RLXMoney::getInstance());
\ No newline at end of file
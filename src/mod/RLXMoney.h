@@ -1,6 +1,8 @@
 #pragma once
 
 #include "ll/api/mod/NativeMod.h"
+#include <atomic>
+#include <memory>
 
 
 namespace rlx_money {
@@ -27,8 +29,9 @@ class RLXMoney {
     // bool unload();
 
 private:
-    ll::mod::NativeMod& mSelf;
-    bool                mInitialized = false;
+    ll::mod::NativeMod&                mSelf;
+    bool                               mInitialized = false;
+    std::shared_ptr<std::atomic<bool>> mTickTaskRunning; // 每 tick 维护任务的运行标记
 
     /// @brief 初始化所有组件
     /// @return 是否初始化成功
@@ -36,6 +39,12 @@ class RLXMoney {
 
     /// @brief 清理所有组件
     void cleanupComponents() const;
+
+    /// @brief 启动每 tick 执行的维护任务（组提交等）
+    void startTickTask();
+
+    /// @brief 停止每 tick 维护任务
+    void stopTickTask();
 };
 
 } // namespace rlx_money
\ No newline at end of file
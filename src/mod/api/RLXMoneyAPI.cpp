@@ -1,5 +1,6 @@
 #include <RLXMoney/api/RLXMoneyAPI.h>
 #include "mod/config/ConfigStructures.h"
+#include "mod/core/AsyncExecutor.h"
 #include "mod/database/DatabaseManager.h"
 #include "mod/economy/EconomyManager.h"
 
@@ -53,6 +54,14 @@ bool RLXMoneyAPI::transferMoney(
     return EconomyManager::getInstance().transferMoney(fromXuid, toXuid, currencyId, amount, description);
 }
 
+std::vector<MoneyOpResult> RLXMoneyAPI::applyBatch(std::span<const MoneyOp> ops) {
+    return EconomyManager::getInstance().applyBatch(ops);
+}
+
+MoneyTxResult RLXMoneyAPI::applyAtomic(std::span<const MoneyOp> legs) {
+    return EconomyManager::getInstance().applyAtomic(legs);
+}
+
 bool RLXMoneyAPI::hasSufficientBalance(const std::string& xuid, const std::string& currencyId, int amount) {
     return EconomyManager::getInstance().hasSufficientBalance(xuid, currencyId, amount);
 }
@@ -61,16 +70,38 @@ std::vector<TopBalanceEntry> RLXMoneyAPI::getTopBalanceList(const std::string& c
     return EconomyManager::getInstance().getTopBalanceList(currencyId, limit);
 }
 
+std::vector<TopBalanceEntry> RLXMoneyAPI::getTopBalanceRange(const std::string& currencyId, int offset, int limit) {
+    return EconomyManager::getInstance().getTopBalanceRange(currencyId, offset, limit);
+}
+
+std::optional<int> RLXMoneyAPI::getPlayerRank(const std::string& xuid, const std::string& currencyId) {
+    return EconomyManager::getInstance().getPlayerRank(xuid, currencyId);
+}
+
+std::vector<TopBalanceEntry>
+RLXMoneyAPI::getRankNeighbors(const std::string& xuid, const std::string& currencyId, int radius) {
+    return EconomyManager::getInstance().getRankNeighbors(xuid, currencyId, radius);
+}
+
 std::vector<TransactionRecord>
 RLXMoneyAPI::getPlayerTransactions(const std::string& xuid, const std::string& currencyId, int page, int pageSize) {
     return EconomyManager::getInstance().getPlayerTransactions(xuid, currencyId, page, pageSize);
 }
 
+TransactionPage RLXMoneyAPI::getPlayerTransactionsPage(
+    const std::string&       xuid,
+    const TransactionFilter& filter,
+    const std::string&       cursor,
+    int                      pageSize
+) {
+    return EconomyManager::getInstance().getPlayerTransactionsPage(xuid, filter, cursor, pageSize);
+}
+
 int RLXMoneyAPI::getPlayerTransactionCount(const std::string& xuid) {
     return EconomyManager::getInstance().getPlayerTransactionCount(xuid);
 }
 
-int RLXMoneyAPI::getTotalWealth(const std::string& currencyId) {
+int64_t RLXMoneyAPI::getTotalWealth(const std::string& currencyId) {
     return EconomyManager::getInstance().getTotalWealth(currencyId);
 }
 
@@ -91,14 +122,136 @@ std::vector<std::string> RLXMoneyAPI::getEnabledCurrencyIds() {
 
 std::string RLXMoneyAPI::getDefaultCurrencyId() { return MoneyConfig::getInstance().get().defaultCurrency; }
 
+AsyncResult<std::optional<int>> RLXMoneyAPI::getBalanceAsync(const std::string& xuid, const std::string& currencyId) {
+    return AsyncExecutor::getInstance().run<std::optional<int>>({xuid}, [xuid, currencyId]() {
+        return EconomyManager::getInstance().getBalance(xuid, currencyId);
+    });
+}
+
+AsyncResult<std::vector<PlayerBalance>> RLXMoneyAPI::getAllBalancesAsync(const std::string& xuid) {
+    return AsyncExecutor::getInstance().run<std::vector<PlayerBalance>>({xuid}, [xuid]() {
+        return EconomyManager::getInstance().getAllBalances(xuid);
+    });
+}
+
+AsyncResult<bool> RLXMoneyAPI::setBalanceAsync(
+    const std::string& xuid,
+    const std::string& currencyId,
+    int                amount,
+    const std::string& description
+) {
+    return AsyncExecutor::getInstance().run<bool>({xuid}, [xuid, currencyId, amount, description]() {
+        return EconomyManager::getInstance().setBalance(xuid, currencyId, amount, description);
+    });
+}
+
+AsyncResult<bool> RLXMoneyAPI::addMoneyAsync(
+    const std::string& xuid,
+    const std::string& currencyId,
+    int                amount,
+    const std::string& description
+) {
+    return AsyncExecutor::getInstance().run<bool>({xuid}, [xuid, currencyId, amount, description]() {
+        return EconomyManager::getInstance().addMoney(xuid, currencyId, amount, description);
+    });
+}
+
+AsyncResult<bool> RLXMoneyAPI::reduceMoneyAsync(
+    const std::string& xuid,
+    const std::string& currencyId,
+    int                amount,
+    const std::string& description
+) {
+    return AsyncExecutor::getInstance().run<bool>({xuid}, [xuid, currencyId, amount, description]() {
+        return EconomyManager::getInstance().reduceMoney(xuid, currencyId, amount, description);
+    });
+}
+
+AsyncResult<bool> RLXMoneyAPI::transferMoneyAsync(
+    const std::string& fromXuid,
+    const std::string& toXuid,
+    const std::string& currencyId,
+    int                amount,
+    const std::string& description
+) {
+    return AsyncExecutor::getInstance().run<bool>(
+        {fromXuid, toXuid},
+        [fromXuid, toXuid, currencyId, amount, description]() {
+            return EconomyManager::getInstance().transferMoney(fromXuid, toXuid, currencyId, amount, description);
+        }
+    );
+}
+
+AsyncResult<std::vector<MoneyOpResult>> RLXMoneyAPI::applyBatchAsync(std::vector<MoneyOp> ops) {
+    std::vector<std::string> keys;
+    for (const auto& op : ops) {
+        keys.push_back(op.xuid);
+        if (!op.toXuid.empty()) {
+            keys.push_back(op.toXuid);
+        }
+    }
+    return AsyncExecutor::getInstance().run<std::vector<MoneyOpResult>>(keys, [ops = std::move(ops)]() {
+        return EconomyManager::getInstance().applyBatch(ops);
+    });
+}
+
+AsyncResult<MoneyTxResult> RLXMoneyAPI::applyAtomicAsync(std::vector<MoneyOp> legs) {
+    std::vector<std::string> keys;
+    for (const auto& leg : legs) {
+        keys.push_back(leg.xuid);
+        if (!leg.toXuid.empty()) {
+            keys.push_back(leg.toXuid);
+        }
+    }
+    return AsyncExecutor::getInstance().run<MoneyTxResult>(keys, [legs = std::move(legs)]() {
+        return EconomyManager::getInstance().applyAtomic(legs);
+    });
+}
+
+AsyncResult<std::vector<TopBalanceEntry>> RLXMoneyAPI::getTopBalanceListAsync(const std::string& currencyId, int limit) {
+    return AsyncExecutor::getInstance().run<std::vector<TopBalanceEntry>>({}, [currencyId, limit]() {
+        return EconomyManager::getInstance().getTopBalanceList(currencyId, limit);
+    });
+}
+
+AsyncResult<std::vector<TransactionRecord>> RLXMoneyAPI::getPlayerTransactionsAsync(
+    const std::string& xuid,
+    const std::string& currencyId,
+    int                page,
+    int                pageSize
+) {
+    return AsyncExecutor::getInstance().run<std::vector<TransactionRecord>>(
+        {xuid},
+        [xuid, currencyId, page, pageSize]() {
+            return EconomyManager::getInstance().getPlayerTransactions(xuid, currencyId, page, pageSize);
+        }
+    );
+}
+
+AsyncResult<TransactionPage> RLXMoneyAPI::getPlayerTransactionsPageAsync(
+    const std::string& xuid,
+    TransactionFilter  filter,
+    std::string        cursor,
+    int                pageSize
+) {
+    return AsyncExecutor::getInstance().run<TransactionPage>(
+        {xuid},
+        [xuid, filter = std::move(filter), cursor = std::move(cursor), pageSize]() {
+            return EconomyManager::getInstance().getPlayerTransactionsPage(xuid, filter, cursor, pageSize);
+        }
+    );
+}
+
+size_t RLXMoneyAPI::runMainThreadTasks() { return AsyncExecutor::getInstance().runMainThreadTasks(); }
+
 bool RLXMoneyAPI::initialize(const std::string& configName) {
     try {
         // 1. 加载配置（使用固定路径前缀）
         MoneyConfig::initWithName(configName);
 
-        // 2. 初始化数据库
+        // 2. 初始化数据库（内存存储后端不使用数据库）
         const auto& config = MoneyConfig::getInstance().get();
-        if (!DatabaseManager::getInstance().initialize(config.database.path)) {
+        if (config.database.backend == "sqlite" && !DatabaseManager::getInstance().initialize(config.database)) {
             return false;
         }
 
@@ -115,8 +268,8 @@ bool RLXMoneyAPI::initialize(const std::string& configName) {
 
 bool RLXMoneyAPI::isInitialized() {
     try {
-        // 检查数据库是否已初始化（这是最关键的检查）
-        if (!DatabaseManager::getInstance().isInitialized()) {
+        // 检查数据库或存储后端是否已初始化（这是最关键的检查）
+        if (!DatabaseManager::getInstance().isInitialized() && !EconomyManager::getInstance().isStorageOpen()) {
             return false;
         }
 
@@ -1,14 +1,20 @@
 #include "Commands.h"
 #include "mod/api/LeviLaminaAPI.h"
 #include "mod/config/ConfigStructures.h"
+#include "mod/core/AdminJobRunner.h"
+#include "mod/database/DatabaseManager.h"
+#include "mod/database/DatabaseRestore.h"
 #include "mod/economy/EconomyManager.h"
 #include "mod/exceptions/MoneyException.h"
 
 
+#include <charconv>
 #include <cstdint>
+#include <filesystem>
 #include <ll/api/command/Command.h>
 #include <ll/api/command/CommandHandle.h>
 #include <ll/api/command/CommandRegistrar.h>
+#include <ll/api/mod/NativeMod.h>
 #include <ll/api/service/Service.h>
 #include <mc/server/ServerPlayer.h>
 #include <mc/server/commands/CommandOutput.h>
@@ -20,6 +26,15 @@
 
 namespace rlx_money {
 
+namespace {
+
+/// @brief 管理任务线程忙时的提示
+std::string describeBusyAdminJob() {
+    return "已有后台任务正在进行：" + AdminJobRunner::getInstance().getRunningJob().value_or("正在停止的任务");
+}
+
+} // namespace
+
 void Commands::registerCommands() {
     using ll::command::CommandRegistrar;
     auto& commad = CommandRegistrar::getInstance(false).getOrCreateCommand("money", "金钱");
@@ -479,6 +494,433 @@ void Commands::registerCommands() {
             }
         });
 
+    // 批量操作：以单条集合语句作用于某币种的所有账户
+    opCommand.overload<BulkAdjustCommand>()
+        .required("Operation")
+        .required("Value")
+        .optional("Currency")
+        .optional("Rounding")
+        .execute([](CommandOrigin const& origin, CommandOutput& output, BulkAdjustCommand const& param, Command const&) {
+            auto actor = origin.getEntity();
+            if (actor == nullptr || !actor->isType(ActorType::Player)) {
+                output.error("只有玩家可以执行批量操作");
+                return;
+            }
+            auto player = static_cast<Player*>(actor);
+            if (!player->isOperator()) {
+                output.error("你没有权限执行批量操作");
+                return;
+            }
+
+            std::string currencyId = param.Currency.mText.empty() ? EconomyManager::getInstance().getDefaultCurrencyId()
+                                                                  : param.Currency.mText;
+            const auto& config       = MoneyConfig::getInstance().get();
+            auto        currencyIt   = config.currencies.find(currencyId);
+            std::string currencyName = currencyIt != config.currencies.end() ? currencyIt->second.name : currencyId;
+
+            try {
+                switch (param.Operation) {
+                case CommandBulkAdjustOperation::airdrop: {
+                    int     amount  = std::stoi(param.Value.mText);
+                    int64_t changed = EconomyManager::getInstance().addToAll(
+                        currencyId,
+                        amount,
+                        OperatorType::ADMIN,
+                        std::string(player->mName)
+                    );
+                    player->sendMessage(
+                        fmt::format("§a已向 §e{}§a 个账户发放 §6{} §b{}", changed, amount, currencyName)
+                    );
+                    break;
+                }
+
+                case CommandBulkAdjustOperation::scale: {
+                    double       rate     = std::stod(param.Value.mText);
+                    RoundingMode rounding = RoundingMode::Floor;
+                    if (param.Rounding.mText == "ceil") {
+                        rounding = RoundingMode::Ceil;
+                    } else if (!param.Rounding.mText.empty() && param.Rounding.mText != "floor") {
+                        output.error("取整方式只能是 floor 或 ceil");
+                        break;
+                    }
+                    int64_t changed = EconomyManager::getInstance().scaleAll(
+                        currencyId,
+                        rate,
+                        rounding,
+                        OperatorType::ADMIN,
+                        std::string(player->mName)
+                    );
+                    player->sendMessage(
+                        fmt::format("§a已将 §e{}§a 个账户的 §b{}§a 余额按 §6{}§a 倍调整", changed, currencyName, rate)
+                    );
+                    break;
+                }
+
+                default:
+                    output.error("未知的批量操作");
+                    break;
+                }
+            } catch (const std::logic_error&) {
+                // std::stoi / std::stod 解析失败
+                output.error(fmt::format("无效的数值：{}", param.Value.mText));
+            } catch (const std::exception& e) {
+                output.error(fmt::format("操作失败：{}", e.what()));
+            }
+        });
+
+    opCommand.overload<BulkResetCommand>()
+        .required("Operation")
+        .optional("Currency")
+        .execute([](CommandOrigin const& origin, CommandOutput& output, BulkResetCommand const& param, Command const&) {
+            auto actor = origin.getEntity();
+            if (actor == nullptr || !actor->isType(ActorType::Player)) {
+                output.error("只有玩家可以执行批量操作");
+                return;
+            }
+            auto player = static_cast<Player*>(actor);
+            if (!player->isOperator()) {
+                output.error("你没有权限执行批量操作");
+                return;
+            }
+
+            std::string currencyId = param.Currency.mText.empty() ? EconomyManager::getInstance().getDefaultCurrencyId()
+                                                                  : param.Currency.mText;
+            const auto& config       = MoneyConfig::getInstance().get();
+            auto        currencyIt   = config.currencies.find(currencyId);
+            std::string currencyName = currencyIt != config.currencies.end() ? currencyIt->second.name : currencyId;
+
+            try {
+                switch (param.Operation) {
+                case CommandBulkResetOperation::resetall: {
+                    int64_t changed = EconomyManager::getInstance()
+                                          .resetAll(currencyId, OperatorType::ADMIN, std::string(player->mName));
+                    player->sendMessage(
+                        fmt::format("§a已将 §e{}§a 个账户的 §b{}§a 余额重置为初始余额", changed, currencyName)
+                    );
+                    break;
+                }
+
+                case CommandBulkResetOperation::clampall: {
+                    int64_t changed = EconomyManager::getInstance()
+                                          .clampAll(currencyId, OperatorType::ADMIN, std::string(player->mName));
+                    player->sendMessage(
+                        fmt::format("§a已将 §e{}§a 个账户的 §b{}§a 余额降到最大余额", changed, currencyName)
+                    );
+                    break;
+                }
+
+                default:
+                    output.error("未知的批量操作");
+                    break;
+                }
+            } catch (const std::exception& e) {
+                output.error(fmt::format("操作失败：{}", e.what()));
+            }
+        });
+
+    // 在线备份：页面由 tick 任务分批复制，这里只负责开始、查询与取消
+    opCommand.overload<BackupCommand>()
+        .required("Operation")
+        .optional("Action")
+        .execute([](CommandOrigin const& origin, CommandOutput& output, BackupCommand const& param, Command const&) {
+            auto actor = origin.getEntity();
+            if (actor == nullptr || !actor->isType(ActorType::Player)) {
+                output.error("只有玩家可以执行备份操作");
+                return;
+            }
+            auto player = static_cast<Player*>(actor);
+            if (!player->isOperator()) {
+                output.error("你没有权限执行备份操作");
+                return;
+            }
+
+            auto& database = DatabaseManager::getInstance();
+            try {
+                const std::string& action = param.Action.mText;
+                if (action.empty()) {
+                    std::string path = database.startBackup();
+                    player->sendMessage(fmt::format("§a已开始在线备份：§e{}", path));
+                    player->sendMessage("§7备份在后台逐 tick 进行，使用 /moneyop backup status 查看进度");
+                } else if (action == "status") {
+                    auto progress = database.getBackupProgress();
+                    switch (progress.state) {
+                    case BackupState::Idle:
+                        player->sendMessage("§e本次启动后尚未执行过在线备份");
+                        break;
+                    case BackupState::Running:
+                        player->sendMessage(fmt::format(
+                            "§a备份进行中：§6{:.1f}% §7({}/{} 页) §e{}",
+                            progress.percent(),
+                            progress.totalPages - progress.remainingPages,
+                            progress.totalPages,
+                            progress.path
+                        ));
+                        break;
+                    case BackupState::Completed:
+                        player->sendMessage(
+                            fmt::format("§a最近一次备份已完成：§e{} §7({} 页)", progress.path, progress.totalPages)
+                        );
+                        break;
+                    case BackupState::Failed:
+                        player->sendMessage(fmt::format("§c最近一次备份失败：{}", progress.error));
+                        break;
+                    }
+                } else if (action == "cancel") {
+                    if (database.cancelBackup()) {
+                        player->sendMessage("§a已取消在线备份");
+                    } else {
+                        output.error("没有正在进行的备份");
+                    }
+                } else {
+                    output.error("备份操作只能是 status 或 cancel（留空表示开始备份）");
+                }
+            } catch (const std::exception& e) {
+                output.error(fmt::format("操作失败：{}", e.what()));
+            }
+        });
+
+    // 按时间点恢复：在后台线程把备份重放到目标时间点，结果写入新文件，不修改正在使用的数据库
+    opCommand.overload<RestoreCommand>()
+        .required("Operation")
+        .required("Backup")
+        .required("Until")
+        .optional("Skip")
+        .execute([](CommandOrigin const& origin, CommandOutput& output, RestoreCommand const& param, Command const&) {
+            auto actor = origin.getEntity();
+            if (actor == nullptr || !actor->isType(ActorType::Player)) {
+                output.error("只有玩家可以执行恢复操作");
+                return;
+            }
+            auto player = static_cast<Player*>(actor);
+            if (!player->isOperator()) {
+                output.error("你没有权限执行恢复操作");
+                return;
+            }
+
+            auto&                 database = DatabaseManager::getInstance();
+            std::filesystem::path backup(param.Backup.mText);
+            std::filesystem::path dbPath(database.getDatabasePath());
+            RestoreOptions        options;
+            options.backupPath = backup.has_parent_path() ? backup.string()
+                                                          : (database.getBackupDirectory() / backup).string();
+            options.sourcePath = dbPath.string();
+            options.outputPath = (dbPath.parent_path() / (dbPath.stem().string() + ".restored.db")).string();
+            try {
+                options.untilTimestamp = std::stoll(param.Until.mText);
+            } catch (const std::logic_error&) {
+                output.error(fmt::format("无效的时间戳：{}", param.Until.mText));
+                return;
+            }
+
+            std::string_view skip = param.Skip.mText;
+            while (!skip.empty()) {
+                size_t           end   = skip.find(',');
+                std::string_view entry = skip.substr(0, end);
+                skip                   = end == std::string_view::npos ? std::string_view() : skip.substr(end + 1);
+                if (entry.starts_with("xuid:")) {
+                    options.skipXuids.emplace_back(entry.substr(5));
+                } else if (entry.starts_with("transfer:")) {
+                    options.skipTransferIds.emplace_back(entry.substr(9));
+                } else if (!entry.empty()) {
+                    output.error(fmt::format("无效的跳过条件：{}（格式为 xuid:<XUID> 或 transfer:<转账ID>）", entry));
+                    return;
+                }
+            }
+
+            // 重放可能需要数分钟，放到管理任务线程执行，结果输出到控制台；卸载插件时在批次之间停止
+            auto* logger = &ll::mod::NativeMod::current()->getLogger();
+            auto  job    = [options, logger](std::stop_token stopToken) {
+                try {
+                    auto restoreOptions      = options;
+                    restoreOptions.stopToken = stopToken;
+                    auto result = DatabaseRestore::restore(restoreOptions, [&](int64_t processed, int64_t total) {
+                        logger->info("恢复进度：{}/{}", processed, total);
+                    });
+                    logger->info(
+                        "恢复完成：重放 {} 条，跳过 {} 条，晚于目标时间点 {} 条，余额为负的账户 {} 个。"
+                        "停止服务器后用 {} 替换数据库文件即可生效",
+                        result.replayedRecords,
+                        result.skippedRecords,
+                        result.laterRecords,
+                        result.negativeBalances,
+                        options.outputPath
+                    );
+                } catch (const std::exception& e) {
+                    logger->error("恢复失败：{}", e.what());
+                }
+            };
+            if (!AdminJobRunner::getInstance().start("恢复", std::move(job))) {
+                output.error(describeBusyAdminJob());
+                return;
+            }
+            player->sendMessage(
+                fmt::format("§a已开始恢复到时间点 §6{}§a，结果将写入 §e{}", options.untilTimestamp, options.outputPath)
+            );
+            player->sendMessage("§7恢复在后台进行，进度与结果输出到控制台");
+        });
+
+    // 交易记录归档：在后台线程按月把旧记录移到分段文件，每个月份占用写连接一个事务
+    opCommand.overload<ArchiveCommand>()
+        .required("Operation")
+        .required("Days")
+        .execute([](CommandOrigin const& origin, CommandOutput& output, ArchiveCommand const& param, Command const&) {
+            auto actor = origin.getEntity();
+            if (actor == nullptr || !actor->isType(ActorType::Player)) {
+                output.error("只有玩家可以执行归档操作");
+                return;
+            }
+            auto player = static_cast<Player*>(actor);
+            if (!player->isOperator()) {
+                output.error("你没有权限执行归档操作");
+                return;
+            }
+            if (param.Days < 1) {
+                output.error("保留天数必须大于 0");
+                return;
+            }
+
+            // 归档在管理任务线程执行；卸载插件时在当前月份完成后停止
+            int   days   = param.Days;
+            auto* logger = &ll::mod::NativeMod::current()->getLogger();
+            auto  job    = [days, logger](std::stop_token stopToken) {
+                try {
+                    int64_t archived = EconomyManager::getInstance().archiveTransactions(days, stopToken);
+                    logger->info(
+                        "归档{}：{} 条早于 {} 天的交易记录已移到 {}",
+                        stopToken.stop_requested() ? "已停止" : "完成",
+                        archived,
+                        days,
+                        DatabaseManager::getInstance().getArchiveDirectory().string()
+                    );
+                } catch (const std::exception& e) {
+                    logger->error("归档失败：{}", e.what());
+                }
+            };
+            if (!AdminJobRunner::getInstance().start("归档", std::move(job))) {
+                output.error(describeBusyAdminJob());
+                return;
+            }
+            player->sendMessage(fmt::format("§a已开始归档早于 §6{}§a 天的交易记录", days));
+            player->sendMessage("§7归档在后台进行，结果输出到控制台");
+        });
+
+    // 交易记录清理：删除由 tick 任务在时间预算内分批执行，这里只负责开始、查询与取消
+    opCommand.overload<RetentionCommand>()
+        .required("Operation")
+        .required("Action")
+        .execute([](CommandOrigin const& origin, CommandOutput& output, RetentionCommand const& param, Command const&) {
+            auto actor = origin.getEntity();
+            if (actor == nullptr || !actor->isType(ActorType::Player)) {
+                output.error("只有玩家可以执行清理操作");
+                return;
+            }
+            auto player = static_cast<Player*>(actor);
+            if (!player->isOperator()) {
+                output.error("你没有权限执行清理操作");
+                return;
+            }
+
+            auto& database = DatabaseManager::getInstance();
+            try {
+                const std::string& action = param.Action.mText;
+                if (action == "status") {
+                    auto progress = database.getRetentionProgress();
+                    switch (progress.state) {
+                    case RetentionState::Idle:
+                        player->sendMessage("§e没有正在进行的清理任务");
+                        break;
+                    case RetentionState::Running:
+                        player->sendMessage(fmt::format(
+                            "§a清理进行中：已删除 §e{}§a 条早于 §6{}§a 的记录",
+                            progress.deletedRecords,
+                            progress.cutoffTime
+                        ));
+                        break;
+                    case RetentionState::Completed:
+                        player->sendMessage(
+                            fmt::format("§a最近一次清理已完成：删除 §e{}§a 条记录", progress.deletedRecords)
+                        );
+                        break;
+                    case RetentionState::Failed:
+                        player->sendMessage(fmt::format("§c最近一次清理失败：{}", progress.error));
+                        break;
+                    }
+                    player->sendMessage(fmt::format(
+                        "§7本次启动以来已归还 {} 字节，尚有 {} 字节空闲页",
+                        progress.reclaimedBytes,
+                        progress.freeBytes
+                    ));
+                } else if (action == "cancel") {
+                    if (database.cancelRetention()) {
+                        player->sendMessage("§a已取消清理任务");
+                    } else {
+                        output.error("没有正在进行的清理任务");
+                    }
+                } else {
+                    int  days   = 0;
+                    auto result = std::from_chars(action.data(), action.data() + action.size(), days);
+                    if (action.empty() || result.ec != std::errc() || result.ptr != action.data() + action.size()
+                        || days < 1) {
+                        output.error("清理操作只能是保留天数（正整数）、status 或 cancel");
+                        return;
+                    }
+                    auto progress = database.startRetention(days);
+                    player->sendMessage(
+                        fmt::format("§a已开始清理早于 §6{}§a 天（时间戳 {}）的交易记录", days, progress.cutoffTime)
+                    );
+                    player->sendMessage("§7清理在后台逐 tick 进行，使用 /moneyop retention status 查看进度");
+                }
+            } catch (const std::exception& e) {
+                output.error(fmt::format("操作失败：{}", e.what()));
+            }
+        });
+
+    // 把旧版本创建的数据库切换为增量整理：VACUUM 重写整个文件，在后台线程执行，期间所有写入等待
+    opCommand.overload<VacuumCommand>()
+        .required("Operation")
+        .execute([](CommandOrigin const& origin, CommandOutput& output, VacuumCommand const&, Command const&) {
+            auto actor = origin.getEntity();
+            if (actor == nullptr || !actor->isType(ActorType::Player)) {
+                output.error("只有玩家可以执行整理操作");
+                return;
+            }
+            auto player = static_cast<Player*>(actor);
+            if (!player->isOperator()) {
+                output.error("你没有权限执行整理操作");
+                return;
+            }
+
+            auto& database = DatabaseManager::getInstance();
+            try {
+                if (database.isIncrementalVacuumEnabled()) {
+                    player->sendMessage("§e数据库已启用增量整理，空闲页由 tick 任务逐步归还，无需整理");
+                    return;
+                }
+                int64_t sizeMB = database.getDatabaseSizeBytes() / (1024 * 1024);
+                auto*   logger = &ll::mod::NativeMod::current()->getLogger();
+                auto    job    = [logger](std::stop_token stopToken) {
+                    try {
+                        DatabaseManager::getInstance().convertToIncrementalVacuum(stopToken);
+                        logger->info(
+                            "数据库整理完成，已启用增量整理，当前大小 {} MB",
+                            DatabaseManager::getInstance().getDatabaseSizeBytes() / (1024 * 1024)
+                        );
+                    } catch (const std::exception& e) {
+                        logger->error("数据库整理失败：{}", e.what());
+                    }
+                };
+                if (!AdminJobRunner::getInstance().start("整理数据库", std::move(job))) {
+                    output.error(describeBusyAdminJob());
+                    return;
+                }
+                logger->warn("开始整理数据库：重写约 {} MB 的文件，需要约 {} MB 的可用磁盘空间", sizeMB, sizeMB * 2);
+                player->sendMessage(fmt::format("§a已开始整理数据库（约 §e{}§a MB）", sizeMB));
+                player->sendMessage("§7整理期间所有写入都会等待，结果输出到控制台");
+            } catch (const std::exception& e) {
+                output.error(fmt::format("操作失败：{}", e.what()));
+            }
+        });
+
     opCommand.overload<CurrencyCommand>()
         .required("Operation")
         .optional("CurrencyId")
@@ -544,6 +986,9 @@ void Commands::registerCommands() {
                     player->sendMessage(
                         fmt::format("§7- 允许玩家转账: {}", currency.allowPlayerTransfer ? "§a是" : "§c否")
                     );
+                    player->sendMessage(
+                        fmt::format("§7- 写后模式: {}", currency.writeBehind ? "§a启用" : "§7关闭")
+                    );
                     break;
                 }
 
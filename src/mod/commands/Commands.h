@@ -28,6 +28,14 @@ enum CommandCurrencyOperation : int {
     info = 7
 };
 
+enum CommandBulkAdjustOperation : int { airdrop = 1, scale = 2 };
+enum CommandBulkResetOperation : int { resetall = 1, clampall = 2 };
+enum CommandBackupOperation : int { backup = 1 };
+enum CommandRestoreOperation : int { restore = 1 };
+enum CommandArchiveOperation : int { archive = 1 };
+enum CommandRetentionOperation : int { retention = 1 };
+enum CommandVacuumOperation : int { vacuum = 1 };
+
 struct BasicCommand {
     CommandBasicOperation Operation{static_cast<CommandBasicOperation>(0)};
     CommandRawText        Currency{""};  // 可选币种参数
@@ -44,6 +52,37 @@ struct AdminCommand {
     int                   Amount{0};
     CommandRawText        Currency{""};  // 可选币种参数
 };
+struct BulkAdjustCommand {
+    CommandBulkAdjustOperation Operation{static_cast<CommandBulkAdjustOperation>(0)};
+    CommandRawText             Value{""};     // airdrop 为金额，scale 为比例（如 0.95）
+    CommandRawText             Currency{""};  // 可选币种参数
+    CommandRawText             Rounding{""};  // scale 的取整方式：floor（默认）或 ceil
+};
+struct BulkResetCommand {
+    CommandBulkResetOperation Operation{static_cast<CommandBulkResetOperation>(0)};
+    CommandRawText            Currency{""};  // 可选币种参数
+};
+struct BackupCommand {
+    CommandBackupOperation Operation{static_cast<CommandBackupOperation>(0)};
+    CommandRawText         Action{""};  // 为空时开始备份，status 查看进度，cancel 取消
+};
+struct RestoreCommand {
+    CommandRestoreOperation Operation{static_cast<CommandRestoreOperation>(0)};
+    CommandRawText          Backup{""}; // 备份文件名（位于备份目录）或完整路径
+    CommandRawText          Until{""};  // 目标时间点（Unix 时间戳，秒）
+    CommandRawText          Skip{""};   // 跳过条件，逗号分隔：xuid:<XUID> 或 transfer:<转账ID>
+};
+struct ArchiveCommand {
+    CommandArchiveOperation Operation{static_cast<CommandArchiveOperation>(0)};
+    int                     Days{0};  // 热表中保留的天数
+};
+struct RetentionCommand {
+    CommandRetentionOperation Operation{static_cast<CommandRetentionOperation>(0)};
+    CommandRawText            Action{""};  // 保留天数时开始清理，status 查看进度，cancel 取消
+};
+struct VacuumCommand {
+    CommandVacuumOperation Operation{static_cast<CommandVacuumOperation>(0)};
+};
 struct CurrencyCommand {
     CommandCurrencyOperation Operation{static_cast<CommandCurrencyOperation>(0)};
     CommandRawText           CurrencyId{""};
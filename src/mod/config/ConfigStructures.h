@@ -27,7 +27,32 @@ void from_json(const nlohmann::json& j, ModConfig& config);
 
 /// @brief 数据库配置结构
 struct DatabaseConfig {
-    std::string path = "plugins/RLXModeResources/data/money/money.db";
+    std::string backend               = "sqlite"; // 存储后端：sqlite、memory（纯内存，不持久化）或 ledger（追加式账本）
+    std::string path                  = "plugins/RLXModeResources/data/money/money.db";
+    std::string journalMode           = "DELETE"; // 日志模式：DELETE 或 WAL
+    std::string synchronous           = "NORMAL"; // 同步级别：OFF、NORMAL、FULL 或 EXTRA
+    int         pageSize              = 0;        // 新建数据库的页大小（字节，0 表示使用 SQLite 默认值）
+    int         cacheSizeKB           = 0;        // 每个连接的页缓存大小（KB，0 表示按数据库大小与内存预算自动计算）
+    int         memoryBudgetMB        = 128;      // 自动计算页缓存时所有连接合计的内存预算（MB）
+    int         mmapSizeMB            = 256;      // 内存映射读取的最大字节数（MB，0 表示不使用内存映射）
+    int         busyTimeoutMs         = 0;        // 数据库被其他连接锁定时的等待时间（毫秒）
+    int         softHeapLimitMB       = 0;        // SQLite 堆内存软上限（MB，0 表示不限制，对整个进程生效）
+    int         walAutocheckpoint     = 1000;     // WAL 文件达到该页数时自动执行检查点（0 表示不自动执行）
+    int         readPoolSize          = 2;        // WAL 模式下只读连接数量（0 表示不使用只读连接池）
+    bool        asyncWriter           = false;    // 是否由独立写线程提交写事务
+    bool        groupCommit           = false;    // 是否把同一 tick 内的写事务合并为一次提交
+    int         groupCommitWindowMs   = 0;        // 组提交最长时间窗口（毫秒，0 表示仅在 tick 结束时提交）
+    std::string backupDir;                        // 在线备份目录（为空时使用数据库所在目录下的 backups）
+    int         backupPagesPerTick    = 256;      // 在线备份每个 tick 复制的页数
+    int         backupKeep            = 7;        // 保留的备份文件数量
+    int         backupIntervalMinutes = 0;        // 定时备份间隔（分钟，0 表示只在执行命令时备份）
+    std::string archiveDir;                       // 交易记录归档目录（为空时使用数据库所在目录下的 archive）
+    int         retentionDays         = 0;        // 交易记录保留天数（0 表示不自动清理）
+    int         retentionBatchSize    = 500;      // 清理任务每批删除的记录数
+    int         retentionBudgetMs     = 5;        // 清理任务每个 tick 的时间预算（毫秒）
+    int         vacuumPagesPerTick    = 64;       // 空闲 tick 归还给文件系统的页数（0 表示不整理）
+    int         ledgerSegmentKB       = 4096;     // 账本后端单个分段文件的大小（KB），写满后封存并切换到新分段
+    int         ledgerCompactSegments = 8;        // 账本后端同一层级的已封存分段达到该数量时在后台合并
 
     /// @brief 验证数据库配置
     void validate() const;
@@ -48,6 +73,7 @@ struct Currency {
     int  transferFee         = 0;
     double feePercentage       = 0.0;
     bool   allowPlayerTransfer = true;
+    bool   writeBehind         = false; // 写后模式：余额在内存中维护并定期刷新到数据库，交易先写入本地重做日志
 
     Currency() : enabled(true) {
         // maxBalance 默认为 0，表示无限制（内部使用 INT_MAX 表示）
@@ -63,7 +89,9 @@ struct Currency {
 struct ModConfig {
     DatabaseConfig                  database;
     std::string                     defaultCurrency = "gold";
-    std::map<std::string, Currency> currencies; // 币种ID -> 币种
+    std::map<std::string, Currency> currencies;                // 币种ID -> 币种
+    int                             balanceCacheKB     = 1024; // 在线玩家余额缓存的内存预算（KB，0 表示禁用缓存）
+    int                             writeBehindFlushMs = 5000; // 写后币种刷新到数据库的间隔（毫秒，0 表示每 tick）
 
     /// @brief 默认构造函数：创建默认金币配置
     ModConfig() {
@@ -94,16 +122,216 @@ using MoneyConfigData = ModConfig;
 
 /// @brief DatabaseConfig 的自定义序列化（带类型验证）
 inline void to_json(nlohmann::json& j, const DatabaseConfig& db) {
+    j["backend"] = db.backend;
     j["path"] = db.path;
+    j["journalMode"] = db.journalMode;
+    j["synchronous"] = db.synchronous;
+    j["pageSize"] = db.pageSize;
+    j["cacheSizeKB"] = db.cacheSizeKB;
+    j["memoryBudgetMB"] = db.memoryBudgetMB;
+    j["mmapSizeMB"] = db.mmapSizeMB;
+    j["busyTimeoutMs"] = db.busyTimeoutMs;
+    j["softHeapLimitMB"] = db.softHeapLimitMB;
+    j["walAutocheckpoint"] = db.walAutocheckpoint;
+    j["readPoolSize"] = db.readPoolSize;
+    j["asyncWriter"] = db.asyncWriter;
+    j["groupCommit"] = db.groupCommit;
+    j["groupCommitWindowMs"] = db.groupCommitWindowMs;
+    j["backupDir"] = db.backupDir;
+    j["backupPagesPerTick"] = db.backupPagesPerTick;
+    j["backupKeep"] = db.backupKeep;
+    j["backupIntervalMinutes"] = db.backupIntervalMinutes;
+    j["archiveDir"] = db.archiveDir;
+    j["retentionDays"] = db.retentionDays;
+    j["retentionBatchSize"] = db.retentionBatchSize;
+    j["retentionBudgetMs"] = db.retentionBudgetMs;
+    j["vacuumPagesPerTick"] = db.vacuumPagesPerTick;
+    j["ledgerSegmentKB"] = db.ledgerSegmentKB;
+    j["ledgerCompactSegments"] = db.ledgerCompactSegments;
 }
 
 inline void from_json(const nlohmann::json& j, DatabaseConfig& db) {
+    if (j.contains("backend")) {
+        if (!j["backend"].is_string()) {
+            throw std::invalid_argument("database.backend 必须是字符串类型");
+        }
+        j.at("backend").get_to(db.backend);
+    }
+
     if (j.contains("path")) {
         if (!j["path"].is_string()) {
             throw std::invalid_argument("database.path 必须是字符串类型");
         }
         j.at("path").get_to(db.path);
     }
+
+    if (j.contains("journalMode")) {
+        if (!j["journalMode"].is_string()) {
+            throw std::invalid_argument("database.journalMode 必须是字符串类型");
+        }
+        j.at("journalMode").get_to(db.journalMode);
+    }
+
+    if (j.contains("synchronous")) {
+        if (!j["synchronous"].is_string()) {
+            throw std::invalid_argument("database.synchronous 必须是字符串类型");
+        }
+        j.at("synchronous").get_to(db.synchronous);
+    }
+
+    if (j.contains("pageSize")) {
+        if (!j["pageSize"].is_number_integer()) {
+            throw std::invalid_argument("database.pageSize 必须是整数类型");
+        }
+        j.at("pageSize").get_to(db.pageSize);
+    }
+
+    if (j.contains("cacheSizeKB")) {
+        if (!j["cacheSizeKB"].is_number_integer()) {
+            throw std::invalid_argument("database.cacheSizeKB 必须是整数类型");
+        }
+        j.at("cacheSizeKB").get_to(db.cacheSizeKB);
+    }
+
+    if (j.contains("memoryBudgetMB")) {
+        if (!j["memoryBudgetMB"].is_number_integer()) {
+            throw std::invalid_argument("database.memoryBudgetMB 必须是整数类型");
+        }
+        j.at("memoryBudgetMB").get_to(db.memoryBudgetMB);
+    }
+
+    if (j.contains("mmapSizeMB")) {
+        if (!j["mmapSizeMB"].is_number_integer()) {
+            throw std::invalid_argument("database.mmapSizeMB 必须是整数类型");
+        }
+        j.at("mmapSizeMB").get_to(db.mmapSizeMB);
+    }
+
+    if (j.contains("busyTimeoutMs")) {
+        if (!j["busyTimeoutMs"].is_number_integer()) {
+            throw std::invalid_argument("database.busyTimeoutMs 必须是整数类型");
+        }
+        j.at("busyTimeoutMs").get_to(db.busyTimeoutMs);
+    }
+
+    if (j.contains("softHeapLimitMB")) {
+        if (!j["softHeapLimitMB"].is_number_integer()) {
+            throw std::invalid_argument("database.softHeapLimitMB 必须是整数类型");
+        }
+        j.at("softHeapLimitMB").get_to(db.softHeapLimitMB);
+    }
+
+    if (j.contains("walAutocheckpoint")) {
+        if (!j["walAutocheckpoint"].is_number_integer()) {
+            throw std::invalid_argument("database.walAutocheckpoint 必须是整数类型");
+        }
+        j.at("walAutocheckpoint").get_to(db.walAutocheckpoint);
+    }
+
+    if (j.contains("readPoolSize")) {
+        if (!j["readPoolSize"].is_number_integer()) {
+            throw std::invalid_argument("database.readPoolSize 必须是整数类型");
+        }
+        j.at("readPoolSize").get_to(db.readPoolSize);
+    }
+
+    if (j.contains("asyncWriter")) {
+        if (!j["asyncWriter"].is_boolean()) {
+            throw std::invalid_argument("database.asyncWriter 必须是布尔类型");
+        }
+        j.at("asyncWriter").get_to(db.asyncWriter);
+    }
+
+    if (j.contains("groupCommit")) {
+        if (!j["groupCommit"].is_boolean()) {
+            throw std::invalid_argument("database.groupCommit 必须是布尔类型");
+        }
+        j.at("groupCommit").get_to(db.groupCommit);
+    }
+
+    if (j.contains("groupCommitWindowMs")) {
+        if (!j["groupCommitWindowMs"].is_number_integer()) {
+            throw std::invalid_argument("database.groupCommitWindowMs 必须是整数类型");
+        }
+        j.at("groupCommitWindowMs").get_to(db.groupCommitWindowMs);
+    }
+
+    if (j.contains("backupDir")) {
+        if (!j["backupDir"].is_string()) {
+            throw std::invalid_argument("database.backupDir 必须是字符串类型");
+        }
+        j.at("backupDir").get_to(db.backupDir);
+    }
+
+    if (j.contains("backupPagesPerTick")) {
+        if (!j["backupPagesPerTick"].is_number_integer()) {
+            throw std::invalid_argument("database.backupPagesPerTick 必须是整数类型");
+        }
+        j.at("backupPagesPerTick").get_to(db.backupPagesPerTick);
+    }
+
+    if (j.contains("backupKeep")) {
+        if (!j["backupKeep"].is_number_integer()) {
+            throw std::invalid_argument("database.backupKeep 必须是整数类型");
+        }
+        j.at("backupKeep").get_to(db.backupKeep);
+    }
+
+    if (j.contains("backupIntervalMinutes")) {
+        if (!j["backupIntervalMinutes"].is_number_integer()) {
+            throw std::invalid_argument("database.backupIntervalMinutes 必须是整数类型");
+        }
+        j.at("backupIntervalMinutes").get_to(db.backupIntervalMinutes);
+    }
+
+    if (j.contains("archiveDir")) {
+        if (!j["archiveDir"].is_string()) {
+            throw std::invalid_argument("database.archiveDir 必须是字符串类型");
+        }
+        j.at("archiveDir").get_to(db.archiveDir);
+    }
+
+    if (j.contains("retentionDays")) {
+        if (!j["retentionDays"].is_number_integer()) {
+            throw std::invalid_argument("database.retentionDays 必须是整数类型");
+        }
+        j.at("retentionDays").get_to(db.retentionDays);
+    }
+
+    if (j.contains("retentionBatchSize")) {
+        if (!j["retentionBatchSize"].is_number_integer()) {
+            throw std::invalid_argument("database.retentionBatchSize 必须是整数类型");
+        }
+        j.at("retentionBatchSize").get_to(db.retentionBatchSize);
+    }
+
+    if (j.contains("retentionBudgetMs")) {
+        if (!j["retentionBudgetMs"].is_number_integer()) {
+            throw std::invalid_argument("database.retentionBudgetMs 必须是整数类型");
+        }
+        j.at("retentionBudgetMs").get_to(db.retentionBudgetMs);
+    }
+
+    if (j.contains("vacuumPagesPerTick")) {
+        if (!j["vacuumPagesPerTick"].is_number_integer()) {
+            throw std::invalid_argument("database.vacuumPagesPerTick 必须是整数类型");
+        }
+        j.at("vacuumPagesPerTick").get_to(db.vacuumPagesPerTick);
+    }
+
+    if (j.contains("ledgerSegmentKB")) {
+        if (!j["ledgerSegmentKB"].is_number_integer()) {
+            throw std::invalid_argument("database.ledgerSegmentKB 必须是整数类型");
+        }
+        j.at("ledgerSegmentKB").get_to(db.ledgerSegmentKB);
+    }
+
+    if (j.contains("ledgerCompactSegments")) {
+        if (!j["ledgerCompactSegments"].is_number_integer()) {
+            throw std::invalid_argument("database.ledgerCompactSegments 必须是整数类型");
+        }
+        j.at("ledgerCompactSegments").get_to(db.ledgerCompactSegments);
+    }
 }
 
 /// @brief Currency 的自定义序列化（处理 maxBalance=0 表示无限制）
@@ -118,6 +346,7 @@ inline void to_json(nlohmann::json& j, const Currency& c) {
     j["transferFee"] = c.transferFee;
     j["feePercentage"] = c.feePercentage;
     j["allowPlayerTransfer"] = c.allowPlayerTransfer;
+    j["writeBehind"] = c.writeBehind;
 }
 
 /// @brief Currency 的自定义反序列化（处理 maxBalance=0 表示无限制）
@@ -209,6 +438,13 @@ inline void from_json(const nlohmann::json& j, Currency& c) {
         }
         j.at("allowPlayerTransfer").get_to(c.allowPlayerTransfer);
     }
+
+    if (j.contains("writeBehind")) {
+        if (!j["writeBehind"].is_boolean()) {
+            throw std::invalid_argument("writeBehind 必须是布尔类型");
+        }
+        j.at("writeBehind").get_to(c.writeBehind);
+    }
 }
 
 /// @brief ModConfig 的自定义序列化（带类型验证）
@@ -216,6 +452,8 @@ inline void to_json(nlohmann::json& j, const ModConfig& config) {
     j["database"] = config.database;
     j["defaultCurrency"] = config.defaultCurrency;
     j["currencies"] = config.currencies;
+    j["balanceCacheKB"] = config.balanceCacheKB;
+    j["writeBehindFlushMs"] = config.writeBehindFlushMs;
 }
 
 inline void from_json(const nlohmann::json& j, ModConfig& config) {
@@ -248,14 +486,95 @@ inline void from_json(const nlohmann::json& j, ModConfig& config) {
             config.currencies[currencyId] = currency;
         }
     }
+
+    if (j.contains("balanceCacheKB")) {
+        if (!j["balanceCacheKB"].is_number_integer()) {
+            throw std::invalid_argument("balanceCacheKB 必须是整数类型");
+        }
+        j.at("balanceCacheKB").get_to(config.balanceCacheKB);
+    }
+
+    if (j.contains("writeBehindFlushMs")) {
+        if (!j["writeBehindFlushMs"].is_number_integer()) {
+            throw std::invalid_argument("writeBehindFlushMs 必须是整数类型");
+        }
+        j.at("writeBehindFlushMs").get_to(config.writeBehindFlushMs);
+    }
 }
 
 // ==================== Validate 方法实现 ====================
 
 inline void DatabaseConfig::validate() const {
+    if (backend != "sqlite" && backend != "memory" && backend != "ledger") {
+        throw std::invalid_argument("database.backend 必须是 sqlite、memory 或 ledger");
+    }
     if (path.empty()) {
         throw std::invalid_argument("database.path 不能为空");
     }
+    if (journalMode != "DELETE" && journalMode != "WAL") {
+        throw std::invalid_argument("database.journalMode 必须是 DELETE 或 WAL");
+    }
+    if (synchronous != "OFF" && synchronous != "NORMAL" && synchronous != "FULL" && synchronous != "EXTRA") {
+        throw std::invalid_argument("database.synchronous 必须是 OFF、NORMAL、FULL 或 EXTRA");
+    }
+    if (pageSize != 0 && (pageSize < 512 || pageSize > 65536 || (pageSize & (pageSize - 1)) != 0)) {
+        throw std::invalid_argument("database.pageSize 必须为 0 或 512 到 65536 之间的 2 的幂");
+    }
+    if (cacheSizeKB < 0 || cacheSizeKB > 16 * 1024 * 1024) {
+        throw std::invalid_argument("database.cacheSizeKB 必须在 0 到 16777216 之间");
+    }
+    if (memoryBudgetMB < 1 || memoryBudgetMB > 1024 * 1024) {
+        throw std::invalid_argument("database.memoryBudgetMB 必须在 1 到 1048576 之间");
+    }
+    if (mmapSizeMB < 0 || mmapSizeMB > 1024 * 1024) {
+        throw std::invalid_argument("database.mmapSizeMB 必须在 0 到 1048576 之间");
+    }
+    if (busyTimeoutMs < 0 || busyTimeoutMs > 60000) {
+        throw std::invalid_argument("database.busyTimeoutMs 必须在 0 到 60000 之间");
+    }
+    if (softHeapLimitMB < 0 || softHeapLimitMB > 1024 * 1024) {
+        throw std::invalid_argument("database.softHeapLimitMB 必须在 0 到 1048576 之间");
+    }
+    if (walAutocheckpoint < 0 || walAutocheckpoint > 1000000) {
+        throw std::invalid_argument("database.walAutocheckpoint 必须在 0 到 1000000 之间");
+    }
+    if (readPoolSize < 0 || readPoolSize > 16) {
+        throw std::invalid_argument("database.readPoolSize 必须在 0 到 16 之间");
+    }
+    if (groupCommitWindowMs < 0 || groupCommitWindowMs > 10000) {
+        throw std::invalid_argument("database.groupCommitWindowMs 必须在 0 到 10000 之间");
+    }
+    if (backupPagesPerTick < 1 || backupPagesPerTick > 65536) {
+        throw std::invalid_argument("database.backupPagesPerTick 必须在 1 到 65536 之间");
+    }
+    if (backupKeep < 1 || backupKeep > 1000) {
+        throw std::invalid_argument("database.backupKeep 必须在 1 到 1000 之间");
+    }
+    if (backupIntervalMinutes < 0 || backupIntervalMinutes > 525600) {
+        throw std::invalid_argument("database.backupIntervalMinutes 必须在 0 到 525600 之间");
+    }
+    if (!archiveDir.empty() && archiveDir == backupDir) {
+        // 清理旧备份时会删除目录中按数据库文件名命名的文件
+        throw std::invalid_argument("database.archiveDir 不能与 database.backupDir 相同");
+    }
+    if (retentionDays < 0 || retentionDays > 36500) {
+        throw std::invalid_argument("database.retentionDays 必须在 0 到 36500 之间");
+    }
+    if (retentionBatchSize < 1 || retentionBatchSize > 100000) {
+        throw std::invalid_argument("database.retentionBatchSize 必须在 1 到 100000 之间");
+    }
+    if (retentionBudgetMs < 1 || retentionBudgetMs > 1000) {
+        throw std::invalid_argument("database.retentionBudgetMs 必须在 1 到 1000 之间");
+    }
+    if (vacuumPagesPerTick < 0 || vacuumPagesPerTick > 65536) {
+        throw std::invalid_argument("database.vacuumPagesPerTick 必须在 0 到 65536 之间");
+    }
+    if (ledgerSegmentKB < 4 || ledgerSegmentKB > 1024 * 1024) {
+        throw std::invalid_argument("database.ledgerSegmentKB 必须在 4 到 1048576 之间");
+    }
+    if (ledgerCompactSegments < 2 || ledgerCompactSegments > 64) {
+        throw std::invalid_argument("database.ledgerCompactSegments 必须在 2 到 64 之间");
+    }
 }
 
 inline void Currency::validate() const {
@@ -284,6 +603,13 @@ inline void ModConfig::validate() const {
         throw std::invalid_argument("默认币种 '" + defaultCurrency + "' 在 currencies 中不存在");
     }
 
+    if (balanceCacheKB < 0 || balanceCacheKB > 1048576) {
+        throw std::invalid_argument("balanceCacheKB 必须在 0 到 1048576 之间");
+    }
+    if (writeBehindFlushMs < 0 || writeBehindFlushMs > 600000) {
+        throw std::invalid_argument("writeBehindFlushMs 必须在 0 到 600000 之间");
+    }
+
     // 验证每个币种
     for (const auto& [currencyId, currency] : currencies) {
         currency.validate();
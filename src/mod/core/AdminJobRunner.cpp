@@ -0,0 +1,59 @@
+#include "mod/core/AdminJobRunner.h"
+
+
+namespace rlx_money {
+
+AdminJobRunner& AdminJobRunner::getInstance() {
+    static AdminJobRunner instance;
+    return instance;
+}
+
+AdminJobRunner::~AdminJobRunner() { shutdown(); }
+
+bool AdminJobRunner::start(std::string name, Job job) {
+    std::lock_guard lock(mMutex);
+    if (mRunningJob || mStopping) {
+        return false;
+    }
+    // 上一个任务已经结束，回收其线程
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+
+    mRunningJob = std::move(name);
+    mThread     = std::jthread([this, job = std::move(job)](std::stop_token stopToken) {
+        // 任务自行处理并记录异常，这里只保证线程结束时清除运行标记
+        try {
+            job(stopToken);
+        } catch (...) {
+        }
+        std::lock_guard lock(mMutex);
+        mRunningJob.reset();
+    });
+    return true;
+}
+
+std::optional<std::string> AdminJobRunner::getRunningJob() const {
+    std::lock_guard lock(mMutex);
+    return mRunningJob;
+}
+
+void AdminJobRunner::shutdown() {
+    std::jthread thread;
+    {
+        std::lock_guard lock(mMutex);
+        thread    = std::move(mThread);
+        mStopping = thread.joinable();
+    }
+    if (!thread.joinable()) {
+        return;
+    }
+    // 任务线程结束前需要取得 mMutex 清除运行标记，因此在锁外等待
+    thread.request_stop();
+    thread.join();
+
+    std::lock_guard lock(mMutex);
+    mStopping = false;
+}
+
+} // namespace rlx_money
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <thread>
+
+
+namespace rlx_money {
+
+/// @brief 管理员长任务（恢复、归档、整理数据库）的专用后台线程
+/// @note 这些任务可能持续数分钟，不放到 AsyncExecutor 的分片线程上，避免阻塞同一分片的异步 API 调用；
+///       同一时间只运行一个任务，卸载插件时请求停止并等待任务在下一个检查点退出
+class AdminJobRunner {
+public:
+    /// @brief 任务函数，需定期检查停止请求
+    using Job = std::function<void(std::stop_token stopToken)>;
+
+    /// @brief 获取单例实例
+    /// @return 任务线程实例
+    static AdminJobRunner& getInstance();
+
+    /// @brief 在专用线程上启动任务
+    /// @param name 任务名称（用于提示正在运行的任务）
+    /// @param job 任务函数
+    /// @return 是否启动；已有任务在运行或正在停止时返回 false
+    bool start(std::string name, Job job);
+
+    /// @brief 获取正在运行的任务名称
+    /// @return 任务名称；没有任务在运行时返回空
+    [[nodiscard]] std::optional<std::string> getRunningJob() const;
+
+    /// @brief 请求正在运行的任务停止并等待其退出（之后仍可启动新任务）
+    void shutdown();
+
+    AdminJobRunner(const AdminJobRunner&)            = delete;
+    AdminJobRunner& operator=(const AdminJobRunner&) = delete;
+
+private:
+    AdminJobRunner() = default;
+    ~AdminJobRunner();
+
+    mutable std::mutex         mMutex;
+    std::jthread               mThread;           // 任务线程（任务结束后保留到下次启动或停止时回收）
+    std::optional<std::string> mRunningJob;       // 正在运行的任务名称
+    bool                       mStopping = false; // 是否正在等待任务停止
+};
+
+} // namespace rlx_money
@@ -0,0 +1,148 @@
+#include "mod/core/AsyncExecutor.h"
+#include <algorithm>
+
+
+namespace rlx_money {
+
+namespace {
+
+/// @brief 工作线程数量上限
+constexpr size_t kMaxWorkers = 4;
+
+/// @brief 跨分片任务的汇合点：最后一个到达的分片执行任务，其余分片等待任务完成
+struct Rendezvous {
+    std::mutex              mutex;
+    std::condition_variable done;
+    size_t                  remaining;
+    bool                    finished = false;
+    std::function<void()>   task;
+};
+
+} // namespace
+
+AsyncExecutor& AsyncExecutor::getInstance() {
+    static AsyncExecutor instance;
+    return instance;
+}
+
+AsyncExecutor::~AsyncExecutor() { shutdown(); }
+
+void AsyncExecutor::submit(const std::vector<std::string>& keys, std::function<void()> task) {
+    std::lock_guard lock(mSubmitMutex);
+    if (mWorkers.empty()) {
+        start();
+    }
+
+    // 计算任务涉及的分片（去重）
+    std::vector<size_t> shards;
+    for (const auto& key : keys) {
+        shards.push_back(std::hash<std::string>{}(key) % mWorkers.size());
+    }
+    std::sort(shards.begin(), shards.end());
+    shards.erase(std::unique(shards.begin(), shards.end()), shards.end());
+
+    if (shards.empty()) {
+        enqueue(*mWorkers[mNextWorker.fetch_add(1, std::memory_order_relaxed) % mWorkers.size()], std::move(task));
+        return;
+    }
+    if (shards.size() == 1) {
+        enqueue(*mWorkers[shards.front()], std::move(task));
+        return;
+    }
+
+    // 在每个分片放入汇合任务，保证任务在所有相关分片之前的任务都完成后才执行
+    auto rendezvous       = std::make_shared<Rendezvous>();
+    rendezvous->remaining = shards.size();
+    rendezvous->task      = std::move(task);
+    for (size_t shard : shards) {
+        enqueue(*mWorkers[shard], [rendezvous]() {
+            std::unique_lock rendezvousLock(rendezvous->mutex);
+            if (--rendezvous->remaining == 0) {
+                rendezvousLock.unlock();
+                rendezvous->task();
+                rendezvousLock.lock();
+                rendezvous->finished = true;
+                rendezvous->done.notify_all();
+                return;
+            }
+            rendezvous->done.wait(rendezvousLock, [&] { return rendezvous->finished; });
+        });
+    }
+}
+
+size_t AsyncExecutor::runMainThreadTasks() {
+    std::vector<std::coroutine_handle<>> ready;
+    {
+        std::lock_guard lock(mMainThreadMutex);
+        ready.swap(mMainThreadQueue);
+    }
+    for (auto handle : ready) {
+        handle.resume();
+    }
+    return ready.size();
+}
+
+void AsyncExecutor::shutdown() {
+    std::lock_guard lock(mSubmitMutex);
+    for (auto& worker : mWorkers) {
+        {
+            std::lock_guard workerLock(worker->mutex);
+            worker->stop = true;
+        }
+        worker->signal.notify_one();
+    }
+    for (auto& worker : mWorkers) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+    mWorkers.clear();
+}
+
+size_t AsyncExecutor::getWorkerCount() const {
+    std::lock_guard lock(mSubmitMutex);
+    return mWorkers.size();
+}
+
+void AsyncExecutor::dispatchToMainThread(std::coroutine_handle<> handle) {
+    auto&           executor = getInstance();
+    std::lock_guard lock(executor.mMainThreadMutex);
+    executor.mMainThreadQueue.push_back(handle);
+}
+
+void AsyncExecutor::start() {
+    size_t count = std::clamp<size_t>(std::thread::hardware_concurrency() / 2, 1, kMaxWorkers);
+    for (size_t i = 0; i < count; ++i) {
+        mWorkers.push_back(std::make_unique<Worker>());
+    }
+    for (auto& worker : mWorkers) {
+        worker->thread = std::thread([&worker = *worker]() { workerLoop(worker); });
+    }
+}
+
+void AsyncExecutor::enqueue(Worker& worker, std::function<void()> task) {
+    {
+        std::lock_guard lock(worker.mutex);
+        worker.queue.push_back(std::move(task));
+    }
+    worker.signal.notify_one();
+}
+
+void AsyncExecutor::workerLoop(Worker& worker) {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(worker.mutex);
+            worker.signal.wait(lock, [&] { return worker.stop || !worker.queue.empty(); });
+            // 停止前先执行完队列中剩余的任务
+            if (worker.queue.empty()) {
+                return;
+            }
+            task = std::move(worker.queue.front());
+            worker.queue.pop_front();
+        }
+        task();
+    }
+}
+
+} // namespace rlx_money
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <RLXMoney/api/AsyncResult.h>
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace rlx_money {
+
+/// @brief 异步 API 的后台执行器
+/// @note 任务按涉及的玩家 XUID 分片到固定的工作线程，同一玩家的任务严格按提交顺序执行，
+///       因此异步写入之后提交的异步读取一定能读到该写入；不涉及玩家的任务轮询分配。
+///       涉及多个分片的任务（如转账）会等待所有相关分片执行完之前的任务后再执行
+class AsyncExecutor {
+public:
+    /// @brief 获取单例实例
+    /// @return 执行器实例
+    static AsyncExecutor& getInstance();
+
+    /// @brief 提交任务
+    /// @param keys 任务涉及的玩家XUID（可为空）
+    /// @param task 任务函数（在工作线程上执行）
+    void submit(const std::vector<std::string>& keys, std::function<void()> task);
+
+    /// @brief 提交带返回值的任务
+    /// @param keys 任务涉及的玩家XUID（可为空）
+    /// @param fn 任务函数（在工作线程上执行）
+    /// @return 异步操作句柄
+    template <typename T, typename Fn>
+    AsyncResult<T> run(const std::vector<std::string>& keys, Fn fn) {
+        auto state = std::make_shared<detail::AsyncState<T>>(&AsyncExecutor::dispatchToMainThread);
+        submit(keys, [state, fn = std::move(fn)]() mutable {
+            if (!state->tryStart()) {
+                return; // 已取消
+            }
+            try {
+                state->setValue(fn());
+            } catch (...) {
+                state->setException(std::current_exception());
+            }
+        });
+        return AsyncResult<T>(std::move(state));
+    }
+
+    /// @brief 在游戏线程上恢复已完成操作的等待协程（每 tick 调用）
+    /// @return 恢复的协程数量
+    size_t runMainThreadTasks();
+
+    /// @brief 执行完已提交的任务后停止工作线程（再次提交任务时会重新启动）
+    void shutdown();
+
+    /// @brief 获取工作线程数量
+    /// @return 工作线程数量（未启动时为 0）
+    [[nodiscard]] size_t getWorkerCount() const;
+
+    AsyncExecutor(const AsyncExecutor&)            = delete;
+    AsyncExecutor& operator=(const AsyncExecutor&) = delete;
+
+private:
+    AsyncExecutor() = default;
+    ~AsyncExecutor();
+
+    /// @brief 工作线程（每个线程对应一个分片，拥有独立的任务队列）
+    struct Worker {
+        std::thread                       thread;
+        std::mutex                        mutex;
+        std::condition_variable           signal;
+        std::deque<std::function<void()>> queue;
+        bool                              stop = false;
+    };
+
+    /// @brief 把协程恢复动作放入游戏线程队列
+    /// @param handle 等待中的协程
+    static void dispatchToMainThread(std::coroutine_handle<> handle);
+
+    /// @brief 启动工作线程（调用方需持有 mSubmitMutex）
+    void start();
+
+    /// @brief 把任务放入指定分片的队列
+    /// @param worker 分片
+    /// @param task 任务函数
+    static void enqueue(Worker& worker, std::function<void()> task);
+
+    /// @brief 工作线程主循环
+    /// @param worker 分片
+    static void workerLoop(Worker& worker);
+
+    mutable std::mutex                   mSubmitMutex; // 保证跨分片任务在各分片队列中的相对顺序一致
+    std::vector<std::unique_ptr<Worker>> mWorkers;
+    std::atomic<size_t>                  mNextWorker{0};
+    std::mutex                           mMainThreadMutex;
+    std::vector<std::coroutine_handle<>> mMainThreadQueue;
+};
+
+} // namespace rlx_money
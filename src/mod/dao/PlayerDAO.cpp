@@ -9,19 +9,17 @@ PlayerDAO::PlayerDAO(DatabaseManager& dbManager) : mDbManager(dbManager) {}
 
 bool PlayerDAO::createPlayer(const PlayerData& playerData) {
     try {
-        auto& db = mDbManager.getConnection();
-
         const char* sql = "INSERT INTO players (xuid, username, first_join_time, created_at, updated_at) "
                           "VALUES (?, ?, ?, ?, ?)";
 
-        SQLite::Statement stmt(db, sql);
-        stmt.bind(1, playerData.xuid);
-        stmt.bind(2, playerData.username);
-        stmt.bind(3, playerData.firstJoinTime);
-        stmt.bind(4, playerData.createdAt);
-        stmt.bind(5, playerData.updatedAt);
+        auto stmt = mDbManager.prepareCached(sql);
+        stmt->bind(1, playerData.xuid);
+        stmt->bind(2, playerData.username);
+        stmt->bind(3, playerData.firstJoinTime);
+        stmt->bind(4, playerData.createdAt);
+        stmt->bind(5, playerData.updatedAt);
 
-        stmt.exec();
+        stmt->exec();
         return true;
 
     } catch (const SQLite::Exception& e) {
@@ -35,15 +33,13 @@ bool PlayerDAO::createPlayer(const PlayerData& playerData) {
 
 std::optional<PlayerData> PlayerDAO::getPlayerByXuid(const std::string& xuid) const {
     try {
-        auto& db = mDbManager.getConnection();
-
         const char* sql = "SELECT xuid, username, first_join_time, created_at, updated_at FROM players WHERE xuid = ?";
 
-        SQLite::Statement stmt(db, sql);
-        stmt.bind(1, xuid);
+        auto stmt = mDbManager.prepareRead(sql);
+        stmt->bind(1, xuid);
 
-        if (stmt.executeStep()) {
-            return buildPlayerDataFromStatement(stmt);
+        if (stmt->executeStep()) {
+            return buildPlayerDataFromStatement(*stmt);
         }
 
         return std::nullopt;
@@ -55,16 +51,14 @@ std::optional<PlayerData> PlayerDAO::getPlayerByXuid(const std::string& xuid) co
 
 std::optional<PlayerData> PlayerDAO::getPlayerByUsername(const std::string& username) const {
     try {
-        auto& db = mDbManager.getConnection();
-
         const char* sql =
             "SELECT xuid, username, first_join_time, created_at, updated_at FROM players WHERE username = ?";
 
-        SQLite::Statement stmt(db, sql);
-        stmt.bind(1, username);
+        auto stmt = mDbManager.prepareRead(sql);
+        stmt->bind(1, username);
 
-        if (stmt.executeStep()) {
-            return buildPlayerDataFromStatement(stmt);
+        if (stmt->executeStep()) {
+            return buildPlayerDataFromStatement(*stmt);
         }
 
         return std::nullopt;
@@ -76,16 +70,16 @@ std::optional<PlayerData> PlayerDAO::getPlayerByUsername(const std::string& user
 
 std::optional<int> PlayerDAO::getBalance(const std::string& xuid, const std::string& currencyId) const {
     try {
-        auto& db = mDbManager.getConnection();
+        const char* sql = "SELECT balance FROM player_balances "
+                          "WHERE account_id = (SELECT id FROM accounts WHERE xuid = ?) "
+                          "AND currency_key = (SELECT id FROM currency_keys WHERE code = ?)";
 
-        const char* sql = "SELECT balance FROM player_balances WHERE xuid = ? AND currency_id = ?";
+        auto stmt = mDbManager.prepareRead(sql);
+        stmt->bind(1, xuid);
+        stmt->bind(2, currencyId);
 
-        SQLite::Statement stmt(db, sql);
-        stmt.bind(1, xuid);
-        stmt.bind(2, currencyId);
-
-        if (stmt.executeStep()) {
-            return stmt.getColumn(0).getInt();
+        if (stmt->executeStep()) {
+            return stmt->getColumn(0).getInt();
         }
 
         return std::nullopt;
@@ -97,23 +91,26 @@ std::optional<int> PlayerDAO::getBalance(const std::string& xuid, const std::str
 
 bool PlayerDAO::updateBalance(const std::string& xuid, const std::string& currencyId, int newBalance) {
     try {
-        auto& db = mDbManager.getConnection();
-
         auto currentTime =
             std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch())
                 .count();
 
-        // 使用 INSERT OR REPLACE 来更新或创建余额记录
-        const char* sql = "INSERT OR REPLACE INTO player_balances (xuid, currency_id, balance, updated_at) "
-                          "VALUES (?, ?, ?, ?)";
+        // 使用 UPSERT 更新或创建余额记录（REPLACE 删除旧行时不触发删除触发器，会使汇总表失真）
+        const char* sql = "INSERT INTO player_balances (account_id, currency_key, balance, updated_at) "
+                          "VALUES (?, ?, ?, ?) "
+                          "ON CONFLICT(account_id, currency_key) DO UPDATE SET balance = excluded.balance, "
+                          "updated_at = excluded.updated_at";
 
-        SQLite::Statement stmt(db, sql);
-        stmt.bind(1, xuid);
-        stmt.bind(2, currencyId);
-        stmt.bind(3, newBalance);
-        stmt.bind(4, currentTime);
+        int64_t accountKey  = mDbManager.resolveAccountKey(xuid);
+        int64_t currencyKey = mDbManager.resolveCurrencyKey(currencyId);
 
-        stmt.exec();
+        auto stmt = mDbManager.prepareCached(sql);
+        stmt->bind(1, accountKey);
+        stmt->bind(2, currencyKey);
+        stmt->bind(3, newBalance);
+        stmt->bind(4, currentTime);
+
+        stmt->exec();
         return true;
 
     } catch (const SQLite::Exception& e) {
@@ -121,22 +118,199 @@ bool PlayerDAO::updateBalance(const std::string& xuid, const std::string& curren
     }
 }
 
-std::vector<PlayerBalance> PlayerDAO::getAllBalances(const std::string& xuid) const {
+std::optional<int> PlayerDAO::applyBalanceDelta(
+    const std::string& xuid,
+    const std::string& currencyId,
+    int64_t            delta,
+    int64_t            minBalance,
+    int64_t            maxBalance,
+    std::optional<int> initialBalance
+) {
+    try {
+        auto currentTime =
+            std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch())
+                .count();
+
+        // 已有记录：由 ON CONFLICT 分支在原值上加 delta，WHERE 不满足时不更新也不返回行
+        // 没有记录：仅当玩家存在、允许创建且初始余额 + delta 在范围内时插入
+        // 候选行的 NOT NULL 约束先于冲突检查，因此未提供初始余额时用 0 占位
+        const char* sql = "INSERT INTO player_balances (account_id, currency_key, balance, updated_at) "
+                          "SELECT ?1, ?2, COALESCE(?3, 0) + ?4, ?7 FROM players "
+                          "WHERE xuid = ?8 AND ("
+                          "  EXISTS (SELECT 1 FROM player_balances WHERE account_id = ?1 AND currency_key = ?2) "
+                          "  OR (?3 IS NOT NULL AND ?3 + ?4 BETWEEN ?5 AND ?6)) "
+                          "ON CONFLICT(account_id, currency_key) DO UPDATE SET balance = balance + ?4, updated_at = ?7 "
+                          "WHERE balance + ?4 BETWEEN ?5 AND ?6 "
+                          "RETURNING balance";
+
+        int64_t accountKey  = mDbManager.resolveAccountKey(xuid);
+        int64_t currencyKey = mDbManager.resolveCurrencyKey(currencyId);
+
+        auto stmt = mDbManager.prepareCached(sql);
+        stmt->bind(1, accountKey);
+        stmt->bind(2, currencyKey);
+        if (initialBalance.has_value()) {
+            stmt->bind(3, initialBalance.value());
+        } else {
+            stmt->bind(3);
+        }
+        stmt->bind(4, delta);
+        stmt->bind(5, minBalance);
+        stmt->bind(6, maxBalance);
+        stmt->bind(7, currentTime);
+        stmt->bind(8, xuid);
+
+        if (!stmt->executeStep()) {
+            return std::nullopt;
+        }
+        return stmt->getColumn(0).getInt();
+
+    } catch (const SQLite::Exception& e) {
+        throw DatabaseException("调整玩家余额失败: " + std::string(e.what()));
+    }
+}
+
+std::optional<int> PlayerDAO::assignBalance(const std::string& xuid, const std::string& currencyId, int balance) {
+    try {
+        auto currentTime =
+            std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch())
+                .count();
+
+        const char* sql = "INSERT INTO player_balances (account_id, currency_key, balance, updated_at) "
+                          "SELECT ?1, ?2, ?3, ?4 FROM players WHERE xuid = ?5 "
+                          "ON CONFLICT(account_id, currency_key) DO UPDATE SET balance = excluded.balance, "
+                          "updated_at = excluded.updated_at "
+                          "RETURNING balance";
+
+        int64_t accountKey  = mDbManager.resolveAccountKey(xuid);
+        int64_t currencyKey = mDbManager.resolveCurrencyKey(currencyId);
+
+        auto stmt = mDbManager.prepareCached(sql);
+        stmt->bind(1, accountKey);
+        stmt->bind(2, currencyKey);
+        stmt->bind(3, balance);
+        stmt->bind(4, currentTime);
+        stmt->bind(5, xuid);
+
+        if (!stmt->executeStep()) {
+            return std::nullopt;
+        }
+        return stmt->getColumn(0).getInt();
+
+    } catch (const SQLite::Exception& e) {
+        throw DatabaseException("设置玩家余额失败: " + std::string(e.what()));
+    }
+}
+
+int64_t PlayerDAO::addToAllBalances(
+    const std::string& currencyId,
+    int                amount,
+    int                maxBalance,
+    const std::string& description
+) {
+    return applyBulkUpdate(currencyId, "MIN(balance + ?4, MAX(balance, ?5))", {amount, maxBalance}, false, description);
+}
+
+int64_t PlayerDAO::scaleAllBalances(
+    const std::string& currencyId,
+    int64_t            rateMicros,
+    bool               roundUp,
+    int                maxBalance,
+    const std::string& description
+) {
+    // 余额非负，整数除法即向下取整；向上取整时先加上 999999
+    return applyBulkUpdate(
+        currencyId,
+        "MIN((balance * ?4 + ?5) / 1000000, MAX(balance, ?6))",
+        {rateMicros, roundUp ? 999999 : 0, maxBalance},
+        false,
+        description
+    );
+}
+
+int64_t PlayerDAO::assignAllBalances(const std::string& currencyId, int balance, const std::string& description) {
+    return applyBulkUpdate(currencyId, "?4", {balance}, true, description);
+}
+
+int64_t PlayerDAO::clampAllBalances(const std::string& currencyId, int maxBalance, const std::string& description) {
+    return applyBulkUpdate(currencyId, "MIN(balance, ?4)", {maxBalance}, true, description);
+}
+
+int64_t PlayerDAO::applyBulkUpdate(
+    const std::string&             currencyId,
+    std::string_view               newBalanceExpr,
+    std::initializer_list<int64_t> params,
+    bool                           recordAsSet,
+    const std::string&             description
+) {
     try {
-        auto& db = mDbManager.getConnection();
+        auto currentTime =
+            std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch())
+                .count();
+        std::string expr(newBalanceExpr);
+
+        // 先根据旧余额写交易记录，再改写余额；两条语句使用同一个表达式，只处理余额实际变化的账户
+        // 交易类型为 TransactionType 的枚举值；记录ID从序号表的当前值起连续分配
+        auto typeValue = [](TransactionType type) { return std::to_string(static_cast<int>(type)); };
+        std::string currencyKey = "(SELECT id FROM currency_keys WHERE code = ?1)";
+        std::string recordSql =
+            "INSERT INTO transactions (id, account_id, currency_key, amount, balance, type, description, timestamp) "
+            "SELECT (SELECT seq FROM transaction_sequence WHERE id = 1) + ROW_NUMBER() OVER (), "
+            "account_id, currency_key, "
+            + std::string(recordAsSet ? "new_balance" : "new_balance - balance") + ", new_balance, "
+            + (recordAsSet ? typeValue(TransactionType::SET)
+                           : "CASE WHEN new_balance > balance THEN " + typeValue(TransactionType::ADD) + " ELSE "
+                                 + typeValue(TransactionType::REDUCE) + " END")
+            + ", ?2, ?3 FROM (SELECT account_id, currency_key, balance, " + expr
+            + " AS new_balance FROM player_balances WHERE currency_key = " + currencyKey
+            + ") WHERE new_balance <> balance";
+        std::string updateSql = "UPDATE player_balances SET balance = " + expr
+                              + ", updated_at = ?3 WHERE currency_key = " + currencyKey + " AND " + expr
+                              + " <> balance";
+
+        auto bindParams = [&](SQLite::Statement& stmt) {
+            int index = 4;
+            for (int64_t param : params) {
+                stmt.bind(index++, param);
+            }
+        };
+
+        {
+            auto stmt = mDbManager.prepareCached(recordSql);
+            stmt->bind(1, currencyId);
+            stmt->bind(2, description);
+            stmt->bind(3, currentTime);
+            bindParams(*stmt);
+            stmt->exec();
+        }
 
-        const char* sql = "SELECT xuid, currency_id, balance, updated_at FROM player_balances WHERE xuid = ?";
+        auto stmt = mDbManager.prepareCached(updateSql);
+        stmt->bind(1, currencyId);
+        stmt->bind(3, currentTime);
+        bindParams(*stmt);
+        return stmt->exec();
 
-        SQLite::Statement stmt(db, sql);
-        stmt.bind(1, xuid);
+    } catch (const SQLite::Exception& e) {
+        throw DatabaseException("批量更新玩家余额失败: " + std::string(e.what()));
+    }
+}
+
+std::vector<PlayerBalance> PlayerDAO::getAllBalances(const std::string& xuid) const {
+    try {
+        const char* sql = "SELECT c.code, pb.balance, pb.updated_at FROM player_balances pb "
+                          "JOIN currency_keys c ON c.id = pb.currency_key "
+                          "WHERE pb.account_id = (SELECT id FROM accounts WHERE xuid = ?)";
+
+        auto stmt = mDbManager.prepareRead(sql);
+        stmt->bind(1, xuid);
 
         std::vector<PlayerBalance> result;
-        while (stmt.executeStep()) {
+        while (stmt->executeStep()) {
             PlayerBalance balance;
-            balance.xuid       = stmt.getColumn(0).getString();
-            balance.currencyId = stmt.getColumn(1).getString();
-            balance.balance    = stmt.getColumn(2).getInt();
-            balance.updatedAt  = stmt.getColumn(3).getInt64();
+            balance.xuid       = xuid;
+            balance.currencyId = stmt->getColumn(0).getString();
+            balance.balance    = stmt->getColumn(1).getInt();
+            balance.updatedAt  = stmt->getColumn(2).getInt64();
             result.push_back(balance);
         }
 
@@ -149,8 +323,6 @@ std::vector<PlayerBalance> PlayerDAO::getAllBalances(const std::string& xuid) co
 
 bool PlayerDAO::initializeBalance(const std::string& xuid, const std::string& currencyId, int initialBalance) {
     try {
-        auto& db = mDbManager.getConnection();
-
         // 检查是否已存在
         auto existing = getBalance(xuid, currencyId);
         if (existing.has_value()) {
@@ -162,15 +334,19 @@ bool PlayerDAO::initializeBalance(const std::string& xuid, const std::string& cu
             std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch())
                 .count();
 
-        const char* sql = "INSERT INTO player_balances (xuid, currency_id, balance, updated_at) VALUES (?, ?, ?, ?)";
+        const char* sql =
+            "INSERT INTO player_balances (account_id, currency_key, balance, updated_at) VALUES (?, ?, ?, ?)";
+
+        int64_t accountKey  = mDbManager.resolveAccountKey(xuid);
+        int64_t currencyKey = mDbManager.resolveCurrencyKey(currencyId);
 
-        SQLite::Statement stmt(db, sql);
-        stmt.bind(1, xuid);
-        stmt.bind(2, currencyId);
-        stmt.bind(3, initialBalance);
-        stmt.bind(4, currentTime);
+        auto stmt = mDbManager.prepareCached(sql);
+        stmt->bind(1, accountKey);
+        stmt->bind(2, currencyKey);
+        stmt->bind(3, initialBalance);
+        stmt->bind(4, currentTime);
 
-        stmt.exec();
+        stmt->exec();
         return true;
 
     } catch (const SQLite::Exception& e) {
@@ -180,21 +356,19 @@ bool PlayerDAO::initializeBalance(const std::string& xuid, const std::string& cu
 
 bool PlayerDAO::updateUsername(const std::string& xuid, const std::string& newUsername) {
     try {
-        auto& db = mDbManager.getConnection();
-
         const char* sql = "UPDATE players SET username = ?, updated_at = ? WHERE xuid = ?";
 
         auto currentTime =
             std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch())
                 .count();
 
-        SQLite::Statement stmt(db, sql);
-        stmt.bind(1, newUsername);
-        stmt.bind(2, currentTime);
-        stmt.bind(3, xuid);
+        auto stmt = mDbManager.prepareCached(sql);
+        stmt->bind(1, newUsername);
+        stmt->bind(2, currentTime);
+        stmt->bind(3, xuid);
 
-        stmt.exec();
-        return stmt.getChanges() > 0;
+        stmt->exec();
+        return stmt->getChanges() > 0;
 
     } catch (const SQLite::Exception& e) {
         throw DatabaseException("更新玩家用户名失败: " + std::string(e.what()));
@@ -207,26 +381,25 @@ std::vector<TopBalanceEntry> PlayerDAO::getTopBalanceList(const std::string& cur
     }
 
     try {
-        auto& db = mDbManager.getConnection();
-
-        const char* sql = "SELECT p.username, pb.xuid, pb.currency_id, pb.balance "
+        const char* sql = "SELECT p.username, a.xuid, pb.balance "
                           "FROM player_balances pb "
-                          "INNER JOIN players p ON pb.xuid = p.xuid "
-                          "WHERE pb.currency_id = ? "
+                          "INNER JOIN accounts a ON a.id = pb.account_id "
+                          "INNER JOIN players p ON p.xuid = a.xuid "
+                          "WHERE pb.currency_key = (SELECT id FROM currency_keys WHERE code = ?) "
                           "ORDER BY pb.balance DESC LIMIT ?";
 
-        SQLite::Statement stmt(db, sql);
-        stmt.bind(1, currencyId);
-        stmt.bind(2, limit);
+        auto stmt = mDbManager.prepareRead(sql);
+        stmt->bind(1, currencyId);
+        stmt->bind(2, limit);
 
         std::vector<TopBalanceEntry> result;
         int                          rank = 1;
-        while (stmt.executeStep()) {
+        while (stmt->executeStep()) {
             TopBalanceEntry entry;
-            entry.username   = stmt.getColumn(0).getString();
-            entry.xuid       = stmt.getColumn(1).getString();
-            entry.currencyId = stmt.getColumn(2).getString();
-            entry.balance    = stmt.getColumn(3).getInt();
+            entry.username   = stmt->getColumn(0).getString();
+            entry.xuid       = stmt->getColumn(1).getString();
+            entry.currencyId = currencyId;
+            entry.balance    = stmt->getColumn(2).getInt();
             entry.rank       = rank++;
             result.push_back(entry);
         }
@@ -238,16 +411,43 @@ std::vector<TopBalanceEntry> PlayerDAO::getTopBalanceList(const std::string& cur
     }
 }
 
-bool PlayerDAO::playerExists(const std::string& xuid) const {
+std::vector<TopBalanceEntry> PlayerDAO::getCurrencyBalanceList(const std::string& currencyId) const {
     try {
-        auto& db = mDbManager.getConnection();
+        const char* sql = "SELECT p.username, a.xuid, pb.balance "
+                          "FROM player_balances pb "
+                          "INNER JOIN accounts a ON a.id = pb.account_id "
+                          "INNER JOIN players p ON p.xuid = a.xuid "
+                          "WHERE pb.currency_key = (SELECT id FROM currency_keys WHERE code = ?)";
+
+        // 全表扫描走只读连接，不占用写连接；构建期间提交的写入由排行榜在构建完成后应用
+        auto stmt = mDbManager.prepareRead(sql);
+        stmt->bind(1, currencyId);
+
+        std::vector<TopBalanceEntry> result;
+        while (stmt->executeStep()) {
+            TopBalanceEntry entry;
+            entry.username   = stmt->getColumn(0).getString();
+            entry.xuid       = stmt->getColumn(1).getString();
+            entry.currencyId = currencyId;
+            entry.balance    = stmt->getColumn(2).getInt();
+            result.push_back(std::move(entry));
+        }
+
+        return result;
+
+    } catch (const SQLite::Exception& e) {
+        throw DatabaseException("获取币种余额列表失败: " + std::string(e.what()));
+    }
+}
 
+bool PlayerDAO::playerExists(const std::string& xuid) const {
+    try {
         const char* sql = "SELECT 1 FROM players WHERE xuid = ? LIMIT 1";
 
-        SQLite::Statement stmt(db, sql);
-        stmt.bind(1, xuid);
+        auto stmt = mDbManager.prepareRead(sql);
+        stmt->bind(1, xuid);
 
-        return stmt.executeStep();
+        return stmt->executeStep();
 
     } catch (const SQLite::Exception& e) {
         throw DatabaseException("检查玩家是否存在失败: " + std::string(e.what()));
@@ -256,14 +456,13 @@ bool PlayerDAO::playerExists(const std::string& xuid) const {
 
 int PlayerDAO::getPlayerCount() const {
     try {
-        auto& db = mDbManager.getConnection();
+        // 由触发器维护的汇总值
+        const char* sql = "SELECT player_count FROM global_aggregates WHERE id = 1";
 
-        const char* sql = "SELECT COUNT(*) FROM players";
+        auto stmt = mDbManager.prepareRead(sql);
 
-        SQLite::Statement stmt(db, sql);
-
-        if (stmt.executeStep()) {
-            return stmt.getColumn(0).getInt();
+        if (stmt->executeStep()) {
+            return stmt->getColumn(0).getInt();
         }
 
         return 0;
@@ -273,17 +472,17 @@ int PlayerDAO::getPlayerCount() const {
     }
 }
 
-int PlayerDAO::getTotalWealth(const std::string& currencyId) const {
+int64_t PlayerDAO::getTotalWealth(const std::string& currencyId) const {
     try {
-        auto& db = mDbManager.getConnection();
-
-        const char* sql = "SELECT SUM(balance) FROM player_balances WHERE currency_id = ?";
+        // 由触发器维护的汇总值
+        const char* sql = "SELECT total_wealth FROM currency_aggregates "
+                          "WHERE currency_key = (SELECT id FROM currency_keys WHERE code = ?)";
 
-        SQLite::Statement stmt(db, sql);
-        stmt.bind(1, currencyId);
+        auto stmt = mDbManager.prepareRead(sql);
+        stmt->bind(1, currencyId);
 
-        if (stmt.executeStep()) {
-            return stmt.getColumn(0).getInt();
+        if (stmt->executeStep()) {
+            return stmt->getColumn(0).getInt64();
         }
 
         return 0;
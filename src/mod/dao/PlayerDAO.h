@@ -3,7 +3,10 @@
 #include <RLXMoney/data/DataStructures.h>
 #include "mod/database/DatabaseManager.h"
 #include <SQLiteCpp/Statement.h>
+#include <cstdint>
+#include <initializer_list>
 #include <optional>
+#include <string_view>
 #include <vector>
 
 
@@ -50,6 +53,77 @@ class PlayerDAO {
     /// @return 是否更新成功
     bool updateBalance(const std::string& xuid, const std::string& currencyId, int newBalance);
 
+    /// @brief 原子地调整玩家余额并返回调整后的余额（单条 UPSERT ... RETURNING）
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @param delta 余额变化量（可为负）
+    /// @param minBalance 调整后允许的最小余额
+    /// @param maxBalance 调整后允许的最大余额
+    /// @param initialBalance 余额记录不存在时的初始余额；为空时不创建记录
+    /// @return 调整后的余额；玩家或余额记录不存在、结果超出范围时返回空且不做任何修改
+    /// @note 必须在事务中调用，失败原因由调用方在冷路径上自行诊断
+    std::optional<int> applyBalanceDelta(
+        const std::string& xuid,
+        const std::string& currencyId,
+        int64_t            delta,
+        int64_t            minBalance,
+        int64_t            maxBalance,
+        std::optional<int> initialBalance = std::nullopt
+    );
+
+    /// @brief 把玩家余额设置为指定值并返回设置后的余额（单条 UPSERT ... RETURNING）
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @param balance 新余额
+    /// @return 设置后的余额；玩家不存在时返回空
+    std::optional<int> assignBalance(const std::string& xuid, const std::string& currencyId, int balance);
+
+    /// @brief 给某币种的所有余额加上固定金额，并写入对应的交易记录
+    /// @param currencyId 币种ID
+    /// @param amount 增加金额（非负）
+    /// @param maxBalance 最大余额，超出部分被截断（已超过上限的余额保持不变）
+    /// @param description 交易描述
+    /// @return 实际变化的账户数量
+    /// @note 必须在事务中调用
+    int64_t addToAllBalances(
+        const std::string& currencyId,
+        int                amount,
+        int                maxBalance,
+        const std::string& description
+    );
+
+    /// @brief 把某币种的所有余额乘以比例，并写入对应的交易记录
+    /// @param currencyId 币种ID
+    /// @param rateMicros 比例（百万分之一为单位，1000000 表示 1 倍）
+    /// @param roundUp 是否向上取整（否则向下取整）
+    /// @param maxBalance 最大余额，超出部分被截断（已超过上限的余额不会因截断而减少）
+    /// @param description 交易描述
+    /// @return 实际变化的账户数量
+    /// @note 必须在事务中调用
+    int64_t scaleAllBalances(
+        const std::string& currencyId,
+        int64_t            rateMicros,
+        bool               roundUp,
+        int                maxBalance,
+        const std::string& description
+    );
+
+    /// @brief 把某币种的所有余额设置为同一个值，并写入对应的交易记录
+    /// @param currencyId 币种ID
+    /// @param balance 新余额
+    /// @param description 交易描述
+    /// @return 实际变化的账户数量
+    /// @note 必须在事务中调用
+    int64_t assignAllBalances(const std::string& currencyId, int balance, const std::string& description);
+
+    /// @brief 把某币种超过上限的余额降到上限，并写入对应的交易记录
+    /// @param currencyId 币种ID
+    /// @param maxBalance 最大余额
+    /// @param description 交易描述
+    /// @return 实际变化的账户数量
+    /// @note 必须在事务中调用
+    int64_t clampAllBalances(const std::string& currencyId, int maxBalance, const std::string& description);
+
     /// @brief 获取玩家所有币种余额
     /// @param xuid 玩家XUID
     /// @return 玩家余额列表
@@ -68,6 +142,12 @@ class PlayerDAO {
     /// @return 玩家余额列表
     [[nodiscard]] std::vector<TopBalanceEntry> getTopBalanceList(const std::string& currencyId, int limit) const;
 
+    /// @brief 获取某币种所有玩家的余额（未排序，rank 为 0），用于构建内存排行榜
+    /// @param currencyId 币种ID
+    /// @return 玩家余额列表
+    /// @note 在只读连接上查询，不阻塞写入；组事务未提交时回退到写连接，能读到其中的写入
+    [[nodiscard]] std::vector<TopBalanceEntry> getCurrencyBalanceList(const std::string& currencyId) const;
+
     /// @brief 检查玩家是否存在
     /// @param xuid 玩家XUID
     /// @return 是否存在
@@ -75,12 +155,14 @@ class PlayerDAO {
 
     /// @brief 获取所有玩家数量
     /// @return 玩家总数
+    /// @note 读取汇总表，不扫描 players 表
     [[nodiscard]] int getPlayerCount() const;
 
     /// @brief 获取指定币种的总财富
     /// @param currencyId 币种ID
     /// @return 服务器总财富
-    [[nodiscard]] int getTotalWealth(const std::string& currencyId) const;
+    /// @note 读取汇总表，不扫描 player_balances 表
+    [[nodiscard]] int64_t getTotalWealth(const std::string& currencyId) const;
 
 private:
     /// @brief 从查询结果构建玩家数据
@@ -88,6 +170,21 @@ class PlayerDAO {
     /// @return 玩家数据
     PlayerData buildPlayerDataFromStatement(SQLite::Statement& stmt) const;
 
+    /// @brief 按表达式批量改写某币种的余额（INSERT ... SELECT 写交易记录，再用一条 UPDATE 改写余额）
+    /// @param currencyId 币种ID
+    /// @param newBalanceExpr 新余额的 SQL 表达式（可引用 balance 列和从 ?4 开始的参数）
+    /// @param params 表达式参数，依次绑定到 ?4、?5 ...
+    /// @param recordAsSet 交易记录是否按 SET 类型记录新余额（否则按增减记录变化量）
+    /// @param description 交易描述
+    /// @return 实际变化的账户数量
+    int64_t applyBulkUpdate(
+        const std::string&             currencyId,
+        std::string_view               newBalanceExpr,
+        std::initializer_list<int64_t> params,
+        bool                           recordAsSet,
+        const std::string&             description
+    );
+
     DatabaseManager& mDbManager;
 };
 
@@ -1,39 +1,318 @@
 #include "mod/dao/TransactionDAO.h"
 #include "mod/exceptions/MoneyException.h"
+#include "mod/storage/StorageBackend.h"
+#include <SQLiteCpp/Database.h>
 #include <SQLiteCpp/Statement.h>
+#include <SQLiteCpp/Transaction.h>
+#include <algorithm>
+#include <array>
+#include <charconv>
 #include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iterator>
+#include <sqlite3.h>
+#include <tuple>
 
 namespace rlx_money {
 
+namespace {
+
+/// @brief 查询交易记录的列与字典表连接（列顺序与 buildTransactionRecordFromStatement 一致）
+constexpr std::string_view kSelectRecord =
+    "SELECT t.id, a.xuid, c.code, t.amount, t.balance, t.type, t.description, t.timestamp, r.xuid, t.transfer_id "
+    "FROM transactions t "
+    "JOIN accounts a ON a.id = t.account_id "
+    "JOIN currency_keys c ON c.id = t.currency_key "
+    "LEFT JOIN accounts r ON r.id = t.related_account_id ";
+
+/// @brief 按玩家过滤（子查询只执行一次，随后按 account_id 走索引）；玩家XUID固定为第 1 个参数
+constexpr std::string_view kAccountFilter = "t.account_id = (SELECT id FROM accounts WHERE xuid = ?1)";
+
+/// @brief 结构迁移期间从新表取出玩家的记录
+constexpr std::string_view kAccountRecords = "WHERE account_id = (SELECT id FROM accounts WHERE xuid = ?1)";
+
+/// @brief 结构迁移期间从新旧两表各取出最近的记录（条数为第 1 个参数）
+constexpr std::string_view kRecentRecords = "ORDER BY timestamp DESC, id DESC LIMIT ?1";
+
+/// @brief 拼接查询语句
+/// @param where 查询条件与排序
+/// @param legacy 尚未迁移完的旧交易记录表（没有时为空指针）
+/// @param newRecords 迁移期间从新表取候选记录的子句
+/// @param legacyRecords 迁移期间从旧表取候选记录的子句
+/// @note 迁移期间交易记录表换为两表候选记录的合并。外层条件不会下推到合并的各部分，
+///       因此各部分自带按玩家过滤或按时间取前 N 条的子句，只读取索引上的一段
+std::string selectRecords(
+    std::string_view               where,
+    const LegacyTransactionSource* legacy        = nullptr,
+    std::string_view               newRecords    = {},
+    std::string_view               legacyRecords = {}
+) {
+    std::string sql(kSelectRecord);
+    if (legacy != nullptr) {
+        constexpr std::string_view kTable = "FROM transactions t ";
+        std::string merged = "FROM (SELECT * FROM (SELECT * FROM transactions " + std::string(newRecords)
+                           + ") UNION ALL SELECT * FROM (" + legacy->records + " " + std::string(legacyRecords)
+                           + ")) t ";
+        sql.replace(sql.find(kTable), kTable.size(), merged);
+    }
+    sql += where;
+    return sql;
+}
+
+/// @brief 拼接按玩家查询的语句
+/// @param conditions 玩家过滤之后的条件与排序
+/// @param legacy 尚未迁移完的旧交易记录表（没有时为空指针）
+std::string selectPlayerRecords(std::string_view conditions, const LegacyTransactionSource* legacy = nullptr) {
+    return selectRecords(
+        "WHERE " + std::string(kAccountFilter) + std::string(conditions),
+        legacy,
+        kAccountRecords,
+        legacy != nullptr ? legacy->accountFilter : ""
+    );
+}
+
+/// @brief 结构迁移尚未完成时拒绝按时间范围删除交易记录（旧表中的记录不在新表上）
+void requireMigrationCompleted(const DatabaseManager& dbManager) {
+    if (dbManager.getLegacyTransactions() != nullptr) {
+        throw DatabaseException("交易记录结构迁移尚未完成，请在迁移完成后再执行");
+    }
+}
+
+/// @brief 还原转账ID：BLOB 转为 24 位小写十六进制，文本原样返回
+std::string unpackTransferId(const SQLite::Column& column) {
+    if (column.getType() != SQLITE_BLOB) {
+        return column.getString();
+    }
+    const auto* bytes = static_cast<const unsigned char*>(column.getBlob());
+    return rlx_money::unpackTransferId(bytes, static_cast<size_t>(column.getBytes()));
+}
+
+/// @brief 从数据库中的整数还原交易类型
+TransactionType toTransactionType(int value) {
+    if (value < static_cast<int>(TransactionType::SET) || value > static_cast<int>(TransactionType::INITIAL)) {
+        throw DatabaseException("无效的交易类型: " + std::to_string(value));
+    }
+    return static_cast<TransactionType>(value);
+}
+
+/// @brief 归档分段文件的表结构：与热表相同的交易记录表，以及记录引用到的字典表行，分段文件可以单独查询
+constexpr const char* kArchiveSchema = R"(
+    CREATE TABLE IF NOT EXISTS accounts (
+        id INTEGER PRIMARY KEY,
+        xuid TEXT NOT NULL UNIQUE
+    );
+    CREATE TABLE IF NOT EXISTS currency_keys (
+        id INTEGER PRIMARY KEY,
+        code TEXT NOT NULL UNIQUE
+    );
+    CREATE TABLE IF NOT EXISTS transactions (
+        account_id INTEGER NOT NULL,
+        timestamp INTEGER NOT NULL,
+        id INTEGER NOT NULL,
+        currency_key INTEGER NOT NULL,
+        amount INTEGER NOT NULL,
+        balance INTEGER NOT NULL,
+        type INTEGER NOT NULL,
+        description TEXT,
+        related_account_id INTEGER,
+        transfer_id BLOB,
+        PRIMARY KEY (account_id, timestamp, id)
+    ) WITHOUT ROWID;
+)";
+
+/// @brief 归档分段文件（每个 UTC 月份一个）
+struct ArchiveSegment {
+    std::filesystem::path path;
+    int64_t               monthStart = 0; // 该月第一秒
+    int64_t               monthEnd   = 0; // 下个月第一秒
+};
+
+/// @brief 时间戳所在的 UTC 月份
+std::chrono::year_month monthOf(int64_t timestamp) {
+    std::chrono::year_month_day date{std::chrono::floor<std::chrono::days>(
+        std::chrono::sys_seconds{std::chrono::seconds{timestamp}}
+    )};
+    return date.year() / date.month();
+}
+
+/// @brief 月份的起止时间
+/// @return (该月第一秒, 下个月第一秒)
+std::pair<int64_t, int64_t> monthRange(std::chrono::year_month month) {
+    using namespace std::chrono;
+    auto first = sys_seconds{sys_days{month / 1}};
+    auto next  = sys_seconds{sys_days{(month + months{1}) / 1}};
+    return {first.time_since_epoch().count(), next.time_since_epoch().count()};
+}
+
+/// @brief 分段文件路径：<归档目录>/<数据库文件名>-YYYYMM.db
+std::filesystem::path
+segmentPath(const std::filesystem::path& directory, const std::string& stem, std::chrono::year_month month) {
+    char name[16];
+    std::snprintf(name, sizeof(name), "%04d%02u", static_cast<int>(month.year()), static_cast<unsigned>(month.month()));
+    return directory / (stem + "-" + name + ".db");
+}
+
+/// @brief 列出归档目录中的分段文件
+/// @return 按月份从新到旧排列的分段
+std::vector<ArchiveSegment> listArchiveSegments(const std::filesystem::path& directory, const std::string& stem) {
+    std::vector<ArchiveSegment> segments;
+    std::error_code             error;
+    for (const auto& file : std::filesystem::directory_iterator(directory, error)) {
+        std::string name = file.path().filename().string();
+        if (!file.is_regular_file(error) || name.size() != stem.size() + 10 || !name.starts_with(stem + "-")
+            || !name.ends_with(".db")) {
+            continue;
+        }
+        std::string_view digits(name.data() + stem.size() + 1, 6);
+        int              yearMonth = 0;
+        auto [end, parseError]     = std::from_chars(digits.data(), digits.data() + digits.size(), yearMonth);
+        if (parseError != std::errc() || end != digits.data() + digits.size() || yearMonth % 100 < 1
+            || yearMonth % 100 > 12) {
+            continue;
+        }
+        std::chrono::year_month month{
+            std::chrono::year{yearMonth / 100},
+            std::chrono::month{static_cast<unsigned>(yearMonth % 100)}
+        };
+        auto [monthStart, monthEnd] = monthRange(month);
+        segments.push_back(ArchiveSegment{file.path(), monthStart, monthEnd});
+    }
+    std::sort(segments.begin(), segments.end(), [](const ArchiveSegment& a, const ArchiveSegment& b) {
+        return a.monthStart > b.monthStart;
+    });
+    return segments;
+}
+
+/// @brief 把源语句当前行的一列按原类型绑定到目标语句
+void bindColumn(SQLite::Statement& target, int index, const SQLite::Column& column) {
+    switch (column.getType()) {
+    case SQLITE_INTEGER:
+        target.bind(index, column.getInt64());
+        break;
+    case SQLITE_FLOAT:
+        target.bind(index, column.getDouble());
+        break;
+    case SQLITE_TEXT:
+        target.bind(index, column.getString());
+        break;
+    case SQLITE_BLOB:
+        target.bind(index, column.getBlob(), column.getBytes());
+        break;
+    default:
+        target.bind(index);
+        break;
+    }
+}
+
+/// @brief 把源语句查询到的每一行写入目标语句
+/// @return 写入的行数
+int64_t copyRows(SQLite::Statement& source, SQLite::Statement& target) {
+    int64_t rows = 0;
+    while (source.executeStep()) {
+        for (int i = 0; i < source.getColumnCount(); ++i) {
+            bindColumn(target, i + 1, source.getColumn(i));
+        }
+        target.exec();
+        target.reset();
+        ++rows;
+    }
+    return rows;
+}
+
+/// @brief 把热表中 [start, end) 内的交易记录写入分段文件并提交
+/// @param db 写连接（调用方已打开事务）
+/// @return 写入的记录数量
+/// @note 分段文件单独提交，之后热表的删除失败时记录会同时留在两处，重复归档按主键忽略，查询时按 (timestamp, id) 去重
+int64_t copyToSegment(SQLite::Database& db, const std::filesystem::path& path, int64_t start, int64_t end) {
+    SQLite::Database segment(path.string(), SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE);
+    segment.exec(kArchiveSchema);
+    SQLite::Transaction transaction(segment);
+
+    SQLite::Statement accounts(
+        db,
+        "SELECT id, xuid FROM accounts WHERE id IN ("
+        "SELECT account_id FROM transactions WHERE timestamp >= ?1 AND timestamp < ?2 UNION "
+        "SELECT related_account_id FROM transactions WHERE timestamp >= ?1 AND timestamp < ?2)"
+    );
+    accounts.bind(1, start);
+    accounts.bind(2, end);
+    SQLite::Statement insertAccount(segment, "INSERT OR IGNORE INTO accounts (id, xuid) VALUES (?, ?)");
+    copyRows(accounts, insertAccount);
+
+    SQLite::Statement currencies(
+        db,
+        "SELECT id, code FROM currency_keys WHERE id IN ("
+        "SELECT currency_key FROM transactions WHERE timestamp >= ?1 AND timestamp < ?2)"
+    );
+    currencies.bind(1, start);
+    currencies.bind(2, end);
+    SQLite::Statement insertCurrency(segment, "INSERT OR IGNORE INTO currency_keys (id, code) VALUES (?, ?)");
+    copyRows(currencies, insertCurrency);
+
+    // 按主键顺序写入，分段文件的页面填充紧凑
+    SQLite::Statement records(
+        db,
+        "SELECT account_id, timestamp, id, currency_key, amount, balance, type, description, related_account_id, "
+        "transfer_id FROM transactions WHERE timestamp >= ? AND timestamp < ? ORDER BY account_id, timestamp, id"
+    );
+    records.bind(1, start);
+    records.bind(2, end);
+    SQLite::Statement insertRecord(
+        segment,
+        "INSERT OR IGNORE INTO transactions (account_id, timestamp, id, currency_key, amount, balance, type, "
+        "description, related_account_id, transfer_id) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"
+    );
+    int64_t copied = copyRows(records, insertRecord);
+
+    transaction.commit();
+    return copied;
+}
+
+} // namespace
+
 TransactionDAO::TransactionDAO(DatabaseManager& dbManager) : mDbManager(dbManager) {}
 
 bool TransactionDAO::createTransaction(const TransactionRecord& record) {
     try {
-        auto& db = mDbManager.getConnection();
-
-        const char* sql = "INSERT INTO transactions (xuid, currency_id, amount, balance, type, description, timestamp, "
-                          "related_xuid, transfer_id) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)";
-
-        SQLite::Statement stmt(db, sql);
-        stmt.bind(1, record.xuid);
-        stmt.bind(2, record.currencyId);
-        stmt.bind(3, record.amount);
-        stmt.bind(4, record.balance);
-        stmt.bind(5, transactionTypeToString(record.type));
-        stmt.bind(6, record.description);
-        stmt.bind(7, record.timestamp);
+        // 记录ID取序号表的下一个值，插入后由触发器推进序号
+        const char* sql = "INSERT INTO transactions (id, account_id, currency_key, amount, balance, type, description, "
+                          "timestamp, related_account_id, transfer_id) "
+                          "VALUES ((SELECT seq + 1 FROM transaction_sequence WHERE id = 1), ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+
+        int64_t                accountKey  = mDbManager.resolveAccountKey(record.xuid);
+        int64_t                currencyKey = mDbManager.resolveCurrencyKey(record.currencyId);
+        std::optional<int64_t> relatedKey;
         if (record.relatedXuid.has_value()) {
-            stmt.bind(8, record.relatedXuid.value());
+            relatedKey = mDbManager.resolveAccountKey(record.relatedXuid.value());
+        }
+
+        auto stmt = mDbManager.prepareCached(sql);
+        stmt->bind(1, accountKey);
+        stmt->bind(2, currencyKey);
+        stmt->bind(3, record.amount);
+        stmt->bind(4, record.balance);
+        stmt->bind(5, static_cast<int>(record.type));
+        stmt->bind(6, record.description);
+        stmt->bind(7, record.timestamp);
+        if (relatedKey.has_value()) {
+            stmt->bind(8, relatedKey.value());
         } else {
-            stmt.bind(8);
+            stmt->bind(8);
         }
+        std::optional<std::array<unsigned char, 12>> packedTransferId;
         if (record.transferId.has_value()) {
-            stmt.bind(9, record.transferId.value());
+            packedTransferId = packTransferId(record.transferId.value());
+        }
+        if (packedTransferId.has_value()) {
+            stmt->bind(9, packedTransferId->data(), static_cast<int>(packedTransferId->size()));
+        } else if (record.transferId.has_value()) {
+            stmt->bind(9, record.transferId.value());
         } else {
-            stmt.bind(9);
+            stmt->bind(9);
         }
 
-        stmt.exec();
+        stmt->exec();
         return true;
 
     } catch (const SQLite::Exception& e) {
@@ -45,35 +324,34 @@ std::vector<TransactionRecord>
 TransactionDAO::getPlayerTransactions(const std::string& xuid, const std::string& currencyId, int page, int pageSize)
     const {
     try {
-        auto& db = mDbManager.getConnection();
-
-        std::string sql;
-        if (currencyId.empty()) {
-            sql = "SELECT id, xuid, currency_id, amount, balance, type, description, timestamp, related_xuid, "
-                  "transfer_id "
-                  "FROM transactions WHERE xuid = ? ORDER BY timestamp DESC LIMIT ? OFFSET ?";
-        } else {
-            sql = "SELECT id, xuid, currency_id, amount, balance, type, description, timestamp, related_xuid, "
-                  "transfer_id "
-                  "FROM transactions WHERE xuid = ? AND currency_id = ? ORDER BY timestamp DESC LIMIT ? OFFSET ?";
-        }
+        constexpr std::string_view kAllConditions = " ORDER BY t.timestamp DESC, t.id DESC LIMIT ? OFFSET ?";
+        constexpr std::string_view kCurrencyConditions =
+            " AND t.currency_key = (SELECT id FROM currency_keys WHERE code = ?) "
+            "ORDER BY t.timestamp DESC, t.id DESC LIMIT ? OFFSET ?";
+        static const std::string allSql      = selectPlayerRecords(kAllConditions);
+        static const std::string currencySql = selectPlayerRecords(kCurrencyConditions);
+        const std::string&       sql         = currencyId.empty() ? allSql : currencySql;
 
         int offset = (page - 1) * pageSize;
 
-        SQLite::Statement stmt(db, sql);
-        stmt.bind(1, xuid);
+        const auto* legacy = mDbManager.getLegacyTransactions();
+        auto        stmt   = mDbManager.prepareRead(
+            legacy != nullptr ? selectPlayerRecords(currencyId.empty() ? kAllConditions : kCurrencyConditions, legacy)
+                              : sql
+        );
+        stmt->bind(1, xuid);
         if (!currencyId.empty()) {
-            stmt.bind(2, currencyId);
-            stmt.bind(3, pageSize);
-            stmt.bind(4, offset);
+            stmt->bind(2, currencyId);
+            stmt->bind(3, pageSize);
+            stmt->bind(4, offset);
         } else {
-            stmt.bind(2, pageSize);
-            stmt.bind(3, offset);
+            stmt->bind(2, pageSize);
+            stmt->bind(3, offset);
         }
 
         std::vector<TransactionRecord> result;
-        while (stmt.executeStep()) {
-            result.push_back(buildTransactionRecordFromStatement(stmt));
+        while (stmt->executeStep()) {
+            result.push_back(buildTransactionRecordFromStatement(*stmt));
         }
 
         return result;
@@ -83,17 +361,146 @@ TransactionDAO::getPlayerTransactions(const std::string& xuid, const std::string
     }
 }
 
-int TransactionDAO::getPlayerTransactionCount(const std::string& xuid) const {
+TransactionPage TransactionDAO::getPlayerTransactionsPage(
+    const std::string&       xuid,
+    const TransactionFilter& filter,
+    const std::string&       cursor,
+    int                      pageSize
+) const {
+    std::optional<std::pair<int64_t, int64_t>> position;
+    if (!cursor.empty()) {
+        position = decodeTransactionCursor(cursor);
+        if (!position) {
+            throw InvalidArgumentException("无效的分页游标: " + cursor);
+        }
+    }
+
     try {
-        auto& db = mDbManager.getConnection();
+        // 每种条件组合对应一条固定的 SQL，可以命中预编译语句缓存
+        std::string conditions;
+        if (!filter.currencyId.empty()) {
+            conditions += " AND t.currency_key = (SELECT id FROM currency_keys WHERE code = ?)";
+        }
+        if (filter.type) {
+            conditions += " AND t.type = ?";
+        }
+        if (filter.startTime) {
+            conditions += " AND t.timestamp >= ?";
+        }
+        if (filter.endTime) {
+            conditions += " AND t.timestamp <= ?";
+        }
+        if (position) {
+            conditions += " AND (t.timestamp, t.id) < (?, ?)";
+        }
+        // 多取一条用于判断是否还有下一页
+        conditions      += " ORDER BY t.timestamp DESC, t.id DESC LIMIT ?";
+        std::string sql  = selectPlayerRecords(conditions);
+
+        // 热表与各分段执行同一条语句，按 (timestamp, id) 倒序各取至多 pageSize + 1 条候选记录
+        size_t limit   = static_cast<size_t>(pageSize) + 1;
+        auto   collect = [&](SQLite::Statement& stmt, std::vector<TransactionRecord>& records) {
+            int index = 0;
+            stmt.bind(++index, xuid);
+            if (!filter.currencyId.empty()) {
+                stmt.bind(++index, filter.currencyId);
+            }
+            if (filter.type) {
+                stmt.bind(++index, static_cast<int>(*filter.type));
+            }
+            if (filter.startTime) {
+                stmt.bind(++index, *filter.startTime);
+            }
+            if (filter.endTime) {
+                stmt.bind(++index, *filter.endTime);
+            }
+            if (position) {
+                stmt.bind(++index, position->first);
+                stmt.bind(++index, position->second);
+            }
+            stmt.bind(++index, pageSize + 1);
+            while (stmt.executeStep()) {
+                records.push_back(buildTransactionRecordFromStatement(stmt));
+            }
+        };
+
+        std::vector<TransactionRecord> records;
+        {
+            // 分段文件中没有旧交易记录表，只有热表的查询需要合并迁移期间的旧表
+            const auto* legacy = mDbManager.getLegacyTransactions();
+            auto stmt = mDbManager.prepareRead(legacy != nullptr ? selectPlayerRecords(conditions, legacy) : sql);
+            collect(*stmt, records);
+        }
+
+        if (filter.includeArchived) {
+            auto newer = [](const TransactionRecord& a, const TransactionRecord& b) {
+                return std::tie(a.timestamp, a.id) > std::tie(b.timestamp, b.id);
+            };
+            auto same = [](const TransactionRecord& a, const TransactionRecord& b) {
+                return a.timestamp == b.timestamp && a.id == b.id;
+            };
+            std::string stem = std::filesystem::path(mDbManager.getDatabasePath()).stem().string();
+            for (const auto& segment : listArchiveSegments(mDbManager.getArchiveDirectory(), stem)) {
+                // 分段按月份从新到旧排列：候选已满且最旧的候选不早于该月时，更旧的分段不会再进入本页
+                if (records.size() == limit && records.back().timestamp >= segment.monthEnd) {
+                    break;
+                }
+                if ((filter.startTime && *filter.startTime >= segment.monthEnd)
+                    || (filter.endTime && *filter.endTime < segment.monthStart)
+                    || (position && position->first < segment.monthStart)) {
+                    continue;
+                }
+
+                SQLite::Database archive(segment.path.string(), SQLite::OPEN_READONLY);
+                archive.setBusyTimeout(1000);
+                SQLite::Statement              stmt(archive, sql);
+                std::vector<TransactionRecord> archived;
+                collect(stmt, archived);
+
+                std::vector<TransactionRecord> merged;
+                merged.reserve(records.size() + archived.size());
+                std::merge(
+                    std::make_move_iterator(records.begin()),
+                    std::make_move_iterator(records.end()),
+                    std::make_move_iterator(archived.begin()),
+                    std::make_move_iterator(archived.end()),
+                    std::back_inserter(merged),
+                    newer
+                );
+                merged.erase(std::unique(merged.begin(), merged.end(), same), merged.end());
+                if (merged.size() > limit) {
+                    merged.resize(limit);
+                }
+                records.swap(merged);
+            }
+        }
+
+        TransactionPage page;
+        if (records.size() == limit) {
+            records.pop_back();
+            const auto& last = records.back();
+            page.nextCursor  = encodeTransactionCursor(last.timestamp, last.id);
+        }
+        page.records = std::move(records);
+
+        return page;
+
+    } catch (const SQLite::Exception& e) {
+        throw DatabaseException("分页获取玩家交易记录失败: " + std::string(e.what()));
+    }
+}
 
-        const char* sql = "SELECT COUNT(*) FROM transactions WHERE xuid = ?";
+int TransactionDAO::getPlayerTransactionCount(const std::string& xuid) const {
+    try {
+        // 由触发器维护的汇总值
+        const char* sql = "SELECT transaction_count FROM player_aggregates "
+                          "WHERE account_id = (SELECT id FROM accounts WHERE xuid = ?)";
 
-        SQLite::Statement stmt(db, sql);
-        stmt.bind(1, xuid);
+        auto stmt = mDbManager.prepareRead(sql);
+        stmt->bind(1, xuid);
 
-        if (stmt.executeStep()) {
-            return stmt.getColumn(0).getInt();
+        if (stmt->executeStep()) {
+            return stmt->getColumn(0).getInt();
         }
 
         return 0;
@@ -107,24 +514,22 @@ std::vector<TransactionRecord>
 TransactionDAO::getPlayerTransactionsByType(const std::string& xuid, TransactionType type, int page, int pageSize)
     const {
     try {
-        auto& db = mDbManager.getConnection();
-
-        std::string typeStr = transactionTypeToString(type);
-        const char* sql =
-            "SELECT id, xuid, currency_id, amount, balance, type, description, timestamp, related_xuid, transfer_id "
-            "FROM transactions WHERE xuid = ? AND type = ? ORDER BY timestamp DESC LIMIT ? OFFSET ?";
+        constexpr std::string_view kConditions =
+            " AND t.type = ? ORDER BY t.timestamp DESC, t.id DESC LIMIT ? OFFSET ?";
+        static const std::string sql = selectPlayerRecords(kConditions);
 
         int offset = (page - 1) * pageSize;
 
-        SQLite::Statement stmt(db, sql);
-        stmt.bind(1, xuid);
-        stmt.bind(2, typeStr);
-        stmt.bind(3, pageSize);
-        stmt.bind(4, offset);
+        const auto* legacy = mDbManager.getLegacyTransactions();
+        auto stmt = mDbManager.prepareRead(legacy != nullptr ? selectPlayerRecords(kConditions, legacy) : sql);
+        stmt->bind(1, xuid);
+        stmt->bind(2, static_cast<int>(type));
+        stmt->bind(3, pageSize);
+        stmt->bind(4, offset);
 
         std::vector<TransactionRecord> result;
-        while (stmt.executeStep()) {
-            result.push_back(buildTransactionRecordFromStatement(stmt));
+        while (stmt->executeStep()) {
+            result.push_back(buildTransactionRecordFromStatement(*stmt));
         }
 
         return result;
@@ -142,25 +547,23 @@ std::vector<TransactionRecord> TransactionDAO::getPlayerTransactionsByTimeRange(
     int                pageSize
 ) const {
     try {
-        auto& db = mDbManager.getConnection();
-
-        const char* sql =
-            "SELECT id, xuid, currency_id, amount, balance, type, description, timestamp, related_xuid, transfer_id "
-            "FROM transactions WHERE xuid = ? AND timestamp >= ? AND timestamp <= ? ORDER BY timestamp "
-            "DESC LIMIT ? OFFSET ?";
+        constexpr std::string_view kConditions =
+            " AND t.timestamp >= ? AND t.timestamp <= ? ORDER BY t.timestamp DESC, t.id DESC LIMIT ? OFFSET ?";
+        static const std::string sql = selectPlayerRecords(kConditions);
 
         int offset = (page - 1) * pageSize;
 
-        SQLite::Statement stmt(db, sql);
-        stmt.bind(1, xuid);
-        stmt.bind(2, startTime);
-        stmt.bind(3, endTime);
-        stmt.bind(4, pageSize);
-        stmt.bind(5, offset);
+        const auto* legacy = mDbManager.getLegacyTransactions();
+        auto stmt = mDbManager.prepareRead(legacy != nullptr ? selectPlayerRecords(kConditions, legacy) : sql);
+        stmt->bind(1, xuid);
+        stmt->bind(2, startTime);
+        stmt->bind(3, endTime);
+        stmt->bind(4, pageSize);
+        stmt->bind(5, offset);
 
         std::vector<TransactionRecord> result;
-        while (stmt.executeStep()) {
-            result.push_back(buildTransactionRecordFromStatement(stmt));
+        while (stmt->executeStep()) {
+            result.push_back(buildTransactionRecordFromStatement(*stmt));
         }
 
         return result;
@@ -172,18 +575,18 @@ std::vector<TransactionRecord> TransactionDAO::getPlayerTransactionsByTimeRange(
 
 std::vector<TransactionRecord> TransactionDAO::getRecentTransactions(int limit) const {
     try {
-        auto& db = mDbManager.getConnection();
+        constexpr std::string_view kConditions = "ORDER BY t.timestamp DESC, t.id DESC LIMIT ?1";
+        static const std::string   sql         = selectRecords(kConditions);
 
-        const char* sql =
-            "SELECT id, xuid, currency_id, amount, balance, type, description, timestamp, related_xuid, transfer_id "
-            "FROM transactions ORDER BY timestamp DESC LIMIT ?";
-
-        SQLite::Statement stmt(db, sql);
-        stmt.bind(1, limit);
+        const auto* legacy = mDbManager.getLegacyTransactions();
+        auto        stmt   = mDbManager.prepareRead(
+            legacy != nullptr ? selectRecords(kConditions, legacy, kRecentRecords, kRecentRecords) : sql
+        );
+        stmt->bind(1, limit);
 
         std::vector<TransactionRecord> result;
-        while (stmt.executeStep()) {
-            result.push_back(buildTransactionRecordFromStatement(stmt));
+        while (stmt->executeStep()) {
+            result.push_back(buildTransactionRecordFromStatement(*stmt));
         }
 
         return result;
@@ -195,14 +598,13 @@ std::vector<TransactionRecord> TransactionDAO::getRecentTransactions(int limit)
 
 int TransactionDAO::getTotalTransactionCount() const {
     try {
-        auto& db = mDbManager.getConnection();
-
-        const char* sql = "SELECT COUNT(*) FROM transactions";
+        // 由触发器维护的汇总值
+        const char* sql = "SELECT transaction_count FROM global_aggregates WHERE id = 1";
 
-        SQLite::Statement stmt(db, sql);
+        auto stmt = mDbManager.prepareRead(sql);
 
-        if (stmt.executeStep()) {
-            return stmt.getColumn(0).getInt();
+        if (stmt->executeStep()) {
+            return stmt->getColumn(0).getInt();
         }
 
         return 0;
@@ -214,16 +616,14 @@ int TransactionDAO::getTotalTransactionCount() const {
 
 int TransactionDAO::getTransactionCountByType(TransactionType type) const {
     try {
-        auto& db = mDbManager.getConnection();
-
-        std::string typeStr = transactionTypeToString(type);
-        const char* sql     = "SELECT COUNT(*) FROM transactions WHERE type = ?";
+        // 由触发器维护的汇总值
+        const char* sql = "SELECT transaction_count FROM type_aggregates WHERE type = ?";
 
-        SQLite::Statement stmt(db, sql);
-        stmt.bind(1, typeStr);
+        auto stmt = mDbManager.prepareRead(sql);
+        stmt->bind(1, static_cast<int>(type));
 
-        if (stmt.executeStep()) {
-            return stmt.getColumn(0).getInt();
+        if (stmt->executeStep()) {
+            return stmt->getColumn(0).getInt();
         }
 
         return 0;
@@ -234,36 +634,134 @@ int TransactionDAO::getTransactionCountByType(TransactionType type) const {
 }
 
 int TransactionDAO::cleanupOldTransactions(int daysToKeep) {
+    requireMigrationCompleted(mDbManager);
     try {
-        auto& db = mDbManager.getConnection();
-
         // 计算截止时间戳
         auto currentTime =
             std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch())
                 .count();
-        int64_t cutoffTime = currentTime - (daysToKeep * 24 * 60 * 60);
+        int64_t cutoffTime = currentTime - static_cast<int64_t>(daysToKeep) * 24 * 60 * 60;
+
+        // 分批删除，每批一个短事务，删除大量记录时不会长时间占用写锁
+        constexpr int kBatchSize = 1000;
+        const char*   sql        = "DELETE FROM transactions WHERE id IN ("
+                                   "SELECT id FROM transactions WHERE timestamp < ? ORDER BY timestamp, id LIMIT ?)";
+
+        int total = 0;
+        while (true) {
+            int  deleted   = 0;
+            bool committed = mDbManager.executeTransaction([&](SQLite::Database& db) {
+                SQLite::Statement stmt(db, sql);
+                stmt.bind(1, cutoffTime);
+                stmt.bind(2, kBatchSize);
+                deleted = stmt.exec();
+                return true;
+            });
+            if (!committed) {
+                throw DatabaseException("清理过期交易记录失败");
+            }
+            total += deleted;
+            if (deleted < kBatchSize) {
+                return total;
+            }
+        }
 
-        const char* sql = "DELETE FROM transactions WHERE timestamp < ?";
+    } catch (const SQLite::Exception& e) {
+        throw DatabaseException("清理过期交易记录失败: " + std::string(e.what()));
+    }
+}
 
-        SQLite::Statement stmt(db, sql);
-        stmt.bind(1, cutoffTime);
+int64_t TransactionDAO::archiveOldTransactions(int daysToKeep, std::stop_token stopToken) {
+    if (daysToKeep < 1) {
+        throw InvalidArgumentException("保留天数必须大于 0");
+    }
+    auto currentTime =
+        std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    int64_t cutoffTime = currentTime - static_cast<int64_t>(daysToKeep) * 24 * 60 * 60;
+    requireMigrationCompleted(mDbManager);
+
+    std::filesystem::path directory = mDbManager.getArchiveDirectory();
+    std::error_code       error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        throw DatabaseException("无法创建归档目录: " + directory.string());
+    }
+    std::string stem = std::filesystem::path(mDbManager.getDatabasePath()).stem().string();
 
-        stmt.exec();
-        return stmt.getChanges();
+    try {
+        // 每个月份一个事务：先把该月早于截止时间的记录写入分段文件，再从热表删除（汇总表由触发器同步）
+        int64_t archived = 0;
+        while (!stopToken.stop_requested()) {
+            int64_t moved     = -1;
+            bool    committed = mDbManager.executeTransaction([&](SQLite::Database& db) {
+                SQLite::Statement oldest(db, "SELECT MIN(timestamp) FROM transactions WHERE timestamp < ?");
+                oldest.bind(1, cutoffTime);
+                if (!oldest.executeStep() || oldest.getColumn(0).isNull()) {
+                    return true;
+                }
+                auto month                  = monthOf(oldest.getColumn(0).getInt64());
+                auto [monthStart, monthEnd] = monthRange(month);
+                int64_t end                 = std::min(monthEnd, cutoffTime);
+
+                moved = copyToSegment(db, segmentPath(directory, stem, month), monthStart, end);
+
+                SQLite::Statement remove(db, "DELETE FROM transactions WHERE timestamp >= ? AND timestamp < ?");
+                remove.bind(1, monthStart);
+                remove.bind(2, end);
+                remove.exec();
+                return true;
+            });
+            if (!committed) {
+                throw DatabaseException("归档交易记录失败");
+            }
+            if (moved < 0) {
+                return archived;
+            }
+            archived += moved;
+        }
+        return archived;
 
     } catch (const SQLite::Exception& e) {
-        throw DatabaseException("清理过期交易记录失败: " + std::string(e.what()));
+        throw DatabaseException("归档交易记录失败: " + std::string(e.what()));
+    }
+}
+
+uint64_t TransactionDAO::getJournalCheckpoint() const {
+    try {
+        // 走写连接，保证读到本线程刚写入的检查点
+        auto stmt = mDbManager.prepareCached("SELECT sequence FROM journal_checkpoint WHERE id = 1");
+        if (stmt->executeStep()) {
+            return static_cast<uint64_t>(stmt->getColumn(0).getInt64());
+        }
+        return 0;
+
+    } catch (const SQLite::Exception& e) {
+        throw DatabaseException("获取重做日志检查点失败: " + std::string(e.what()));
+    }
+}
+
+void TransactionDAO::setJournalCheckpoint(uint64_t sequence) {
+    try {
+        const char* sql = "INSERT INTO journal_checkpoint (id, sequence) VALUES (1, ?) "
+                          "ON CONFLICT(id) DO UPDATE SET sequence = excluded.sequence";
+
+        auto stmt = mDbManager.prepareCached(sql);
+        stmt->bind(1, static_cast<int64_t>(sequence));
+        stmt->exec();
+
+    } catch (const SQLite::Exception& e) {
+        throw DatabaseException("更新重做日志检查点失败: " + std::string(e.what()));
     }
 }
 
 TransactionRecord TransactionDAO::buildTransactionRecordFromStatement(SQLite::Statement& stmt) const {
     TransactionRecord record;
-    record.id          = stmt.getColumn(0).getInt();
+    record.id          = stmt.getColumn(0).getInt64();
     record.xuid        = stmt.getColumn(1).getString();
     record.currencyId  = stmt.getColumn(2).getString();
     record.amount      = stmt.getColumn(3).getInt();
     record.balance     = stmt.getColumn(4).getInt();
-    record.type        = stringToTransactionType(stmt.getColumn(5).getString());
+    record.type        = toTransactionType(stmt.getColumn(5).getInt());
     record.description = stmt.getColumn(6).getString();
     record.timestamp   = stmt.getColumn(7).getInt64();
     if (!stmt.getColumn(8).isNull()) {
@@ -272,7 +770,7 @@ TransactionRecord TransactionDAO::buildTransactionRecordFromStatement(SQLite::St
         record.relatedXuid = std::nullopt;
     }
     if (!stmt.getColumn(9).isNull()) {
-        record.transferId = stmt.getColumn(9).getString();
+        record.transferId = unpackTransferId(stmt.getColumn(9));
     } else {
         record.transferId = std::nullopt;
     }
@@ -282,15 +780,14 @@ TransactionRecord TransactionDAO::buildTransactionRecordFromStatement(SQLite::St
 std::optional<TransactionRecord>
 TransactionDAO::executeQuerySingle(const std::string& sql, const std::vector<std::string>& params) const {
     try {
-        auto&             db = mDbManager.getConnection();
-        SQLite::Statement stmt(db, sql);
+        auto stmt = mDbManager.prepareRead(sql);
 
         for (size_t i = 0; i < params.size(); ++i) {
-            stmt.bind(static_cast<int>(i + 1), params[i]);
+            stmt->bind(static_cast<int>(i + 1), params[i]);
         }
 
-        if (stmt.executeStep()) {
-            return buildTransactionRecordFromStatement(stmt);
+        if (stmt->executeStep()) {
+            return buildTransactionRecordFromStatement(*stmt);
         }
 
         return std::nullopt;
@@ -303,16 +800,15 @@ TransactionDAO::executeQuerySingle(const std::string& sql, const std::vector<std
 std::vector<TransactionRecord>
 TransactionDAO::executeQueryMultiple(const std::string& sql, const std::vector<std::string>& params) const {
     try {
-        auto&             db = mDbManager.getConnection();
-        SQLite::Statement stmt(db, sql);
+        auto stmt = mDbManager.prepareRead(sql);
 
         for (size_t i = 0; i < params.size(); ++i) {
-            stmt.bind(static_cast<int>(i + 1), params[i]);
+            stmt->bind(static_cast<int>(i + 1), params[i]);
         }
 
         std::vector<TransactionRecord> result;
-        while (stmt.executeStep()) {
-            result.push_back(buildTransactionRecordFromStatement(stmt));
+        while (stmt->executeStep()) {
+            result.push_back(buildTransactionRecordFromStatement(*stmt));
         }
 
         return result;
@@ -5,6 +5,7 @@
 #include <RLXMoney/types/Types.h>
 #include <SQLiteCpp/Statement.h>
 #include <optional>
+#include <stop_token>
 #include <vector>
 
 
@@ -32,9 +33,26 @@ class TransactionDAO {
     getPlayerTransactions(const std::string& xuid, const std::string& currencyId = "", int page = 1, int pageSize = 10)
         const;
 
+    /// @brief 按游标分页获取玩家交易历史
+    /// @param xuid 玩家XUID
+    /// @param filter 查询条件
+    /// @param cursor 上一页返回的游标（为空表示第一页）
+    /// @param pageSize 每页大小
+    /// @return 本页交易记录与下一页游标
+    /// @throw InvalidArgumentException 游标无效时
+    /// @note 以 (timestamp, id) 为键定位下一页，不使用 OFFSET，任意页的查询代价与页码无关；
+    ///       filter.includeArchived 为 true 时把归档分段中的记录按同一顺序合并进来，游标在两层之间通用
+    [[nodiscard]] TransactionPage getPlayerTransactionsPage(
+        const std::string&       xuid,
+        const TransactionFilter& filter,
+        const std::string&       cursor,
+        int                      pageSize
+    ) const;
+
     /// @brief 获取玩家交易记录总数
     /// @param xuid 玩家XUID
     /// @return 记录总数
+    /// @note 读取汇总表，不扫描 transactions 表
     [[nodiscard]] int getPlayerTransactionCount(const std::string& xuid) const;
 
     /// @brief 根据交易类型获取玩家交易记录
@@ -68,18 +86,42 @@ class TransactionDAO {
 
     /// @brief 获取服务器总交易次数
     /// @return 总交易次数
+    /// @note 读取汇总表，不扫描 transactions 表
     [[nodiscard]] int getTotalTransactionCount() const;
 
     /// @brief 获取指定交易类型的总次数
     /// @param type 交易类型
     /// @return 交易次数
+    /// @note 读取汇总表，不扫描 transactions 表
     [[nodiscard]] int getTransactionCountByType(TransactionType type) const;
 
     /// @brief 清理过期的交易记录
     /// @param daysToKeep 保留天数
     /// @return 清理的记录数
+    /// @throw DatabaseException 交易记录结构迁移尚未完成或数据库操作失败时
+    /// @note 每 1000 条一个写事务；需要在服务器运行时清理大量记录时使用 DatabaseManager::startRetention()，
+    ///       由 tick 任务按时间预算分批删除
     int cleanupOldTransactions(int daysToKeep = 90);
 
+    /// @brief 把早于保留天数的交易记录移到按 UTC 月份划分的归档分段文件
+    /// @param daysToKeep 热表中保留的天数
+    /// @param stopToken 每个月份开始前检查，请求停止时返回已归档的记录数（已完成的月份保留）
+    /// @return 移出热表的记录数
+    /// @throw InvalidArgumentException daysToKeep 小于 1 时
+    /// @throw DatabaseException 交易记录结构迁移尚未完成或读写数据库、分段文件失败时
+    /// @note 分段文件位于 DatabaseConfig::archiveDir，命名为 <数据库文件名>-YYYYMM.db，
+    ///       包含与热表相同结构的交易记录表及其引用的字典表行；每个月份在一个写事务中完成，
+    ///       热表只保留近期记录，常用查询涉及的页面可以常驻页缓存
+    int64_t archiveOldTransactions(int daysToKeep, std::stop_token stopToken = {});
+
+    /// @brief 获取已写入数据库的重做日志序号
+    /// @return 最后写入的日志序号（从未写入时为 0）
+    [[nodiscard]] uint64_t getJournalCheckpoint() const;
+
+    /// @brief 记录已写入数据库的重做日志序号（需与日志内容在同一事务中写入）
+    /// @param sequence 最后写入的日志序号
+    void setJournalCheckpoint(uint64_t sequence);
+
 private:
     /// @brief 从查询结果构建交易记录
     /// @param stmt SQLite语句
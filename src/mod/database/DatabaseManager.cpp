@@ -1,129 +1,1539 @@
 #include "mod/database/DatabaseManager.h"
 #include "mod/exceptions/MoneyException.h"
 #include <SQLiteCpp/Exception.h>
+#include <SQLiteCpp/Transaction.h>
+#include <algorithm>
+#include <cstdio>
+#include <exception>
 #include <filesystem>
+#include <sqlite3.h>
 
 namespace rlx_money {
 
+namespace {
+
+// 当前线程正在执行的写事务层数：事务内的读取必须走写连接才能看到未提交的修改
+thread_local int tTransactionDepth = 0;
+
+// 当前线程是否为异步写线程
+thread_local bool tIsWriterThread = false;
+
+// 当前线程最近一次投递到写队列的事务，读取前需等待其完成
+thread_local WriteHandle tLastWrite;
+
+struct TransactionDepthGuard {
+    TransactionDepthGuard() { ++tTransactionDepth; }
+    ~TransactionDepthGuard() { --tTransactionDepth; }
+};
+
+/// @brief 当前数据库结构版本（PRAGMA user_version）
+/// @note 1: 余额表与交易记录表以 XUID、币种ID、交易类型文本为列；
+///       2: 改为 accounts / currency_keys 字典表的整数键，交易类型存整数，转账ID存 12 字节 BLOB，
+///          player_balances 为 WITHOUT ROWID 表；
+///       3: transactions 改为按 (account_id, timestamp, id) 聚簇的 WITHOUT ROWID 表，记录ID由 transaction_sequence 分配
+constexpr int kSchemaVersion = 3;
+
+/// @brief 定期更新查询优化器统计信息的间隔
+constexpr int64_t kOptimizeIntervalMs = 60 * 60 * 1000;
+
+/// @brief 自动计算页缓存时每个连接的最小缓存（KB）
+constexpr int64_t kMinAutoCacheKB = 2048;
+
+/// @brief 按 DatabaseConfig::retentionDays 自动清理交易记录的间隔
+constexpr int64_t kRetentionIntervalMs = 24 * 60 * 60 * 1000;
+
+/// @brief 清理任务的一批：沿 (timestamp, id) 索引从最旧的记录开始取一段记录ID，再按记录ID索引删除；
+///        已删除的记录不会留在索引中，每批都从索引开头读取，不需要记录上一批的位置
+constexpr const char* kRetentionBatchSql = "DELETE FROM transactions WHERE id IN ("
+                                           "SELECT id FROM transactions WHERE timestamp < ? ORDER BY timestamp, id "
+                                           "LIMIT ?)";
+
+/// @brief 结构迁移每批移动的交易记录数；每批在独立的短事务中复制、删除并记录进度，tick 在时间预算内执行若干批
+constexpr int kMigrationBatchRows = 1000;
+
+/// @brief 第 1 版交易记录表：XUID、币种ID与交易类型以文本存储，读取时按字典表与 TransactionType 的枚举值转换；
+///        无法识别的交易类型转换为 NULL，在迁移开始前拒绝加载
+constexpr LegacyTransactionSource kLegacyV1Transactions{
+    "transactions_v1",
+    "SELECT a.id AS account_id, t.timestamp AS timestamp, t.id AS id, c.id AS currency_key, t.amount AS amount, "
+    "t.balance AS balance, CASE t.type WHEN 'set' THEN 0 WHEN 'add' THEN 1 WHEN 'reduce' THEN 2 "
+    "WHEN 'transfer' THEN 3 WHEN 'initial' THEN 4 END AS type, t.description AS description, "
+    "r.id AS related_account_id, t.transfer_id AS transfer_id "
+    "FROM transactions_v1 t "
+    "JOIN accounts a ON a.xuid = t.xuid "
+    "JOIN currency_keys c ON c.code = t.currency_id "
+    "LEFT JOIN accounts r ON r.xuid = t.related_xuid",
+    "WHERE t.xuid = ?1"
+};
+
+/// @brief 第 2 版交易记录表：与新表的列相同，按自增ID存储
+constexpr LegacyTransactionSource kLegacyV2Transactions{
+    "transactions_v2",
+    "SELECT account_id, timestamp, id, currency_key, amount, balance, type, description, related_account_id, "
+    "transfer_id FROM transactions_v2",
+    "WHERE account_id = (SELECT id FROM accounts WHERE xuid = ?1)"
+};
+
+/// @brief 移入新表的记录已由新表的插入触发器计入汇总表，按新表中该ID范围内的记录减去它们在旧表中的计数
+constexpr const char* kMigrationAggregateSql[] = {
+    "UPDATE player_aggregates SET transaction_count = transaction_count - m.moved "
+    "FROM (SELECT account_id, COUNT(*) AS moved FROM transactions WHERE id > ?1 AND id <= ?2 GROUP BY account_id) m "
+    "WHERE player_aggregates.account_id = m.account_id",
+    "UPDATE type_aggregates SET transaction_count = transaction_count - m.moved "
+    "FROM (SELECT type, COUNT(*) AS moved FROM transactions WHERE id > ?1 AND id <= ?2 GROUP BY type) m "
+    "WHERE type_aggregates.type = m.type"
+};
+
+/// @brief 表是否存在
+bool tableExists(SQLite::Database& db, const char* name) {
+    SQLite::Statement stmt(db, "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = ?");
+    stmt.bind(1, name);
+    return stmt.executeStep();
+}
+
+/// @brief 保留天数对应的截止时间戳（秒）
+int64_t retentionCutoff(int daysToKeep) {
+    auto currentTime =
+        std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    return currentTime - static_cast<int64_t>(daysToKeep) * 24 * 60 * 60;
+}
+
+/// @brief 当前 steady_clock 毫秒数
+int64_t steadyNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/// @brief 迁移用 SQL 函数 rlx_transfer_id(text)：24 位十六进制转账ID转为 12 字节 BLOB，其他值原样返回
+void transferIdToBlob(sqlite3_context* context, int, sqlite3_value** argv) {
+    auto hexValue = [](unsigned char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+
+    const auto* text = sqlite3_value_text(argv[0]);
+    if (sqlite3_value_type(argv[0]) == SQLITE_TEXT && sqlite3_value_bytes(argv[0]) == 24) {
+        unsigned char bytes[12];
+        bool          valid = true;
+        for (int i = 0; i < 12 && valid; ++i) {
+            int high = hexValue(text[i * 2]);
+            int low  = hexValue(text[i * 2 + 1]);
+            valid    = high >= 0 && low >= 0;
+            bytes[i] = static_cast<unsigned char>(high << 4 | low);
+        }
+        if (valid) {
+            sqlite3_result_blob(context, bytes, sizeof(bytes), SQLITE_TRANSIENT);
+            return;
+        }
+    }
+    sqlite3_result_value(context, argv[0]);
+}
+
+} // namespace
+
 DatabaseManager& DatabaseManager::getInstance() {
     static DatabaseManager instance;
     return instance;
 }
 
-DatabaseManager::~DatabaseManager() { close(); }
+DatabaseManager::~DatabaseManager() { close(); }
+
+bool DatabaseManager::initialize(const std::string& dbPath) {
+    DatabaseConfig config;
+    config.path = dbPath;
+    return initialize(config);
+}
+
+bool DatabaseManager::initialize(const DatabaseConfig& config) {
+    const std::string& dbPath = config.path;
+    try {
+        // 如果已初始化，检查路径是否相同
+        if (mInitialized) {
+            if (mDatabasePath == dbPath) {
+                // 已初始化且路径相同，直接返回成功
+                return true;
+            } else {
+                // 已初始化但路径不同，这是错误情况（在生产环境中不应该发生）
+                throw DatabaseException("数据库已初始化，无法切换到不同路径: " + dbPath);
+            }
+        }
+
+        // 首次初始化
+        mDatabasePath = dbPath;
+        mConfig       = config;
+
+        // 确保数据库文件所在目录存在
+        std::filesystem::path dbFilePath(dbPath);
+        std::filesystem::path dbDir = dbFilePath.parent_path();
+        if (!dbDir.empty() && !std::filesystem::exists(dbDir)) {
+            std::filesystem::create_directories(dbDir);
+        }
+
+        // 创建数据库连接
+        mDatabase = std::make_unique<SQLite::Database>(dbPath, SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE);
+
+        // 旧交易记录表由 createTables() 发现后重新登记
+        mLegacyTransactions.store(nullptr, std::memory_order_release);
+        {
+            std::lock_guard lock(mMigrationMutex);
+            mMigrationProgress = {};
+            mMigrationSource   = nullptr;
+            mLegacyDrained     = false;
+            mMigrationWrite    = WriteHandle();
+            mMigrationStep.reset();
+        }
+
+        // 配置优化参数
+        if (!configureOptimization(*mDatabase)) {
+            throw DatabaseException("数据库优化配置失败");
+        }
+
+        // 创建表结构
+        if (!createTables(*mDatabase)) {
+            throw DatabaseException("创建数据库表失败");
+        }
+
+        // 为尚无统计信息或变化较大的表收集统计信息，让优化器按实际数据分布选择索引
+        mDatabase->exec("PRAGMA optimize = 0x10002");
+        mLastOptimizeMs.store(steadyNowMs(), std::memory_order_relaxed);
+        mLastBackupMs = steadyNowMs();
+
+        // 上次运行未完成的清理任务由 stepRetention() 继续
+        {
+            std::lock_guard   lock(mRetentionMutex);
+            SQLite::Statement job(*mDatabase, "SELECT cutoff_time, deleted FROM retention_job WHERE id = 1");
+            mRetentionProgress = {};
+            mLastRetentionMs   = 0;
+            mRetentionWrite    = WriteHandle();
+            mRetentionStep.reset();
+            if (job.executeStep()) {
+                mRetentionProgress.state          = RetentionState::Running;
+                mRetentionProgress.cutoffTime     = job.getColumn(0).getInt64();
+                mRetentionProgress.deletedRecords = job.getColumn(1).getInt64();
+            }
+        }
+
+        mStatementCache = std::make_unique<StatementCache>(*mDatabase);
+
+        // WAL 模式下读者不阻塞写者，为只读查询打开独立连接
+        if (mWalEnabled) {
+            openReadPool();
+        }
+
+        if (mConfig.asyncWriter) {
+            startWriter();
+        }
+
+        mInitialized = true;
+        return true;
+
+    } catch (const SQLite::Exception& e) {
+        throw DatabaseException("初始化数据库失败: " + std::string(e.what()));
+    }
+}
+
+SQLite::Database& DatabaseManager::getConnection() const {
+    if (!mInitialized || !mDatabase) {
+        throw DatabaseException("数据库未初始化");
+    }
+
+    return *mDatabase;
+}
+
+CachedStatement DatabaseManager::prepareCached(std::string_view sql) {
+    if (!mInitialized || !mDatabase || !mStatementCache) {
+        throw DatabaseException("数据库未初始化");
+    }
+
+    waitForOwnWrites();
+    ConnectionLease lease(mWriterMutex);
+    return mStatementCache->acquire(sql, std::move(lease));
+}
+
+CachedStatement DatabaseManager::prepareRead(std::string_view sql) {
+    // 组事务未提交时只有写连接能看到其中的修改
+    if (mReadPool.empty() || tTransactionDepth > 0 || mGroupOpen.load(std::memory_order_acquire)) {
+        return prepareCached(sql);
+    }
+
+    waitForOwnWrites();
+
+    // 优先选择空闲连接；全部繁忙时在轮询到的连接上等待
+    const size_t start = mNextReader.fetch_add(1, std::memory_order_relaxed);
+    for (size_t i = 0; i < mReadPool.size(); ++i) {
+        auto&           reader = *mReadPool[(start + i) % mReadPool.size()];
+        ConnectionLease lease(reader.mutex, std::try_to_lock);
+        if (lease.owns_lock()) {
+            return reader.statementCache->acquire(sql, std::move(lease));
+        }
+    }
+
+    auto&           reader = *mReadPool[start % mReadPool.size()];
+    ConnectionLease lease(reader.mutex);
+    return reader.statementCache->acquire(sql, std::move(lease));
+}
+
+StatementCacheStats DatabaseManager::getStatementCacheStats() const {
+    ConnectionLease lease(mWriterMutex);
+    if (!mStatementCache) {
+        return {};
+    }
+    return mStatementCache->getStats();
+}
+
+bool DatabaseManager::executeTransaction(const std::function<bool(SQLite::Database&)>& transaction) {
+    if (!mInitialized || !mDatabase) {
+        throw DatabaseException("数据库未初始化");
+    }
+
+    // 异步模式下交给写线程执行，保证与已投递的写事务保持提交顺序
+    if (mWriterThread.joinable() && !tIsWriterThread) {
+        return enqueueWrite(transaction).get();
+    }
+
+    ConnectionLease lease(mWriterMutex);
+    // 在事务函数内再次调用时不能再次 BEGIN，改为在嵌套保存点内执行，失败只撤销本次调用
+    if (tTransactionDepth > 0) {
+        return runNested(transaction);
+    }
+    if (!mConfig.groupCommit) {
+        return runTransaction(transaction);
+    }
+
+    // 同步组提交：首个操作打开组事务，每个操作在自己的保存点内执行，失败只回滚自身
+    if (!mGroupOpen.load(std::memory_order_relaxed)) {
+        try {
+            mDatabase->exec("BEGIN IMMEDIATE TRANSACTION;");
+        } catch (const SQLite::Exception& e) {
+            throw DatabaseException("事务执行失败: " + std::string(e.what()));
+        }
+        mGroupStartedAt = std::chrono::steady_clock::now();
+        mGroupOpen.store(true, std::memory_order_release);
+    }
+
+    bool result = runInSavepoint(transaction);
+
+    if (mConfig.groupCommitWindowMs > 0
+        && std::chrono::steady_clock::now() - mGroupStartedAt
+               >= std::chrono::milliseconds(mConfig.groupCommitWindowMs)) {
+        commitGroup();
+    }
+    return result;
+}
+
+WriteHandle
+DatabaseManager::submitTransaction(std::function<bool(SQLite::Database&)> transaction, bool readYourWrites) {
+    if (!mInitialized || !mDatabase) {
+        throw DatabaseException("数据库未初始化");
+    }
+
+    if (mWriterThread.joinable() && !tIsWriterThread) {
+        return enqueueWrite(std::move(transaction), readYourWrites);
+    }
+
+    std::promise<bool> promise;
+    try {
+        promise.set_value(executeTransaction(transaction));
+    } catch (...) {
+        promise.set_exception(std::current_exception());
+    }
+    return promise.get_future().share();
+}
+
+void DatabaseManager::flushWrites() {
+    if (!mWriterThread.joinable() || tIsWriterThread) {
+        return;
+    }
+    enqueueWrite(nullptr).wait();
+}
+
+bool DatabaseManager::isAsyncWriterEnabled() const { return mWriterThread.joinable(); }
+
+void DatabaseManager::flushGroupCommit() {
+    if (!mGroupOpen.load(std::memory_order_acquire)) {
+        return;
+    }
+    ConnectionLease lease(mWriterMutex);
+    commitGroup();
+}
+
+bool DatabaseManager::isGroupCommitEnabled() const { return mConfig.groupCommit; }
+
+GroupCommitStats DatabaseManager::getGroupCommitStats() const {
+    ConnectionLease lease(mWriterMutex);
+    return mGroupStats;
+}
+
+void DatabaseManager::setGroupRollbackListener(std::function<void()> listener) {
+    ConnectionLease lease(mWriterMutex);
+    mGroupRollbackListener = std::move(listener);
+}
+
+WriteHandle DatabaseManager::enqueueWrite(std::function<bool(SQLite::Database&)> transaction, bool readYourWrites) {
+    WriteRequest request;
+    request.transaction = std::move(transaction);
+    WriteHandle handle  = request.promise.get_future().share();
+
+    mWriteQueue.push(std::move(request));
+    mWriteSignal.fetch_add(1, std::memory_order_release);
+    mWriteSignal.notify_one();
+
+    if (readYourWrites) {
+        tLastWrite = handle;
+    }
+    return handle;
+}
+
+void DatabaseManager::waitForOwnWrites() const {
+    if (tLastWrite.valid() && !tIsWriterThread) {
+        tLastWrite.wait();
+        tLastWrite = WriteHandle();
+    }
+}
+
+void DatabaseManager::startWriter() {
+    mStopWriter.store(false, std::memory_order_release);
+    mWriterThread = std::thread([this] { writerLoop(); });
+}
+
+void DatabaseManager::stopWriter() {
+    if (!mWriterThread.joinable()) {
+        return;
+    }
+    mStopWriter.store(true, std::memory_order_release);
+    mWriteSignal.fetch_add(1, std::memory_order_release);
+    mWriteSignal.notify_one();
+    mWriterThread.join();
+}
+
+void DatabaseManager::writerLoop() {
+    tIsWriterThread = true;
+
+    while (true) {
+        // 先读信号再出队：若出队为空后才有新请求，信号值必然已变化，wait 会立即返回
+        const uint32_t signal  = mWriteSignal.load(std::memory_order_acquire);
+        auto           request = mWriteQueue.pop();
+        if (!request) {
+            if (mStopWriter.load(std::memory_order_acquire)) {
+                break;
+            }
+            mWriteSignal.wait(signal, std::memory_order_acquire);
+            continue;
+        }
+
+        if (mConfig.groupCommit) {
+            // 取出当前已排队的全部请求，合并为一个事务提交
+            std::vector<WriteRequest> batch;
+            batch.push_back(std::move(*request));
+            while (auto next = mWriteQueue.pop()) {
+                batch.push_back(std::move(*next));
+            }
+            applyWriteBatch(batch);
+            continue;
+        }
+
+        if (!request->transaction) {
+            request->promise.set_value(true);
+            continue;
+        }
+
+        try {
+            ConnectionLease lease(mWriterMutex);
+            request->promise.set_value(runTransaction(request->transaction));
+        } catch (...) {
+            request->promise.set_exception(std::current_exception());
+        }
+    }
+}
+
+void DatabaseManager::applyWriteBatch(std::vector<WriteRequest>& batch) {
+    ConnectionLease lease(mWriterMutex);
+
+    // 每个请求的结果：提交/回滚，或在自己保存点内抛出的异常
+    std::vector<bool>               results(batch.size(), false);
+    std::vector<std::exception_ptr> errors(batch.size());
+    try {
+        mDatabase->exec("BEGIN IMMEDIATE TRANSACTION;");
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (!batch[i].transaction) {
+                results[i] = true;
+                continue;
+            }
+            try {
+                results[i] = runInSavepoint(batch[i].transaction);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+        mDatabase->exec("COMMIT;");
+        ++mGroupStats.commits;
+    } catch (const SQLite::Exception& e) {
+        try {
+            mDatabase->exec("ROLLBACK;");
+        } catch (...) {}
+        // 整组提交失败，组内所有请求都未持久化
+        auto error = std::make_exception_ptr(DatabaseException("组提交失败: " + std::string(e.what())));
+        for (auto& request : batch) {
+            request.promise.set_exception(error);
+        }
+        return;
+    }
+
+    // 提交成功后才通知调用方，句柄就绪即代表已持久化
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (errors[i]) {
+            batch[i].promise.set_exception(errors[i]);
+        } else {
+            batch[i].promise.set_value(results[i]);
+        }
+    }
+}
+
+bool DatabaseManager::runInSavepoint(const std::function<bool(SQLite::Database&)>& transaction) {
+    TransactionDepthGuard depthGuard;
+    ++mGroupStats.operations;
+    mNestedReleased = false;
+
+    auto rollbackToSavepoint = [this]() {
+        ++mGroupStats.failedOperations;
+        try {
+            mDatabase->exec("ROLLBACK TO rlx_group_op;");
+            mDatabase->exec("RELEASE rlx_group_op;");
+        } catch (...) {}
+        notifyNestedRollback();
+    };
+
+    try {
+        mDatabase->exec("SAVEPOINT rlx_group_op;");
+
+        if (transaction(*mDatabase)) {
+            mDatabase->exec("RELEASE rlx_group_op;");
+            return true;
+        }
+        rollbackToSavepoint();
+        return false;
+
+    } catch (const SQLite::Exception& e) {
+        rollbackToSavepoint();
+        throw DatabaseException("事务执行失败: " + std::string(e.what()));
+    } catch (const std::exception& e) {
+        rollbackToSavepoint();
+        throw DatabaseException("事务执行失败: " + std::string(e.what()));
+    } catch (...) {
+        rollbackToSavepoint();
+        throw;
+    }
+}
+
+bool DatabaseManager::runNested(const std::function<bool(SQLite::Database&)>& transaction) {
+    TransactionDepthGuard depthGuard;
+    const std::string     savepoint = "rlx_nested_" + std::to_string(tTransactionDepth);
+
+    // 回滚到保存点只撤销本次调用内的写入，之前已释放的同级保存点不受影响
+    bool releasedBefore = mNestedReleased;
+    mNestedReleased     = false;
+
+    auto rollbackToSavepoint = [&]() {
+        try {
+            mDatabase->exec("ROLLBACK TO " + savepoint);
+            mDatabase->exec("RELEASE " + savepoint);
+        } catch (...) {}
+        notifyNestedRollback();
+        mNestedReleased = releasedBefore;
+    };
+
+    try {
+        mDatabase->exec("SAVEPOINT " + savepoint);
+
+        if (transaction(*mDatabase)) {
+            mDatabase->exec("RELEASE " + savepoint);
+            mNestedReleased = true;
+            return true;
+        }
+        rollbackToSavepoint();
+        return false;
+
+    } catch (const SQLite::Exception& e) {
+        rollbackToSavepoint();
+        throw DatabaseException("事务执行失败: " + std::string(e.what()));
+    } catch (const std::exception& e) {
+        rollbackToSavepoint();
+        throw DatabaseException("事务执行失败: " + std::string(e.what()));
+    } catch (...) {
+        rollbackToSavepoint();
+        throw;
+    }
+}
+
+void DatabaseManager::notifyNestedRollback() {
+    // 嵌套调用返回 true 后调用方已据此更新内存状态，外层回滚会一并撤销这些写入
+    if (mNestedReleased) {
+        mNestedReleased = false;
+        if (mGroupRollbackListener) {
+            mGroupRollbackListener();
+        }
+    }
+}
+
+void DatabaseManager::commitGroup() {
+    if (!mGroupOpen.load(std::memory_order_relaxed)) {
+        return;
+    }
+    mGroupOpen.store(false, std::memory_order_release);
+
+    try {
+        mDatabase->exec("COMMIT;");
+        ++mGroupStats.commits;
+    } catch (const SQLite::Exception& e) {
+        try {
+            mDatabase->exec("ROLLBACK;");
+        } catch (...) {}
+        if (mGroupRollbackListener) {
+            mGroupRollbackListener();
+        }
+        throw DatabaseException("组提交失败: " + std::string(e.what()));
+    }
+}
+
+bool DatabaseManager::runTransaction(const std::function<bool(SQLite::Database&)>& transaction) {
+    TransactionDepthGuard depthGuard;
+    mNestedReleased = false;
+
+    auto rollback = [this]() {
+        try {
+            mDatabase->exec("ROLLBACK;");
+        } catch (...) {}
+        notifyNestedRollback();
+    };
+
+    try {
+        // 使用 IMMEDIATE 事务避免并发冲突（单线程下同样适用）
+        mDatabase->exec("BEGIN IMMEDIATE TRANSACTION;");
+
+        bool result = transaction(*mDatabase);
+
+        if (result) {
+            mDatabase->exec("COMMIT;");
+            return true;
+        } else {
+            rollback();
+            return false;
+        }
+
+    } catch (const SQLite::Exception& e) {
+        rollback();
+        throw DatabaseException("事务执行失败: " + std::string(e.what()));
+    } catch (const std::exception& e) {
+        rollback();
+        throw DatabaseException("事务执行失败: " + std::string(e.what()));
+    } catch (...) {
+        rollback();
+        throw;
+    }
+}
+
+
+CheckpointResult DatabaseManager::checkpoint(CheckpointMode mode) {
+    if (!mInitialized || !mDatabase) {
+        throw DatabaseException("数据库未初始化");
+    }
+
+    const char* sql = "PRAGMA wal_checkpoint(PASSIVE)";
+    switch (mode) {
+    case CheckpointMode::Passive:
+        break;
+    case CheckpointMode::Full:
+        sql = "PRAGMA wal_checkpoint(FULL)";
+        break;
+    case CheckpointMode::Restart:
+        sql = "PRAGMA wal_checkpoint(RESTART)";
+        break;
+    case CheckpointMode::Truncate:
+        sql = "PRAGMA wal_checkpoint(TRUNCATE)";
+        break;
+    }
+
+    try {
+        ConnectionLease   lease(mWriterMutex);
+        SQLite::Statement stmt(*mDatabase, sql);
+        CheckpointResult  result;
+        if (stmt.executeStep()) {
+            result.busy               = stmt.getColumn(0).getInt() != 0;
+            result.logFrames          = stmt.getColumn(1).getInt();
+            result.checkpointedFrames = stmt.getColumn(2).getInt();
+        }
+        return result;
+    } catch (const SQLite::Exception& e) {
+        throw DatabaseException("执行 WAL 检查点失败: " + std::string(e.what()));
+    }
+}
+
+void DatabaseManager::optimize() {
+    if (!mDatabase) {
+        throw DatabaseException("数据库未初始化");
+    }
+    try {
+        ConnectionLease lease(mWriterMutex);
+        mDatabase->exec("PRAGMA optimize");
+        mLastOptimizeMs.store(steadyNowMs(), std::memory_order_relaxed);
+    } catch (const SQLite::Exception& e) {
+        throw DatabaseException("更新统计信息失败: " + std::string(e.what()));
+    }
+}
+
+void DatabaseManager::optimizeIfDue() {
+    if (!isInitialized() || steadyNowMs() - mLastOptimizeMs.load(std::memory_order_relaxed) < kOptimizeIntervalMs) {
+        return;
+    }
+    optimize();
+}
+
+std::string DatabaseManager::startBackup() {
+    if (!isInitialized()) {
+        throw DatabaseException("数据库未初始化");
+    }
+
+    std::lock_guard lock(mBackupMutex);
+    if (mBackup) {
+        throw DatabaseException("已有备份正在进行: " + mBackupProgress.path);
+    }
+
+    std::filesystem::path directory = getBackupDirectory();
+    std::error_code       error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        throw DatabaseException("无法创建备份目录: " + directory.string());
+    }
+
+    // 文件名中的 UTC 时间精确到毫秒，按文件名排序即按备份时间排序
+    auto now  = std::chrono::system_clock::now();
+    auto days = std::chrono::floor<std::chrono::days>(now);
+    std::chrono::year_month_day date{days};
+    std::chrono::hh_mm_ss       time{std::chrono::floor<std::chrono::milliseconds>(now - days)};
+    char                        stamp[32];
+    std::snprintf(
+        stamp,
+        sizeof(stamp),
+        "%04d%02u%02u-%02d%02d%02d-%03d",
+        static_cast<int>(date.year()),
+        static_cast<unsigned>(date.month()),
+        static_cast<unsigned>(date.day()),
+        static_cast<int>(time.hours().count()),
+        static_cast<int>(time.minutes().count()),
+        static_cast<int>(time.seconds().count()),
+        static_cast<int>(time.subseconds().count())
+    );
+    std::string stem = std::filesystem::path(mDatabasePath).stem().string();
+    std::string path = (directory / (stem + "-" + stamp + ".db")).string();
+
+    // 复制到临时文件，全部完成后再改名，目录中的备份文件总是完整的
+    std::string partialPath = path + ".partial";
+    std::filesystem::remove(partialPath, error);
+
+    sqlite3* backupDb = nullptr;
+    if (sqlite3_open_v2(partialPath.c_str(), &backupDb, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr)
+        != SQLITE_OK) {
+        std::string message = backupDb ? sqlite3_errmsg(backupDb) : "内存不足";
+        sqlite3_close(backupDb);
+        throw DatabaseException("无法创建备份文件: " + message);
+    }
+    sqlite3_backup* backup = sqlite3_backup_init(backupDb, "main", mDatabase->getHandle(), "main");
+    if (!backup) {
+        std::string message = sqlite3_errmsg(backupDb);
+        sqlite3_close(backupDb);
+        std::filesystem::remove(partialPath, error);
+        throw DatabaseException("无法开始备份: " + message);
+    }
+
+    mBackupDb       = backupDb;
+    mBackup         = backup;
+    mBackupProgress = BackupProgress{BackupState::Running, path};
+    mLastBackupMs   = steadyNowMs();
+    return path;
+}
+
+BackupProgress DatabaseManager::stepBackup() {
+    if (!isInitialized()) {
+        return getBackupProgress();
+    }
+
+    std::unique_lock lock(mBackupMutex);
+    if (!mBackup) {
+        int64_t intervalMs = static_cast<int64_t>(mConfig.backupIntervalMinutes) * 60 * 1000;
+        if (intervalMs <= 0 || steadyNowMs() - mLastBackupMs < intervalMs) {
+            return mBackupProgress;
+        }
+        // 到达定时备份间隔；先记下时间，开始失败时不会每个 tick 重试
+        mLastBackupMs = steadyNowMs();
+        lock.unlock();
+        startBackup();
+        lock.lock();
+        if (!mBackup) {
+            return mBackupProgress;
+        }
+    }
+
+    // 不等待写连接：写线程或未提交的组事务正占用写连接时留到下个 tick，游戏线程不会因备份卡顿
+    ConnectionLease lease(mWriterMutex, std::try_to_lock);
+    if (!lease.owns_lock() || sqlite3_get_autocommit(mDatabase->getHandle()) == 0) {
+        return mBackupProgress;
+    }
+    int result = sqlite3_backup_step(mBackup, mConfig.backupPagesPerTick);
+    lease.unlock();
+
+    mBackupProgress.totalPages     = sqlite3_backup_pagecount(mBackup);
+    mBackupProgress.remainingPages = sqlite3_backup_remaining(mBackup);
+    if (result == SQLITE_DONE) {
+        finishBackup({});
+    } else if (result != SQLITE_OK && result != SQLITE_BUSY && result != SQLITE_LOCKED) {
+        finishBackup(std::string("复制页面失败: ") + sqlite3_errstr(result));
+    }
+    return mBackupProgress;
+}
+
+bool DatabaseManager::cancelBackup() {
+    std::lock_guard lock(mBackupMutex);
+    if (!mBackup) {
+        return false;
+    }
+    finishBackup("备份已取消");
+    return true;
+}
+
+BackupProgress DatabaseManager::getBackupProgress() const {
+    std::lock_guard lock(mBackupMutex);
+    return mBackupProgress;
+}
+
+void DatabaseManager::finishBackup(std::string error) {
+    int result = sqlite3_backup_finish(mBackup);
+    mBackup    = nullptr;
+    if (error.empty() && result != SQLITE_OK) {
+        error = sqlite3_errmsg(mBackupDb);
+    }
+    sqlite3_close(mBackupDb);
+    mBackupDb = nullptr;
+
+    std::string     partialPath = mBackupProgress.path + ".partial";
+    std::error_code fileError;
+    if (error.empty()) {
+        std::filesystem::rename(partialPath, mBackupProgress.path, fileError);
+        if (fileError) {
+            error = "无法重命名备份文件: " + fileError.message();
+        }
+    }
+    if (!error.empty()) {
+        std::filesystem::remove(partialPath, fileError);
+        mBackupProgress.state = BackupState::Failed;
+        mBackupProgress.error = std::move(error);
+        return;
+    }
+    mBackupProgress.state          = BackupState::Completed;
+    mBackupProgress.remainingPages = 0;
+    pruneBackups();
+}
+
+void DatabaseManager::pruneBackups() {
+    std::string prefix = std::filesystem::path(mDatabasePath).stem().string() + "-";
+
+    std::vector<std::filesystem::path> backups;
+    std::error_code                    error;
+    for (const auto& file : std::filesystem::directory_iterator(getBackupDirectory(), error)) {
+        std::string name = file.path().filename().string();
+        if (file.is_regular_file(error) && name.starts_with(prefix) && name.ends_with(".db")) {
+            backups.push_back(file.path());
+        }
+    }
+    if (backups.size() <= static_cast<size_t>(mConfig.backupKeep)) {
+        return;
+    }
+    std::sort(backups.begin(), backups.end());
+    for (size_t i = 0; i + mConfig.backupKeep < backups.size(); ++i) {
+        std::filesystem::remove(backups[i], error);
+    }
+}
+
+std::filesystem::path DatabaseManager::getBackupDirectory() const {
+    if (!mConfig.backupDir.empty()) {
+        return mConfig.backupDir;
+    }
+    return std::filesystem::path(mDatabasePath).parent_path() / "backups";
+}
+
+std::filesystem::path DatabaseManager::getArchiveDirectory() const {
+    if (!mConfig.archiveDir.empty()) {
+        return mConfig.archiveDir;
+    }
+    return std::filesystem::path(mDatabasePath).parent_path() / "archive";
+}
+
+RetentionProgress DatabaseManager::startRetention(int daysToKeep) {
+    if (daysToKeep < 1) {
+        throw InvalidArgumentException("保留天数必须大于 0");
+    }
+    if (!isInitialized()) {
+        throw DatabaseException("数据库未初始化");
+    }
+
+    std::lock_guard lock(mRetentionMutex);
+    if (mRetentionProgress.state == RetentionState::Running) {
+        throw DatabaseException("已有清理任务正在进行");
+    }
+    beginRetention(retentionCutoff(daysToKeep));
+    return mRetentionProgress;
+}
+
+void DatabaseManager::beginRetention(int64_t cutoffTime) {
+    bool committed = executeTransaction([&](SQLite::Database& db) {
+        SQLite::Statement stmt(db, "INSERT OR REPLACE INTO retention_job (id, cutoff_time, deleted) VALUES (1, ?, 0)");
+        stmt.bind(1, cutoffTime);
+        stmt.exec();
+        return true;
+    });
+    if (!committed) {
+        throw DatabaseException("记录清理任务失败");
+    }
+    int64_t reclaimedBytes = mRetentionProgress.reclaimedBytes;
+    int64_t freeBytes      = mRetentionProgress.freeBytes;
+    mRetentionProgress     = RetentionProgress{RetentionState::Running, cutoffTime, 0, reclaimedBytes, freeBytes};
+}
+
+RetentionProgress DatabaseManager::stepRetention() {
+    if (!isInitialized()) {
+        return getRetentionProgress();
+    }
+
+    std::lock_guard lock(mRetentionMutex);
+    try {
+        if (mWriterThread.joinable()) {
+            submitRetentionStep();
+            return mRetentionProgress;
+        }
+
+        if (mRetentionProgress.state != RetentionState::Running && mConfig.retentionDays > 0
+            && (mLastRetentionMs == 0 || steadyNowMs() - mLastRetentionMs >= kRetentionIntervalMs)) {
+            // 先记下时间，开始失败时不会每个 tick 重试
+            mLastRetentionMs = steadyNowMs();
+            beginRetention(retentionCutoff(mConfig.retentionDays));
+        }
+
+        // 不等待写连接，也不把删除并入未提交的组事务
+        ConnectionLease lease(mWriterMutex, std::try_to_lock);
+        if (!lease.owns_lock() || sqlite3_get_autocommit(mDatabase->getHandle()) == 0) {
+            return mRetentionProgress;
+        }
+
+        // 结构迁移完成前旧表中的记录不在新表上，删除留到迁移完成后进行
+        RetentionStep step{
+            mRetentionProgress.state == RetentionState::Running && getLegacyTransactions() == nullptr,
+            mRetentionProgress.cutoffTime
+        };
+        try {
+            runRetentionStep(step);
+        } catch (...) {
+            applyRetentionStep(step);
+            throw;
+        }
+        applyRetentionStep(step);
+
+    } catch (const std::exception& e) {
+        if (mRetentionProgress.state == RetentionState::Running) {
+            mRetentionProgress.state = RetentionState::Failed;
+            mRetentionProgress.error = e.what();
+        }
+    }
+    return mRetentionProgress;
+}
+
+void DatabaseManager::submitRetentionStep() {
+    if (mRetentionWrite.valid()) {
+        if (mRetentionWrite.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return;
+        }
+        auto write = std::exchange(mRetentionWrite, WriteHandle());
+        auto step  = std::move(mRetentionStep);
+        // 失败的步骤整体回滚，不计入进度
+        write.get();
+        applyRetentionStep(*step);
+    }
+
+    std::optional<int64_t> beginCutoff;
+    if (mRetentionProgress.state != RetentionState::Running && mConfig.retentionDays > 0
+        && (mLastRetentionMs == 0 || steadyNowMs() - mLastRetentionMs >= kRetentionIntervalMs)) {
+        // 任务记录与第一批删除在同一个事务中写入
+        mLastRetentionMs   = steadyNowMs();
+        beginCutoff        = retentionCutoff(mConfig.retentionDays);
+        mRetentionProgress = RetentionProgress{
+            RetentionState::Running,
+            *beginCutoff,
+            0,
+            mRetentionProgress.reclaimedBytes,
+            mRetentionProgress.freeBytes
+        };
+    }
+
+    auto step = std::make_shared<RetentionStep>();
+    step->running    = mRetentionProgress.state == RetentionState::Running && getLegacyTransactions() == nullptr;
+    step->cutoffTime = mRetentionProgress.cutoffTime;
+    // 清理不改变调用方随后读取的数据，之后的读取不必等待本步提交
+    mRetentionWrite = submitTransaction(
+        [this, step, beginCutoff](SQLite::Database& db) {
+            if (beginCutoff) {
+                SQLite::Statement record(
+                    db,
+                    "INSERT OR REPLACE INTO retention_job (id, cutoff_time, deleted) VALUES (1, ?, 0)"
+                );
+                record.bind(1, *beginCutoff);
+                record.exec();
+            }
+            runRetentionStep(*step);
+            return true;
+        },
+        false
+    );
+    mRetentionStep = std::move(step);
+}
+
+void DatabaseManager::runRetentionStep(RetentionStep& step) {
+    if (!step.running) {
+        // 空闲 tick：把删除释放的页逐步归还给文件系统
+        vacuumFreePages(step);
+        return;
+    }
+
+    // 至少执行一批，之后在时间预算内继续
+    int64_t deadline = steadyNowMs() + mConfig.retentionBudgetMs;
+    do {
+        int  deleted = 0;
+        auto batch   = [&](SQLite::Database& db) {
+            SQLite::Statement remove(db, kRetentionBatchSql);
+            remove.bind(1, step.cutoffTime);
+            remove.bind(2, mConfig.retentionBatchSize);
+            deleted = remove.exec();
+
+            SQLite::Statement progress(db, "UPDATE retention_job SET deleted = deleted + ? WHERE id = 1");
+            progress.bind(1, deleted);
+            progress.exec();
+            return true;
+        };
+        auto finish = [](SQLite::Database& db) {
+            db.exec("DELETE FROM retention_job");
+            return true;
+        };
+        runStepBatch(batch);
+        step.deleted += deleted;
+
+        if (deleted < mConfig.retentionBatchSize) {
+            runStepBatch(finish);
+            step.completed = true;
+            break;
+        }
+    } while (steadyNowMs() < deadline);
+}
+
+void DatabaseManager::runStepBatch(const std::function<bool(SQLite::Database&)>& transaction) {
+    // 写线程上已处于投递的事务中，直接写入该事务
+    if (tTransactionDepth > 0) {
+        transaction(*mDatabase);
+    } else {
+        runTransaction(transaction);
+    }
+}
+
+void DatabaseManager::applyRetentionStep(const RetentionStep& step) {
+    if (step.freeBytes) {
+        mRetentionProgress.reclaimedBytes += step.reclaimedBytes;
+        mRetentionProgress.freeBytes       = *step.freeBytes;
+    }
+    // 投递后任务可能已被取消或重新开始
+    if (mRetentionProgress.state != RetentionState::Running || mRetentionProgress.cutoffTime != step.cutoffTime) {
+        return;
+    }
+    mRetentionProgress.deletedRecords += step.deleted;
+    if (step.completed) {
+        mRetentionProgress.state = RetentionState::Completed;
+    }
+}
+
+bool DatabaseManager::isIncrementalVacuumEnabled() const {
+    if (!mInitialized || !mDatabase) {
+        throw DatabaseException("数据库未初始化");
+    }
+    ConnectionLease lease(mWriterMutex);
+    return mDatabase->execAndGet("PRAGMA auto_vacuum").getInt() == 2;
+}
+
+int64_t DatabaseManager::getDatabaseSizeBytes() const {
+    if (!mInitialized || !mDatabase) {
+        throw DatabaseException("数据库未初始化");
+    }
+    ConnectionLease lease(mWriterMutex);
+    return mDatabase->execAndGet("PRAGMA page_count").getInt64() * mDatabase->execAndGet("PRAGMA page_size").getInt64();
+}
+
+bool DatabaseManager::convertToIncrementalVacuum(std::stop_token stopToken) {
+    if (!mInitialized || !mDatabase) {
+        throw DatabaseException("数据库未初始化");
+    }
+    if (tTransactionDepth > 0) {
+        throw DatabaseException("不能在事务内整理数据库");
+    }
+    flushWrites();
+
+    ConnectionLease lease(mWriterMutex);
+    // VACUUM 不能在事务内执行
+    commitGroup();
+    if (mDatabase->execAndGet("PRAGMA auto_vacuum").getInt() == 2) {
+        return false;
+    }
+    if (stopToken.stop_requested()) {
+        throw DatabaseException("整理数据库已取消");
+    }
+
+    // 每执行一定数量的虚拟机指令检查一次停止请求，返回非零时 VACUUM 以 SQLITE_INTERRUPT 中止并回滚
+    sqlite3_progress_handler(
+        mDatabase->getHandle(),
+        10000,
+        [](void* token) { return static_cast<std::stop_token*>(token)->stop_requested() ? 1 : 0; },
+        &stopToken
+    );
+    try {
+        mDatabase->exec("PRAGMA auto_vacuum = INCREMENTAL");
+        mDatabase->exec("VACUUM");
+    } catch (const SQLite::Exception& e) {
+        sqlite3_progress_handler(mDatabase->getHandle(), 0, nullptr, nullptr);
+        if (stopToken.stop_requested()) {
+            throw DatabaseException("整理数据库已取消");
+        }
+        throw DatabaseException("整理数据库失败: " + std::string(e.what()));
+    }
+    sqlite3_progress_handler(mDatabase->getHandle(), 0, nullptr, nullptr);
+    return true;
+}
+
+void DatabaseManager::vacuumFreePages(RetentionStep& step) {
+    if (mConfig.vacuumPagesPerTick <= 0) {
+        return;
+    }
+    auto pragma = [&](const char* sql) { return mDatabase->execAndGet(sql).getInt64(); };
+
+    int64_t pageSize  = pragma("PRAGMA page_size");
+    int64_t freePages = pragma("PRAGMA freelist_count");
+    if (freePages > 0) {
+        // 未启用 auto_vacuum = INCREMENTAL 的数据库（如内存数据库）上为空操作
+        mDatabase->exec("PRAGMA incremental_vacuum(" + std::to_string(mConfig.vacuumPagesPerTick) + ")");
+        int64_t remaining    = pragma("PRAGMA freelist_count");
+        step.reclaimedBytes += (freePages - remaining) * pageSize;
+        freePages            = remaining;
+    }
+    step.freeBytes = freePages * pageSize;
+}
+
+bool DatabaseManager::cancelRetention() {
+    std::lock_guard lock(mRetentionMutex);
+    if (mRetentionProgress.state != RetentionState::Running && mRetentionProgress.state != RetentionState::Failed) {
+        return false;
+    }
+    bool committed = executeTransaction([](SQLite::Database& db) {
+        db.exec("DELETE FROM retention_job");
+        return true;
+    });
+    if (!committed) {
+        throw DatabaseException("取消清理任务失败");
+    }
+    mRetentionProgress.state = RetentionState::Idle;
+    return true;
+}
+
+RetentionProgress DatabaseManager::getRetentionProgress() const {
+    std::lock_guard lock(mRetentionMutex);
+    return mRetentionProgress;
+}
 
-bool DatabaseManager::initialize(const std::string& dbPath) {
+MigrationProgress DatabaseManager::stepMigration() {
+    if (!isInitialized()) {
+        return getMigrationProgress();
+    }
+
+    std::lock_guard lock(mMigrationMutex);
+    if (mMigrationProgress.state != MigrationState::Running) {
+        return mMigrationProgress;
+    }
     try {
-        // 如果已初始化，检查路径是否相同
-        if (mInitialized) {
-            if (mDatabasePath == dbPath) {
-                // 已初始化且路径相同，直接返回成功
-                return true;
-            } else {
-                // 已初始化但路径不同，这是错误情况（在生产环境中不应该发生）
-                throw DatabaseException("数据库已初始化，无法切换到不同路径: " + dbPath);
-            }
+        if (mWriterThread.joinable()) {
+            submitMigrationStep();
+            return mMigrationProgress;
         }
 
-        // 首次初始化
-        mDatabasePath = dbPath;
+        // 不等待写连接，也不把移动并入未提交的组事务
+        ConnectionLease lease(mWriterMutex, std::try_to_lock);
+        if (!lease.owns_lock() || sqlite3_get_autocommit(mDatabase->getHandle()) == 0) {
+            return mMigrationProgress;
+        }
 
-        // 确保数据库文件所在目录存在
-        std::filesystem::path dbFilePath(dbPath);
-        std::filesystem::path dbDir = dbFilePath.parent_path();
-        if (!dbDir.empty() && !std::filesystem::exists(dbDir)) {
-            std::filesystem::create_directories(dbDir);
+        MigrationStep step{mMigrationSource, mLegacyDrained, mMigrationProgress.movedId};
+        try {
+            runMigrationStep(step);
+        } catch (...) {
+            applyMigrationStep(step);
+            throw;
         }
+        applyMigrationStep(step);
 
-        // 创建数据库连接
-        mDatabase = std::make_unique<SQLite::Database>(dbPath, SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE);
+    } catch (const std::exception& e) {
+        mMigrationProgress.state = MigrationState::Failed;
+        mMigrationProgress.error = e.what();
+    }
+    return mMigrationProgress;
+}
 
-        // 配置优化参数
-        if (!configureOptimization(*mDatabase)) {
-            throw DatabaseException("数据库优化配置失败");
+void DatabaseManager::submitMigrationStep() {
+    if (mMigrationWrite.valid()) {
+        if (mMigrationWrite.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return;
         }
-
-        // 创建表结构
-        if (!createTables(*mDatabase)) {
-            throw DatabaseException("创建数据库表失败");
+        auto write = std::exchange(mMigrationWrite, WriteHandle());
+        auto step  = std::move(mMigrationStep);
+        // 失败的步骤整体回滚，不计入进度
+        write.get();
+        applyMigrationStep(*step);
+        if (mMigrationProgress.state != MigrationState::Running) {
+            return;
         }
+    }
 
-        mInitialized = true;
-        return true;
+    auto step = std::make_shared<MigrationStep>();
+    step->source     = mMigrationSource;
+    step->dropLegacy = mLegacyDrained;
+    step->movedId    = mMigrationProgress.movedId;
+    // 移动不改变读取到的数据，之后的读取不必等待本步提交
+    mMigrationWrite = submitTransaction(
+        [this, step](SQLite::Database&) {
+            runMigrationStep(*step);
+            return true;
+        },
+        false
+    );
+    mMigrationStep = std::move(step);
+}
 
-    } catch (const SQLite::Exception& e) {
-        throw DatabaseException("初始化数据库失败: " + std::string(e.what()));
+void DatabaseManager::runMigrationStep(MigrationStep& step) {
+    const std::string table = step.source->table;
+    if (step.dropLegacy) {
+        runStepBatch([&](SQLite::Database& db) {
+            db.exec("DROP TABLE " + table);
+            db.exec("DROP TABLE IF EXISTS migration_progress");
+            return true;
+        });
+        step.dropped = true;
+        return;
     }
+
+    // 每批内按聚簇键顺序插入；转账ID按第 1 版的文本格式转换为 BLOB（已是 BLOB 的原样保留）
+    const std::string moveSql =
+        "INSERT INTO transactions (account_id, timestamp, id, currency_key, amount, balance, type, description, "
+        "related_account_id, transfer_id) "
+        "SELECT account_id, timestamp, id, currency_key, amount, balance, type, description, related_account_id, "
+        "rlx_transfer_id(transfer_id) FROM ("
+        + std::string(step.source->records) + ") WHERE id > ?1 AND id <= ?2 ORDER BY account_id, timestamp, id";
+
+    // 至少执行一批，之后在时间预算内继续
+    int64_t deadline = steadyNowMs() + mConfig.retentionBudgetMs;
+    do {
+        int64_t upper = 0;
+        int     moved = 0;
+        runStepBatch([&](SQLite::Database& db) {
+            // 旧表按自增ID存储，按ID范围分批读取只访问该范围的页
+            SQLite::Statement next(
+                db,
+                "SELECT MAX(id) FROM (SELECT id FROM " + table + " WHERE id > ? ORDER BY id LIMIT ?)"
+            );
+            next.bind(1, step.movedId);
+            next.bind(2, kMigrationBatchRows);
+            if (!next.executeStep() || next.getColumn(0).isNull()) {
+                return true;
+            }
+            upper = next.getColumn(0).getInt64();
+
+            SQLite::Statement copy(db, moveSql);
+            copy.bind(1, step.movedId);
+            copy.bind(2, upper);
+            moved = copy.exec();
+
+            for (const char* sql : kMigrationAggregateSql) {
+                SQLite::Statement adjust(db, sql);
+                adjust.bind(1, step.movedId);
+                adjust.bind(2, upper);
+                adjust.exec();
+            }
+            SQLite::Statement global(
+                db,
+                "UPDATE global_aggregates SET transaction_count = transaction_count - ? WHERE id = 1"
+            );
+            global.bind(1, moved);
+            global.exec();
+
+            // 字典表中缺少对应键的记录无法复制，整批回滚，不会随旧表一起删除
+            SQLite::Statement remove(db, "DELETE FROM " + table + " WHERE id > ? AND id <= ?");
+            remove.bind(1, step.movedId);
+            remove.bind(2, upper);
+            if (remove.exec() != moved) {
+                throw DatabaseException(
+                    "旧交易记录表中记录ID " + std::to_string(step.movedId + 1) + " 到 " + std::to_string(upper)
+                    + " 之间有无法迁移的记录"
+                );
+            }
+
+            SQLite::Statement progress(db, "UPDATE migration_progress SET copied_id = ? WHERE id = 1");
+            progress.bind(1, upper);
+            progress.exec();
+            return true;
+        });
+        if (upper == 0) {
+            step.drained = true;
+            break;
+        }
+        step.movedId  = upper;
+        step.moved   += moved;
+    } while (steadyNowMs() < deadline);
 }
 
-SQLite::Database& DatabaseManager::getConnection() const {
-    if (!mInitialized || !mDatabase) {
-        throw DatabaseException("数据库未初始化");
+void DatabaseManager::applyMigrationStep(const MigrationStep& step) {
+    mMigrationProgress.movedRecords += step.moved;
+    mMigrationProgress.movedId       = step.movedId;
+    if (step.dropped) {
+        mMigrationProgress.state = MigrationState::Completed;
+        mMigrationSource         = nullptr;
+        mLegacyDrained           = false;
+    } else if (step.drained) {
+        // 旧表已经移空：之后的读取只查询新表；已按旧表拼接语句的读取仍可能在执行，旧表留到下一步再删除
+        mLegacyDrained = true;
+        mLegacyTransactions.store(nullptr, std::memory_order_release);
     }
+}
 
-    return *mDatabase;
+MigrationProgress DatabaseManager::getMigrationProgress() const {
+    std::lock_guard lock(mMigrationMutex);
+    return mMigrationProgress;
 }
 
-bool DatabaseManager::executeTransaction(const std::function<bool(SQLite::Database&)>& transaction) {
-    if (!mInitialized || !mDatabase) {
-        throw DatabaseException("数据库未初始化");
-    }
+const LegacyTransactionSource* DatabaseManager::getLegacyTransactions() const {
+    return mLegacyTransactions.load(std::memory_order_acquire);
+}
 
-    try {
-        // 使用 IMMEDIATE 事务避免并发冲突（单线程下同样适用）
-        mDatabase->exec("BEGIN IMMEDIATE TRANSACTION;");
+AggregateCheckResult DatabaseManager::verifyAggregates(bool repair) {
+    // 在写事务中比对，校验期间明细与汇总表不会被修改
+    AggregateCheckResult result;
+    bool committed = executeTransaction([&](SQLite::Database& db) -> bool {
+        // 结构迁移期间交易记录分布在新旧两表中
+        auto count = [&](const char* sql) {
+            SQLite::Statement stmt(db, withLegacyTransactions(sql));
+            return stmt.executeStep() ? stmt.getColumn(0).getInt() : 0;
+        };
 
-        bool result = transaction(*mDatabase);
+        result.mismatchedCurrencies = count(R"(
+            SELECT COUNT(*) FROM (
+                SELECT d.currency_key FROM (
+                    SELECT currency_key, SUM(balance) AS total_wealth, COUNT(*) AS account_count
+                    FROM player_balances GROUP BY currency_key
+                ) d LEFT JOIN currency_aggregates a ON a.currency_key = d.currency_key
+                WHERE a.currency_key IS NULL OR a.total_wealth <> d.total_wealth
+                   OR a.account_count <> d.account_count
+                UNION ALL
+                SELECT a.currency_key FROM currency_aggregates a
+                WHERE (a.total_wealth <> 0 OR a.account_count <> 0)
+                  AND NOT EXISTS (SELECT 1 FROM player_balances pb WHERE pb.currency_key = a.currency_key)
+            )
+        )");
+        result.mismatchedPlayers = count(R"(
+            SELECT COUNT(*) FROM (
+                SELECT d.account_id FROM (
+                    SELECT account_id, COUNT(*) AS transaction_count FROM transactions GROUP BY account_id
+                ) d LEFT JOIN player_aggregates a ON a.account_id = d.account_id
+                WHERE a.account_id IS NULL OR a.transaction_count <> d.transaction_count
+                UNION ALL
+                SELECT a.account_id FROM player_aggregates a
+                WHERE a.transaction_count <> 0
+                  AND NOT EXISTS (SELECT 1 FROM transactions t WHERE t.account_id = a.account_id)
+            )
+        )");
+        result.mismatchedTypes = count(R"(
+            SELECT COUNT(*) FROM (
+                SELECT d.type FROM (
+                    SELECT type, COUNT(*) AS transaction_count FROM transactions GROUP BY type
+                ) d LEFT JOIN type_aggregates a ON a.type = d.type
+                WHERE a.type IS NULL OR a.transaction_count <> d.transaction_count
+                UNION ALL
+                SELECT a.type FROM type_aggregates a
+                WHERE a.transaction_count <> 0 AND NOT EXISTS (SELECT 1 FROM transactions t WHERE t.type = a.type)
+            )
+        )");
+        result.globalMismatch = count(R"(
+            SELECT NOT EXISTS (
+                SELECT 1 FROM global_aggregates
+                WHERE id = 1 AND player_count = (SELECT COUNT(*) FROM players)
+                  AND transaction_count = (SELECT COUNT(*) FROM transactions)
+            )
+        )") != 0;
 
-        if (result) {
-            mDatabase->exec("COMMIT;");
-            return true;
-        } else {
-            mDatabase->exec("ROLLBACK;");
-            return false;
+        if (repair && !result.consistent()) {
+            rebuildAggregates(db);
+            result.repaired = true;
         }
+        return true;
+    });
+    if (!committed) {
+        throw DatabaseException("校验汇总表失败");
+    }
+    return result;
+}
+
+int64_t DatabaseManager::resolveAccountKey(const std::string& xuid) {
+    return resolveKey(
+        "SELECT id FROM accounts WHERE xuid = ?",
+        "INSERT INTO accounts (xuid) VALUES (?) RETURNING id",
+        xuid
+    );
+}
+
+int64_t DatabaseManager::resolveCurrencyKey(const std::string& currencyId) {
+    return resolveKey(
+        "SELECT id FROM currency_keys WHERE code = ?",
+        "INSERT INTO currency_keys (code) VALUES (?) RETURNING id",
+        currencyId
+    );
+}
 
+int64_t DatabaseManager::resolveKey(std::string_view selectSql, std::string_view insertSql, const std::string& value) {
+    try {
+        {
+            auto select = prepareCached(selectSql);
+            select->bind(1, value);
+            if (select->executeStep()) {
+                return select->getColumn(0).getInt64();
+            }
+        }
+        auto insert = prepareCached(insertSql);
+        insert->bind(1, value);
+        insert->executeStep();
+        return insert->getColumn(0).getInt64();
     } catch (const SQLite::Exception& e) {
-        try {
-            mDatabase->exec("ROLLBACK;");
-        } catch (...) {}
-        throw DatabaseException("事务执行失败: " + std::string(e.what()));
-    } catch (const std::exception& e) {
-        try {
-            mDatabase->exec("ROLLBACK;");
-        } catch (...) {}
-        throw DatabaseException("事务执行失败: " + std::string(e.what()));
-    } catch (...) {
-        try {
-            mDatabase->exec("ROLLBACK;");
-        } catch (...) {}
-        throw;
+        throw DatabaseException("获取字典键失败: " + std::string(e.what()));
     }
 }
 
+bool DatabaseManager::isWalEnabled() const { return mWalEnabled; }
+
+int64_t DatabaseManager::getCacheSizeKB() const { return mCacheSizeKB; }
+
+size_t DatabaseManager::getReadPoolSize() const { return mReadPool.size(); }
 
 bool DatabaseManager::isInitialized() const { return mInitialized && mDatabase != nullptr; }
 
 void DatabaseManager::close() {
+    // 先让写线程提交完队列中的事务，再提交未结束的组事务
+    stopWriter();
+    if (mDatabase && mGroupOpen.load(std::memory_order_acquire)) {
+        ConnectionLease lease(mWriterMutex);
+        try {
+            commitGroup();
+        } catch (const DatabaseException&) {}
+    }
+    // 未完成的备份引用写连接，必须先于连接结束
+    cancelBackup();
+    // 关闭前按本次连接期间的查询更新统计信息
+    if (mDatabase) {
+        try {
+            optimize();
+        } catch (const DatabaseException&) {}
+    }
+    // 只读连接先关闭，让写连接最后关闭时完成检查点并清理 WAL 文件
+    mReadPool.clear();
+    // 缓存的语句引用连接，必须先于连接释放
+    mStatementCache.reset();
     if (mDatabase) {
         mDatabase.reset();
         mInitialized = false;
     }
+    mWalEnabled = false;
+    mLegacyTransactions.store(nullptr, std::memory_order_release);
 }
 
 void DatabaseManager::resetForTesting() {
     // 关闭数据库连接并重置所有状态
     close();
     mDatabasePath.clear();
+    mGroupStats     = {};
+    mBackupProgress = {};
+    std::lock_guard lock(mRetentionMutex);
+    mRetentionProgress = {};
+    mLastRetentionMs   = 0;
+    mRetentionWrite    = WriteHandle();
+    mRetentionStep.reset();
+    std::lock_guard migrationLock(mMigrationMutex);
+    mMigrationProgress = {};
+    mMigrationSource   = nullptr;
+    mLegacyDrained     = false;
+    mMigrationWrite    = WriteHandle();
+    mMigrationStep.reset();
 }
 
 const std::string& DatabaseManager::getDatabasePath() const { return mDatabasePath; }
 
 bool DatabaseManager::createTables(SQLite::Database& db) {
     try {
+        int version = 0;
+        {
+            SQLite::Statement stmt(db, "PRAGMA user_version");
+            if (stmt.executeStep()) {
+                version = stmt.getColumn(0).getInt();
+            }
+        }
+        if (version > kSchemaVersion) {
+            throw DatabaseException(
+                "数据库结构版本 " + std::to_string(version) + " 高于插件支持的版本 " + std::to_string(kSchemaVersion)
+            );
+        }
+
+        // 第 1 版数据库没有设置 user_version，按 player_balances 表是否存在 xuid 列识别；
+        // 交易记录尚未移完时旧表以 transactions_v1 保留，重新启动后继续移动
+        bool legacy = tableExists(db, "transactions_v1");
+        if (!legacy) {
+            SQLite::Statement stmt(db, "SELECT 1 FROM pragma_table_info('player_balances') WHERE name = 'xuid'");
+            legacy = stmt.executeStep();
+        }
+
+        // 删除记录释放的页可由 incremental_vacuum 逐步归还给文件系统。auto_vacuum 只在建表前设置才生效，
+        // 已有数据库切换需要重写整个文件，不在启动时进行，由 convertToIncrementalVacuum() 按需执行
+        if (db.execAndGet("SELECT COUNT(*) FROM sqlite_master").getInt() == 0) {
+            db.exec("PRAGMA auto_vacuum = INCREMENTAL");
+        }
+
         // Currency 现在只存储在配置文件中，不再需要 currencies 和 currency_configs 表
-        return createPlayersTable(db) && createPlayerBalancesTable(db) && createTransactionsTable(db)
-            && createIndexes(db);
+        if (!createPlayersTable(db) || !createKeyTables(db)) {
+            return false;
+        }
+        // 第 2 版的交易记录表为按自增ID存储的 rowid 表，改为按玩家聚簇；
+        // 旧交易记录表在记录移完前以 transactions_v2 保留，重新启动后继续移动
+        if (legacy) {
+            migrateLegacySchema(db);
+        } else if (!createPlayerBalancesTable(db)) {
+            return false;
+        } else if (version == 2 || tableExists(db, "transactions_v2")) {
+            migrateTransactionsToClustered(db);
+        } else if (!createTransactionsTable(db)) {
+            return false;
+        }
+        if (!createJournalCheckpointTable(db) || !createRetentionJobTable(db) || !createAggregateTables(db)
+            || !createIndexes(db)) {
+            return false;
+        }
+        // 结构已是当前版本，交易记录由 stepMigration() 逐 tick 移入新表；迁移释放的页进入空闲列表，
+        // 启用了增量整理的数据库由空闲 tick 逐步归还，其余留待下次写入复用
+        db.exec("PRAGMA user_version = " + std::to_string(kSchemaVersion));
+        return true;
     } catch (const SQLite::Exception& e) {
         throw DatabaseException("创建数据库表失败: " + std::string(e.what()));
     }
@@ -148,17 +1558,43 @@ bool DatabaseManager::createPlayersTable(SQLite::Database& db) {
     }
 }
 
+bool DatabaseManager::createKeyTables(SQLite::Database& db) {
+    // 余额与交易记录只保存整数键，XUID 与币种ID各只存一份
+    const char* statements[] = {
+        R"(
+        CREATE TABLE IF NOT EXISTS accounts (
+            id INTEGER PRIMARY KEY,
+            xuid TEXT NOT NULL UNIQUE
+        )
+        )",
+        R"(
+        CREATE TABLE IF NOT EXISTS currency_keys (
+            id INTEGER PRIMARY KEY,
+            code TEXT NOT NULL UNIQUE
+        )
+        )"
+    };
+
+    try {
+        for (const char* sql : statements) {
+            db.exec(sql);
+        }
+        return true;
+    } catch (const SQLite::Exception& e) {
+        throw DatabaseException("创建字典表失败: " + std::string(e.what()));
+    }
+}
+
 bool DatabaseManager::createPlayerBalancesTable(SQLite::Database& db) {
+    // 主键即聚簇键，WITHOUT ROWID 省去 rowid 与单独的主键索引
     const char* sql = R"(
         CREATE TABLE IF NOT EXISTS player_balances (
-            xuid TEXT NOT NULL,
-            currency_id TEXT NOT NULL,
+            account_id INTEGER NOT NULL,
+            currency_key INTEGER NOT NULL,
             balance INTEGER NOT NULL DEFAULT 0,
             updated_at INTEGER NOT NULL,
-            PRIMARY KEY (xuid, currency_id),
-            FOREIGN KEY (xuid) REFERENCES players(xuid) ON DELETE CASCADE
-            -- currency_id 不再引用 currencies 表，由配置文件验证
-        )
+            PRIMARY KEY (account_id, currency_key)
+        ) WITHOUT ROWID
     )";
 
     try {
@@ -170,21 +1606,198 @@ bool DatabaseManager::createPlayerBalancesTable(SQLite::Database& db) {
 }
 
 bool DatabaseManager::createTransactionsTable(SQLite::Database& db) {
-    const char* sql = R"(
+    // 按 (account_id, timestamp, id) 聚簇：同一玩家的记录按时间相邻存放，查询历史只读取少量连续页；
+    // type 为 TransactionType 的枚举值；transfer_id 为 12 字节 BLOB（读取时还原为 24 位十六进制）
+    // WITHOUT ROWID 表不能自增，记录ID取 transaction_sequence.seq + 1，触发器保证序号只增不减，已删除记录的ID不会复用
+    const char* statements[] = {
+        R"(
         CREATE TABLE IF NOT EXISTS transactions (
-            id INTEGER PRIMARY KEY AUTOINCREMENT,
-            xuid TEXT NOT NULL,
-            currency_id TEXT NOT NULL,
+            account_id INTEGER NOT NULL,
+            timestamp INTEGER NOT NULL,
+            id INTEGER NOT NULL,
+            currency_key INTEGER NOT NULL,
             amount INTEGER NOT NULL,
             balance INTEGER NOT NULL,
-            type TEXT NOT NULL,
+            type INTEGER NOT NULL,
             description TEXT,
-            timestamp INTEGER NOT NULL,
-            related_xuid TEXT,
-            transfer_id TEXT,
-            FOREIGN KEY (xuid) REFERENCES players(xuid),
-            -- currency_id 不再引用 currencies 表，由配置文件验证
-            FOREIGN KEY (related_xuid) REFERENCES players(xuid)
+            related_account_id INTEGER,
+            transfer_id BLOB,
+            PRIMARY KEY (account_id, timestamp, id)
+        ) WITHOUT ROWID
+        )",
+        R"(
+        CREATE TABLE IF NOT EXISTS transaction_sequence (
+            id INTEGER PRIMARY KEY CHECK (id = 1),
+            seq INTEGER NOT NULL
+        )
+        )",
+        "INSERT OR IGNORE INTO transaction_sequence (id, seq) VALUES (1, 0)",
+        R"(
+        CREATE TRIGGER IF NOT EXISTS trg_transactions_sequence AFTER INSERT ON transactions
+        WHEN NEW.id > (SELECT seq FROM transaction_sequence WHERE id = 1)
+        BEGIN
+            UPDATE transaction_sequence SET seq = NEW.id WHERE id = 1;
+        END
+        )"
+    };
+
+    try {
+        for (const char* sql : statements) {
+            db.exec(sql);
+        }
+        return true;
+    } catch (const SQLite::Exception& e) {
+        throw DatabaseException("创建交易记录表失败: " + std::string(e.what()));
+    }
+}
+
+void DatabaseManager::migrateLegacySchema(SQLite::Database& db) {
+    // 上次启动时结构已经转换完成的，直接继续移动交易记录
+    if (!tableExists(db, "transactions_v1")) {
+        // 交易类型必须与 TransactionType 的枚举值一致；无法识别的类型在转换前拒绝加载，修正数据后重新启动
+        SQLite::Statement unknown(
+            db,
+            "SELECT type FROM transactions WHERE type NOT IN ('set', 'add', 'reduce', 'transfer', 'initial') LIMIT 1"
+        );
+        if (unknown.executeStep()) {
+            throw DatabaseException("旧交易记录中有无法识别的交易类型: " + unknown.getColumn(0).getString());
+        }
+
+        SQLite::Transaction transaction(db);
+        convertLegacyTables(db);
+        transaction.commit();
+    }
+    beginMigration(db, kLegacyV1Transactions);
+}
+
+void DatabaseManager::convertLegacyTables(SQLite::Database& db) {
+    // 旧汇总表以文本为键，删除后由 createAggregateTables 按新结构重建并回填
+    const char* dropAggregates[] = {
+        "DROP TRIGGER IF EXISTS trg_player_balances_insert",
+        "DROP TRIGGER IF EXISTS trg_player_balances_update",
+        "DROP TRIGGER IF EXISTS trg_player_balances_move",
+        "DROP TRIGGER IF EXISTS trg_player_balances_delete",
+        "DROP TRIGGER IF EXISTS trg_players_insert",
+        "DROP TRIGGER IF EXISTS trg_players_delete",
+        "DROP TRIGGER IF EXISTS trg_transactions_insert",
+        "DROP TRIGGER IF EXISTS trg_transactions_delete",
+        "DROP TABLE IF EXISTS currency_aggregates",
+        "DROP TABLE IF EXISTS player_aggregates",
+        "DROP TABLE IF EXISTS global_aggregates"
+    };
+    for (const char* sql : dropAggregates) {
+        db.exec(sql);
+    }
+
+    // 旧表改名后保留到数据复制完成；旧索引随旧表一起删除，新索引在迁移后统一创建
+    db.exec("ALTER TABLE player_balances RENAME TO player_balances_v1");
+    db.exec("ALTER TABLE transactions RENAME TO transactions_v1");
+    createPlayerBalancesTable(db);
+    createTransactionsTable(db);
+
+    db.exec(R"(
+        INSERT OR IGNORE INTO accounts (xuid)
+        SELECT xuid FROM players
+        UNION SELECT xuid FROM player_balances_v1
+        UNION SELECT xuid FROM transactions_v1
+        UNION SELECT related_xuid FROM transactions_v1 WHERE related_xuid IS NOT NULL
+    )");
+    db.exec(R"(
+        INSERT OR IGNORE INTO currency_keys (code)
+        SELECT currency_id FROM player_balances_v1
+        UNION SELECT currency_id FROM transactions_v1
+    )");
+
+    db.exec(R"(
+        INSERT INTO player_balances (account_id, currency_key, balance, updated_at)
+        SELECT a.id, c.id, pb.balance, pb.updated_at
+        FROM player_balances_v1 pb
+        JOIN accounts a ON a.xuid = pb.xuid
+        JOIN currency_keys c ON c.code = pb.currency_id
+    )");
+    db.exec("DROP TABLE player_balances_v1");
+}
+
+void DatabaseManager::migrateTransactionsToClustered(SQLite::Database& db) {
+    // 旧索引随改名的旧表保留，迁移期间用于读取旧表；上次启动时已经改名的，直接继续移动
+    if (!tableExists(db, "transactions_v2")) {
+        SQLite::Transaction transaction(db);
+        db.exec("ALTER TABLE transactions RENAME TO transactions_v2");
+        createTransactionsTable(db);
+        transaction.commit();
+    }
+    beginMigration(db, kLegacyV2Transactions);
+}
+
+void DatabaseManager::beginMigration(SQLite::Database& db, const LegacyTransactionSource& source) {
+    const std::string   table = source.table;
+    SQLite::Transaction transaction(db);
+
+    // 汇总触发器随改名的旧表保留并占用原名，删除后由 createAggregateTables 在新表上重建；
+    // 移动时在同一批中抵消新表触发器的计数，汇总值保持不变
+    std::vector<std::string> triggers;
+    {
+        SQLite::Statement stmt(db, "SELECT name FROM sqlite_master WHERE type = 'trigger' AND tbl_name = ?");
+        stmt.bind(1, table);
+        while (stmt.executeStep()) {
+            triggers.push_back(stmt.getColumn(0).getString());
+        }
+    }
+    for (const auto& name : triggers) {
+        db.exec("DROP TRIGGER \"" + name + "\"");
+    }
+
+    // 单行表记录已移入新表的最大旧记录ID
+    db.exec(R"(
+        CREATE TABLE IF NOT EXISTS migration_progress (
+            id INTEGER PRIMARY KEY CHECK (id = 1),
+            copied_id INTEGER NOT NULL
+        )
+    )");
+    db.exec("INSERT OR IGNORE INTO migration_progress (id, copied_id) VALUES (1, 0)");
+    int64_t movedId = db.execAndGet("SELECT copied_id FROM migration_progress WHERE id = 1").getInt64();
+    // 早期版本只复制不删除，已复制的记录仍留在旧表中
+    db.exec("DELETE FROM " + table + " WHERE id <= " + std::to_string(movedId));
+
+    // 新记录的ID越过旧表中的最大ID与自增序号（末尾的记录可能已被删除），移入的记录与已删除记录的ID不会被重新分配
+    SQLite::Statement sequence(
+        db,
+        "UPDATE transaction_sequence SET seq = MAX(seq, COALESCE((SELECT MAX(id) FROM " + table
+            + "), 0), COALESCE((SELECT seq FROM sqlite_sequence WHERE name = ?), 0)) WHERE id = 1"
+    );
+    sequence.bind(1, table);
+    sequence.exec();
+    int64_t lastId = db.execAndGet("SELECT COALESCE(MAX(id), 0) FROM " + table).getInt64();
+    transaction.commit();
+
+    if (sqlite3_create_function_v2(
+            db.getHandle(),
+            "rlx_transfer_id",
+            1,
+            SQLITE_UTF8 | SQLITE_DETERMINISTIC,
+            nullptr,
+            transferIdToBlob,
+            nullptr,
+            nullptr,
+            nullptr
+        )
+        != SQLITE_OK) {
+        throw DatabaseException("注册迁移函数失败: " + std::string(db.getErrorMsg()));
+    }
+
+    // 之后的读取与汇总表计算合并旧表
+    mLegacyTransactions.store(&source, std::memory_order_release);
+    std::lock_guard lock(mMigrationMutex);
+    mMigrationSource   = &source;
+    mMigrationProgress = MigrationProgress{MigrationState::Running, 0, movedId, lastId};
+}
+
+bool DatabaseManager::createJournalCheckpointTable(SQLite::Database& db) {
+    // 单行表：写后模式已写入 transactions 表的最后一条重做日志序号
+    const char* sql = R"(
+        CREATE TABLE IF NOT EXISTS journal_checkpoint (
+            id INTEGER PRIMARY KEY CHECK (id = 1),
+            sequence INTEGER NOT NULL
         )
     )";
 
@@ -192,25 +1805,232 @@ bool DatabaseManager::createTransactionsTable(SQLite::Database& db) {
         db.exec(sql);
         return true;
     } catch (const SQLite::Exception& e) {
-        throw DatabaseException("创建交易记录表失败: " + std::string(e.what()));
+        throw DatabaseException("创建重做日志检查点表失败: " + std::string(e.what()));
+    }
+}
+
+bool DatabaseManager::createRetentionJobTable(SQLite::Database& db) {
+    // 单行表：正在进行的交易记录清理任务（没有任务时为空）
+    const char* sql = R"(
+        CREATE TABLE IF NOT EXISTS retention_job (
+            id INTEGER PRIMARY KEY CHECK (id = 1),
+            cutoff_time INTEGER NOT NULL,
+            deleted INTEGER NOT NULL
+        )
+    )";
+
+    try {
+        db.exec(sql);
+        return true;
+    } catch (const SQLite::Exception& e) {
+        throw DatabaseException("创建清理任务表失败: " + std::string(e.what()));
+    }
+}
+
+bool DatabaseManager::createAggregateTables(SQLite::Database& db) {
+    // 汇总表由触发器在修改明细的同一事务中维护，读取总财富、玩家数量和交易记录数时不再扫描明细表
+    const char* statements[] = {
+        R"(
+        CREATE TABLE IF NOT EXISTS currency_aggregates (
+            currency_key INTEGER PRIMARY KEY,
+            total_wealth INTEGER NOT NULL DEFAULT 0,
+            account_count INTEGER NOT NULL DEFAULT 0
+        )
+        )",
+        R"(
+        CREATE TABLE IF NOT EXISTS player_aggregates (
+            account_id INTEGER PRIMARY KEY,
+            transaction_count INTEGER NOT NULL DEFAULT 0
+        )
+        )",
+        R"(
+        CREATE TABLE IF NOT EXISTS global_aggregates (
+            id INTEGER PRIMARY KEY CHECK (id = 1),
+            player_count INTEGER NOT NULL DEFAULT 0,
+            transaction_count INTEGER NOT NULL DEFAULT 0
+        )
+        )",
+        R"(
+        CREATE TABLE IF NOT EXISTS type_aggregates (
+            type INTEGER PRIMARY KEY,
+            transaction_count INTEGER NOT NULL DEFAULT 0
+        )
+        )",
+        R"(
+        CREATE TRIGGER IF NOT EXISTS trg_player_balances_insert AFTER INSERT ON player_balances
+        BEGIN
+            INSERT INTO currency_aggregates (currency_key, total_wealth, account_count)
+            VALUES (NEW.currency_key, NEW.balance, 1)
+            ON CONFLICT(currency_key) DO UPDATE SET total_wealth = total_wealth + excluded.total_wealth,
+                                                    account_count = account_count + 1;
+        END
+        )",
+        R"(
+        CREATE TRIGGER IF NOT EXISTS trg_player_balances_update AFTER UPDATE OF balance ON player_balances
+        WHEN NEW.balance <> OLD.balance AND NEW.currency_key = OLD.currency_key
+        BEGIN
+            UPDATE currency_aggregates SET total_wealth = total_wealth + NEW.balance - OLD.balance
+            WHERE currency_key = NEW.currency_key;
+        END
+        )",
+        R"(
+        CREATE TRIGGER IF NOT EXISTS trg_player_balances_move AFTER UPDATE OF currency_key ON player_balances
+        WHEN NEW.currency_key <> OLD.currency_key
+        BEGIN
+            UPDATE currency_aggregates SET total_wealth = total_wealth - OLD.balance, account_count = account_count - 1
+            WHERE currency_key = OLD.currency_key;
+            INSERT INTO currency_aggregates (currency_key, total_wealth, account_count)
+            VALUES (NEW.currency_key, NEW.balance, 1)
+            ON CONFLICT(currency_key) DO UPDATE SET total_wealth = total_wealth + excluded.total_wealth,
+                                                    account_count = account_count + 1;
+        END
+        )",
+        R"(
+        CREATE TRIGGER IF NOT EXISTS trg_player_balances_delete AFTER DELETE ON player_balances
+        BEGIN
+            UPDATE currency_aggregates SET total_wealth = total_wealth - OLD.balance, account_count = account_count - 1
+            WHERE currency_key = OLD.currency_key;
+        END
+        )",
+        R"(
+        CREATE TRIGGER IF NOT EXISTS trg_players_insert AFTER INSERT ON players
+        BEGIN
+            UPDATE global_aggregates SET player_count = player_count + 1 WHERE id = 1;
+        END
+        )",
+        R"(
+        CREATE TRIGGER IF NOT EXISTS trg_players_delete AFTER DELETE ON players
+        BEGIN
+            UPDATE global_aggregates SET player_count = player_count - 1 WHERE id = 1;
+        END
+        )",
+        R"(
+        CREATE TRIGGER IF NOT EXISTS trg_transactions_insert AFTER INSERT ON transactions
+        BEGIN
+            INSERT INTO player_aggregates (account_id, transaction_count) VALUES (NEW.account_id, 1)
+            ON CONFLICT(account_id) DO UPDATE SET transaction_count = transaction_count + 1;
+            UPDATE global_aggregates SET transaction_count = transaction_count + 1 WHERE id = 1;
+        END
+        )",
+        R"(
+        CREATE TRIGGER IF NOT EXISTS trg_transactions_delete AFTER DELETE ON transactions
+        BEGIN
+            UPDATE player_aggregates SET transaction_count = transaction_count - 1 WHERE account_id = OLD.account_id;
+            UPDATE global_aggregates SET transaction_count = transaction_count - 1 WHERE id = 1;
+        END
+        )",
+        R"(
+        CREATE TRIGGER IF NOT EXISTS trg_transactions_type_insert AFTER INSERT ON transactions
+        BEGIN
+            INSERT INTO type_aggregates (type, transaction_count) VALUES (NEW.type, 1)
+            ON CONFLICT(type) DO UPDATE SET transaction_count = transaction_count + 1;
+        END
+        )",
+        R"(
+        CREATE TRIGGER IF NOT EXISTS trg_transactions_type_delete AFTER DELETE ON transactions
+        BEGIN
+            UPDATE type_aggregates SET transaction_count = transaction_count - 1 WHERE type = OLD.type;
+        END
+        )"
+    };
+
+    try {
+        SQLite::Transaction transaction(db);
+        // 按类型的交易记录数晚于其他汇总表加入，已有汇总表的数据库同样需要回填
+        bool typeAggregatesExisted = false;
+        {
+            SQLite::Statement stmt(db, "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'type_aggregates'");
+            typeAggregatesExisted = stmt.executeStep();
+        }
+        for (const char* sql : statements) {
+            db.exec(sql);
+        }
+
+        // 首次创建（包括从旧版本升级）时按明细表回填
+        SQLite::Statement exists(db, "SELECT 1 FROM global_aggregates WHERE id = 1");
+        if (!exists.executeStep() || !typeAggregatesExisted) {
+            rebuildAggregates(db);
+        }
+        transaction.commit();
+        return true;
+    } catch (const SQLite::Exception& e) {
+        throw DatabaseException("创建汇总表失败: " + std::string(e.what()));
+    }
+}
+
+void DatabaseManager::rebuildAggregates(SQLite::Database& db) const {
+    db.exec("DELETE FROM currency_aggregates");
+    db.exec(
+        "INSERT INTO currency_aggregates (currency_key, total_wealth, account_count) "
+        "SELECT currency_key, SUM(balance), COUNT(*) FROM player_balances GROUP BY currency_key"
+    );
+    db.exec("DELETE FROM player_aggregates");
+    db.exec(withLegacyTransactions(
+        "INSERT INTO player_aggregates (account_id, transaction_count) "
+        "SELECT account_id, COUNT(*) FROM transactions GROUP BY account_id"
+    ));
+    db.exec(withLegacyTransactions(
+        "INSERT OR REPLACE INTO global_aggregates (id, player_count, transaction_count) "
+        "VALUES (1, (SELECT COUNT(*) FROM players), (SELECT COUNT(*) FROM transactions))"
+    ));
+    db.exec("DELETE FROM type_aggregates");
+    db.exec(withLegacyTransactions(
+        "INSERT INTO type_aggregates (type, transaction_count) "
+        "SELECT type, COUNT(*) FROM transactions GROUP BY type"
+    ));
+}
+
+std::string DatabaseManager::withLegacyTransactions(std::string sql) const {
+    const auto* legacy = getLegacyTransactions();
+    if (legacy == nullptr) {
+        return sql;
+    }
+    constexpr std::string_view kTable = "FROM transactions";
+    const std::string          merged = "FROM (SELECT account_id, type FROM transactions UNION ALL "
+                                        "SELECT account_id, type FROM ("
+                                      + std::string(legacy->records) + "))";
+    for (size_t pos = sql.find(kTable); pos != std::string::npos; pos = sql.find(kTable, pos + merged.size())) {
+        sql.replace(pos, kTable.size(), merged);
     }
+    return sql;
 }
 
 bool DatabaseManager::createIndexes(SQLite::Database& db) {
+    // 索引按 DAO 的实际查询设计，每条语句都由主键或下列索引定位，不出现全表扫描与临时排序：
+    // - player_balances 按 (account_id, currency_key) 聚簇，transactions 按 (account_id, timestamp, id) 聚簇，
+    //   按玩家查询余额与历史记录（含类型、时间过滤与游标分页）直接读取主键范围
+    // - 二级索引末尾隐含主键列：(currency_key, balance) 覆盖排行榜与批量操作，
+    //   (currency_key, account_id, timestamp) 满足按币种过滤的玩家历史且按 (timestamp, id) 有序，
+    //   (timestamp, id) 满足全服最近记录与过期清理
+    // - 按类型计数读取 type_aggregates，不再为低选择性的类型列、关联账户与转账ID维护索引
+    const char* obsoleteIndexes[] = {
+        "idx_transactions_currency",
+        "idx_transactions_timestamp",
+        "idx_transactions_type",
+        "idx_transactions_related_account",
+        "idx_transactions_transfer_id"
+    };
     const char* indexes[] = {
         "CREATE INDEX IF NOT EXISTS idx_players_username ON players(username)",
-        "CREATE INDEX IF NOT EXISTS idx_player_balances_xuid ON player_balances(xuid)",
-        "CREATE INDEX IF NOT EXISTS idx_player_balances_currency ON player_balances(currency_id)",
-        "CREATE INDEX IF NOT EXISTS idx_player_balances_balance ON player_balances(balance)",
-        "CREATE INDEX IF NOT EXISTS idx_transactions_xuid ON transactions(xuid)",
-        "CREATE INDEX IF NOT EXISTS idx_transactions_currency ON transactions(currency_id)",
-        "CREATE INDEX IF NOT EXISTS idx_transactions_timestamp ON transactions(timestamp)",
-        "CREATE INDEX IF NOT EXISTS idx_transactions_type ON transactions(type)",
-        "CREATE INDEX IF NOT EXISTS idx_transactions_related_xuid ON transactions(related_xuid)",
-        "CREATE INDEX IF NOT EXISTS idx_transactions_transfer_id ON transactions(transfer_id)"
+        "CREATE INDEX IF NOT EXISTS idx_player_balances_currency ON player_balances(currency_key, balance)",
+        "CREATE UNIQUE INDEX IF NOT EXISTS idx_transactions_id ON transactions(id)",
+        "CREATE INDEX IF NOT EXISTS idx_transactions_currency_account_time "
+        "ON transactions(currency_key, account_id, timestamp)",
+        "CREATE INDEX IF NOT EXISTS idx_transactions_time ON transactions(timestamp, id)"
     };
 
     try {
+        // 只删除新表上的旧索引，迁移期间的旧表沿用同名索引读取
+        for (const char* name : obsoleteIndexes) {
+            SQLite::Statement stmt(
+                db,
+                "SELECT 1 FROM sqlite_master WHERE type = 'index' AND name = ? AND tbl_name = 'transactions'"
+            );
+            stmt.bind(1, name);
+            if (stmt.executeStep()) {
+                db.exec("DROP INDEX " + std::string(name));
+            }
+        }
         for (const char* sql : indexes) {
             db.exec(sql);
         }
@@ -221,25 +2041,104 @@ bool DatabaseManager::createIndexes(SQLite::Database& db) {
 }
 
 bool DatabaseManager::configureOptimization(SQLite::Database& db) {
-    const char* optimizations[] = {// 单线程 + Windows 测试环境更适合 DELETE 模式，避免 wal/shm 文件占用
-                                   "PRAGMA journal_mode = DELETE",
-                                   "PRAGMA synchronous = NORMAL",
-                                   "PRAGMA cache_size = 10000",
-                                   "PRAGMA temp_store = MEMORY",
-                                   "PRAGMA mmap_size = 268435456",
-                                   "PRAGMA optimize"
+    // 页大小只对尚未写入任何页的新数据库生效，必须在设置日志模式之前执行
+    if (mConfig.pageSize > 0) {
+        try {
+            db.exec("PRAGMA page_size = " + std::to_string(mConfig.pageSize));
+        } catch (const SQLite::Exception&) {
+            return false;
+        }
+    }
+
+    // 默认 DELETE 模式：单线程 + Windows 测试环境下避免 wal/shm 文件占用；
+    // WAL 模式需显式配置，读写互不阻塞
+    try {
+        const std::string journalMode = mConfig.journalMode == "WAL" ? "WAL" : "DELETE";
+        SQLite::Statement stmt(db, "PRAGMA journal_mode = " + journalMode);
+        // 内存数据库等不支持 WAL 时 SQLite 会返回实际生效的模式
+        mWalEnabled = stmt.executeStep() && stmt.getColumn(0).getString() == "wal";
+    } catch (const SQLite::Exception&) {
+        return false;
+    }
+
+    // 进程级设置：SQLite 在堆内存超过软上限时优先释放各连接的页缓存
+    if (mConfig.softHeapLimitMB > 0) {
+        sqlite3_soft_heap_limit64(static_cast<sqlite3_int64>(mConfig.softHeapLimitMB) * 1024 * 1024);
+    }
+    mCacheSizeKB = resolveCacheSizeKB();
+
+    // analysis_limit 限制 ANALYZE 每个索引采样的行数，大表上的统计也能很快完成
+    const std::string optimizations[] = {
+        "PRAGMA synchronous = " + mConfig.synchronous,
+        "PRAGMA wal_autocheckpoint = " + std::to_string(mConfig.walAutocheckpoint),
+        "PRAGMA analysis_limit = 1000"
+    };
+
+    bool allSuccess = configureConnection(db);
+    for (const auto& sql : optimizations) {
+        try {
+            db.exec(sql);
+        } catch (const SQLite::Exception&) {
+            allSuccess = false;
+        }
+    }
+    return allSuccess;
+}
+
+bool DatabaseManager::configureConnection(SQLite::Database& db) const {
+    // cache_size 取负值时单位为 KB，与页大小无关
+    const std::string settings[] = {
+        "PRAGMA cache_size = -" + std::to_string(mCacheSizeKB),
+        "PRAGMA temp_store = MEMORY",
+        "PRAGMA mmap_size = " + std::to_string(static_cast<int64_t>(mConfig.mmapSizeMB) * 1024 * 1024)
     };
 
     bool allSuccess = true;
-    for (const char* sql : optimizations) {
+    for (const auto& sql : settings) {
         try {
             db.exec(sql);
         } catch (const SQLite::Exception&) {
             allSuccess = false;
         }
     }
+    try {
+        db.setBusyTimeout(mConfig.busyTimeoutMs);
+    } catch (const SQLite::Exception&) {
+        allSuccess = false;
+    }
     return allSuccess;
 }
 
+int64_t DatabaseManager::resolveCacheSizeKB() const {
+    if (mConfig.cacheSizeKB > 0) {
+        return mConfig.cacheSizeKB;
+    }
+
+    // 自动：内存预算由写连接与只读连接平分；数据库文件（预留四分之一的增长）放得进缓存时只按文件大小分配，
+    // 小服务器不会预留用不到的内存，大数据库在预算内尽量多缓存
+    int64_t connections = 1 + (mConfig.journalMode == "WAL" ? mConfig.readPoolSize : 0);
+    int64_t budgetKB    = std::max<int64_t>(static_cast<int64_t>(mConfig.memoryBudgetMB) * 1024 / connections, 1);
+
+    std::error_code error;
+    auto            fileSize = std::filesystem::file_size(mDatabasePath, error);
+    int64_t         fileKB   = error ? 0 : static_cast<int64_t>(fileSize / 1024);
+    return std::min(std::max(fileKB + fileKB / 4, kMinAutoCacheKB), budgetKB);
+}
+
+void DatabaseManager::openReadPool() {
+    try {
+        for (int i = 0; i < mConfig.readPoolSize; ++i) {
+            auto reader      = std::make_unique<ReadConnection>();
+            reader->database = std::make_unique<SQLite::Database>(mDatabasePath, SQLite::OPEN_READONLY);
+            configureConnection(*reader->database);
+            reader->statementCache = std::make_unique<StatementCache>(*reader->database);
+            mReadPool.push_back(std::move(reader));
+        }
+    } catch (const SQLite::Exception& e) {
+        mReadPool.clear();
+        throw DatabaseException("打开只读连接失败: " + std::string(e.what()));
+    }
+}
+
 
 } // namespace rlx_money
\ No newline at end of file
@@ -1,14 +1,136 @@
 #pragma once
 
+#include "mod/config/ConfigStructures.h"
+#include "mod/database/MpscQueue.h"
+#include "mod/database/StatementCache.h"
 #include <SQLiteCpp/Database.h>
 #include <SQLiteCpp/Statement.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
 #include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
+struct sqlite3;
+struct sqlite3_backup;
 
 namespace rlx_money {
 
+/// @brief WAL 检查点模式（对应 PRAGMA wal_checkpoint 的参数）
+enum class CheckpointMode {
+    Passive,  // 不等待读写，尽可能多地回写
+    Full,     // 等待写者完成后回写全部帧
+    Restart,  // 在 Full 基础上等待读者，使下次写入从 WAL 头部开始
+    Truncate, // 在 Restart 基础上把 WAL 文件截断为 0 字节
+};
+
+/// @brief WAL 检查点结果
+struct CheckpointResult {
+    bool busy               = false; // 是否因读写冲突未能完成
+    int  logFrames          = 0;     // WAL 中的帧数（非 WAL 模式为 -1）
+    int  checkpointedFrames = 0;     // 已回写到数据库文件的帧数（非 WAL 模式为 -1）
+};
+
+/// @brief 组提交统计信息
+struct GroupCommitStats {
+    uint64_t commits          = 0; // 实际执行的 COMMIT 次数
+    uint64_t operations       = 0; // 合并进组提交的写事务数量
+    uint64_t failedOperations = 0; // 在各自保存点内回滚的写事务数量
+};
+
+/// @brief 汇总表校验结果
+struct AggregateCheckResult {
+    int  mismatchedCurrencies = 0;     // 总财富或账户数与明细不一致的币种数量
+    int  mismatchedPlayers    = 0;     // 交易记录数与明细不一致的玩家数量
+    int  mismatchedTypes      = 0;     // 交易记录数与明细不一致的交易类型数量
+    bool globalMismatch       = false; // 玩家总数或交易记录总数是否不一致
+    bool repaired             = false; // 是否已按明细重新计算汇总表
+
+    /// @brief 汇总表是否与明细一致
+    [[nodiscard]] bool consistent() const {
+        return mismatchedCurrencies == 0 && mismatchedPlayers == 0 && mismatchedTypes == 0 && !globalMismatch;
+    }
+};
+
+/// @brief 在线备份状态
+enum class BackupState {
+    Idle,      // 尚未执行过备份
+    Running,   // 正在逐 tick 复制
+    Completed, // 最近一次备份已完成
+    Failed,    // 最近一次备份失败或已取消
+};
+
+/// @brief 在线备份进度
+struct BackupProgress {
+    BackupState state          = BackupState::Idle;
+    std::string path;               // 备份文件路径
+    int         totalPages     = 0; // 源数据库总页数（第一次复制之前为 0）
+    int         remainingPages = 0; // 尚未复制的页数
+    std::string error;              // 失败原因
+
+    /// @brief 已复制页数的百分比
+    [[nodiscard]] double percent() const {
+        if (state == BackupState::Completed) {
+            return 100.0;
+        }
+        return totalPages > 0 ? 100.0 * (totalPages - remainingPages) / totalPages : 0.0;
+    }
+};
+
+/// @brief 交易记录清理任务状态
+enum class RetentionState {
+    Idle,      // 没有清理任务
+    Running,   // 正在逐 tick 分批删除
+    Completed, // 最近一次清理已完成
+    Failed,    // 最近一次清理失败（任务保留在数据库中，下次启动时继续）
+};
+
+/// @brief 交易记录清理任务进度
+struct RetentionProgress {
+    RetentionState state          = RetentionState::Idle;
+    int64_t        cutoffTime     = 0; // 删除早于该时间戳的记录
+    int64_t        deletedRecords = 0; // 本任务已删除的记录数量（含重启前删除的）
+    int64_t        reclaimedBytes = 0; // 本次启动以来增量整理归还给文件系统的字节数
+    int64_t        freeBytes      = 0; // 数据库文件中尚未归还的空闲页字节数
+    std::string    error;              // 失败原因
+};
+
+/// @brief 交易记录结构迁移状态
+enum class MigrationState {
+    Idle,      // 没有需要迁移的旧交易记录表
+    Running,   // 正在逐 tick 分批把旧表中的记录移入新表
+    Completed, // 本次启动期间迁移已完成
+    Failed,    // 迁移失败（已移入新表的记录保留，下次启动时继续）
+};
+
+/// @brief 交易记录结构迁移进度
+struct MigrationProgress {
+    MigrationState state        = MigrationState::Idle;
+    int64_t        movedRecords = 0; // 本次启动以来移入新表的记录数量
+    int64_t        movedId      = 0; // 已移入新表的最大旧记录ID
+    int64_t        lastId       = 0; // 启动时旧表中的最大记录ID
+    std::string    error;            // 失败原因
+};
+
+/// @brief 尚未迁移完的旧交易记录表（迁移期间读取交易记录时与新表合并）
+struct LegacyTransactionSource {
+    const char* table;         // 旧表名（按自增ID存储）
+    const char* records;       // 按新表的列名与列顺序读取旧表记录的 SELECT 语句（不含 WHERE）
+    const char* accountFilter; // 追加在 records 之后按玩家过滤的 WHERE 子句，玩家XUID为参数 ?1
+};
+
+/// @brief 写事务完成句柄：事务提交后为 true，回滚后为 false，失败时 get() 抛出 DatabaseException
+using WriteHandle = std::shared_future<bool>;
+
 /// @brief 数据库管理器类
 class DatabaseManager {
 public:
@@ -21,15 +143,211 @@ class DatabaseManager {
     /// @return 是否初始化成功
     bool initialize(const std::string& dbPath);
 
+    /// @brief 按数据库配置初始化数据库连接
+    /// @param config 数据库配置（路径、日志模式、只读连接池大小）
+    /// @return 是否初始化成功
+    bool initialize(const DatabaseConfig& config);
+
     /// @brief 获取数据库连接
     /// @return 数据库连接对象
     [[nodiscard]] SQLite::Database& getConnection() const;
 
+    /// @brief 从预编译语句缓存中借出语句
+    /// @param sql SQL语句
+    /// @return 已清空绑定参数的语句，离开作用域时自动 reset 并归还
+    /// @note 语句存活期间独占写连接；异步写入模式下不要持有语句等待写事务完成
+    [[nodiscard]] CachedStatement prepareCached(std::string_view sql);
+
+    /// @brief 借出只读查询语句
+    /// @param sql 只读 SQL 语句
+    /// @return 已清空绑定参数的语句
+    /// @note WAL 模式下从只读连接池借出，不会阻塞写连接；
+    ///       当前线程处于事务中或未启用连接池时使用写连接，保证读到本事务未提交的修改
+    [[nodiscard]] CachedStatement prepareRead(std::string_view sql);
+
+    /// @brief 获取预编译语句缓存统计信息
+    /// @return 命中/未命中次数及缓存条目数
+    [[nodiscard]] StatementCacheStats getStatementCacheStats() const;
+
     /// @brief 执行事务
     /// @param transaction 事务函数
     /// @return 是否执行成功
+    /// @note 异步写入模式下事务按提交顺序在写线程执行，本函数等待其提交完成（包括磁盘同步），
+    ///       调用线程并不会因此免于等待磁盘；不需要结果时使用 submitTransaction。
+    ///       在事务函数内再次调用时在嵌套保存点内执行：返回 false 或抛出异常只回滚本次调用，
+    ///       提交与否由最外层事务决定
     bool executeTransaction(const std::function<bool(SQLite::Database&)>& transaction);
 
+    /// @brief 提交写事务但不等待完成
+    /// @param transaction 事务函数（在写线程上执行）
+    /// @param readYourWrites 同一线程之后的读取是否先等待该事务完成
+    /// @return 完成句柄
+    /// @note 未启用异步写入时同步执行并返回已就绪的句柄；
+    ///       默认同一线程之后的读取会先等待本线程已提交的写事务完成，保证读到自己的写入。
+    ///       调用方的读取不依赖该事务时（如写后刷新的余额仍在内存中）传入 false，避免之后的读取等待磁盘
+    WriteHandle submitTransaction(std::function<bool(SQLite::Database&)> transaction, bool readYourWrites = true);
+
+    /// @brief 等待此前提交的所有写事务完成
+    void flushWrites();
+
+    /// @brief 是否已启用异步写入
+    /// @return 是否启用写线程
+    [[nodiscard]] bool isAsyncWriterEnabled() const;
+
+    /// @brief 提交当前打开的组事务（每个 tick 结束时调用）
+    /// @note 组提交模式下 executeTransaction 返回 true 只表示该操作已在保存点内成功，
+    ///       持久化发生在本函数提交整组之后；异步写入模式下由写线程按批提交，本函数为空操作
+    void flushGroupCommit();
+
+    /// @brief 是否已启用组提交
+    /// @return 是否启用组提交
+    [[nodiscard]] bool isGroupCommitEnabled() const;
+
+    /// @brief 获取组提交统计信息
+    /// @return 统计信息
+    [[nodiscard]] GroupCommitStats getGroupCommitStats() const;
+
+    /// @brief 设置组事务整体回滚时的回调
+    /// @param listener 回调函数（在回滚后于执行提交的线程上调用，可为空）
+    /// @note 组提交模式下已返回 true 的操作会随整组回滚一起丢失，依赖这些结果的内存状态需要在回调中失效；
+    ///       已返回 true 的嵌套调用随外层事务回滚时同样调用
+    void setGroupRollbackListener(std::function<void()> listener);
+
+    /// @brief 执行 WAL 检查点
+    /// @param mode 检查点模式
+    /// @return 检查点结果
+    CheckpointResult checkpoint(CheckpointMode mode = CheckpointMode::Passive);
+
+    /// @brief 更新查询优化器的统计信息（PRAGMA optimize：只对自上次分析以来变化较大的表执行 ANALYZE）
+    /// @throw DatabaseException 数据库未初始化或执行失败时
+    void optimize();
+
+    /// @brief 距上次更新统计信息超过一小时时调用 optimize()（每个 tick 调用）
+    void optimizeIfDue();
+
+    /// @brief 开始在线备份（备份文件位于 DatabaseConfig::backupDir，按 UTC 时间命名）
+    /// @return 备份文件路径
+    /// @throw DatabaseException 数据库未初始化、已有备份正在进行或无法创建备份文件时
+    /// @note 本函数只打开备份文件，页面由之后每个 tick 的 stepBackup() 分批复制；
+    ///       复制期间经写连接提交的修改会同步到备份中，完成的备份与完成时刻的数据库一致
+    std::string startBackup();
+
+    /// @brief 推进在线备份（每个 tick 调用）：到达定时备份间隔时开始新的备份，
+    ///        写连接空闲时复制 DatabaseConfig::backupPagesPerTick 页
+    /// @return 当前备份进度
+    /// @note 写连接被占用或有未提交的事务时跳过本 tick，不会等待写连接，也不会让写连接长时间等待备份；
+    ///       全部复制完成后把临时文件改名为备份文件，并按 DatabaseConfig::backupKeep 删除较旧的备份
+    BackupProgress stepBackup();
+
+    /// @brief 取消正在进行的在线备份并删除未完成的备份文件
+    /// @return 是否有备份被取消
+    bool cancelBackup();
+
+    /// @brief 获取最近一次在线备份的进度
+    /// @return 备份进度
+    [[nodiscard]] BackupProgress getBackupProgress() const;
+
+    /// @brief 获取备份目录
+    /// @return DatabaseConfig::backupDir；未配置时为数据库所在目录下的 backups
+    [[nodiscard]] std::filesystem::path getBackupDirectory() const;
+
+    /// @brief 获取交易记录归档目录
+    /// @return DatabaseConfig::archiveDir；未配置时为数据库所在目录下的 archive
+    [[nodiscard]] std::filesystem::path getArchiveDirectory() const;
+
+    /// @brief 开始清理早于保留天数的交易记录
+    /// @param daysToKeep 保留天数
+    /// @return 清理任务进度
+    /// @throw InvalidArgumentException daysToKeep 小于 1 时
+    /// @throw DatabaseException 数据库未初始化、已有清理任务正在进行或写入任务失败时
+    /// @note 任务的截止时间与已删除数量保存在 retention_job 表中，服务器重启后由 stepRetention() 继续
+    RetentionProgress startRetention(int daysToKeep);
+
+    /// @brief 推进交易记录清理（每个 tick 调用）：设置了 DatabaseConfig::retentionDays 时每天自动开始一次清理，
+    ///        有清理任务时在 DatabaseConfig::retentionBudgetMs 内按 retentionBatchSize 分批删除，
+    ///        没有清理任务的空闲 tick 执行 incremental_vacuum，把至多 vacuumPagesPerTick 个空闲页归还给文件系统
+    /// @return 当前清理进度
+    /// @note 与 stepBackup() 相同，写连接被占用或有未提交的事务时跳过本 tick；每批删除是一个独立的短事务，
+    ///       并在同一事务中更新 retention_job 中的进度。
+    ///       异步写入模式下删除与整理投递给写线程执行，tick 不等待磁盘，结果在之后的 tick 计入进度；
+    ///       交易记录结构迁移完成前清理任务保持进行中状态，不删除记录
+    RetentionProgress stepRetention();
+
+    /// @brief 取消正在进行的清理任务（已删除的记录不会恢复）
+    /// @return 是否有任务被取消
+    bool cancelRetention();
+
+    /// @brief 获取交易记录清理进度
+    /// @return 清理进度
+    [[nodiscard]] RetentionProgress getRetentionProgress() const;
+
+    /// @brief 推进交易记录结构迁移（每个 tick 调用）：在 DatabaseConfig::retentionBudgetMs 内按记录ID分批
+    ///        把旧交易记录表中的记录移入新表，旧表移空后在之后的 tick 删除旧表
+    /// @return 当前迁移进度
+    /// @note 与 stepRetention() 相同，写连接被占用或有未提交的事务时跳过本 tick；每批的复制、删除与
+    ///       migration_progress 中的进度在同一个短事务中提交，迁移期间的读取合并新旧两表，汇总值保持不变。
+    ///       异步写入模式下各批投递给写线程执行，tick 不等待磁盘
+    MigrationProgress stepMigration();
+
+    /// @brief 获取交易记录结构迁移进度
+    /// @return 迁移进度
+    [[nodiscard]] MigrationProgress getMigrationProgress() const;
+
+    /// @brief 获取尚未迁移完的旧交易记录表
+    /// @return 旧表；没有进行中的迁移时为空指针
+    /// @note 读取交易记录时需要合并返回的旧表；按时间范围删除交易记录的操作（归档、清理）在迁移完成前拒绝执行
+    [[nodiscard]] const LegacyTransactionSource* getLegacyTransactions() const;
+
+    /// @brief 数据库是否已启用增量整理（auto_vacuum = INCREMENTAL）
+    /// @return 是否启用；新建的数据库默认启用，旧版本创建的数据库需要执行一次 convertToIncrementalVacuum()
+    /// @throw DatabaseException 数据库未初始化时
+    [[nodiscard]] bool isIncrementalVacuumEnabled() const;
+
+    /// @brief 获取数据库占用的空间（页数 × 页大小）
+    /// @return 字节数
+    /// @throw DatabaseException 数据库未初始化时
+    [[nodiscard]] int64_t getDatabaseSizeBytes() const;
+
+    /// @brief 把已有数据库切换为增量整理：设置 auto_vacuum = INCREMENTAL 后执行一次完整的 VACUUM
+    /// @param stopToken VACUUM 执行期间定期检查，请求停止时中断并回滚，数据库保持原样
+    /// @return 是否执行了转换（已启用增量整理时返回 false）
+    /// @throw DatabaseException 数据库未初始化、在事务内调用、整理失败或被停止时
+    /// @note VACUUM 重写整个数据库文件，耗时与数据库大小成正比，期间独占写连接，所有写入都会等待；
+    ///       需要约为数据库大小两倍的可用磁盘空间。组提交模式下先提交当前打开的组事务
+    bool convertToIncrementalVacuum(std::stop_token stopToken = {});
+
+    /// @brief 获取玩家XUID对应的账户键（不存在时创建）
+    /// @param xuid 玩家XUID
+    /// @return 账户键（accounts 表主键）
+    /// @throw DatabaseException 数据库操作失败时
+    /// @note 使用写连接；在事务中调用时新建的键随事务一起提交或回滚
+    int64_t resolveAccountKey(const std::string& xuid);
+
+    /// @brief 获取币种ID对应的币种键（不存在时创建）
+    /// @param currencyId 币种ID
+    /// @return 币种键（currency_keys 表主键）
+    /// @throw DatabaseException 数据库操作失败时
+    /// @note 使用写连接；在事务中调用时新建的键随事务一起提交或回滚
+    int64_t resolveCurrencyKey(const std::string& currencyId);
+
+    /// @brief 按明细表重新计算汇总表并与当前值比对
+    /// @param repair 发现不一致时是否用重新计算的结果覆盖汇总表
+    /// @return 校验结果
+    /// @note 需要扫描全部余额与交易记录，适合在维护窗口或排查问题时执行
+    AggregateCheckResult verifyAggregates(bool repair = false);
+
+    /// @brief 是否已启用 WAL 日志模式
+    /// @return 是否为 WAL 模式
+    [[nodiscard]] bool isWalEnabled() const;
+
+    /// @brief 获取每个连接实际使用的页缓存大小
+    /// @return 页缓存大小（KB）
+    [[nodiscard]] int64_t getCacheSizeKB() const;
+
+    /// @brief 获取只读连接池大小
+    /// @return 只读连接数量
+    [[nodiscard]] size_t getReadPoolSize() const;
+
     /// @brief 检查数据库是否已初始化
     /// @return 是否已初始化
     [[nodiscard]] bool isInitialized() const;
@@ -53,11 +371,36 @@ class DatabaseManager {
     ~DatabaseManager();
 
 
-    /// @brief 创建数据库表结构
+    /// @brief 创建数据库表结构（旧版本数据库就地迁移到当前结构版本）
     /// @param db 数据库连接
     /// @return 是否创建成功
     bool createTables(SQLite::Database& db);
 
+    /// @brief 创建账户键与币种键字典表
+    /// @param db 数据库连接
+    /// @return 是否创建成功
+    bool createKeyTables(SQLite::Database& db);
+
+    /// @brief 把第 1 版结构（文本键、文本交易类型）的余额表与交易记录表迁移到当前结构
+    /// @param db 数据库连接（不能在事务内调用）
+    /// @note 只在一个事务内转换结构与余额，交易记录由 stepMigration() 逐 tick 移入新表；
+    ///       上次启动时已转换的，直接继续移动
+    void migrateLegacySchema(SQLite::Database& db);
+
+    /// @brief 删除旧汇总表，旧余额表与交易记录表改名后建立新表，填充字典表并复制余额
+    /// @param db 数据库连接（调用方需已打开事务）
+    void convertLegacyTables(SQLite::Database& db);
+
+    /// @brief 把第 2 版按自增ID存储的交易记录表改为按 (account_id, timestamp, id) 聚簇的表
+    /// @param db 数据库连接（不能在事务内调用）
+    /// @note 只把旧表改名并建立新表，记录由 stepMigration() 逐 tick 移入新表
+    void migrateTransactionsToClustered(SQLite::Database& db);
+
+    /// @brief 开始（或在重新启动后继续）把旧交易记录表移入新表：记录进度并让新记录的ID越过旧表
+    /// @param db 数据库连接
+    /// @param source 旧表
+    void beginMigration(SQLite::Database& db, const LegacyTransactionSource& source);
+
     /// @brief 创建玩家表
     /// @param db 数据库连接
     /// @return 是否创建成功
@@ -68,24 +411,222 @@ class DatabaseManager {
     /// @return 是否创建成功
     bool createPlayerBalancesTable(SQLite::Database& db);
 
-    /// @brief 创建交易记录表
+    /// @brief 创建交易记录表及记录ID序号表
     /// @param db 数据库连接
     /// @return 是否创建成功
     bool createTransactionsTable(SQLite::Database& db);
 
+    /// @brief 创建重做日志检查点表
+    /// @param db 数据库连接
+    /// @return 是否创建成功
+    bool createJournalCheckpointTable(SQLite::Database& db);
+
+    /// @brief 创建汇总表及维护汇总表的触发器（新建时按明细表回填）
+    /// @param db 数据库连接
+    /// @return 是否创建成功
+    bool createAggregateTables(SQLite::Database& db);
+
+    /// @brief 按明细表重新计算全部汇总表（迁移期间合并新旧两表计数）
+    /// @param db 数据库连接（调用方需已打开事务）
+    void rebuildAggregates(SQLite::Database& db) const;
+
+    /// @brief 把语句中读取交易记录表的 "FROM transactions" 换为迁移期间新旧两表的合并
+    /// @param sql 只读取 account_id 与 type 列的语句
+    /// @return 替换后的语句；没有进行中的迁移时原样返回
+    [[nodiscard]] std::string withLegacyTransactions(std::string sql) const;
+
     /// @brief 创建索引
     /// @param db 数据库连接
     /// @return 是否创建成功
     bool createIndexes(SQLite::Database& db);
 
-    /// @brief 配置数据库优化参数
+    /// @brief 结束当前备份：成功时把临时文件改名为备份文件并清理旧备份，失败时删除临时文件
+    /// @param error 失败原因（为空表示复制已完成）
+    /// @note 调用方需持有备份锁
+    void finishBackup(std::string error);
+
+    /// @brief 按保留数量删除备份目录中较旧的备份文件
+    void pruneBackups();
+
+    /// @brief 在 retention_job 表中记录新的清理任务（调用方需持有清理锁）
+    /// @param cutoffTime 删除早于该时间戳的记录
+    void beginRetention(int64_t cutoffTime);
+
+    /// @brief 一次清理步骤的结果（异步写入模式下由写线程填写，完成句柄就绪后在 tick 上读取）
+    struct RetentionStep {
+        bool                   running        = false; // 是否有清理任务（否则本步只执行增量整理）
+        int64_t                cutoffTime     = 0;     // 清理任务的截止时间
+        int64_t                deleted        = 0;     // 本步删除的记录数量
+        bool                   completed      = false; // 是否已删除全部过期记录
+        int64_t                reclaimedBytes = 0;     // 本步增量整理归还的字节数
+        std::optional<int64_t> freeBytes;              // 整理后剩余的空闲页字节数（本步未整理时为空）
+    };
+
+    /// @brief 执行一次清理步骤：有清理任务时在时间预算内分批删除，否则执行增量整理（调用方需持有写连接锁）
+    /// @param step 步骤参数与结果（抛出异常时保留已完成部分的结果）
+    /// @note 在写线程投递的事务中执行时各批直接写入该事务，否则每批是一个独立的短事务
+    void runRetentionStep(RetentionStep& step);
+
+    /// @brief 把清理步骤的结果合并到清理进度（调用方需持有清理锁）
+    /// @param step 步骤结果；删除数量只计入截止时间相同、仍在进行的任务
+    void applyRetentionStep(const RetentionStep& step);
+
+    /// @brief 异步写入模式下推进清理：取回上一步的结果，再把下一步投递给写线程（调用方需持有清理锁）
+    /// @note tick 不等待写线程；上一步尚未完成时本 tick 不投递
+    void submitRetentionStep();
+
+    /// @brief 执行一次增量整理并记录归还的字节数（调用方需持有写连接锁）
+    /// @param step 步骤结果
+    void vacuumFreePages(RetentionStep& step);
+
+    /// @brief 一次迁移步骤的参数与结果（异步写入模式下由写线程填写，完成句柄就绪后在 tick 上读取）
+    struct MigrationStep {
+        const LegacyTransactionSource* source     = nullptr; // 旧表
+        bool                           dropLegacy = false;   // 旧表已移空，本步删除旧表
+        int64_t                        movedId    = 0;       // 已移入新表的最大旧记录ID
+        int64_t                        moved      = 0;       // 本步移入的记录数量
+        bool                           drained    = false;   // 旧表中已没有记录
+        bool                           dropped    = false;   // 已删除旧表
+    };
+
+    /// @brief 执行一次迁移步骤：在时间预算内分批移动记录，或删除已移空的旧表（调用方需持有写连接锁）
+    /// @param step 步骤参数与结果（抛出异常时保留已提交部分的结果）
+    /// @note 在写线程投递的事务中执行时各批直接写入该事务，否则每批是一个独立的短事务
+    void runMigrationStep(MigrationStep& step);
+
+    /// @brief 把迁移步骤的结果合并到迁移进度（调用方需持有迁移锁）
+    /// @param step 步骤结果
+    void applyMigrationStep(const MigrationStep& step);
+
+    /// @brief 异步写入模式下推进迁移：取回上一步的结果，再把下一步投递给写线程（调用方需持有迁移锁）
+    void submitMigrationStep();
+
+    /// @brief 在执行步骤的线程上运行迁移或清理的一批：写线程上直接写入已打开的事务，否则单独提交
+    /// @param transaction 事务函数
+    void runStepBatch(const std::function<bool(SQLite::Database&)>& transaction);
+
+    /// @brief 创建清理任务进度表
+    /// @param db 数据库连接
+    /// @return 是否创建成功
+    bool createRetentionJobTable(SQLite::Database& db);
+
+    /// @brief 按字典表查找或创建键
+    /// @param selectSql 查找键的语句
+    /// @param insertSql 创建键并返回键值的语句
+    /// @param value 字典值
+    /// @return 键值
+    int64_t resolveKey(std::string_view selectSql, std::string_view insertSql, const std::string& value);
+
+    /// @brief 按 DatabaseConfig 配置写连接（页大小、日志模式、同步级别、检查点以及 configureConnection() 的设置）
     /// @param db 数据库连接
     /// @return 是否配置成功
     bool configureOptimization(SQLite::Database& db);
 
-    std::unique_ptr<SQLite::Database> mDatabase;
-    std::string                       mDatabasePath;
-    bool                              mInitialized = false;
+    /// @brief 配置每个连接各自的参数（页缓存、内存映射、锁等待时间），写连接与只读连接共用
+    /// @param db 数据库连接
+    /// @return 是否配置成功
+    bool configureConnection(SQLite::Database& db) const;
+
+    /// @brief 计算每个连接的页缓存大小
+    /// @return DatabaseConfig::cacheSizeKB；为 0 时按数据库文件大小与 memoryBudgetMB 计算
+    [[nodiscard]] int64_t resolveCacheSizeKB() const;
+
+    /// @brief 打开只读连接池
+    void openReadPool();
+
+    /// @brief 在写连接上执行事务（调用方需持有写连接锁）
+    /// @param transaction 事务函数
+    /// @return 是否提交
+    bool runTransaction(const std::function<bool(SQLite::Database&)>& transaction);
+
+    /// @brief 写队列中的请求（transaction 为空表示屏障）
+    struct WriteRequest {
+        std::function<bool(SQLite::Database&)> transaction;
+        std::promise<bool>                     promise;
+    };
+
+    /// @brief 在保存点内执行单个写事务（调用方需已打开外层事务并持有写连接锁）
+    /// @param transaction 事务函数
+    /// @return 是否释放保存点（false 表示已回滚到保存点）
+    bool runInSavepoint(const std::function<bool(SQLite::Database&)>& transaction);
+
+    /// @brief 在嵌套保存点内执行事务函数内再次发起的事务（调用方需持有写连接锁）
+    /// @param transaction 事务函数
+    /// @return 是否释放保存点（false 表示已回滚到保存点）
+    bool runNested(const std::function<bool(SQLite::Database&)>& transaction);
+
+    /// @brief 外层事务或保存点回滚时，若其中有已释放的嵌套保存点则调用回滚回调
+    void notifyNestedRollback();
+
+    /// @brief 提交组事务（调用方需持有写连接锁）
+    void commitGroup();
+
+    /// @brief 写线程把一批请求合并为一个事务提交
+    /// @param batch 请求列表
+    void applyWriteBatch(std::vector<WriteRequest>& batch);
+
+    /// @brief 把请求放入写队列并唤醒写线程
+    /// @param transaction 事务函数（为空表示屏障）
+    /// @param readYourWrites 是否记为当前线程最近的写事务（之后的读取先等待其完成）
+    /// @return 完成句柄
+    WriteHandle enqueueWrite(std::function<bool(SQLite::Database&)> transaction, bool readYourWrites = true);
+
+    /// @brief 等待当前线程此前提交的写事务完成
+    void waitForOwnWrites() const;
+
+    /// @brief 启动写线程
+    void startWriter();
+
+    /// @brief 处理完队列中剩余的写事务后停止写线程
+    void stopWriter();
+
+    /// @brief 写线程主循环
+    void writerLoop();
+
+    /// @brief 只读连接（每个连接独占一把锁和一份语句缓存）
+    struct ReadConnection {
+        std::unique_ptr<SQLite::Database> database;
+        std::unique_ptr<StatementCache>   statementCache;
+        std::recursive_mutex              mutex;
+    };
+
+    std::unique_ptr<SQLite::Database>            mDatabase;
+    std::unique_ptr<StatementCache>              mStatementCache; // 绑定 mDatabase，必须先于连接释放
+    mutable std::recursive_mutex                 mWriterMutex;    // 保护写连接及其语句缓存
+    std::vector<std::unique_ptr<ReadConnection>> mReadPool;
+    std::atomic<size_t>                          mNextReader{0};
+    MpscQueue<WriteRequest>                      mWriteQueue;
+    std::atomic<uint32_t>                        mWriteSignal{0}; // 入队后递增，用于唤醒写线程
+    std::atomic<bool>                            mStopWriter{false};
+    std::thread                                  mWriterThread;
+    std::atomic<bool>                            mGroupOpen{false}; // 同步组提交模式下是否有未提交的组事务
+    std::chrono::steady_clock::time_point        mGroupStartedAt;
+    GroupCommitStats                             mGroupStats;
+    std::function<void()>                        mGroupRollbackListener;
+    bool                                         mNestedReleased = false; // 当前外层事务中是否有已释放的嵌套保存点
+    std::atomic<int64_t>                         mLastOptimizeMs{0}; // 上次更新统计信息的时间（steady_clock 毫秒）
+    mutable std::mutex                           mBackupMutex;       // 保护以下在线备份状态
+    BackupProgress                               mBackupProgress;
+    sqlite3*                                     mBackupDb     = nullptr; // 正在写入的备份文件连接
+    sqlite3_backup*                              mBackup       = nullptr;
+    int64_t                                      mLastBackupMs = 0;      // 上次开始备份的时间（steady_clock 毫秒）
+    mutable std::mutex                           mRetentionMutex;        // 保护以下清理任务状态
+    RetentionProgress                            mRetentionProgress;
+    int64_t                                      mLastRetentionMs = 0;   // 上次自动开始清理的时间（steady_clock 毫秒）
+    WriteHandle                                  mRetentionWrite;        // 异步写入模式下已投递、尚未取回的清理步骤
+    std::shared_ptr<RetentionStep>               mRetentionStep;         // 该步骤的结果
+    std::atomic<const LegacyTransactionSource*>  mLegacyTransactions{nullptr}; // 尚未迁移完的旧交易记录表
+    mutable std::mutex                           mMigrationMutex; // 保护以下迁移状态
+    MigrationProgress                            mMigrationProgress;
+    const LegacyTransactionSource*               mMigrationSource = nullptr; // 正在迁移的旧表（移空后保留到删除旧表）
+    bool                                         mLegacyDrained   = false;   // 旧表已移空，等待下一步删除
+    WriteHandle                                  mMigrationWrite;        // 异步写入模式下已投递、尚未取回的迁移步骤
+    std::shared_ptr<MigrationStep>               mMigrationStep;         // 该步骤的结果
+    int64_t                                      mCacheSizeKB = 0; // 每个连接的页缓存大小（KB）
+    DatabaseConfig                               mConfig;
+    std::string                                  mDatabasePath;
+    bool                                         mWalEnabled  = false;
+    bool                                         mInitialized = false;
 };
 
 } // namespace rlx_money
\ No newline at end of file
@@ -0,0 +1,303 @@
+#include "mod/database/DatabaseRestore.h"
+#include "mod/exceptions/MoneyException.h"
+#include <RLXMoney/types/Types.h>
+#include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Exception.h>
+#include <SQLiteCpp/Statement.h>
+#include <SQLiteCpp/Transaction.h>
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+
+
+namespace rlx_money {
+
+namespace {
+
+/// @brief 重放记录的筛选条件：跳过涉及指定玩家的记录与指定转账的记录
+constexpr const char* kSkipCondition =
+    "t.account_id NOT IN (SELECT id FROM temp.skip_accounts) "
+    "AND (t.related_account_id IS NULL OR t.related_account_id NOT IN (SELECT id FROM temp.skip_accounts)) "
+    "AND (t.transfer_id IS NULL OR CASE WHEN typeof(t.transfer_id) = 'blob' THEN lower(hex(t.transfer_id)) "
+    "ELSE t.transfer_id END NOT IN (SELECT value FROM temp.skip_transfers))";
+
+int64_t queryInt64(SQLite::Database& db, const std::string& sql) { return db.execAndGet(sql).getInt64(); }
+
+/// @brief 把一批记录重放到 temp.replay：按 (账户, 币种) 分区，以最近一条 SET/INITIAL 记录为界分段，
+///        段内余额 = 段首的新余额（第一段为恢复起点的余额）+ 之后各条记录的变化量
+std::string buildReplaySql() {
+    std::string setTypes = std::to_string(static_cast<int>(TransactionType::SET)) + ", "
+                         + std::to_string(static_cast<int>(TransactionType::INITIAL));
+    return "INSERT INTO temp.replay (id, account_id, currency_key, amount, balance, type, description, timestamp, "
+           "related_account_id, transfer_id) "
+           "SELECT id, account_id, currency_key, amount, "
+           "CASE WHEN segment_no = 0 THEN start_balance ELSE FIRST_VALUE(amount) OVER segment END "
+           "+ SUM(CASE WHEN is_set THEN 0 ELSE amount END) OVER segment, "
+           "type, description, timestamp, related_account_id, transfer_id FROM ("
+           "SELECT t.id, t.account_id, t.currency_key, t.amount, t.type, t.description, t.timestamp, "
+           "t.related_account_id, t.transfer_id, t.type IN ("
+         + setTypes + ") AS is_set, SUM(t.type IN (" + setTypes
+         + ")) OVER account AS segment_no, "
+           // 备份中没有余额的账户以源数据库中第一条记录之前的余额为起点（如未记录交易的初始余额）
+           "COALESCE(b.balance, FIRST_VALUE(t.balance - t.amount) OVER account) AS start_balance "
+           "FROM src.transactions t LEFT JOIN main.player_balances b "
+           "ON b.account_id = t.account_id AND b.currency_key = t.currency_key "
+           "WHERE t.id > ?1 AND t.id <= ?2 AND t.timestamp <= ?3 AND "
+         + kSkipCondition
+         + " WINDOW account AS (PARTITION BY t.account_id, t.currency_key ORDER BY t.id)) "
+           "WINDOW segment AS (PARTITION BY account_id, currency_key, segment_no ORDER BY id)";
+}
+
+/// @brief 附加源数据库、校验两者属于同一份数据并准备临时表
+/// @return 备份中已有的最大记录ID
+int64_t prepareReplay(SQLite::Database& db, const RestoreOptions& options) {
+    SQLite::Statement attach(db, "ATTACH DATABASE ? AS src");
+    attach.bind(1, options.sourcePath);
+    attach.exec();
+
+    if (queryInt64(db, "PRAGMA main.user_version") != queryInt64(db, "PRAGMA src.user_version")) {
+        throw InvalidArgumentException("备份与源数据库的结构版本不同，请先用当前版本的插件打开一次备份文件");
+    }
+    // 迁移期间的交易记录分布在新旧两表中，按记录ID重放需要全部记录都已移入新表
+    if (queryInt64(
+            db,
+            "SELECT (SELECT COUNT(*) FROM main.sqlite_master WHERE name = 'migration_progress') "
+            "+ (SELECT COUNT(*) FROM src.sqlite_master WHERE name = 'migration_progress')"
+        )
+        != 0) {
+        throw InvalidArgumentException("备份或源数据库的交易记录结构迁移尚未完成，请在迁移完成后再恢复");
+    }
+
+    // 同一份数据的字典键只增不改，备份中已有的键在源数据库中必须对应相同的值
+    if (queryInt64(
+            db,
+            "SELECT (SELECT COUNT(*) FROM main.accounts m JOIN src.accounts s ON s.id = m.id WHERE s.xuid <> m.xuid) "
+            "+ (SELECT COUNT(*) FROM main.currency_keys m JOIN src.currency_keys s ON s.id = m.id "
+            "WHERE s.code <> m.code)"
+        )
+        != 0) {
+        throw InvalidArgumentException("备份与源数据库不属于同一份数据");
+    }
+    int64_t fromId = queryInt64(db, "SELECT seq FROM main.transaction_sequence WHERE id = 1");
+    if (fromId > queryInt64(db, "SELECT seq FROM src.transaction_sequence WHERE id = 1")) {
+        throw InvalidArgumentException("备份比源数据库更新，无法从备份向后重放");
+    }
+
+    SQLite::Statement latest(db, "SELECT COALESCE(MAX(timestamp), 0) FROM main.transactions");
+    latest.executeStep();
+    if (latest.getColumn(0).getInt64() > options.untilTimestamp) {
+        throw InvalidArgumentException("备份中已有晚于目标时间点的交易记录，请选择更早的备份");
+    }
+
+    db.exec(R"(
+        CREATE TEMP TABLE skip_accounts (id INTEGER PRIMARY KEY);
+        CREATE TEMP TABLE skip_transfers (value TEXT PRIMARY KEY);
+        CREATE TEMP TABLE replay (
+            id INTEGER PRIMARY KEY,
+            account_id INTEGER NOT NULL,
+            currency_key INTEGER NOT NULL,
+            amount INTEGER NOT NULL,
+            balance INTEGER NOT NULL,
+            type INTEGER NOT NULL,
+            description TEXT,
+            timestamp INTEGER NOT NULL,
+            related_account_id INTEGER,
+            transfer_id BLOB
+        );
+    )");
+
+    SQLite::Statement skipAccount(
+        db,
+        "INSERT OR IGNORE INTO temp.skip_accounts SELECT id FROM src.accounts WHERE xuid = ?"
+    );
+    for (const auto& xuid : options.skipXuids) {
+        skipAccount.bind(1, xuid);
+        skipAccount.exec();
+        skipAccount.reset();
+    }
+    SQLite::Statement skipTransfer(db, "INSERT OR IGNORE INTO temp.skip_transfers VALUES (?)");
+    for (const auto& transferId : options.skipTransferIds) {
+        // 十六进制转账ID以 BLOB 存储，比较时按小写十六进制还原
+        std::string lower = transferId;
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+        for (const auto& value : {transferId, lower}) {
+            skipTransfer.bind(1, value);
+            skipTransfer.exec();
+            skipTransfer.reset();
+        }
+    }
+    return fromId;
+}
+
+} // namespace
+
+RestoreResult DatabaseRestore::restore(const RestoreOptions& options, const ProgressCallback& progress) {
+    if (options.backupPath.empty() || options.sourcePath.empty() || options.outputPath.empty()) {
+        throw InvalidArgumentException("备份文件、源数据库与输出文件路径不能为空");
+    }
+    if (options.untilTimestamp <= 0) {
+        throw InvalidArgumentException("目标时间点必须是正数时间戳");
+    }
+    if (options.batchSize <= 0) {
+        throw InvalidArgumentException("每批重放的记录数量必须大于 0");
+    }
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(options.backupPath, error)) {
+        throw InvalidArgumentException("备份文件不存在: " + options.backupPath);
+    }
+    for (const auto& path : {options.backupPath, options.sourcePath}) {
+        if (std::filesystem::equivalent(path, options.outputPath, error)) {
+            throw InvalidArgumentException("输出文件不能是备份文件或源数据库");
+        }
+    }
+
+    // 在备份的副本上重放，备份文件本身保持不变
+    for (const char* suffix : {"", "-journal", "-wal", "-shm"}) {
+        std::filesystem::remove(options.outputPath + suffix, error);
+    }
+    if (!std::filesystem::copy_file(options.backupPath, options.outputPath, error)) {
+        throw DatabaseException("无法复制备份文件: " + error.message());
+    }
+
+    try {
+        RestoreResult result;
+        {
+            SQLite::Database db(options.outputPath, SQLite::OPEN_READWRITE);
+            // 输出文件在失败时整体删除，不需要回滚日志与同步落盘
+            db.exec("PRAGMA journal_mode = OFF");
+            db.exec("PRAGMA synchronous = OFF");
+            db.exec("PRAGMA cache_size = -65536");
+            db.exec("PRAGMA temp_store = MEMORY");
+
+            int64_t lastId = prepareReplay(db, options);
+            int64_t total  = 0;
+            {
+                SQLite::Statement count(db, "SELECT COUNT(*) FROM src.transactions WHERE id > ?");
+                count.bind(1, lastId);
+                count.executeStep();
+                total = count.getColumn(0).getInt64();
+            }
+
+            {
+                // 备份之后新出现的玩家与币种；字典键沿用源数据库的值
+                SQLite::Transaction transaction(db);
+                db.exec("INSERT OR IGNORE INTO main.accounts (id, xuid) SELECT id, xuid FROM src.accounts");
+                db.exec("INSERT OR IGNORE INTO main.currency_keys (id, code) SELECT id, code FROM src.currency_keys");
+                db.exec(
+                    "INSERT OR IGNORE INTO main.players (xuid, username, first_join_time, created_at, updated_at) "
+                    "SELECT xuid, username, first_join_time, created_at, updated_at FROM src.players"
+                );
+                transaction.commit();
+            }
+
+            SQLite::Statement nextBound(
+                db,
+                "SELECT id FROM src.transactions WHERE id > ?1 ORDER BY id LIMIT 1 OFFSET ?2"
+            );
+            SQLite::Statement lastBound(db, "SELECT MAX(id) FROM src.transactions WHERE id > ?");
+            SQLite::Statement counts(
+                db,
+                "SELECT COUNT(*), COALESCE(SUM(timestamp <= ?3), 0) FROM src.transactions WHERE id > ?1 AND id <= ?2"
+            );
+            SQLite::Statement replay(db, buildReplaySql());
+            SQLite::Statement insertRecords(
+                db,
+                "INSERT INTO main.transactions (account_id, timestamp, id, currency_key, amount, balance, type, "
+                "description, related_account_id, transfer_id) "
+                "SELECT account_id, timestamp, id, currency_key, amount, balance, type, description, "
+                "related_account_id, transfer_id FROM temp.replay ORDER BY account_id, timestamp, id"
+            );
+            SQLite::Statement updateBalances(
+                db,
+                "INSERT INTO main.player_balances (account_id, currency_key, balance, updated_at) "
+                "SELECT account_id, currency_key, balance, timestamp FROM ("
+                "SELECT account_id, currency_key, balance, timestamp, "
+                "ROW_NUMBER() OVER (PARTITION BY account_id, currency_key ORDER BY id DESC) AS position "
+                "FROM temp.replay) WHERE position = 1 "
+                "ON CONFLICT(account_id, currency_key) DO UPDATE SET balance = excluded.balance, "
+                "updated_at = excluded.updated_at"
+            );
+
+            int64_t processed = 0;
+            while (true) {
+                if (options.stopToken.stop_requested()) {
+                    throw DatabaseException("恢复已取消");
+                }
+
+                // 按记录ID切分批次：取第 batchSize 条记录的ID为上界，不足一批时取最大ID
+                int64_t upperId = 0;
+                nextBound.bind(1, lastId);
+                nextBound.bind(2, options.batchSize - 1);
+                if (nextBound.executeStep()) {
+                    upperId = nextBound.getColumn(0).getInt64();
+                } else {
+                    lastBound.bind(1, lastId);
+                    lastBound.executeStep();
+                    upperId = lastBound.getColumn(0).isNull() ? 0 : lastBound.getColumn(0).getInt64();
+                    lastBound.reset();
+                }
+                nextBound.reset();
+                if (upperId <= lastId) {
+                    break;
+                }
+
+                SQLite::Transaction transaction(db);
+                counts.bind(1, lastId);
+                counts.bind(2, upperId);
+                counts.bind(3, options.untilTimestamp);
+                counts.executeStep();
+                int64_t inRange  = counts.getColumn(0).getInt64();
+                int64_t eligible = counts.getColumn(1).getInt64();
+                counts.reset();
+
+                replay.bind(1, lastId);
+                replay.bind(2, upperId);
+                replay.bind(3, options.untilTimestamp);
+                int replayed = replay.exec();
+                replay.reset();
+
+                insertRecords.exec();
+                insertRecords.reset();
+                updateBalances.exec();
+                updateBalances.reset();
+                if (replayed > 0) {
+                    result.lastReplayedId = queryInt64(db, "SELECT MAX(id) FROM temp.replay");
+                }
+                db.exec("DELETE FROM temp.replay");
+                transaction.commit();
+
+                result.replayedRecords += replayed;
+                result.skippedRecords  += eligible - replayed;
+                result.laterRecords    += inRange - eligible;
+                processed              += inRange;
+                lastId                  = upperId;
+                if (progress) {
+                    progress(processed, total);
+                }
+            }
+
+            // 记录ID不回退；写后日志的检查点沿用源数据库，已写入源数据库的日志不会在新文件上重复应用
+            db.exec(
+                "UPDATE main.transaction_sequence SET seq = MAX(seq, (SELECT seq FROM src.transaction_sequence "
+                "WHERE id = 1)) WHERE id = 1"
+            );
+            db.exec(
+                "INSERT OR REPLACE INTO main.journal_checkpoint (id, sequence) "
+                "SELECT id, sequence FROM src.journal_checkpoint"
+            );
+            result.negativeBalances =
+                static_cast<int>(queryInt64(db, "SELECT COUNT(*) FROM main.player_balances WHERE balance < 0"));
+            db.exec("DETACH DATABASE src");
+        }
+        return result;
+
+    } catch (const SQLite::Exception& e) {
+        std::filesystem::remove(options.outputPath, error);
+        throw DatabaseException("从备份恢复失败: " + std::string(e.what()));
+    } catch (...) {
+        std::filesystem::remove(options.outputPath, error);
+        throw;
+    }
+}
+
+} // namespace rlx_money
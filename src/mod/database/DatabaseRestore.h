@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+
+namespace rlx_money {
+
+/// @brief 按时间点恢复的选项
+struct RestoreOptions {
+    std::string              backupPath;         // 作为起点的备份文件
+    std::string              sourcePath;         // 提供备份之后交易记录的数据库（通常为当前的 money.db）
+    std::string              outputPath;         // 恢复结果写入的新数据库文件（已存在时覆盖）
+    int64_t                  untilTimestamp = 0; // 重放到该时间戳为止（含，秒）
+    std::vector<std::string> skipXuids;          // 跳过这些玩家的记录，以及以他们为对方的转账记录
+    std::vector<std::string> skipTransferIds;    // 跳过这些转账的全部记录
+    int                      batchSize = 100000; // 每批重放的记录数量
+    std::stop_token          stopToken;          // 每批开始前检查，请求停止时放弃恢复
+};
+
+/// @brief 按时间点恢复的结果
+struct RestoreResult {
+    int64_t replayedRecords  = 0; // 重放的交易记录数量
+    int64_t skippedRecords   = 0; // 因匹配跳过条件而未重放的记录数量
+    int64_t laterRecords     = 0; // 晚于目标时间点而未重放的记录数量
+    int64_t lastReplayedId   = 0; // 最后一条重放记录的ID
+    int     negativeBalances = 0; // 恢复后余额为负数的账户数量（跳过入账后仍保留了之后的支出）
+};
+
+/// @brief 从备份恢复到指定时间点
+/// @note 以备份文件为起点，按记录ID顺序把源数据库中备份之后产生的交易记录重放到目标时间点。
+///       重放按批用集合语句完成：每批先用窗口函数按 (账户, 币种) 重新计算每条记录之后的余额
+///       （SET/INITIAL 记录的金额为新余额，其余记录的金额为变化量），再整批写入交易记录表并更新余额表，
+///       汇总表由触发器同步维护。跳过记录后，之后记录的 balance 按重新计算的余额写入
+class DatabaseRestore {
+public:
+    /// @brief 恢复进度回调
+    /// @param processed 已处理的记录数量
+    /// @param total 需要处理的记录总数
+    using ProgressCallback = std::function<void(int64_t processed, int64_t total)>;
+
+    /// @brief 执行恢复，结果写入 options.outputPath
+    /// @param options 恢复选项
+    /// @param progress 每批完成后调用的进度回调（可为空）
+    /// @return 恢复结果
+    /// @throw InvalidArgumentException 选项无效、备份晚于目标时间点、备份与源数据库不属于同一份数据
+    ///        或两者之一的交易记录结构迁移尚未完成时
+    /// @throw DatabaseException 读写数据库失败或 options.stopToken 请求停止时（未完成的输出文件会被删除）
+    /// @note 只读取源数据库，可以在服务器运行时执行；之后需停止服务器，用输出文件替换数据库文件
+    static RestoreResult restore(const RestoreOptions& options, const ProgressCallback& progress = {});
+};
+
+} // namespace rlx_money
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+
+namespace rlx_money {
+
+/// @brief 无锁多生产者单消费者队列（Vyukov 侵入式链表算法）
+/// @note push 可在任意线程并发调用；pop 只能由唯一的消费者线程调用。
+///       生产者交换头指针后、链接 next 之前，pop 可能暂时看不到该元素，
+///       调用方需配合唤醒信号在 push 完成后重新 pop
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() : mHead(new Node), mTail(mHead.load(std::memory_order_relaxed)) {}
+
+    ~MpscQueue() {
+        while (pop()) {}
+        delete mTail;
+    }
+
+    MpscQueue(const MpscQueue&)            = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    /// @brief 入队（多生产者安全）
+    /// @param value 元素
+    void push(T value) {
+        auto* node = new Node;
+        node->value.emplace(std::move(value));
+        Node* prev = mHead.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    /// @brief 出队（仅消费者线程调用）
+    /// @return 队首元素，队列为空时返回 std::nullopt
+    std::optional<T> pop() {
+        Node* tail = mTail;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            return std::nullopt;
+        }
+
+        // next 成为新的哨兵节点，取走它的值后释放旧哨兵
+        std::optional<T> value(std::move(next->value));
+        next->value.reset();
+        mTail = next;
+        delete tail;
+        return value;
+    }
+
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        std::optional<T>   value;
+    };
+
+    std::atomic<Node*> mHead; // 生产者端，最近入队的节点
+    Node*              mTail; // 消费者端，哨兵节点
+};
+
+} // namespace rlx_money
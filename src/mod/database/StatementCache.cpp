@@ -0,0 +1,70 @@
+#include "mod/database/StatementCache.h"
+
+namespace rlx_money {
+
+CachedStatement::CachedStatement(SQLite::Statement* statement, bool* inUse, ConnectionLease lease)
+: mLease(std::move(lease)),
+  mStatement(statement),
+  mInUse(inUse) {
+    *mInUse = true;
+}
+
+CachedStatement::CachedStatement(std::unique_ptr<SQLite::Statement> owned, ConnectionLease lease)
+: mLease(std::move(lease)),
+  mStatement(owned.get()),
+  mOwned(std::move(owned)) {}
+
+CachedStatement::CachedStatement(CachedStatement&& other) noexcept
+: mLease(std::move(other.mLease)),
+  mStatement(other.mStatement),
+  mInUse(other.mInUse),
+  mOwned(std::move(other.mOwned)) {
+    other.mStatement = nullptr;
+    other.mInUse     = nullptr;
+}
+
+CachedStatement::~CachedStatement() {
+    if (mStatement == nullptr) {
+        return;
+    }
+    // 归还前 reset，释放语句持有的读锁；错误码已在 executeStep/exec 中抛出，这里忽略
+    (void)mStatement->tryReset();
+    if (mInUse != nullptr) {
+        *mInUse = false;
+    }
+}
+
+StatementCache::StatementCache(SQLite::Database& db) : mDatabase(db) {}
+
+CachedStatement StatementCache::acquire(std::string_view sql, ConnectionLease lease) {
+    auto it = mEntries.find(sql);
+    if (it == mEntries.end()) {
+        ++mMisses;
+        auto statement = std::make_unique<SQLite::Statement>(mDatabase, std::string(sql));
+        it             = mEntries.emplace(std::string(sql), Entry{std::move(statement), false}).first;
+        return CachedStatement(it->second.statement.get(), &it->second.inUse, std::move(lease));
+    }
+
+    auto& entry = it->second;
+    if (entry.inUse) {
+        // 同一条 SQL 被嵌套使用（例如遍历结果集时再次查询），临时编译一条，不影响缓存中的语句
+        ++mMisses;
+        return CachedStatement(std::make_unique<SQLite::Statement>(mDatabase, std::string(sql)), std::move(lease));
+    }
+
+    ++mHits;
+    entry.statement->clearBindings();
+    return CachedStatement(entry.statement.get(), &entry.inUse, std::move(lease));
+}
+
+void StatementCache::clear() { mEntries.clear(); }
+
+StatementCacheStats StatementCache::getStats() const {
+    StatementCacheStats stats;
+    stats.hits    = mHits;
+    stats.misses  = mMisses;
+    stats.entries = mEntries.size();
+    return stats;
+}
+
+} // namespace rlx_money
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Statement.h>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+
+namespace rlx_money {
+
+/// @brief 预编译语句缓存统计信息
+struct StatementCacheStats {
+    uint64_t hits    = 0; // 命中次数（直接复用已编译语句）
+    uint64_t misses  = 0; // 未命中次数（需要重新编译 SQL）
+    size_t   entries = 0; // 当前缓存的语句数量
+};
+
+/// @brief 连接租约：持有期间独占对应的数据库连接
+using ConnectionLease = std::unique_lock<std::recursive_mutex>;
+
+/// @brief 从缓存借出的预编译语句
+/// @note 借出时已清空绑定参数，析构时自动 reset 并归还缓存；
+///       若同一条 SQL 正在被使用（嵌套调用），则返回一条临时编译的语句；
+///       借出时传入的连接租约在语句 reset 之后才释放
+class CachedStatement {
+public:
+    CachedStatement(CachedStatement&& other) noexcept;
+    ~CachedStatement();
+
+    CachedStatement(const CachedStatement&)            = delete;
+    CachedStatement& operator=(const CachedStatement&) = delete;
+    CachedStatement& operator=(CachedStatement&&)      = delete;
+
+    SQLite::Statement* operator->() const { return mStatement; }
+    SQLite::Statement& operator*() const { return *mStatement; }
+
+private:
+    friend class StatementCache;
+
+    CachedStatement(SQLite::Statement* statement, bool* inUse, ConnectionLease lease);
+    CachedStatement(std::unique_ptr<SQLite::Statement> owned, ConnectionLease lease);
+
+    ConnectionLease                    mLease;               // 连接租约，须最先声明以便最后释放
+    SQLite::Statement*                 mStatement = nullptr;
+    bool*                              mInUse     = nullptr; // 缓存条目的占用标记，临时语句为 nullptr
+    std::unique_ptr<SQLite::Statement> mOwned;               // 临时语句的所有权
+};
+
+/// @brief 按 SQL 文本索引的预编译语句缓存（绑定到单个数据库连接）
+class StatementCache {
+public:
+    /// @brief 构造函数
+    /// @param db 语句所属的数据库连接，必须比缓存存活更久
+    explicit StatementCache(SQLite::Database& db);
+
+    /// @brief 借出预编译语句
+    /// @param sql SQL 语句
+    /// @param lease 连接租约，随语句一起归还（可为空）
+    /// @return 已清空绑定参数的语句
+    [[nodiscard]] CachedStatement acquire(std::string_view sql, ConnectionLease lease = {});
+
+    /// @brief 释放所有缓存的语句（必须在关闭连接前调用）
+    void clear();
+
+    /// @brief 获取缓存统计信息
+    /// @return 统计信息
+    [[nodiscard]] StatementCacheStats getStats() const;
+
+private:
+    struct Entry {
+        std::unique_ptr<SQLite::Statement> statement;
+        bool                               inUse = false;
+    };
+
+    struct SqlHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view sql) const noexcept { return std::hash<std::string_view>{}(sql); }
+    };
+
+    SQLite::Database&                                                mDatabase;
+    std::unordered_map<std::string, Entry, SqlHash, std::equal_to<>> mEntries;
+    uint64_t                                                         mHits   = 0;
+    uint64_t                                                         mMisses = 0;
+};
+
+} // namespace rlx_money
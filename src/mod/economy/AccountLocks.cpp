@@ -0,0 +1,55 @@
+#include "mod/economy/AccountLocks.h"
+#include <algorithm>
+#include <functional>
+
+
+namespace rlx_money {
+
+AccountLockTable::AccountLockTable(size_t stripeCount)
+: mStripeCount(std::max<size_t>(stripeCount, 1)),
+  mStripes(std::make_unique<std::mutex[]>(mStripeCount)) {}
+
+size_t AccountLockTable::stripeOf(std::string_view xuid, std::string_view currencyId) const {
+    size_t seed  = std::hash<std::string_view>{}(xuid);
+    seed        ^= std::hash<std::string_view>{}(currencyId) + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+    return seed % mStripeCount;
+}
+
+AccountLockGuard AccountLockTable::lock(std::string_view xuid, std::string_view currencyId) {
+    AccountLockGuard guard;
+    guard.emplace_back(mStripes[stripeOf(xuid, currencyId)]);
+    return guard;
+}
+
+AccountLockGuard
+AccountLockTable::lockMany(const std::vector<std::pair<std::string_view, std::string_view>>& accounts) {
+    std::vector<size_t> stripes;
+    stripes.reserve(accounts.size());
+    for (const auto& [xuid, currencyId] : accounts) {
+        stripes.push_back(stripeOf(xuid, currencyId));
+    }
+    return lockStripes(stripes);
+}
+
+AccountLockGuard AccountLockTable::lockAll() {
+    AccountLockGuard guard;
+    guard.reserve(mStripeCount);
+    for (size_t i = 0; i < mStripeCount; ++i) {
+        guard.emplace_back(mStripes[i]);
+    }
+    return guard;
+}
+
+AccountLockGuard AccountLockTable::lockStripes(std::vector<size_t>& stripes) {
+    std::sort(stripes.begin(), stripes.end());
+    stripes.erase(std::unique(stripes.begin(), stripes.end()), stripes.end());
+
+    AccountLockGuard guard;
+    guard.reserve(stripes.size());
+    for (size_t stripe : stripes) {
+        guard.emplace_back(mStripes[stripe]);
+    }
+    return guard;
+}
+
+} // namespace rlx_money
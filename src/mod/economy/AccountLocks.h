@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+
+namespace rlx_money {
+
+/// @brief 已持有的一组条带锁，离开作用域时全部释放
+using AccountLockGuard = std::vector<std::unique_lock<std::mutex>>;
+
+/// @brief 账户条带锁表：把 (xuid, 币种) 哈希到固定数量的互斥锁上
+/// @note 同时锁多个账户时总是按条带序号升序加锁（同一条带只锁一次），
+///       因此任意两个调用方之间都不会死锁
+class AccountLockTable {
+public:
+    /// @brief 默认条带数量
+    static constexpr size_t kDefaultStripeCount = 64;
+
+    /// @brief 构造函数
+    /// @param stripeCount 条带数量（至少为 1）
+    explicit AccountLockTable(size_t stripeCount = kDefaultStripeCount);
+
+    /// @brief 计算账户所在的条带
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @return 条带序号
+    [[nodiscard]] size_t stripeOf(std::string_view xuid, std::string_view currencyId) const;
+
+    /// @brief 锁定单个账户
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @return 锁守卫
+    [[nodiscard]] AccountLockGuard lock(std::string_view xuid, std::string_view currencyId);
+
+    /// @brief 按全局顺序锁定多个账户
+    /// @param accounts (xuid, 币种ID) 列表
+    /// @return 锁守卫
+    [[nodiscard]] AccountLockGuard lockMany(const std::vector<std::pair<std::string_view, std::string_view>>& accounts);
+
+    /// @brief 锁定全部条带（用于作用于所有账户的批量操作）
+    /// @return 锁守卫
+    [[nodiscard]] AccountLockGuard lockAll();
+
+    /// @brief 获取条带数量
+    /// @return 条带数量
+    [[nodiscard]] size_t getStripeCount() const { return mStripeCount; }
+
+private:
+    /// @brief 按升序锁定给定的条带
+    /// @param stripes 条带序号（会被排序去重）
+    /// @return 锁守卫
+    AccountLockGuard lockStripes(std::vector<size_t>& stripes);
+
+    size_t                        mStripeCount;
+    std::unique_ptr<std::mutex[]> mStripes;
+};
+
+} // namespace rlx_money
@@ -0,0 +1,236 @@
+#include "mod/economy/BalanceCache.h"
+#include <mutex>
+
+
+namespace rlx_money {
+
+namespace {
+
+/// @brief 哈希表节点、键字符串等固定开销的估算值
+constexpr size_t kNodeOverhead = 64;
+
+} // namespace
+
+void BalanceCache::setBudget(size_t budgetBytes) {
+    std::unique_lock lock(mMutex);
+    mBudgetBytes.store(budgetBytes, std::memory_order_relaxed);
+    if (budgetBytes == 0) {
+        mPlayers.clear();
+        mBytes   = 0;
+        mEntries = 0;
+        return;
+    }
+    (void)makeRoom(0);
+}
+
+BalanceCache::Lookup BalanceCache::lookup(const std::string& xuid, const std::string& currencyId) const {
+    Lookup result;
+    {
+        std::shared_lock lock(mMutex);
+        auto             playerIt = mPlayers.find(xuid);
+        if (playerIt != mPlayers.end()) {
+            auto balanceIt = playerIt->second->balances.find(currencyId);
+            if (balanceIt != playerIt->second->balances.end()) {
+                result.status  = LookupStatus::Hit;
+                result.balance = balanceIt->second;
+            } else {
+                result.status = LookupStatus::Miss;
+            }
+        }
+    }
+    (result.status == LookupStatus::Hit ? mHits : mMisses).fetch_add(1, std::memory_order_relaxed);
+    return result;
+}
+
+bool BalanceCache::loadPlayer(
+    const std::string&                               xuid,
+    const std::map<std::string, std::optional<int>>& balances,
+    uint64_t                                         epoch
+) {
+    std::unique_lock lock(mMutex);
+    mVersion.fetch_add(1, std::memory_order_release);
+    if (mBudgetBytes.load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+
+    auto entry   = std::make_unique<PlayerEntry>();
+    entry->bytes = playerBytes(xuid);
+    // 读取期间发生过整体失效时只登记常驻状态，余额在读取时按需填充
+    if (epoch == mEpoch.load(std::memory_order_relaxed)) {
+        for (const auto& [currencyId, balance] : balances) {
+            entry->balances.emplace(currencyId, balance);
+            entry->bytes += entryBytes(currencyId);
+        }
+    }
+
+    if (auto existing = mPlayers.find(xuid); existing != mPlayers.end()) {
+        erasePlayer(existing);
+    }
+    if (!makeRoom(entry->bytes)) {
+        return false;
+    }
+
+    entry->loadOrder  = mNextLoadOrder++;
+    mBytes           += entry->bytes;
+    mEntries         += entry->balances.size();
+    mPlayers.emplace(xuid, std::move(entry));
+    return true;
+}
+
+void BalanceCache::evictPlayer(const std::string& xuid) {
+    std::unique_lock lock(mMutex);
+    if (auto it = mPlayers.find(xuid); it != mPlayers.end()) {
+        erasePlayer(it);
+    }
+}
+
+void BalanceCache::store(
+    const std::string& xuid,
+    const std::string& currencyId,
+    std::optional<int> balance,
+    uint64_t           epoch
+) {
+    std::unique_lock lock(mMutex);
+    mVersion.fetch_add(1, std::memory_order_release);
+    auto             playerIt = mPlayers.find(xuid);
+    if (playerIt == mPlayers.end()) {
+        return;
+    }
+
+    auto& player    = *playerIt->second;
+    auto  balanceIt = player.balances.find(currencyId);
+    if (epoch != mEpoch.load(std::memory_order_relaxed)) {
+        // 写事务开始后发生过整体失效，写入的值可能已被回滚
+        if (balanceIt != player.balances.end()) {
+            player.balances.erase(balanceIt);
+            player.bytes -= entryBytes(currencyId);
+            mBytes       -= entryBytes(currencyId);
+            --mEntries;
+        }
+        return;
+    }
+
+    if (balanceIt != player.balances.end()) {
+        balanceIt->second = balance;
+        return;
+    }
+    emplaceBalance(player, currencyId, balance);
+}
+
+void BalanceCache::fill(
+    const std::string& xuid,
+    const std::string& currencyId,
+    std::optional<int> balance,
+    uint64_t           version
+) {
+    std::unique_lock lock(mMutex);
+    // 读取之后有过写入或失效时，读到的值可能早于该写入，放弃回填
+    if (version != mVersion.load(std::memory_order_relaxed)) {
+        return;
+    }
+    auto playerIt = mPlayers.find(xuid);
+    if (playerIt == mPlayers.end() || playerIt->second->balances.contains(currencyId)) {
+        return;
+    }
+    emplaceBalance(*playerIt->second, currencyId, balance);
+}
+
+void BalanceCache::invalidateCurrency(const std::string& currencyId) {
+    std::unique_lock lock(mMutex);
+    mVersion.fetch_add(1, std::memory_order_release);
+    for (auto& [xuid, player] : mPlayers) {
+        if (player->balances.erase(currencyId) > 0) {
+            player->bytes -= entryBytes(currencyId);
+            mBytes        -= entryBytes(currencyId);
+            --mEntries;
+        }
+    }
+}
+
+void BalanceCache::invalidateAll() {
+    std::unique_lock lock(mMutex);
+    mVersion.fetch_add(1, std::memory_order_release);
+    mEpoch.fetch_add(1, std::memory_order_release);
+    for (auto& [xuid, player] : mPlayers) {
+        for (const auto& [currencyId, balance] : player->balances) {
+            player->bytes -= entryBytes(currencyId);
+            mBytes        -= entryBytes(currencyId);
+        }
+        player->balances.clear();
+    }
+    mEntries = 0;
+}
+
+void BalanceCache::clear() {
+    std::unique_lock lock(mMutex);
+    mVersion.fetch_add(1, std::memory_order_release);
+    mEpoch.fetch_add(1, std::memory_order_release);
+    mPlayers.clear();
+    mBytes     = 0;
+    mEntries   = 0;
+    mEvictions = 0;
+    mHits.store(0, std::memory_order_relaxed);
+    mMisses.store(0, std::memory_order_relaxed);
+}
+
+bool BalanceCache::isResident(const std::string& xuid) const {
+    std::shared_lock lock(mMutex);
+    return mPlayers.contains(xuid);
+}
+
+BalanceCacheStats BalanceCache::getStats() const {
+    std::shared_lock  lock(mMutex);
+    BalanceCacheStats stats;
+    stats.hits        = mHits.load(std::memory_order_relaxed);
+    stats.misses      = mMisses.load(std::memory_order_relaxed);
+    stats.evictions   = mEvictions;
+    stats.players     = mPlayers.size();
+    stats.entries     = mEntries;
+    stats.bytes       = mBytes;
+    stats.budgetBytes = mBudgetBytes.load(std::memory_order_relaxed);
+    return stats;
+}
+
+size_t BalanceCache::entryBytes(const std::string& currencyId) {
+    return kNodeOverhead + sizeof(std::optional<int>) + currencyId.size();
+}
+
+size_t BalanceCache::playerBytes(const std::string& xuid) {
+    return kNodeOverhead + sizeof(PlayerEntry) + xuid.size();
+}
+
+bool BalanceCache::makeRoom(size_t required) {
+    size_t budget = mBudgetBytes.load(std::memory_order_relaxed);
+    if (required > budget) {
+        return false;
+    }
+    while (mBytes + required > budget && !mPlayers.empty()) {
+        auto oldest = mPlayers.begin();
+        for (auto it = mPlayers.begin(); it != mPlayers.end(); ++it) {
+            if (it->second->loadOrder < oldest->second->loadOrder) {
+                oldest = it;
+            }
+        }
+        erasePlayer(oldest);
+        ++mEvictions;
+    }
+    return true;
+}
+
+void BalanceCache::emplaceBalance(PlayerEntry& player, const std::string& currencyId, std::optional<int> balance) {
+    if (mBytes + entryBytes(currencyId) > mBudgetBytes.load(std::memory_order_relaxed)) {
+        return; // 超出预算时不再新增条目，读取回退到数据库
+    }
+    player.balances.emplace(currencyId, balance);
+    player.bytes += entryBytes(currencyId);
+    mBytes       += entryBytes(currencyId);
+    ++mEntries;
+}
+
+void BalanceCache::erasePlayer(std::unordered_map<std::string, std::unique_ptr<PlayerEntry>>::iterator it) {
+    mBytes   -= it->second->bytes;
+    mEntries -= it->second->balances.size();
+    mPlayers.erase(it);
+}
+
+} // namespace rlx_money
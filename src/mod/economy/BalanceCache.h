@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+
+namespace rlx_money {
+
+/// @brief 余额缓存统计
+struct BalanceCacheStats {
+    uint64_t hits        = 0; // 命中缓存的余额读取次数
+    uint64_t misses      = 0; // 需要查询数据库的余额读取次数
+    uint64_t evictions   = 0; // 因超出内存预算被淘汰的玩家数量
+    size_t   players     = 0; // 当前常驻的玩家数量
+    size_t   entries     = 0; // 当前缓存的余额条目数量
+    size_t   bytes       = 0; // 当前估算占用的内存（字节）
+    size_t   budgetBytes = 0; // 内存预算（字节，0 表示禁用）
+};
+
+/// @brief 在线玩家余额缓存（写穿透）
+/// @note 只缓存“常驻”玩家（在线玩家）的余额，键为 (xuid, 币种)。所有写入都由调用方在持有对应账户锁、
+///       事务提交之后完成，因此缓存中的值总是某个已提交的余额；读取未命中时不加锁回填，
+///       读取期间写入版本发生变化的回填会被丢弃，过期的值不会进入缓存。
+///       组提交整组回滚时调用 invalidateAll() 使纪元递增，纪元变化之前开始的写入会被丢弃
+class BalanceCache {
+public:
+    /// @brief 查询结果
+    enum class LookupStatus {
+        Hit,        // 命中
+        Miss,       // 玩家常驻但该币种余额未缓存
+        NotResident // 玩家不在缓存中
+    };
+
+    /// @brief 查询结果
+    struct Lookup {
+        LookupStatus       status = LookupStatus::NotResident;
+        std::optional<int> balance; // 命中时的余额（为空表示余额记录不存在）
+    };
+
+    /// @brief 设置内存预算，超出预算时淘汰最早载入的玩家
+    /// @param budgetBytes 内存预算（字节，0 表示禁用缓存并清空）
+    void setBudget(size_t budgetBytes);
+
+    /// @brief 缓存是否启用
+    [[nodiscard]] bool isEnabled() const { return mBudgetBytes.load(std::memory_order_relaxed) > 0; }
+
+    /// @brief 获取当前纪元（写入前读取，写入时用于判断期间是否发生过整体失效）
+    [[nodiscard]] uint64_t epoch() const { return mEpoch.load(std::memory_order_acquire); }
+
+    /// @brief 获取写入版本（每次写入、载入或失效时递增；回填前读取，用于判断读取期间是否有写入）
+    [[nodiscard]] uint64_t version() const { return mVersion.load(std::memory_order_acquire); }
+
+    /// @brief 查询余额，并累计命中/未命中次数
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @return 查询结果
+    [[nodiscard]] Lookup lookup(const std::string& xuid, const std::string& currencyId) const;
+
+    /// @brief 载入玩家（玩家上线时调用）
+    /// @param xuid 玩家XUID
+    /// @param balances 币种ID -> 余额（为空表示余额记录不存在）
+    /// @param epoch 读取余额之前获取的纪元
+    /// @return 是否载入成功（缓存禁用或单个玩家超出预算时返回 false）
+    bool loadPlayer(const std::string& xuid, const std::map<std::string, std::optional<int>>& balances, uint64_t epoch);
+
+    /// @brief 移除玩家（玩家下线时调用）
+    /// @param xuid 玩家XUID
+    void evictPlayer(const std::string& xuid);
+
+    /// @brief 写入余额（玩家不常驻时忽略）
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @param balance 余额（为空表示余额记录不存在）
+    /// @param epoch 开始写事务之前获取的纪元；纪元已变化时只删除该条目
+    void store(const std::string& xuid, const std::string& currencyId, std::optional<int> balance, uint64_t epoch);
+
+    /// @brief 回填读取未命中的余额（调用方不持有账户锁）
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @param balance 从数据库读取的余额（为空表示余额记录不存在）
+    /// @param version 读取数据库之前获取的写入版本；版本已变化或条目已存在时放弃回填
+    void fill(const std::string& xuid, const std::string& currencyId, std::optional<int> balance, uint64_t version);
+
+    /// @brief 删除所有玩家的某个币种余额（集合操作之后调用，常驻状态保留）
+    /// @param currencyId 币种ID
+    void invalidateCurrency(const std::string& currencyId);
+
+    /// @brief 删除所有缓存的余额并递增纪元（常驻状态保留）
+    void invalidateAll();
+
+    /// @brief 清空缓存（包括常驻状态）与统计
+    void clear();
+
+    /// @brief 玩家是否常驻
+    /// @param xuid 玩家XUID
+    [[nodiscard]] bool isResident(const std::string& xuid) const;
+
+    /// @brief 获取统计信息
+    [[nodiscard]] BalanceCacheStats getStats() const;
+
+private:
+    /// @brief 常驻玩家
+    struct PlayerEntry {
+        std::unordered_map<std::string, std::optional<int>> balances;
+        uint64_t                                            loadOrder = 0;
+        size_t                                              bytes     = 0;
+    };
+
+    /// @brief 估算单个余额条目占用的内存
+    static size_t entryBytes(const std::string& currencyId);
+
+    /// @brief 估算玩家条目本身占用的内存（不含余额）
+    static size_t playerBytes(const std::string& xuid);
+
+    /// @brief 淘汰最早载入的玩家直到腾出指定空间（调用方需持有写锁）
+    /// @param required 需要的空间
+    /// @return 是否腾出了足够空间
+    bool makeRoom(size_t required);
+
+    /// @brief 新增余额条目，超出预算时放弃（调用方需持有写锁）
+    void emplaceBalance(PlayerEntry& player, const std::string& currencyId, std::optional<int> balance);
+
+    /// @brief 删除玩家条目（调用方需持有写锁）
+    void erasePlayer(std::unordered_map<std::string, std::unique_ptr<PlayerEntry>>::iterator it);
+
+    mutable std::shared_mutex                                     mMutex;
+    std::unordered_map<std::string, std::unique_ptr<PlayerEntry>> mPlayers;
+    std::atomic<size_t>                                           mBudgetBytes{0};
+    std::atomic<uint64_t>                                         mEpoch{0};
+    std::atomic<uint64_t>                                         mVersion{0};
+    uint64_t                                                      mNextLoadOrder = 0;
+    size_t                                                        mBytes         = 0;
+    size_t                                                        mEntries       = 0;
+    uint64_t                                                      mEvictions     = 0;
+    mutable std::atomic<uint64_t>                                 mHits{0};
+    mutable std::atomic<uint64_t>                                 mMisses{0};
+};
+
+} // namespace rlx_money
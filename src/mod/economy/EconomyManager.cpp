@@ -3,19 +3,87 @@
 #include "mod/database/DatabaseManager.h"
 #include "mod/exceptions/MoneyException.h"
 #include <RLXMoney/types/Types.h>
-#include <SQLiteCpp/Statement.h>
+#include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <iomanip>
 #include <limits>
+#include <map>
+#include <optional>
 #include <random>
+#include <sstream>
+#include <unordered_map>
 
 
 namespace rlx_money {
 
-EconomyManager::EconomyManager()
-: mPlayerDAO(DatabaseManager::getInstance()),
-  mTransactionDAO(DatabaseManager::getInstance()),
-  mInitialized(false) {
+namespace {
+
+/// @brief 获取币种配置
+/// @param currencyId 币种ID
+/// @return 币种配置
+/// @throw InvalidArgumentException 币种配置不存在时
+const Currency& findCurrencyConfig(const std::string& currencyId) {
+    const auto& config     = MoneyConfig::getInstance().get();
+    auto        currencyIt = config.currencies.find(currencyId);
+    if (currencyIt == config.currencies.end()) {
+        throw InvalidArgumentException("币种配置不存在: " + currencyId);
+    }
+    return currencyIt->second;
+}
+
+/// @brief 计算转账总扣款（转账金额 + 手续费）并检查转账限制
+/// @param currency 币种配置
+/// @param amount 转账金额
+/// @return 转出玩家需要扣除的总金额
+/// @throw MoneyException 币种不允许转账、金额低于最小限制或与手续费之和溢出时
+int computeTransferTotal(const Currency& currency, int amount) {
+    // 检查转账是否允许
+    if (!currency.allowPlayerTransfer) {
+        throw MoneyException(ErrorCode::TRANSFER_DISABLED, "该币种不允许玩家转账");
+    }
+
+    if (amount < currency.minTransferAmount) {
+        throw InvalidArgumentException("转账金额小于最小限制");
+    }
+
+    // 计算手续费
+    int fee = currency.transferFee;
+    if (currency.feePercentage > 0.0) {
+        double feeAmount  = static_cast<double>(amount) * currency.feePercentage / 100.0;
+        fee              += static_cast<int>(std::round(feeAmount));
+    }
+
+    // 检查整数溢出风险
+    if (amount > 0 && fee > 0 && amount > std::numeric_limits<int>::max() - fee) {
+        throw InvalidArgumentException("转账金额和手续费过大，超出系统处理范围");
+    }
+
+    return amount + fee;
+}
+
+/// @brief 生成转账ID（出入两条记录共享）
+/// @return 24 位十六进制字符串
+std::string generateTransferId() {
+    static const char*                 hex = "0123456789abcdef";
+    std::string                        s(24, '0');
+    std::random_device                 rd;
+    std::mt19937                       rng(rd());
+    std::uniform_int_distribution<int> dist(0, 15);
+    for (char& c : s) c = hex[dist(rng)];
+    return s;
+}
+
+/// @brief 写入是否已完成（不等待）
+/// @param handle 完成句柄
+/// @return 是否已完成
+bool isFlushReady(const std::shared_future<bool>& handle) {
+    return handle.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+} // namespace
+
+EconomyManager::EconomyManager() : mInitialized(false) {
     // 构造函数中初始化依赖的单例，确保依赖关系正确
     try {
         // 确保依赖的单例已初始化
@@ -33,7 +101,7 @@ EconomyManager& EconomyManager::getInstance() {
 }
 
 bool EconomyManager::initialize() {
-    // 单线程模式，无需加锁
+    std::lock_guard lock(mInitMutex);
 
     // 如果已初始化，直接返回成功
     if (mInitialized) {
@@ -41,21 +109,30 @@ bool EconomyManager::initialize() {
     }
 
     try {
-        // 读取配置并确保数据库已初始化
+        // 读取配置，按配置创建并打开存储后端（重置后或后端类型变化时重新创建）
         const auto& config = MoneyConfig::getInstance().get();
-
-        auto& dbManager = DatabaseManager::getInstance();
-        if (!dbManager.isInitialized()) {
-            if (!dbManager.initialize(config.database.path)) {
-                return false;
-            }
+        if (!mStorage || mStorage->getName() != config.database.backend) {
+            mStorage = createStorageBackend(config.database);
+        }
+        if (!mStorage->open(config.database)) {
+            return false;
         }
 
+        // 重放上次运行未写入数据库的写后交易
+        recoverWriteBehindJournal();
+
         // 同步配置文件中的币种到数据库
         if (!syncCurrenciesFromConfig()) {
             return false;
         }
 
+        // 配置余额缓存；组事务整体回滚时已写入缓存与排行榜的余额随之失效
+        mBalanceCache.setBudget(static_cast<size_t>(config.balanceCacheKB) * 1024);
+        mStorage->setRollbackListener([this]() {
+            mBalanceCache.invalidateAll();
+            mLeaderboard.invalidateAll();
+        });
+
         // 标记初始化完成
         mInitialized = true;
         return true;
@@ -66,23 +143,178 @@ bool EconomyManager::initialize() {
 }
 
 std::optional<int> EconomyManager::getBalance(const std::string& xuid, const std::string& currencyId) const {
-    // 单线程模式，无需加锁
+    // 读取不加账户锁：余额更新都在事务内完成，读到的总是某个已提交的值；
+    // 未命中时按版本号无锁回填，读取期间发生过写入或移出时放弃回填，不会把旧值写进缓存
 
     try {
         if (!isValidCurrency(currencyId)) {
             throw InvalidArgumentException("无效的币种ID: " + currencyId);
         }
 
-        return mPlayerDAO.getBalance(xuid, currencyId);
+        // 写后模式币种以内存余额为准，未载入时从数据库载入
+        if (isWriteBehindCurrency(currencyId)) {
+            return loadWriteBehindBalance(xuid, currencyId);
+        }
+
+        auto cached = mBalanceCache.lookup(xuid, currencyId);
+        if (cached.status == BalanceCache::LookupStatus::Hit) {
+            return cached.balance;
+        }
+        if (cached.status == BalanceCache::LookupStatus::NotResident) {
+            return storage().getBalance(xuid, currencyId);
+        }
+
+        // 常驻玩家未命中时回填；先取版本再读取，期间有写入时回填被丢弃
+        uint64_t cacheVersion = mBalanceCache.version();
+        auto     balance      = storage().getBalance(xuid, currencyId);
+        mBalanceCache.fill(xuid, currencyId, balance, cacheVersion);
+        return balance;
 
     } catch (const std::exception& e) {
         throw DatabaseException("获取玩家余额失败: " + std::string(e.what()));
     }
 }
 
+bool EconomyManager::cachePlayerBalances(const std::string& xuid) {
+    if (!mBalanceCache.isEnabled()) {
+        return false;
+    }
+
+    try {
+        // 锁定该玩家所有启用币种的账户，载入期间不会有写入落在读取与载入之间
+        const auto&                                                 config = MoneyConfig::getInstance().get();
+        std::map<std::string, std::optional<int>>                   balances;
+        std::vector<std::pair<std::string_view, std::string_view>> accounts;
+        for (const auto& [currencyId, currency] : config.currencies) {
+            // 写后模式币种的余额本身就在内存中，不进入缓存
+            if (currency.enabled && !isWriteBehindCurrency(currencyId)) {
+                balances.emplace(currencyId, std::nullopt);
+                accounts.emplace_back(xuid, currencyId);
+            }
+        }
+        auto accountLock = mAccountLocks.lockMany(accounts);
+
+        uint64_t cacheEpoch = mBalanceCache.epoch();
+        for (const auto& balance : storage().getAllBalances(xuid)) {
+            if (auto it = balances.find(balance.currencyId); it != balances.end()) {
+                it->second = balance.balance;
+            }
+        }
+        return mBalanceCache.loadPlayer(xuid, balances, cacheEpoch);
+
+    } catch (const std::exception& e) {
+        throw DatabaseException("载入玩家余额缓存失败: " + std::string(e.what()));
+    }
+}
+
+void EconomyManager::evictPlayerBalances(const std::string& xuid) {
+    mBalanceCache.evictPlayer(xuid);
+    if (!mWriteBehind.isOpen()) {
+        return;
+    }
+
+    // 玩家下线时刷新写后余额，再移出该玩家已写入数据库的内存余额
+    try {
+        std::lock_guard flushLock(mWriteBehindFlushMutex);
+        if (!mPendingFlush) {
+            submitWriteBehindFlush();
+        }
+        // 刷新仍在写线程中时不等待也不移出，该玩家之后未再修改的余额在下一次刷新开始时移出内存
+        if (mPendingFlush && !isFlushReady(mPendingFlush->handle)) {
+            return;
+        }
+        finishWriteBehindFlush();
+        mWriteBehind.dropPlayer(xuid);
+    } catch (const std::exception& e) {
+        throw DatabaseException("刷新下线玩家的写后余额失败: " + std::string(e.what()));
+    }
+}
+
+BalanceCacheStats EconomyManager::getBalanceCacheStats() const { return mBalanceCache.getStats(); }
+
+bool EconomyManager::isWriteBehindCurrency(const std::string& currencyId) const {
+    if (!mWriteBehind.isOpen()) {
+        return false;
+    }
+    const auto& config     = MoneyConfig::getInstance().get();
+    auto        currencyIt = config.currencies.find(currencyId);
+    return currencyIt != config.currencies.end() && currencyIt->second.writeBehind;
+}
+
+int64_t EconomyManager::flushWriteBehind() {
+    std::lock_guard flushLock(mWriteBehindFlushMutex);
+    return flushWriteBehindLocked();
+}
+
+void EconomyManager::flushCommits() {
+    if (isStorageOpen()) {
+        storage().flushCommits();
+    }
+}
+
+void EconomyManager::flushForShutdown() {
+    // 写后刷新只在有脏数据时提交组事务；其余写入仍在未提交的组中，卸载后不会再有 tick 提交它们
+    try {
+        flushWriteBehind();
+    } catch (...) {
+        flushCommits();
+        throw;
+    }
+    flushCommits();
+}
+
+void EconomyManager::flushWriteBehindIfDue() {
+    if (!mWriteBehind.isOpen()) {
+        return;
+    }
+    // 其他线程正在刷新时跳过本 tick
+    std::unique_lock flushLock(mWriteBehindFlushMutex, std::try_to_lock);
+    if (!flushLock.owns_lock()) {
+        return;
+    }
+    // 上一次刷新仍在写线程中时不等待，之后的 tick 再确认
+    if (mPendingFlush && !isFlushReady(mPendingFlush->handle)) {
+        return;
+    }
+    finishWriteBehindFlush();
+
+    int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::steady_clock::now().time_since_epoch()
+    )
+                      .count();
+    if (now - mLastWriteBehindFlushMs.load(std::memory_order_relaxed)
+        < MoneyConfig::getInstance().get().writeBehindFlushMs) {
+        return;
+    }
+    submitWriteBehindFlush();
+    // 同步执行的存储后端此时已写入完成
+    if (mPendingFlush && isFlushReady(mPendingFlush->handle)) {
+        finishWriteBehindFlush();
+    }
+}
+
+WriteBehindStats EconomyManager::getWriteBehindStats() const { return mWriteBehind.getStats(); }
+
 std::vector<PlayerBalance> EconomyManager::getAllBalances(const std::string& xuid) const {
     try {
-        return mPlayerDAO.getAllBalances(xuid);
+        auto balances = storage().getAllBalances(xuid);
+
+        // 写后模式币种用内存中的余额覆盖数据库中尚未刷新的值
+        if (mWriteBehind.isOpen()) {
+            for (const auto& [currencyId, balance] : mWriteBehind.getPlayerBalances(xuid)) {
+                auto it = std::find_if(balances.begin(), balances.end(), [&](const PlayerBalance& item) {
+                    return item.currencyId == currencyId;
+                });
+                if (it == balances.end()) {
+                    it             = balances.emplace(balances.end());
+                    it->xuid       = xuid;
+                    it->currencyId = currencyId;
+                    it->updatedAt  = getCurrentTimestamp();
+                }
+                it->balance = balance;
+            }
+        }
+        return balances;
     } catch (const std::exception& e) {
         throw DatabaseException("获取玩家所有余额失败: " + std::string(e.what()));
     }
@@ -102,43 +334,8 @@ bool EconomyManager::setBalance(
         throw InvalidArgumentException("无效的币种ID: " + currencyId);
     }
 
-    // 单线程模式，无需加锁
-
     try {
-        // 检查玩家是否存在
-        if (!mPlayerDAO.playerExists(xuid)) {
-            throw MoneyException(ErrorCode::PLAYER_NOT_FOUND, "玩家不存在");
-        }
-
-        // 获取币种配置，检查最大余额限制
-        const auto& config     = MoneyConfig::getInstance().get();
-        auto  currencyIt = config.currencies.find(currencyId);
-        if (currencyIt == config.currencies.end()) {
-            throw InvalidArgumentException("币种配置不存在: " + currencyId);
-        }
-
-        if (amount > currencyIt->second.maxBalance) {
-            throw InvalidArgumentException("金额超过最大余额限制");
-        }
-
-        // 使用事务确保余额更新和交易记录创建的原子性
-        return DatabaseManager::getInstance().executeTransaction([&](SQLite::Database& db) -> bool {
-            try {
-                (void)db; // 避免未使用参数警告
-                // 更新余额
-                if (!mPlayerDAO.updateBalance(xuid, currencyId, amount)) {
-                    return false;
-                }
-
-                // 创建交易记录
-                return createTransactionRecord(xuid, currencyId, amount, amount, TransactionType::SET, description);
-
-            } catch (const std::exception&) {
-                // 事务会自动回滚
-                return false;
-            }
-        });
-
+        return applySetBalance(xuid, currencyId, amount, description);
     } catch (const std::exception& e) {
         throw DatabaseException("设置玩家余额失败: " + std::string(e.what()));
     }
@@ -158,57 +355,8 @@ bool EconomyManager::addMoney(
         throw InvalidArgumentException("无效的币种ID: " + currencyId);
     }
 
-    // 单线程模式，无需加锁
-
     try {
-        // 获取币种配置
-        const auto& config     = MoneyConfig::getInstance().get();
-        auto  currencyIt = config.currencies.find(currencyId);
-        if (currencyIt == config.currencies.end()) {
-            throw InvalidArgumentException("币种配置不存在: " + currencyId);
-        }
-
-        // 检查玩家是否存在
-        if (!mPlayerDAO.playerExists(xuid)) {
-            throw MoneyException(ErrorCode::PLAYER_NOT_FOUND, "玩家不存在，请先初始化玩家");
-        }
-
-        // 获取当前余额
-        auto currentBalance = mPlayerDAO.getBalance(xuid, currencyId);
-        int  oldBalance     = currentBalance.has_value() ? currentBalance.value() : 0;
-
-        // 初始化余额（如果不存在）- 这种情况发生在玩家已存在但某个币种余额未初始化（例如添加了新币种）
-        if (!currentBalance.has_value()) {
-            oldBalance = currencyIt->second.initialBalance;
-            mPlayerDAO.initializeBalance(xuid, currencyId, oldBalance);
-        }
-
-        int newBalance = oldBalance + amount;
-
-        // 检查最大余额限制
-        if (newBalance > currencyIt->second.maxBalance) {
-            throw InvalidArgumentException("金额超过最大余额限制");
-        }
-
-        // 使用事务确保余额更新和交易记录创建的原子性
-        return DatabaseManager::getInstance().executeTransaction([&](SQLite::Database& db) -> bool {
-            try {
-                (void)db; // 避免未使用参数警告
-
-                // 更新余额
-                if (!mPlayerDAO.updateBalance(xuid, currencyId, newBalance)) {
-                    return false;
-                }
-
-                // 创建交易记录
-                return createTransactionRecord(xuid, currencyId, amount, newBalance, TransactionType::ADD, description);
-
-            } catch (const std::exception&) {
-                // 事务会自动回滚
-                return false;
-            }
-        });
-
+        return applyBalanceChange(xuid, currencyId, amount, TransactionType::ADD, description);
     } catch (const std::exception& e) {
         throw DatabaseException("增加玩家金钱失败: " + std::string(e.what()));
     }
@@ -228,50 +376,8 @@ bool EconomyManager::reduceMoney(
         throw InvalidArgumentException("无效的币种ID: " + currencyId);
     }
 
-    // 单线程模式，无需加锁
-
     try {
-        // 获取当前余额
-        auto currentBalance = mPlayerDAO.getBalance(xuid, currencyId);
-        if (!currentBalance.has_value()) {
-            throw MoneyException(ErrorCode::PLAYER_NOT_FOUND, "玩家不存在或余额未初始化");
-        }
-
-        int oldBalance = currentBalance.value();
-
-        // 检查余额是否充足
-        if (oldBalance < amount) {
-            throw MoneyException(ErrorCode::INSUFFICIENT_BALANCE, "余额不足");
-        }
-
-        int newBalance = oldBalance - amount;
-
-        // 使用事务确保余额更新和交易记录创建的原子性
-        return DatabaseManager::getInstance().executeTransaction([&](SQLite::Database& db) -> bool {
-            try {
-                (void)db; // 避免未使用参数警告
-
-                // 更新余额
-                if (!mPlayerDAO.updateBalance(xuid, currencyId, newBalance)) {
-                    return false;
-                }
-
-                // 创建交易记录
-                return createTransactionRecord(
-                    xuid,
-                    currencyId,
-                    -amount,
-                    newBalance,
-                    TransactionType::REDUCE,
-                    description
-                );
-
-            } catch (const std::exception&) {
-                // 事务会自动回滚
-                return false;
-            }
-        });
-
+        return applyBalanceChange(xuid, currencyId, amount, TransactionType::REDUCE, description);
     } catch (const std::exception& e) {
         throw DatabaseException("扣除玩家金钱失败: " + std::string(e.what()));
     }
@@ -297,232 +403,668 @@ bool EconomyManager::transferMoney(
         throw InvalidArgumentException("不能转账给自己");
     }
 
-    // 单线程模式，无需加锁
-
     try {
-        // 获取币种配置
-        const auto& config     = MoneyConfig::getInstance().get();
-        auto  currencyIt = config.currencies.find(currencyId);
-        if (currencyIt == config.currencies.end()) {
-            throw InvalidArgumentException("币种配置不存在: " + currencyId);
-        }
-        const auto& currency = currencyIt->second;
+        int totalAmount = computeTransferTotal(findCurrencyConfig(currencyId), amount);
 
-        // 检查转账是否允许
-        if (!currency.allowPlayerTransfer) {
-            throw MoneyException(ErrorCode::TRANSFER_DISABLED, "该币种不允许玩家转账");
-        }
+        // 按全局顺序锁定双方账户，避免相向转账死锁
+        auto accountLock = mAccountLocks.lockMany({
+            {fromXuid, currencyId},
+            {toXuid,   currencyId}
+        });
 
-        if (amount < currency.minTransferAmount) {
-            throw InvalidArgumentException("转账金额小于最小限制");
+        if (isWriteBehindCurrency(currencyId)) {
+            std::optional<MoneyException> failure;
+            auto balances = writeBehindTransfer(fromXuid, toXuid, currencyId, amount, totalAmount, description, failure);
+            if (failure) {
+                throw *failure;
+            }
+            return balances.has_value();
         }
 
-        // 获取转出玩家余额
-        auto fromBalance = mPlayerDAO.getBalance(fromXuid, currencyId);
-        if (!fromBalance.has_value()) {
-            throw MoneyException(ErrorCode::PLAYER_NOT_FOUND, "转出玩家不存在或余额未初始化");
-        }
+        auto                               epoch = currentWriteEpoch();
+        std::optional<std::pair<int, int>> balances;
+        std::optional<MoneyException>      failure;
+        bool committed = storage().runTransaction([&]() -> bool {
+            try {
+                balances =
+                    transferInTransaction(fromXuid, toXuid, currencyId, amount, totalAmount, description, failure);
+                return balances.has_value();
+            } catch (const std::exception&) {
+                return false;
+            }
+        });
 
-        // 获取转入玩家信息
-        auto toPlayer = mPlayerDAO.getPlayerByXuid(toXuid);
-        if (!toPlayer) {
-            throw MoneyException(ErrorCode::PLAYER_NOT_FOUND, "转入玩家不存在");
+        if (failure) {
+            throw *failure;
         }
-
-        // 获取转入玩家余额（如果不存在则初始化为初始余额）
-        // 注意：这种情况发生在玩家已存在但某个币种余额未初始化（例如添加了新币种）
-        auto toBalance    = mPlayerDAO.getBalance(toXuid, currencyId);
-        int  toOldBalance = toBalance.has_value() ? toBalance.value() : 0;
-        if (!toBalance.has_value()) {
-            mPlayerDAO.initializeBalance(toXuid, currencyId, currency.initialBalance);
-            toOldBalance = currency.initialBalance;
+        if (committed) {
+            publishBalance(epoch, fromXuid, currencyId, balances->first);
+            publishBalance(epoch, toXuid, currencyId, balances->second);
         }
+        return committed;
 
-        // 检查余额是否充足
-        if (fromBalance.value() < amount) {
-            throw MoneyException(ErrorCode::INSUFFICIENT_BALANCE, "余额不足");
-        }
+    } catch (const std::exception& e) {
+        throw DatabaseException("转账失败: " + std::string(e.what()));
+    }
+}
 
-        // 计算手续费
-        int fee = currency.transferFee;
-        if (currency.feePercentage > 0.0) {
-            double feeAmount  = static_cast<double>(amount) * currency.feePercentage / 100.0;
-            fee              += static_cast<int>(std::round(feeAmount));
+std::vector<MoneyOpResult> EconomyManager::applyBatch(std::span<const MoneyOp> ops) {
+    std::vector<MoneyOpResult> results(ops.size());
+    std::vector<int>           transferTotals(ops.size(), 0);
+
+    // 预先校验全部条目，未通过校验的条目不会执行
+    size_t validCount = 0;
+    for (size_t i = 0; i < ops.size(); ++i) {
+        try {
+            transferTotals[i] = validateMoneyOp(ops[i]);
+            results[i].success = true;
+            ++validCount;
+        } catch (const MoneyException& e) {
+            results[i].error   = e.getErrorCode();
+            results[i].message = e.what();
         }
+    }
+    if (validCount == 0) {
+        return results;
+    }
 
-        // 检查整数溢出风险
-        if (amount > 0 && fee > 0 && amount > std::numeric_limits<int>::max() - fee) {
-            throw InvalidArgumentException("转账金额和手续费过大，超出系统处理范围");
+    auto fail = [](MoneyOpResult& result, const MoneyException& e) {
+        result.success = false;
+        result.error   = e.getErrorCode();
+        result.message = e.what();
+        result.balance.reset();
+    };
+
+    // 按全局顺序锁定所有相关账户
+    std::vector<std::pair<std::string_view, std::string_view>> accounts;
+    for (size_t i = 0; i < ops.size(); ++i) {
+        if (results[i].success) {
+            accounts.emplace_back(ops[i].xuid, ops[i].currencyId);
+            if (ops[i].type == TransactionType::TRANSFER) {
+                accounts.emplace_back(ops[i].toXuid, ops[i].currencyId);
+            }
         }
+    }
+    auto accountLock = mAccountLocks.lockMany(accounts);
 
-        int totalAmount = amount + fee;
+    auto                            epoch = currentWriteEpoch();
+    std::vector<std::optional<int>> toBalances(ops.size()); // 转账条目转入玩家操作后的余额
 
-        // 检查余额是否充足（考虑手续费）
-        if (fromBalance.value() < totalAmount) {
-            throw MoneyException(ErrorCode::INSUFFICIENT_BALANCE, "余额不足（含手续费）");
+    // 执行单个条目，写后模式币种的条目在内存中执行，其余条目在已打开的事务中执行
+    auto execute = [&](size_t i, bool writeBehind, std::optional<MoneyException>& failure) -> std::optional<int> {
+        const auto& op = ops[i];
+        if (!writeBehind) {
+            return applyOpInTransaction(op, transferTotals[i], toBalances[i], failure);
         }
-
-        // 检查减法溢出风险
-        if (totalAmount > fromBalance.value()) {
-            throw MoneyException(ErrorCode::INSUFFICIENT_BALANCE, "余额不足（含手续费）");
+        switch (op.type) {
+        case TransactionType::SET:
+            return writeBehindSet(op.xuid, op.currencyId, op.amount, op.description, failure);
+        case TransactionType::ADD:
+        case TransactionType::REDUCE:
+            return writeBehindChange(op.xuid, op.currencyId, op.amount, op.type, op.description, failure);
+        default: {
+            auto balances = writeBehindTransfer(
+                op.xuid,
+                op.toXuid,
+                op.currencyId,
+                op.amount,
+                transferTotals[i],
+                op.description,
+                failure
+            );
+            if (!balances) {
+                return std::nullopt;
+            }
+            toBalances[i] = balances->second;
+            return balances->first;
         }
-
-        int fromNewBalance = fromBalance.value() - totalAmount;
-
-        // 检查加法溢出风险
-        if (amount > 0 && toOldBalance > std::numeric_limits<int>::max() - amount) {
-            throw InvalidArgumentException("转入金额过大，超出系统处理范围");
         }
-
-        int toNewBalance = toOldBalance + amount;
-
-        // 检查最大余额限制
-        if (toNewBalance > currency.maxBalance) {
-            throw InvalidArgumentException("转入金额超过最大余额限制");
+    };
+
+    // 写后模式币种的条目不经过数据库事务，逐条执行（与其余条目涉及的账户互不相交）
+    std::vector<bool> writeBehindOps(ops.size(), false);
+    bool              hasDatabaseOps = false;
+    for (size_t i = 0; i < ops.size(); ++i) {
+        if (!results[i].success) {
+            continue;
         }
+        if (!isWriteBehindCurrency(ops[i].currencyId)) {
+            hasDatabaseOps = true;
+            continue;
+        }
+        writeBehindOps[i] = true;
+
+        std::optional<MoneyException> failure;
+        std::optional<int>            balance;
+        try {
+            balance = execute(i, true, failure);
+        } catch (const MoneyException& e) {
+            failure = e;
+        } catch (const std::exception& e) {
+            failure = DatabaseException(e.what());
+        }
+        if (failure) {
+            fail(results[i], *failure);
+        } else {
+            results[i].balance = balance;
+        }
+    }
+    if (!hasDatabaseOps) {
+        return results;
+    }
 
-        // 使用事务执行转账
-        return DatabaseManager::getInstance().executeTransaction([&](SQLite::Database&) -> bool {
-            try {
-                // 生成 transfer_id
-                auto genId = []() {
-                    static const char*                 hex = "0123456789abcdef";
-                    std::string                        s(24, '0');
-                    std::random_device                 rd;
-                    std::mt19937                       rng(rd());
-                    std::uniform_int_distribution<int> dist(0, 15);
-                    for (char& c : s) c = hex[dist(rng)];
-                    return s;
-                };
-                std::string transferId = genId();
-
-                // 更新转出玩家余额
-                if (!mPlayerDAO.updateBalance(fromXuid, currencyId, fromNewBalance)) {
-                    return false;
-                }
-
-                // 更新转入玩家余额
-                if (!mPlayerDAO.updateBalance(toXuid, currencyId, toNewBalance)) {
-                    return false;
+    // 其余条目在同一个事务中执行，每个条目独占一个保存点，失败的条目只回滚自身
+    auto isDatabaseOp = [&](size_t i) { return results[i].success && !writeBehindOps[i]; };
+    bool committed    = false;
+    try {
+        committed = storage().runTransaction([&]() -> bool {
+            for (size_t i = 0; i < ops.size(); ++i) {
+                if (!isDatabaseOp(i)) {
+                    continue;
                 }
 
-                // 创建转出交易记录
-                createTransactionRecord(
-                    fromXuid,
-                    currencyId,
-                    -totalAmount,
-                    fromNewBalance,
-                    TransactionType::TRANSFER,
-                    description,
-                    toXuid,
-                    transferId
-                );
-
-                // 创建转入交易记录
-                createTransactionRecord(
-                    toXuid,
-                    currencyId,
-                    amount,
-                    toNewBalance,
-                    TransactionType::TRANSFER,
-                    description,
-                    fromXuid,
-                    transferId
-                );
-
-                return true;
+                std::optional<MoneyException> failure;
+                std::optional<int>            balance;
+
+                // 嵌套事务在保存点内执行，返回 false 只回滚该条目的写入
+                (void)storage().runTransaction([&]() -> bool {
+                    try {
+                        balance = execute(i, false, failure);
+                        if (!balance && !failure) {
+                            failure = DatabaseException("创建交易记录失败");
+                        }
+                    } catch (const MoneyException& e) {
+                        failure = e;
+                    } catch (const std::exception& e) {
+                        failure = DatabaseException(e.what());
+                    }
+                    return !failure;
+                });
 
-            } catch (const std::exception&) {
-                return false;
+                if (failure) {
+                    fail(results[i], *failure);
+                } else {
+                    results[i].balance = balance;
+                }
             }
+            return true;
         });
-
     } catch (const std::exception& e) {
-        throw DatabaseException("转账失败: " + std::string(e.what()));
+        for (size_t i = 0; i < ops.size(); ++i) {
+            if (isDatabaseOp(i)) {
+                fail(results[i], DatabaseException(e.what()));
+            }
+        }
+        return results;
     }
-}
 
-bool EconomyManager::initializeNewPlayer(const std::string& xuid, const std::string& username) {
-    // 单线程模式，无需加锁
+    if (!committed) {
+        for (size_t i = 0; i < ops.size(); ++i) {
+            if (isDatabaseOp(i)) {
+                fail(results[i], DatabaseException("批量操作事务提交失败"));
+            }
+        }
+        return results;
+    }
 
-    try {
-        // 步骤1：玩家存在性检查（必须在事务外执行）
-        if (mPlayerDAO.playerExists(xuid)) {
-            throw MoneyException(ErrorCode::PLAYER_ALREADY_EXISTS, "玩家已存在");
+    for (size_t i = 0; i < ops.size(); ++i) {
+        if (isDatabaseOp(i)) {
+            publishBalance(epoch, ops[i].xuid, ops[i].currencyId, results[i].balance);
+            if (ops[i].type == TransactionType::TRANSFER) {
+                publishBalance(epoch, ops[i].toXuid, ops[i].currencyId, toBalances[i]);
+            }
         }
+    }
+    return results;
+}
 
-        // 步骤2：整个初始化过程在事务中执行
-        return DatabaseManager::getInstance().executeTransaction([&](SQLite::Database& db) -> bool {
-            try {
-                (void)db;                                    // 避免未使用参数警告
-                int64_t currentTime = getCurrentTimestamp(); // 时间戳保持 int64_t
+MoneyTxResult EconomyManager::applyAtomic(std::span<const MoneyOp> legs) {
+    MoneyTxResult result;
+    auto          fail = [&](int leg, const MoneyException& e) {
+        result.error     = e.getErrorCode();
+        result.message   = e.what();
+        result.failedLeg = leg;
+        return result;
+    };
+
+    if (legs.empty()) {
+        return fail(-1, InvalidArgumentException("事务不包含任何条目"));
+    }
 
-                // 2.1 创建玩家基础记录（players表）
-                PlayerData playerData(xuid, username, currentTime);
-                playerData.createdAt = currentTime;
-                playerData.updatedAt = currentTime;
+    // 整体校验：任一条目未通过时不执行任何条目
+    std::vector<int> transferTotals(legs.size(), 0);
+    for (size_t i = 0; i < legs.size(); ++i) {
+        try {
+            transferTotals[i] = validateMoneyOp(legs[i]);
+            // 写后模式的变更逐条追加到重做日志，无法与其余条目一起回滚
+            if (isWriteBehindCurrency(legs[i].currencyId)) {
+                throw InvalidArgumentException("写后模式币种不支持原子事务: " + legs[i].currencyId);
+            }
+        } catch (const MoneyException& e) {
+            return fail(static_cast<int>(i), e);
+        }
+    }
 
-                if (!mPlayerDAO.createPlayer(playerData)) {
-                    return false;
-                }
+    std::vector<std::pair<std::string_view, std::string_view>> accounts;
+    for (const auto& leg : legs) {
+        accounts.emplace_back(leg.xuid, leg.currencyId);
+        if (leg.type == TransactionType::TRANSFER) {
+            accounts.emplace_back(leg.toXuid, leg.currencyId);
+        }
+    }
+    auto accountLock = mAccountLocks.lockMany(accounts);
 
-                // 2.2 为所有启用的币种初始化余额和交易记录
-                const auto& config = MoneyConfig::getInstance().get();
-                for (const auto& [currencyId, currency] : config.currencies) {
-                    if (currency.enabled) {
-                        // 直接在事务中执行余额初始化（player_balances表）
-                        SQLite::Statement balanceStmt(
-                            db,
-                            "INSERT INTO player_balances (xuid, currency_id, balance, updated_at) VALUES (?, ?, ?, ?)"
-                        );
-                        balanceStmt.bind(1, xuid);
-                        balanceStmt.bind(2, currencyId);
-                        balanceStmt.bind(3, currency.initialBalance);
-                        balanceStmt.bind(4, currentTime);
-                        balanceStmt.exec();
+    auto                            epoch = currentWriteEpoch();
+    std::vector<std::optional<int>> balances(legs.size());
+    std::vector<std::optional<int>> toBalances(legs.size()); // 转账条目转入玩家操作后的余额
+    std::optional<MoneyException>   failure;
+    int                             failedLeg = -1;
 
-                        // 创建交易记录（transactions表）
-                        createTransactionRecord(
-                            xuid,
-                            currencyId,
-                            currency.initialBalance,
-                            currency.initialBalance,
-                            TransactionType::INITIAL,
-                            "新玩家初始金额"
-                        );
+    // 所有条目在同一个事务中按顺序执行，任一条目失败则整个事务回滚；
+    // 已在事务中调用时（嵌套使用）由 executeTransaction 在保存点内执行，只回滚本次调用
+    bool committed = false;
+    try {
+        committed = storage().runTransaction([&]() -> bool {
+            for (size_t i = 0; i < legs.size(); ++i) {
+                try {
+                    balances[i] = applyOpInTransaction(legs[i], transferTotals[i], toBalances[i], failure);
+                } catch (const MoneyException& e) {
+                    failure = e;
+                } catch (const std::exception& e) {
+                    failure = DatabaseException(e.what());
+                }
+                if (!balances[i]) {
+                    failedLeg = static_cast<int>(i);
+                    if (!failure) {
+                        failure = DatabaseException("创建交易记录失败");
                     }
+                    return false;
                 }
-
-                return true;
-
-            } catch (const std::exception&) {
-                // 任何步骤失败都会自动回滚，确保不会有部分创建的玩家
-                return false;
             }
+            return true;
         });
+    } catch (const MoneyException& e) {
+        return fail(failedLeg, e);
+    }
 
-    } catch (const std::exception& e) {
-        throw DatabaseException("初始化新玩家失败: " + std::string(e.what()));
+    if (failure) {
+        return fail(failedLeg, *failure);
+    }
+    if (!committed) {
+        return fail(-1, DatabaseException("事务提交失败"));
     }
-}
 
-bool EconomyManager::playerExists(const std::string& xuid) const { return mPlayerDAO.playerExists(xuid); }
+    // 同一账户出现在多个条目中时按条目顺序发布，最终为最后一个条目的余额
+    result.balances.reserve(legs.size());
+    for (size_t i = 0; i < legs.size(); ++i) {
+        publishBalance(epoch, legs[i].xuid, legs[i].currencyId, balances[i]);
+        if (legs[i].type == TransactionType::TRANSFER) {
+            publishBalance(epoch, legs[i].toXuid, legs[i].currencyId, toBalances[i]);
+        }
+        result.balances.push_back(balances[i].value());
+    }
+    result.success = true;
+    return result;
+}
 
-std::vector<TopBalanceEntry> EconomyManager::getTopBalanceList(const std::string& currencyId, int limit) const {
-    if (!isValidCurrency(currencyId)) {
-        throw InvalidArgumentException("无效的币种ID: " + currencyId);
+std::optional<int> EconomyManager::applyOpInTransaction(
+    const MoneyOp&                 op,
+    int                            transferTotal,
+    std::optional<int>&            toBalance,
+    std::optional<MoneyException>& failure
+) {
+    switch (op.type) {
+    case TransactionType::SET:
+        return setBalanceInTransaction(op.xuid, op.currencyId, op.amount, op.description, failure);
+    case TransactionType::ADD:
+    case TransactionType::REDUCE:
+        return changeBalanceInTransaction(op.xuid, op.currencyId, op.amount, op.type, op.description, failure);
+    default: {
+        auto balances =
+            transferInTransaction(op.xuid, op.toXuid, op.currencyId, op.amount, transferTotal, op.description, failure);
+        if (!balances) {
+            return std::nullopt;
+        }
+        toBalance = balances->second;
+        return balances->first;
+    }
     }
-    return mPlayerDAO.getTopBalanceList(currencyId, limit);
 }
 
-std::vector<TransactionRecord>
+int EconomyManager::validateMoneyOp(const MoneyOp& op) const {
+    if (!isValidAmount(op.amount)) {
+        throw InvalidArgumentException("无效的金额");
+    }
+
+    if (!isValidCurrency(op.currencyId)) {
+        throw InvalidArgumentException("无效的币种ID: " + op.currencyId);
+    }
+
+    const auto& currency = findCurrencyConfig(op.currencyId);
+    switch (op.type) {
+    case TransactionType::SET:
+        if (op.amount > currency.maxBalance) {
+            throw InvalidArgumentException("金额超过最大余额限制");
+        }
+        return 0;
+    case TransactionType::ADD:
+    case TransactionType::REDUCE:
+        return 0;
+    case TransactionType::TRANSFER:
+        if (op.toXuid.empty()) {
+            throw InvalidArgumentException("转入玩家不能为空");
+        }
+        if (op.xuid == op.toXuid) {
+            throw InvalidArgumentException("不能转账给自己");
+        }
+        return computeTransferTotal(currency, op.amount);
+    default:
+        throw InvalidArgumentException("不支持的批量操作类型: " + transactionTypeToString(op.type));
+    }
+}
+
+int64_t EconomyManager::addToAll(
+    const std::string& currencyId,
+    int                amount,
+    OperatorType       operatorType,
+    const std::string& operatorName
+) {
+    if (!isValidAmount(amount)) {
+        throw InvalidArgumentException("无效的金额");
+    }
+
+    if (!isValidCurrency(currencyId)) {
+        throw InvalidArgumentException("无效的币种ID: " + currencyId);
+    }
+
+    int         maxBalance = findCurrencyConfig(currencyId).maxBalance;
+    std::string description =
+        describe(TransactionType::ADD, static_cast<uint64_t>(amount), MoneyFlow::CREDIT, operatorType, operatorName);
+
+    return runBulkOperation(currencyId, [&]() {
+        return storage().addToAllBalances(currencyId, amount, maxBalance, description);
+    });
+}
+
+int64_t EconomyManager::scaleAll(
+    const std::string& currencyId,
+    double             rate,
+    RoundingMode       rounding,
+    OperatorType       operatorType,
+    const std::string& operatorName
+) {
+    if (!(rate >= 0.0 && rate <= 1000.0)) {
+        throw InvalidArgumentException("无效的比例，范围为 0 ~ 1000");
+    }
+
+    if (!isValidCurrency(currencyId)) {
+        throw InvalidArgumentException("无效的币种ID: " + currencyId);
+    }
+
+    int     maxBalance = findCurrencyConfig(currencyId).maxBalance;
+    int64_t rateMicros = std::llround(rate * 1000000.0);
+    bool    roundUp    = rounding == RoundingMode::Ceil;
+
+    // 比例没有单一的金额可供 describe 使用，单独生成描述
+    std::string operatorLabel = operatorTypeToString(operatorType);
+    if (!operatorName.empty()) {
+        operatorLabel += "[" + operatorName + "]";
+    }
+    std::ostringstream rateText;
+    rateText << std::setprecision(6) << rate;
+    std::string description = operatorLabel + "按 " + rateText.str() + " 倍调整余额";
+
+    return runBulkOperation(currencyId, [&]() {
+        return storage().scaleAllBalances(currencyId, rateMicros, roundUp, maxBalance, description);
+    });
+}
+
+int64_t EconomyManager::resetAll(
+    const std::string& currencyId,
+    OperatorType       operatorType,
+    const std::string& operatorName
+) {
+    if (!isValidCurrency(currencyId)) {
+        throw InvalidArgumentException("无效的币种ID: " + currencyId);
+    }
+
+    int         initialBalance = findCurrencyConfig(currencyId).initialBalance;
+    std::string description     = describe(
+        TransactionType::SET,
+        static_cast<uint64_t>(initialBalance),
+        MoneyFlow::NEUTRAL,
+        operatorType,
+        operatorName
+    );
+
+    return runBulkOperation(currencyId, [&]() {
+        return storage().assignAllBalances(currencyId, initialBalance, description);
+    });
+}
+
+int64_t EconomyManager::clampAll(
+    const std::string& currencyId,
+    OperatorType       operatorType,
+    const std::string& operatorName
+) {
+    if (!isValidCurrency(currencyId)) {
+        throw InvalidArgumentException("无效的币种ID: " + currencyId);
+    }
+
+    int         maxBalance  = findCurrencyConfig(currencyId).maxBalance;
+    std::string description = describe(
+        TransactionType::SET,
+        static_cast<uint64_t>(maxBalance),
+        MoneyFlow::NEUTRAL,
+        operatorType,
+        operatorName
+    );
+
+    return runBulkOperation(currencyId, [&]() {
+        return storage().clampAllBalances(currencyId, maxBalance, description);
+    });
+}
+
+int64_t EconomyManager::runBulkOperation(const std::string& currencyId, const std::function<int64_t()>& operation) {
+    // 集合操作作用于所有账户，锁定全部条带
+    auto    accountLock = mAccountLocks.lockAll();
+    int64_t changed     = 0;
+
+    // 先使该币种的缓存失效；未命中的读取不取账户锁，集合操作提交前仍可能读到旧值并回填，
+    // 因此提交（或失败）后在持有全部条带时再次移出，回填版本随之失效
+    mBalanceCache.invalidateCurrency(currencyId);
+    try {
+        // 集合语句直接作用于数据库：先把该币种的写后余额刷新到数据库，再移出内存
+        if (isWriteBehindCurrency(currencyId)) {
+            std::lock_guard flushLock(mWriteBehindFlushMutex);
+            flushWriteBehindLocked();
+            mWriteBehind.dropCurrency(currencyId);
+        }
+
+        bool committed = storage().runTransaction([&]() -> bool {
+            changed = operation();
+            return true;
+        });
+        if (!committed) {
+            throw DatabaseException("事务未提交");
+        }
+    } catch (const std::exception& e) {
+        dropBulkReadBalances(currencyId);
+        mLeaderboard.invalidateCurrency(currencyId);
+        throw DatabaseException("批量更新余额失败: " + std::string(e.what()));
+    }
+
+    // 集合操作写入之后再使缓存与排行榜失效，避免期间的查询用旧数据回填或重新构建
+    dropBulkReadBalances(currencyId);
+    mLeaderboard.invalidateCurrency(currencyId);
+    return changed;
+}
+
+void EconomyManager::dropBulkReadBalances(const std::string& currencyId) {
+    mBalanceCache.invalidateCurrency(currencyId);
+    if (isWriteBehindCurrency(currencyId)) {
+        mWriteBehind.dropCurrency(currencyId);
+    }
+}
+
+bool EconomyManager::initializeNewPlayer(const std::string& xuid, const std::string& username) {
+    // 锁定该玩家，避免并发初始化同一玩家时存在性检查与插入之间出现竞争
+    auto playerLock = mAccountLocks.lock(xuid, {});
+
+    try {
+        // 步骤1：玩家存在性检查（必须在事务外执行）
+        if (storage().playerExists(xuid)) {
+            throw MoneyException(ErrorCode::PLAYER_ALREADY_EXISTS, "玩家已存在");
+        }
+
+        // 步骤2：整个初始化过程在事务中执行
+        auto epoch   = currentWriteEpoch();
+        bool created = storage().runTransaction([&]() -> bool {
+            try {
+                int64_t currentTime = getCurrentTimestamp(); // 时间戳保持 int64_t
+
+                // 2.1 创建玩家基础记录（players表）
+                PlayerData playerData(xuid, username, currentTime);
+                playerData.createdAt = currentTime;
+                playerData.updatedAt = currentTime;
+
+                if (!storage().createPlayer(playerData)) {
+                    return false;
+                }
+
+                // 2.2 为所有启用的币种初始化余额和交易记录
+                const auto& config = MoneyConfig::getInstance().get();
+                for (const auto& [currencyId, currency] : config.currencies) {
+                    if (currency.enabled) {
+                        // 在同一事务中初始化余额（player_balances表）
+                        if (!storage().initializeBalance(xuid, currencyId, currency.initialBalance)) {
+                            return false;
+                        }
+
+                        // 创建交易记录（transactions表）
+                        createTransactionRecord(
+                            xuid,
+                            currencyId,
+                            currency.initialBalance,
+                            currency.initialBalance,
+                            TransactionType::INITIAL,
+                            "新玩家初始金额"
+                        );
+                    }
+                }
+
+                return true;
+
+            } catch (const std::exception&) {
+                // 任何步骤失败都会自动回滚，确保不会有部分创建的玩家
+                return false;
+            }
+        });
+
+        // 步骤3：把新玩家加入各币种排行榜
+        if (created) {
+            mLeaderboard.setUsername(xuid, username);
+            for (const auto& [currencyId, currency] : MoneyConfig::getInstance().get().currencies) {
+                if (currency.enabled) {
+                    publishBalance(epoch, xuid, currencyId, currency.initialBalance);
+                }
+            }
+        }
+        return created;
+
+    } catch (const std::exception& e) {
+        throw DatabaseException("初始化新玩家失败: " + std::string(e.what()));
+    }
+}
+
+bool EconomyManager::playerExists(const std::string& xuid) const { return storage().playerExists(xuid); }
+
+std::optional<PlayerData> EconomyManager::getPlayer(const std::string& xuid) const {
+    return storage().getPlayerByXuid(xuid);
+}
+
+std::vector<TopBalanceEntry> EconomyManager::getTopBalanceList(const std::string& currencyId, int limit) const {
+    return getTopBalanceRange(currencyId, 0, limit);
+}
+
+std::vector<TopBalanceEntry>
+EconomyManager::getTopBalanceRange(const std::string& currencyId, int offset, int limit) const {
+    if (!isValidCurrency(currencyId)) {
+        throw InvalidArgumentException("无效的币种ID: " + currencyId);
+    }
+    if (limit <= 0 || limit > 1000) {
+        throw InvalidArgumentException("limit 必须在 1-1000 之间");
+    }
+    if (offset < 0) {
+        throw InvalidArgumentException("offset 不能为负数");
+    }
+    ensureLeaderboard(currencyId);
+    return mLeaderboard.range(currencyId, static_cast<size_t>(offset), static_cast<size_t>(limit));
+}
+
+std::optional<int> EconomyManager::getPlayerRank(const std::string& xuid, const std::string& currencyId) const {
+    if (!isValidCurrency(currencyId)) {
+        throw InvalidArgumentException("无效的币种ID: " + currencyId);
+    }
+    ensureLeaderboard(currencyId);
+    return mLeaderboard.rankOf(currencyId, xuid);
+}
+
+std::vector<TopBalanceEntry>
+EconomyManager::getRankNeighbors(const std::string& xuid, const std::string& currencyId, int radius) const {
+    if (radius < 0 || radius > 500) {
+        throw InvalidArgumentException("radius 必须在 0-500 之间");
+    }
+    auto rank = getPlayerRank(xuid, currencyId);
+    if (!rank) {
+        return {};
+    }
+    int first = std::max(rank.value() - radius, 1);
+    return mLeaderboard.range(
+        currencyId,
+        static_cast<size_t>(first - 1),
+        static_cast<size_t>(rank.value() - first + radius + 1)
+    );
+}
+
+bool EconomyManager::updateUsername(const std::string& xuid, const std::string& username) {
+    if (!storage().updateUsername(xuid, username)) {
+        return false;
+    }
+    mLeaderboard.setUsername(xuid, username);
+    return true;
+}
+
+std::vector<TransactionRecord>
 EconomyManager::getPlayerTransactions(const std::string& xuid, const std::string& currencyId, int page, int pageSize)
     const {
-    return mTransactionDAO.getPlayerTransactions(xuid, currencyId, page, pageSize);
+    return storage().getPlayerTransactions(xuid, currencyId, page, pageSize);
+}
+
+TransactionPage EconomyManager::getPlayerTransactionsPage(
+    const std::string&       xuid,
+    const TransactionFilter& filter,
+    const std::string&       cursor,
+    int                      pageSize
+) const {
+    if (pageSize <= 0 || pageSize > 1000) {
+        throw InvalidArgumentException("pageSize 必须在 1-1000 之间");
+    }
+    if (!filter.currencyId.empty() && !isValidCurrency(filter.currencyId)) {
+        throw InvalidArgumentException("无效的币种ID: " + filter.currencyId);
+    }
+    if (filter.startTime && filter.endTime && *filter.startTime > *filter.endTime) {
+        throw InvalidArgumentException("开始时间不能晚于结束时间");
+    }
+    return storage().getPlayerTransactionsPage(xuid, filter, cursor, pageSize);
 }
 
 int EconomyManager::getPlayerTransactionCount(const std::string& xuid) const {
-    return mTransactionDAO.getPlayerTransactionCount(xuid);
+    return storage().getPlayerTransactionCount(xuid);
+}
+
+int64_t EconomyManager::archiveTransactions(int daysToKeep, std::stop_token stopToken) {
+    return storage().archiveOldTransactions(daysToKeep, std::move(stopToken));
 }
 
 bool EconomyManager::isValidAmount(int amount) const { return amount >= 0; }
@@ -532,16 +1074,16 @@ bool EconomyManager::hasSufficientBalance(const std::string& xuid, const std::st
     return balance.has_value() && balance.value() >= amount;
 }
 
-int EconomyManager::getTotalWealth(const std::string& currencyId) const {
+int64_t EconomyManager::getTotalWealth(const std::string& currencyId) const {
     if (!isValidCurrency(currencyId)) {
         throw InvalidArgumentException("无效的币种ID: " + currencyId);
     }
-    return mPlayerDAO.getTotalWealth(currencyId);
+    return storage().getTotalWealth(currencyId);
 }
 
-int EconomyManager::getPlayerCount() const { return mPlayerDAO.getPlayerCount(); }
+int EconomyManager::getPlayerCount() const { return storage().getPlayerCount(); }
 
-bool EconomyManager::createTransactionRecord(
+TransactionRecord EconomyManager::buildTransactionRecord(
     const std::string&                xuid,
     const std::string&                currencyId,
     int                               amount,
@@ -550,59 +1092,72 @@ bool EconomyManager::createTransactionRecord(
     const std::string&                description,
     const std::optional<std::string>& relatedXuid,
     const std::optional<std::string>& transferId
-) {
-    try {
-        // 如果没有提供描述，根据交易类型自动生成
-        std::string finalDescription = description;
-        if (finalDescription.empty()) {
-            // 获取关联玩家名称（如果有的话）
-            std::string relatedPlayerName;
-            if (relatedXuid.has_value()) {
-                auto relatedPlayer = mPlayerDAO.getPlayerByXuid(relatedXuid.value());
-                if (relatedPlayer) {
-                    relatedPlayerName = relatedPlayer->username;
-                }
-            }
-
-            auto amountAbs = std::abs(amount);
-
-            MoneyFlow flow = MoneyFlow::NEUTRAL;
-            switch (type) {
-            case TransactionType::SET:
-            case TransactionType::INITIAL:
-                flow = MoneyFlow::NEUTRAL;
-                break;
-            case TransactionType::ADD:
-                flow = (amount >= 0) ? MoneyFlow::CREDIT : MoneyFlow::DEBIT;
-                break;
-            case TransactionType::REDUCE:
-                flow = MoneyFlow::DEBIT;
-                break;
-            case TransactionType::TRANSFER:
-                flow = (amount >= 0) ? MoneyFlow::CREDIT : MoneyFlow::DEBIT;
-                break;
-            default:
-                flow = MoneyFlow::NEUTRAL;
-                break;
+) const {
+    // 如果没有提供描述，根据交易类型自动生成
+    std::string finalDescription = description;
+    if (finalDescription.empty()) {
+        // 获取关联玩家名称（如果有的话）
+        std::string relatedPlayerName;
+        if (relatedXuid.has_value()) {
+            auto relatedPlayer = storage().getPlayerByXuid(relatedXuid.value());
+            if (relatedPlayer) {
+                relatedPlayerName = relatedPlayer->username;
             }
+        }
 
-            finalDescription = describe(type, amountAbs, flow, relatedPlayerName);
+        auto amountAbs = std::abs(amount);
+
+        MoneyFlow flow = MoneyFlow::NEUTRAL;
+        switch (type) {
+        case TransactionType::SET:
+        case TransactionType::INITIAL:
+            flow = MoneyFlow::NEUTRAL;
+            break;
+        case TransactionType::ADD:
+            flow = (amount >= 0) ? MoneyFlow::CREDIT : MoneyFlow::DEBIT;
+            break;
+        case TransactionType::REDUCE:
+            flow = MoneyFlow::DEBIT;
+            break;
+        case TransactionType::TRANSFER:
+            flow = (amount >= 0) ? MoneyFlow::CREDIT : MoneyFlow::DEBIT;
+            break;
+        default:
+            flow = MoneyFlow::NEUTRAL;
+            break;
         }
 
-        TransactionRecord record(
-            0,
-            xuid,
-            currencyId,
-            amount,
-            balance,
-            type,
-            finalDescription,
-            getCurrentTimestamp(),
-            relatedXuid,
-            transferId
-        );
-        return mTransactionDAO.createTransaction(record);
+        finalDescription = describe(type, amountAbs, flow, relatedPlayerName);
+    }
+
+    return TransactionRecord(
+        0,
+        xuid,
+        currencyId,
+        amount,
+        balance,
+        type,
+        finalDescription,
+        getCurrentTimestamp(),
+        relatedXuid,
+        transferId
+    );
+}
 
+bool EconomyManager::createTransactionRecord(
+    const std::string&                xuid,
+    const std::string&                currencyId,
+    int                               amount,
+    int                               balance,
+    TransactionType                   type,
+    const std::string&                description,
+    const std::optional<std::string>& relatedXuid,
+    const std::optional<std::string>& transferId
+) {
+    try {
+        return storage().createTransaction(
+            buildTransactionRecord(xuid, currencyId, amount, balance, type, description, relatedXuid, transferId)
+        );
     } catch (const std::exception& e) {
         throw DatabaseException("创建交易记录失败: " + std::string(e.what()));
     }
@@ -623,25 +1178,7 @@ bool EconomyManager::setBalance(
         throw InvalidArgumentException("无效的币种ID: " + currencyId);
     }
 
-    // 单线程模式，无需加锁
-
     try {
-        // 检查玩家是否存在
-        if (!mPlayerDAO.playerExists(xuid)) {
-            throw MoneyException(ErrorCode::PLAYER_NOT_FOUND, "玩家不存在");
-        }
-
-        // 获取币种配置，检查最大余额限制
-        const auto& config     = MoneyConfig::getInstance().get();
-        auto  currencyIt = config.currencies.find(currencyId);
-        if (currencyIt == config.currencies.end()) {
-            throw InvalidArgumentException("币种配置不存在: " + currencyId);
-        }
-
-        if (amount > currencyIt->second.maxBalance) {
-            throw InvalidArgumentException("金额超过最大余额限制");
-        }
-
         // 生成带操作者信息的描述
         std::string description = describe(
             TransactionType::SET,
@@ -651,25 +1188,7 @@ bool EconomyManager::setBalance(
             operatorName
         );
 
-        // 使用事务确保余额更新和交易记录创建的原子性
-        return DatabaseManager::getInstance().executeTransaction([&](SQLite::Database& db) -> bool {
-            try {
-                (void)db; // 避免未使用参数警告
-
-                // 更新余额
-                if (!mPlayerDAO.updateBalance(xuid, currencyId, amount)) {
-                    return false;
-                }
-
-                // 创建交易记录
-                return createTransactionRecord(xuid, currencyId, amount, amount, TransactionType::SET, description);
-
-            } catch (const std::exception&) {
-                // 事务会自动回滚
-                return false;
-            }
-        });
-
+        return applySetBalance(xuid, currencyId, amount, description);
     } catch (const std::exception& e) {
         throw DatabaseException("设置玩家余额失败: " + std::string(e.what()));
     }
@@ -690,38 +1209,7 @@ bool EconomyManager::addMoney(
         throw InvalidArgumentException("无效的币种ID: " + currencyId);
     }
 
-    // 单线程模式，无需加锁
-
     try {
-        // 获取币种配置
-        const auto& config     = MoneyConfig::getInstance().get();
-        auto  currencyIt = config.currencies.find(currencyId);
-        if (currencyIt == config.currencies.end()) {
-            throw InvalidArgumentException("币种配置不存在: " + currencyId);
-        }
-
-        // 检查玩家是否存在
-        if (!mPlayerDAO.playerExists(xuid)) {
-            throw MoneyException(ErrorCode::PLAYER_NOT_FOUND, "玩家不存在，请先初始化玩家");
-        }
-
-        // 获取当前余额
-        auto currentBalance = mPlayerDAO.getBalance(xuid, currencyId);
-        int  oldBalance     = currentBalance.has_value() ? currentBalance.value() : 0;
-
-        // 初始化余额（如果不存在）- 这种情况发生在玩家已存在但某个币种余额未初始化（例如添加了新币种）
-        if (!currentBalance.has_value()) {
-            oldBalance = currencyIt->second.initialBalance;
-            mPlayerDAO.initializeBalance(xuid, currencyId, oldBalance);
-        }
-
-        int newBalance = oldBalance + amount;
-
-        // 检查最大余额限制
-        if (newBalance > currencyIt->second.maxBalance) {
-            throw InvalidArgumentException("金额超过最大余额限制");
-        }
-
         // 生成带操作者信息的描述
         std::string description = describe(
             TransactionType::ADD,
@@ -731,25 +1219,7 @@ bool EconomyManager::addMoney(
             operatorName
         );
 
-        // 使用事务确保余额更新和交易记录创建的原子性
-        return DatabaseManager::getInstance().executeTransaction([&](SQLite::Database& db) -> bool {
-            try {
-                (void)db; // 避免未使用参数警告
-
-                // 更新余额
-                if (!mPlayerDAO.updateBalance(xuid, currencyId, newBalance)) {
-                    return false;
-                }
-
-                // 创建交易记录
-                return createTransactionRecord(xuid, currencyId, amount, newBalance, TransactionType::ADD, description);
-
-            } catch (const std::exception&) {
-                // 事务会自动回滚
-                return false;
-            }
-        });
-
+        return applyBalanceChange(xuid, currencyId, amount, TransactionType::ADD, description);
     } catch (const std::exception& e) {
         throw DatabaseException("增加玩家金钱失败: " + std::string(e.what()));
     }
@@ -770,24 +1240,7 @@ bool EconomyManager::reduceMoney(
         throw InvalidArgumentException("无效的币种ID: " + currencyId);
     }
 
-    // 单线程模式，无需加锁
-
     try {
-        // 获取当前余额
-        auto currentBalance = mPlayerDAO.getBalance(xuid, currencyId);
-        if (!currentBalance.has_value()) {
-            throw MoneyException(ErrorCode::PLAYER_NOT_FOUND, "玩家不存在或余额未初始化");
-        }
-
-        int oldBalance = currentBalance.value();
-
-        // 检查余额是否充足
-        if (oldBalance < amount) {
-            throw MoneyException(ErrorCode::INSUFFICIENT_BALANCE, "余额不足");
-        }
-
-        int newBalance = oldBalance - amount;
-
         // 生成带操作者信息的描述
         std::string description = describe(
             TransactionType::REDUCE,
@@ -797,35 +1250,586 @@ bool EconomyManager::reduceMoney(
             operatorName
         );
 
-        // 使用事务确保余额更新和交易记录创建的原子性
-        return DatabaseManager::getInstance().executeTransaction([&](SQLite::Database& db) -> bool {
-            try {
-                (void)db; // 避免未使用参数警告
+        return applyBalanceChange(xuid, currencyId, amount, TransactionType::REDUCE, description);
+    } catch (const std::exception& e) {
+        throw DatabaseException("扣除玩家金钱失败: " + std::string(e.what()));
+    }
+}
 
-                // 更新余额
-                if (!mPlayerDAO.updateBalance(xuid, currencyId, newBalance)) {
-                    return false;
-                }
+bool EconomyManager::applySetBalance(
+    const std::string& xuid,
+    const std::string& currencyId,
+    int                amount,
+    const std::string& description
+) {
+    // 检查最大余额限制
+    if (amount > findCurrencyConfig(currencyId).maxBalance) {
+        throw InvalidArgumentException("金额超过最大余额限制");
+    }
 
-                // 创建交易记录
-                return createTransactionRecord(
-                    xuid,
-                    currencyId,
-                    -amount,
-                    newBalance,
-                    TransactionType::REDUCE,
-                    description
-                );
+    auto accountLock = mAccountLocks.lock(xuid, currencyId);
 
-            } catch (const std::exception&) {
-                // 事务会自动回滚
-                return false;
+    if (isWriteBehindCurrency(currencyId)) {
+        std::optional<MoneyException> failure;
+        auto                          newBalance = writeBehindSet(xuid, currencyId, amount, description, failure);
+        if (failure) {
+            throw *failure;
+        }
+        return newBalance.has_value();
+    }
+
+    // 使用事务确保余额更新和交易记录创建的原子性
+    auto                          epoch = currentWriteEpoch();
+    std::optional<int>            newBalance;
+    std::optional<MoneyException> failure;
+    bool committed = storage().runTransaction([&]() -> bool {
+        try {
+            newBalance = setBalanceInTransaction(xuid, currencyId, amount, description, failure);
+            return newBalance.has_value();
+        } catch (const std::exception&) {
+            // 事务会自动回滚
+            return false;
+        }
+    });
+
+    if (failure) {
+        throw *failure;
+    }
+    if (committed) {
+        publishBalance(epoch, xuid, currencyId, newBalance);
+    }
+    return committed;
+}
+
+bool EconomyManager::applyBalanceChange(
+    const std::string& xuid,
+    const std::string& currencyId,
+    int                amount,
+    TransactionType    type,
+    const std::string& description
+) {
+    auto accountLock = mAccountLocks.lock(xuid, currencyId);
+
+    if (isWriteBehindCurrency(currencyId)) {
+        std::optional<MoneyException> failure;
+        auto newBalance = writeBehindChange(xuid, currencyId, amount, type, description, failure);
+        if (failure) {
+            throw *failure;
+        }
+        return newBalance.has_value();
+    }
+
+    // 使用事务确保余额更新和交易记录创建的原子性
+    auto                          epoch = currentWriteEpoch();
+    std::optional<int>            newBalance;
+    std::optional<MoneyException> failure;
+    bool committed = storage().runTransaction([&]() -> bool {
+        try {
+            newBalance = changeBalanceInTransaction(xuid, currencyId, amount, type, description, failure);
+            return newBalance.has_value();
+        } catch (const std::exception&) {
+            // 事务会自动回滚
+            return false;
+        }
+    });
+
+    if (failure) {
+        throw *failure;
+    }
+    if (committed) {
+        publishBalance(epoch, xuid, currencyId, newBalance);
+    }
+    return committed;
+}
+
+std::optional<int> EconomyManager::setBalanceInTransaction(
+    const std::string&             xuid,
+    const std::string&             currencyId,
+    int                            amount,
+    const std::string&             description,
+    std::optional<MoneyException>& failure
+) {
+    // 玩家不存在时不会写入任何行
+    auto newBalance = storage().assignBalance(xuid, currencyId, amount);
+    if (!newBalance) {
+        failure.emplace(ErrorCode::PLAYER_NOT_FOUND, "玩家不存在");
+        return std::nullopt;
+    }
+
+    // 创建交易记录
+    if (!createTransactionRecord(xuid, currencyId, amount, newBalance.value(), TransactionType::SET, description)) {
+        return std::nullopt;
+    }
+    return newBalance;
+}
+
+std::optional<int> EconomyManager::changeBalanceInTransaction(
+    const std::string&             xuid,
+    const std::string&             currencyId,
+    int                            amount,
+    TransactionType                type,
+    const std::string&             description,
+    std::optional<MoneyException>& failure
+) {
+    const auto& currency = findCurrencyConfig(currencyId);
+    const bool  isAdd    = type == TransactionType::ADD;
+
+    // 增加：余额记录不存在时（例如新增了币种）以初始余额为基础，结果不能超过最大余额
+    // 扣除：余额记录必须存在，结果不能为负
+    auto newBalance = isAdd ? storage().applyBalanceDelta(
+                                  xuid,
+                                  currencyId,
+                                  amount,
+                                  std::numeric_limits<int>::min(),
+                                  currency.maxBalance,
+                                  currency.initialBalance
+                              )
+                            : storage().applyBalanceDelta(
+                                  xuid,
+                                  currencyId,
+                                  -static_cast<int64_t>(amount),
+                                  0,
+                                  std::numeric_limits<int>::max()
+                              );
+
+    if (!newBalance) {
+        if (isAdd) {
+            if (!storage().playerExists(xuid)) {
+                failure.emplace(ErrorCode::PLAYER_NOT_FOUND, "玩家不存在，请先初始化玩家");
+            } else {
+                failure = InvalidArgumentException("金额超过最大余额限制");
             }
+        } else {
+            if (!storage().getBalance(xuid, currencyId)) {
+                failure.emplace(ErrorCode::PLAYER_NOT_FOUND, "玩家不存在或余额未初始化");
+            } else {
+                failure.emplace(ErrorCode::INSUFFICIENT_BALANCE, "余额不足");
+            }
+        }
+        return std::nullopt;
+    }
+
+    // 创建交易记录
+    if (!createTransactionRecord(xuid, currencyId, isAdd ? amount : -amount, newBalance.value(), type, description)) {
+        return std::nullopt;
+    }
+    return newBalance;
+}
+
+std::optional<std::pair<int, int>> EconomyManager::transferInTransaction(
+    const std::string&             fromXuid,
+    const std::string&             toXuid,
+    const std::string&             currencyId,
+    int                            amount,
+    int                            totalAmount,
+    const std::string&             description,
+    std::optional<MoneyException>& failure
+) {
+    const auto& currency = findCurrencyConfig(currencyId);
+
+    // 两条 UPSERT 完成扣款和入账，余额检查由语句自身完成；失败时在冷路径上诊断原因
+    auto fromNewBalance = storage().applyBalanceDelta(
+        fromXuid,
+        currencyId,
+        -static_cast<int64_t>(totalAmount),
+        0,
+        std::numeric_limits<int>::max()
+    );
+    if (!fromNewBalance) {
+        auto fromBalance = storage().getBalance(fromXuid, currencyId);
+        if (!fromBalance) {
+            failure.emplace(ErrorCode::PLAYER_NOT_FOUND, "转出玩家不存在或余额未初始化");
+        } else if (!storage().playerExists(toXuid)) {
+            failure.emplace(ErrorCode::PLAYER_NOT_FOUND, "转入玩家不存在");
+        } else if (fromBalance.value() < amount) {
+            failure.emplace(ErrorCode::INSUFFICIENT_BALANCE, "余额不足");
+        } else {
+            failure.emplace(ErrorCode::INSUFFICIENT_BALANCE, "余额不足（含手续费）");
+        }
+        return std::nullopt;
+    }
+
+    // 转入玩家某个币种余额未初始化时（例如新增了币种），以初始余额为基础入账
+    auto toNewBalance = storage().applyBalanceDelta(
+        toXuid,
+        currencyId,
+        amount,
+        std::numeric_limits<int>::min(),
+        currency.maxBalance,
+        currency.initialBalance
+    );
+    if (!toNewBalance) {
+        if (!storage().playerExists(toXuid)) {
+            failure.emplace(ErrorCode::PLAYER_NOT_FOUND, "转入玩家不存在");
+        } else {
+            failure = InvalidArgumentException("转入金额超过最大余额限制");
+        }
+        return std::nullopt;
+    }
+
+    std::string transferId = generateTransferId();
+
+    // 创建转出交易记录
+    if (!createTransactionRecord(
+            fromXuid,
+            currencyId,
+            -totalAmount,
+            fromNewBalance.value(),
+            TransactionType::TRANSFER,
+            description,
+            toXuid,
+            transferId
+        )) {
+        return std::nullopt;
+    }
+
+    // 创建转入交易记录
+    if (!createTransactionRecord(
+            toXuid,
+            currencyId,
+            amount,
+            toNewBalance.value(),
+            TransactionType::TRANSFER,
+            description,
+            fromXuid,
+            transferId
+        )) {
+        return std::nullopt;
+    }
+
+    return std::make_pair(fromNewBalance.value(), toNewBalance.value());
+}
+
+std::optional<int> EconomyManager::loadWriteBehindBalance(const std::string& xuid, const std::string& currencyId) const {
+    // 不在内存中的账户没有未刷新的变更，数据库中的值就是最新值；
+    // 读取期间有余额移出内存时，读到的值可能早于移出前刷新的值，由 load() 按版本放弃载入
+    uint64_t generation = mWriteBehind.generation();
+    if (auto balance = mWriteBehind.get(xuid, currencyId)) {
+        return balance;
+    }
+    auto balance = storage().getBalance(xuid, currencyId);
+    if (balance) {
+        mWriteBehind.load(xuid, currencyId, balance.value(), generation);
+    }
+    return balance;
+}
+
+std::optional<int> EconomyManager::writeBehindSet(
+    const std::string&             xuid,
+    const std::string&             currencyId,
+    int                            amount,
+    const std::string&             description,
+    std::optional<MoneyException>& failure
+) {
+    if (!loadWriteBehindBalance(xuid, currencyId) && !storage().playerExists(xuid)) {
+        failure.emplace(ErrorCode::PLAYER_NOT_FOUND, "玩家不存在");
+        return std::nullopt;
+    }
+
+    uint64_t epoch = mLeaderboard.epoch();
+    mWriteBehind.commit({buildTransactionRecord(xuid, currencyId, amount, amount, TransactionType::SET, description)});
+    mLeaderboard.update(currencyId, xuid, amount, epoch);
+    return amount;
+}
+
+std::optional<int> EconomyManager::writeBehindChange(
+    const std::string&             xuid,
+    const std::string&             currencyId,
+    int                            amount,
+    TransactionType                type,
+    const std::string&             description,
+    std::optional<MoneyException>& failure
+) {
+    const auto& currency = findCurrencyConfig(currencyId);
+    const bool  isAdd    = type == TransactionType::ADD;
+    auto        current  = loadWriteBehindBalance(xuid, currencyId);
+
+    // 与同步模式的校验保持一致：增加时余额记录不存在则以初始余额为基础，扣除时余额记录必须存在
+    int64_t newBalance = 0;
+    if (isAdd) {
+        if (!current) {
+            if (!storage().playerExists(xuid)) {
+                failure.emplace(ErrorCode::PLAYER_NOT_FOUND, "玩家不存在，请先初始化玩家");
+                return std::nullopt;
+            }
+            current = currency.initialBalance;
+        }
+        newBalance = static_cast<int64_t>(current.value()) + amount;
+        if (newBalance > currency.maxBalance) {
+            failure = InvalidArgumentException("金额超过最大余额限制");
+            return std::nullopt;
+        }
+    } else {
+        if (!current) {
+            failure.emplace(ErrorCode::PLAYER_NOT_FOUND, "玩家不存在或余额未初始化");
+            return std::nullopt;
+        }
+        newBalance = static_cast<int64_t>(current.value()) - amount;
+        if (newBalance < 0) {
+            failure.emplace(ErrorCode::INSUFFICIENT_BALANCE, "余额不足");
+            return std::nullopt;
+        }
+    }
+
+    uint64_t epoch = mLeaderboard.epoch();
+    mWriteBehind.commit({buildTransactionRecord(
+        xuid,
+        currencyId,
+        isAdd ? amount : -amount,
+        static_cast<int>(newBalance),
+        type,
+        description
+    )});
+    mLeaderboard.update(currencyId, xuid, static_cast<int>(newBalance), epoch);
+    return static_cast<int>(newBalance);
+}
+
+std::optional<std::pair<int, int>> EconomyManager::writeBehindTransfer(
+    const std::string&             fromXuid,
+    const std::string&             toXuid,
+    const std::string&             currencyId,
+    int                            amount,
+    int                            totalAmount,
+    const std::string&             description,
+    std::optional<MoneyException>& failure
+) {
+    const auto& currency = findCurrencyConfig(currencyId);
+
+    auto fromBalance = loadWriteBehindBalance(fromXuid, currencyId);
+    if (!fromBalance) {
+        failure.emplace(ErrorCode::PLAYER_NOT_FOUND, "转出玩家不存在或余额未初始化");
+        return std::nullopt;
+    }
+    auto toBalance = loadWriteBehindBalance(toXuid, currencyId);
+    if (!toBalance) {
+        if (!storage().playerExists(toXuid)) {
+            failure.emplace(ErrorCode::PLAYER_NOT_FOUND, "转入玩家不存在");
+            return std::nullopt;
+        }
+        toBalance = currency.initialBalance;
+    }
+    if (fromBalance.value() < totalAmount) {
+        failure.emplace(
+            ErrorCode::INSUFFICIENT_BALANCE,
+            fromBalance.value() < amount ? "余额不足" : "余额不足（含手续费）"
+        );
+        return std::nullopt;
+    }
+    if (static_cast<int64_t>(toBalance.value()) + amount > currency.maxBalance) {
+        failure = InvalidArgumentException("转入金额超过最大余额限制");
+        return std::nullopt;
+    }
+
+    int         fromNewBalance = fromBalance.value() - totalAmount;
+    int         toNewBalance   = toBalance.value() + amount;
+    std::string transferId     = generateTransferId();
+
+    // 出入两条记录一次追加到日志
+    uint64_t epoch = mLeaderboard.epoch();
+    mWriteBehind.commit({
+        buildTransactionRecord(
+            fromXuid,
+            currencyId,
+            -totalAmount,
+            fromNewBalance,
+            TransactionType::TRANSFER,
+            description,
+            toXuid,
+            transferId
+        ),
+        buildTransactionRecord(
+            toXuid,
+            currencyId,
+            amount,
+            toNewBalance,
+            TransactionType::TRANSFER,
+            description,
+            fromXuid,
+            transferId
+        )
+    });
+    mLeaderboard.update(currencyId, fromXuid, fromNewBalance, epoch);
+    mLeaderboard.update(currencyId, toXuid, toNewBalance, epoch);
+    return std::make_pair(fromNewBalance, toNewBalance);
+}
+
+int64_t EconomyManager::flushWriteBehindLocked() {
+    if (!mWriteBehind.isOpen()) {
+        return 0;
+    }
+    // 先确认仍在写线程中的上一次刷新，再刷新之后的变更
+    int64_t flushed = finishWriteBehindFlush();
+    submitWriteBehindFlush();
+    return flushed + finishWriteBehindFlush();
+}
+
+void EconomyManager::submitWriteBehindFlush() {
+    mLastWriteBehindFlushMs.store(
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count(),
+        std::memory_order_relaxed
+    );
+
+    auto batch = std::make_shared<WriteBehindStore::FlushBatch>(mWriteBehind.beginFlush());
+    if (batch->empty()) {
+        mWriteBehind.finishFlush(*batch);
+        return;
+    }
+
+    // 写入完成前这些余额仍保存在内存中，读取不依赖该事务，因此不必等待它提交
+    std::shared_future<bool> handle;
+    try {
+        // 余额、交易记录与日志检查点在同一个事务中写入
+        handle = storage().submitTransaction([this, batch]() -> bool {
+            for (const auto& balance : batch->balances) {
+                (void)storage().assignBalance(balance.xuid, balance.currencyId, balance.balance);
+            }
+            for (const auto& entry : batch->entries) {
+                storage().createTransaction(entry.record);
+            }
+            if (!batch->entries.empty()) {
+                storage().setJournalCheckpoint(batch->lastSequence);
+            }
+            return true;
         });
+    } catch (...) {
+        // 由 finishWriteBehindFlush() 统一报告失败并恢复脏标记
+        std::promise<bool> failed;
+        failed.set_exception(std::current_exception());
+        handle = failed.get_future().share();
+    }
+    mPendingFlush = PendingFlush{std::move(batch), std::move(handle)};
+}
 
+int64_t EconomyManager::finishWriteBehindFlush() {
+    if (!mPendingFlush) {
+        return 0;
+    }
+    auto pending = std::move(*mPendingFlush);
+    mPendingFlush.reset();
+
+    try {
+        if (!pending.handle.get()) {
+            throw DatabaseException("事务未提交");
+        }
+        // 组提交模式下确认整组已提交后才能删除日志段
+        storage().flushCommits();
     } catch (const std::exception& e) {
-        throw DatabaseException("扣除玩家金钱失败: " + std::string(e.what()));
+        auto flushed = pending.batch->balances.size();
+        mWriteBehind.abortFlush(std::move(*pending.batch));
+        throw DatabaseException(
+            "刷新写后余额失败（" + std::to_string(flushed) + " 个账户保留在内存中）: " + std::string(e.what())
+        );
+    }
+
+    mWriteBehind.finishFlush(*pending.batch);
+    return static_cast<int64_t>(pending.batch->balances.size());
+}
+
+void EconomyManager::recoverWriteBehindJournal() {
+    auto basePath = storage().getJournalBasePath();
+    if (basePath.empty()) {
+        return; // 后端不支持写后模式，不会产生重做日志
+    }
+    auto segments = RedoJournal::listSegments(basePath);
+    if (segments.empty()) {
+        return;
+    }
+
+    // 序号不大于检查点的记录已随上次刷新写入数据库
+    auto     entries      = RedoJournal::readSegments(segments);
+    uint64_t checkpoint   = storage().getJournalCheckpoint();
+    uint64_t lastSequence = checkpoint;
+    std::erase_if(entries, [&](const JournalEntry& entry) { return entry.sequence <= checkpoint; });
+    for (const auto& entry : entries) {
+        lastSequence = std::max(lastSequence, entry.sequence);
+    }
+
+    if (!entries.empty()) {
+        // 每条记录的 balance 即账户在该交易后的余额，按序号重放即可恢复最终余额
+        bool committed = storage().runTransaction([&]() -> bool {
+            for (const auto& entry : entries) {
+                (void)storage().assignBalance(entry.record.xuid, entry.record.currencyId, entry.record.balance);
+                storage().createTransaction(entry.record);
+            }
+            storage().setJournalCheckpoint(lastSequence);
+            return true;
+        });
+        if (!committed) {
+            throw DatabaseException("重放重做日志失败");
+        }
+        storage().flushCommits();
     }
+    RedoJournal::removeSegments(segments);
+}
+
+void EconomyManager::configureWriteBehind() {
+    const auto& config  = MoneyConfig::getInstance().get();
+    bool        enabled = std::any_of(config.currencies.begin(), config.currencies.end(), [](const auto& item) {
+        return item.second.enabled && item.second.writeBehind;
+    });
+
+    std::lock_guard flushLock(mWriteBehindFlushMutex);
+    if (mWriteBehind.isOpen()) {
+        flushWriteBehindLocked();
+        if (!enabled) {
+            mWriteBehind.close();
+            return;
+        }
+        // 各币种的写后模式可能已变化，已刷新的内存余额全部移出，之后按需重新载入
+        mWriteBehind.dropClean();
+        return;
+    }
+
+    // 后端不支持写后模式时（没有重做日志路径）这些币种按普通模式直接写入存储
+    auto journalBasePath = storage().getJournalBasePath();
+    if (enabled && !journalBasePath.empty()) {
+        mWriteBehind.open(journalBasePath, storage().getJournalCheckpoint() + 1);
+    }
+}
+
+EconomyManager::WriteEpoch EconomyManager::currentWriteEpoch() const {
+    return WriteEpoch{mBalanceCache.epoch(), mLeaderboard.epoch()};
+}
+
+void EconomyManager::publishBalance(
+    const WriteEpoch&  epoch,
+    const std::string& xuid,
+    const std::string& currencyId,
+    std::optional<int> balance
+) {
+    mBalanceCache.store(xuid, currencyId, balance, epoch.cache);
+    mLeaderboard.update(currencyId, xuid, balance, epoch.leaderboard);
+}
+
+void EconomyManager::ensureLeaderboard(const std::string& currencyId) const {
+    mLeaderboard.ensureBuilt(currencyId, [&]() {
+        std::vector<Leaderboard::Row> rows;
+        for (auto& entry : storage().getCurrencyBalanceList(currencyId)) {
+            rows.push_back(Leaderboard::Row{std::move(entry.xuid), std::move(entry.username), entry.balance});
+        }
+
+        // 写后模式币种以内存余额为准，覆盖数据库中尚未刷新的值
+        if (isWriteBehindCurrency(currencyId)) {
+            std::unordered_map<std::string, int> pending;
+            for (auto& [xuid, balance] : mWriteBehind.getCurrencyBalances(currencyId)) {
+                pending.emplace(std::move(xuid), balance);
+            }
+            for (auto& row : rows) {
+                if (auto it = pending.find(row.xuid); it != pending.end()) {
+                    row.balance = it->second;
+                    pending.erase(it);
+                }
+            }
+            // 只存在于内存中的余额（玩家首次获得该币种）
+            for (auto& [xuid, balance] : pending) {
+                if (auto player = storage().getPlayerByXuid(xuid)) {
+                    rows.push_back(Leaderboard::Row{xuid, std::move(player->username), balance});
+                }
+            }
+        }
+        return rows;
+    });
 }
 
 int64_t EconomyManager::getCurrentTimestamp() const {
@@ -839,8 +1843,16 @@ std::string EconomyManager::getDefaultCurrencyId() const {
 
 bool EconomyManager::syncCurrenciesFromConfig() {
     // Currency 现在只存储在配置文件中，不需要同步到数据库
-    // 这个方法保留用于 reload 命令的调用，但不需要执行任何操作
-    return true;
+    // 重载后币种的写后模式可能变化：锁定全部账户，刷新写后余额后按新配置重新打开写后存储
+    try {
+        auto accountLock = mAccountLocks.lockAll();
+        configureWriteBehind();
+        mBalanceCache.invalidateAll();
+        mLeaderboard.invalidateAll();
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
 }
 
 bool EconomyManager::isValidCurrency(const std::string& currencyId) const {
@@ -854,8 +1866,31 @@ bool EconomyManager::isValidCurrency(const std::string& currencyId) const {
 }
 
 void EconomyManager::resetForTesting() {
-    // 重置初始化状态，允许重新初始化
+    {
+        // 仍在写线程中的刷新引用即将释放的存储后端
+        std::lock_guard flushLock(mWriteBehindFlushMutex);
+        if (mPendingFlush) {
+            mPendingFlush->handle.wait();
+            mPendingFlush.reset();
+        }
+    }
+    // 重置初始化状态，允许重新初始化（内存后端的数据随存储后端一起丢弃）
     mInitialized = false;
+    mBalanceCache.clear();
+    mLeaderboard.clear();
+    mWriteBehind.close();
+    mStorage.reset();
+}
+
+bool EconomyManager::isStorageOpen() const { return mStorage && mStorage->isOpen(); }
+
+StorageBackend& EconomyManager::getStorageForTesting() const { return storage(); }
+
+StorageBackend& EconomyManager::storage() const {
+    if (!mStorage) {
+        throw DatabaseException("存储后端未初始化");
+    }
+    return *mStorage;
 }
 
 } // namespace rlx_money
\ No newline at end of file
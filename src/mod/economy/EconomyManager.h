@@ -1,16 +1,41 @@
 #pragma once
 
-#include "mod/dao/PlayerDAO.h"
-#include "mod/dao/TransactionDAO.h"
+#include "mod/economy/AccountLocks.h"
+#include "mod/economy/BalanceCache.h"
+#include "mod/economy/Leaderboard.h"
+#include "mod/economy/WriteBehindStore.h"
+#include "mod/exceptions/MoneyException.h"
+#include "mod/storage/StorageBackend.h"
 #include <RLXMoney/data/DataStructures.h>
 #include <RLXMoney/types/Types.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <span>
+#include <stop_token>
+#include <utility>
 #include <vector>
 
 
 namespace rlx_money {
 
+/// @brief 按比例调整余额时的取整方式
+enum class RoundingMode {
+    Floor, // 向下取整
+    Ceil   // 向上取整
+};
+
 /// @brief 经济管理器类
+/// @note 线程安全：写操作按 (xuid, 币种) 加条带锁，转账和批量操作按全局顺序锁定所有相关账户，
+///       作用于全部账户的集合操作锁定全部条带；读操作不加账户锁，只读取已提交的数据。
+///       在线玩家的余额常驻内存缓存，写操作在提交后写穿透到缓存，读取命中时不访问数据库。
+///       启用写后模式的币种余额以内存为准，交易先写入本地重做日志，按间隔或玩家下线时批量刷新到数据库。
+///       排行榜与排名由内存中的顺序统计树提供，每次余额写入后增量更新。
+///       数据通过 StorageBackend 读写，由配置项 database.backend 选择 SQLite 或纯内存实现
 class EconomyManager {
 public:
     /// @brief 获取单例实例
@@ -27,6 +52,45 @@ class EconomyManager {
     /// @return 玩家余额
     [[nodiscard]] std::optional<int> getBalance(const std::string& xuid, const std::string& currencyId) const;
 
+    /// @brief 把玩家的余额载入缓存（玩家上线时调用）
+    /// @param xuid 玩家XUID
+    /// @return 是否载入成功（缓存禁用或超出内存预算时返回 false）
+    bool cachePlayerBalances(const std::string& xuid);
+
+    /// @brief 把玩家移出缓存（玩家下线时调用）
+    /// @param xuid 玩家XUID
+    void evictPlayerBalances(const std::string& xuid);
+
+    /// @brief 获取余额缓存统计信息
+    /// @return 统计信息
+    [[nodiscard]] BalanceCacheStats getBalanceCacheStats() const;
+
+    /// @brief 币种是否以写后模式运行
+    /// @param currencyId 币种ID
+    /// @return 是否为写后模式
+    [[nodiscard]] bool isWriteBehindCurrency(const std::string& currencyId) const;
+
+    /// @brief 把写后模式币种的脏余额和交易记录写入数据库
+    /// @return 写入的余额条目数量
+    /// @throw DatabaseException 写入失败时（数据保留在内存和重做日志中，下次刷新重试）
+    int64_t flushWriteBehind();
+
+    /// @brief 距上次刷新超过配置的间隔时刷新写后模式币种（每 tick 调用）
+    void flushWriteBehindIfDue();
+
+    /// @brief 提交存储后端中尚未提交的组事务（每 tick 结束时调用）
+    /// @throw DatabaseException 提交失败时
+    void flushCommits();
+
+    /// @brief 卸载前刷新写后模式币种并提交尚未提交的组事务
+    /// @note 必须在停止 tick 任务之后调用；写后刷新失败时仍会提交组事务，然后重新抛出异常
+    /// @throw DatabaseException 写入或提交失败时
+    void flushForShutdown();
+
+    /// @brief 获取写后存储统计信息
+    /// @return 统计信息
+    [[nodiscard]] WriteBehindStats getWriteBehindStats() const;
+
     /// @brief 获取玩家所有币种余额
     /// @param xuid 玩家XUID
     /// @return 玩家余额列表
@@ -123,6 +187,63 @@ class EconomyManager {
         const std::string& description = ""
     );
 
+    /// @brief 批量执行余额操作（增加/扣除/设置/转账）
+    /// @param ops 操作列表
+    /// @return 与 ops 一一对应的执行结果
+    /// @note 所有条目先在内存中校验，未通过的条目不会执行；其余条目在同一个事务中按顺序执行，
+    ///       每个条目使用独立的保存点，单个条目失败（如余额不足）只回滚该条目
+    std::vector<MoneyOpResult> applyBatch(std::span<const MoneyOp> ops);
+
+    /// @brief 以单个原子事务执行多个余额操作（可跨玩家、跨币种）
+    /// @param legs 操作条目，按顺序执行
+    /// @return 执行结果，success 为 false 时没有任何条目生效
+    /// @note 所有条目先整体校验，再在同一个事务中执行，任一条目失败（如余额不足）则全部回滚；
+    ///       在其他事务函数内调用时使用保存点，只回滚本次调用。不支持写后模式币种
+    MoneyTxResult applyAtomic(std::span<const MoneyOp> legs);
+
+    /// @brief 给某币种的所有账户增加固定金额（空投）
+    /// @param currencyId 币种ID
+    /// @param amount 增加金额
+    /// @param operatorType 操作者类型
+    /// @param operatorName 操作者名称
+    /// @return 余额实际变化的账户数量
+    /// @note 以单条集合语句执行；结果超过最大余额的账户被截断到最大余额
+    int64_t addToAll(
+        const std::string& currencyId,
+        int                amount,
+        OperatorType       operatorType,
+        const std::string& operatorName = ""
+    );
+
+    /// @brief 把某币种的所有账户余额乘以比例（如征税、通胀调整）
+    /// @param currencyId 币种ID
+    /// @param rate 比例（0 ~ 1000，精确到百万分之一）
+    /// @param rounding 取整方式
+    /// @param operatorType 操作者类型
+    /// @param operatorName 操作者名称
+    /// @return 余额实际变化的账户数量
+    int64_t scaleAll(
+        const std::string& currencyId,
+        double             rate,
+        RoundingMode       rounding,
+        OperatorType       operatorType,
+        const std::string& operatorName = ""
+    );
+
+    /// @brief 把某币种的所有账户余额重置为初始余额（如赛季重置）
+    /// @param currencyId 币种ID
+    /// @param operatorType 操作者类型
+    /// @param operatorName 操作者名称
+    /// @return 余额实际变化的账户数量
+    int64_t resetAll(const std::string& currencyId, OperatorType operatorType, const std::string& operatorName = "");
+
+    /// @brief 把某币种超过最大余额的账户降到最大余额（如调低上限之后）
+    /// @param currencyId 币种ID
+    /// @param operatorType 操作者类型
+    /// @param operatorName 操作者名称
+    /// @return 余额实际变化的账户数量
+    int64_t clampAll(const std::string& currencyId, OperatorType operatorType, const std::string& operatorName = "");
+
     /// @brief 初始化新玩家
     /// @param xuid 玩家XUID
     /// @param username 玩家用户名
@@ -134,12 +255,45 @@ class EconomyManager {
     /// @return 玩家是否存在
     [[nodiscard]] bool playerExists(const std::string& xuid) const;
 
+    /// @brief 获取玩家数据
+    /// @param xuid 玩家XUID
+    /// @return 玩家数据；玩家不存在时返回空
+    [[nodiscard]] std::optional<PlayerData> getPlayer(const std::string& xuid) const;
+
     /// @brief 获取财富排行榜（按币种）
     /// @param currencyId 币种ID
     /// @param limit 返回数量限制
     /// @return 财富排行榜
     [[nodiscard]] std::vector<TopBalanceEntry> getTopBalanceList(const std::string& currencyId, int limit) const;
 
+    /// @brief 按名次分页获取财富排行榜
+    /// @param currencyId 币种ID
+    /// @param offset 跳过的名次数量（0 表示从第一名开始）
+    /// @param limit 返回数量限制（1-1000）
+    /// @return 排行榜条目
+    [[nodiscard]] std::vector<TopBalanceEntry>
+    getTopBalanceRange(const std::string& currencyId, int offset, int limit) const;
+
+    /// @brief 获取玩家在某币种的财富排名
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @return 排名（从 1 开始）；玩家没有该币种余额时返回空
+    [[nodiscard]] std::optional<int> getPlayerRank(const std::string& xuid, const std::string& currencyId) const;
+
+    /// @brief 获取玩家名次前后的一段排行榜
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @param radius 玩家前后各返回的条目数量（0-500）
+    /// @return 排行榜条目（包含玩家本人）；玩家不在排行榜中时返回空列表
+    [[nodiscard]] std::vector<TopBalanceEntry>
+    getRankNeighbors(const std::string& xuid, const std::string& currencyId, int radius) const;
+
+    /// @brief 更新玩家用户名
+    /// @param xuid 玩家XUID
+    /// @param username 新用户名
+    /// @return 是否更新成功
+    bool updateUsername(const std::string& xuid, const std::string& username);
+
     /// @brief 获取玩家交易历史
     /// @param xuid 玩家XUID
     /// @param currencyId 币种ID（可选，为空则查询所有币种）
@@ -150,11 +304,34 @@ class EconomyManager {
     getPlayerTransactions(const std::string& xuid, const std::string& currencyId = "", int page = 1, int pageSize = 10)
         const;
 
+    /// @brief 按游标分页获取玩家交易历史
+    /// @param xuid 玩家XUID
+    /// @param filter 查询条件
+    /// @param cursor 上一页返回的游标（为空表示第一页）
+    /// @param pageSize 每页大小（1-1000）
+    /// @return 本页交易记录与下一页游标
+    /// @throw InvalidArgumentException 参数或游标无效时
+    [[nodiscard]] TransactionPage getPlayerTransactionsPage(
+        const std::string&       xuid,
+        const TransactionFilter& filter,
+        const std::string&       cursor,
+        int                      pageSize
+    ) const;
+
     /// @brief 获取玩家交易记录总数
     /// @param xuid 玩家XUID
     /// @return 记录总数
     [[nodiscard]] int getPlayerTransactionCount(const std::string& xuid) const;
 
+    /// @brief 把早于保留天数的交易记录移到按月划分的归档分段文件
+    /// @param daysToKeep 热表中保留的天数（至少 1 天）
+    /// @param stopToken 请求停止时在当前月份完成后返回，已归档的月份保留
+    /// @return 移出热表的记录数
+    /// @throw InvalidArgumentException daysToKeep 小于 1 时
+    /// @throw DatabaseException 归档失败时
+    /// @note 归档后的记录不再计入交易次数统计，按游标分页查询时设置 TransactionFilter::includeArchived 仍可查到
+    int64_t archiveTransactions(int daysToKeep, std::stop_token stopToken = {});
+
     /// @brief 验证金额是否有效
     /// @param amount 金额
     /// @return 是否有效
@@ -170,7 +347,7 @@ class EconomyManager {
     /// @brief 获取服务器总财富（按币种）
     /// @param currencyId 币种ID
     /// @return 总财富
-    [[nodiscard]] int getTotalWealth(const std::string& currencyId) const;
+    [[nodiscard]] int64_t getTotalWealth(const std::string& currencyId) const;
 
     /// @brief 获取玩家总数
     /// @return 玩家总数
@@ -188,6 +365,13 @@ class EconomyManager {
     /// @note 此方法仅用于测试，用于清理单例状态以便测试之间隔离
     void resetForTesting();
 
+    /// @brief 存储后端是否已打开
+    [[nodiscard]] bool isStorageOpen() const;
+
+    /// @brief 获取存储后端（仅用于测试，绕过余额缓存与写后内存直接读取存储）
+    /// @throw DatabaseException 尚未初始化时
+    [[nodiscard]] StorageBackend& getStorageForTesting() const;
+
     EconomyManager(const EconomyManager&)            = delete;
     EconomyManager& operator=(const EconomyManager&) = delete;
 
@@ -196,6 +380,238 @@ class EconomyManager {
     ~EconomyManager() = default;
 
 
+    /// @brief 设置余额并记录交易（在单个事务中完成）
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @param amount 新余额
+    /// @param description 交易描述
+    /// @return 是否操作成功
+    bool applySetBalance(
+        const std::string& xuid,
+        const std::string& currencyId,
+        int                amount,
+        const std::string& description
+    );
+
+    /// @brief 增加或扣除余额并记录交易（在单个事务中完成）
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @param amount 金额（非负）
+    /// @param type 交易类型（ADD 或 REDUCE）
+    /// @param description 交易描述
+    /// @return 是否操作成功
+    bool applyBalanceChange(
+        const std::string& xuid,
+        const std::string& currencyId,
+        int                amount,
+        TransactionType    type,
+        const std::string& description
+    );
+
+    /// @brief 在已打开的事务中设置余额并记录交易
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @param amount 新余额
+    /// @param description 交易描述
+    /// @param failure 业务失败（如玩家不存在）时写入的异常
+    /// @return 设置后的余额，失败时返回空
+    std::optional<int> setBalanceInTransaction(
+        const std::string&             xuid,
+        const std::string&             currencyId,
+        int                            amount,
+        const std::string&             description,
+        std::optional<MoneyException>& failure
+    );
+
+    /// @brief 在已打开的事务中增加或扣除余额并记录交易
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @param amount 金额（非负）
+    /// @param type 交易类型（ADD 或 REDUCE）
+    /// @param description 交易描述
+    /// @param failure 业务失败（如余额不足）时写入的异常
+    /// @return 操作后的余额，失败时返回空
+    std::optional<int> changeBalanceInTransaction(
+        const std::string&             xuid,
+        const std::string&             currencyId,
+        int                            amount,
+        TransactionType                type,
+        const std::string&             description,
+        std::optional<MoneyException>& failure
+    );
+
+    /// @brief 在已打开的事务中完成转账并记录两条交易
+    /// @param fromXuid 转出玩家XUID
+    /// @param toXuid 转入玩家XUID
+    /// @param currencyId 币种ID
+    /// @param amount 转账金额
+    /// @param totalAmount 转出玩家扣除的总金额（含手续费）
+    /// @param description 转账描述
+    /// @param failure 业务失败（如余额不足）时写入的异常
+    /// @return 转出、转入玩家操作后的余额，失败时返回空
+    std::optional<std::pair<int, int>> transferInTransaction(
+        const std::string&             fromXuid,
+        const std::string&             toXuid,
+        const std::string&             currencyId,
+        int                            amount,
+        int                            totalAmount,
+        const std::string&             description,
+        std::optional<MoneyException>& failure
+    );
+
+    /// @brief 在已打开的事务中执行单个批量操作条目
+    /// @param op 操作条目
+    /// @param transferTotal 转账条目含手续费的总扣款（validateMoneyOp 的返回值）
+    /// @param toBalance 转账条目转入玩家操作后的余额
+    /// @param failure 业务失败（如余额不足）时写入的异常
+    /// @return 操作后的余额（转账时为转出玩家余额），失败时返回空
+    std::optional<int> applyOpInTransaction(
+        const MoneyOp&                 op,
+        int                            transferTotal,
+        std::optional<int>&            toBalance,
+        std::optional<MoneyException>& failure
+    );
+
+    /// @brief 获取写后模式币种的当前余额（未载入时从数据库载入；只读取时无需持有账户锁）
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @return 余额；余额记录不存在时返回空
+    std::optional<int> loadWriteBehindBalance(const std::string& xuid, const std::string& currencyId) const;
+
+    /// @brief 以写后模式设置余额（调用方需持有账户锁）
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @param amount 新余额
+    /// @param description 交易描述
+    /// @param failure 业务失败（如玩家不存在）时写入的异常
+    /// @return 设置后的余额，失败时返回空
+    std::optional<int> writeBehindSet(
+        const std::string&             xuid,
+        const std::string&             currencyId,
+        int                            amount,
+        const std::string&             description,
+        std::optional<MoneyException>& failure
+    );
+
+    /// @brief 以写后模式增加或扣除余额（调用方需持有账户锁）
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @param amount 金额（非负）
+    /// @param type 交易类型（ADD 或 REDUCE）
+    /// @param description 交易描述
+    /// @param failure 业务失败（如余额不足）时写入的异常
+    /// @return 操作后的余额，失败时返回空
+    std::optional<int> writeBehindChange(
+        const std::string&             xuid,
+        const std::string&             currencyId,
+        int                            amount,
+        TransactionType                type,
+        const std::string&             description,
+        std::optional<MoneyException>& failure
+    );
+
+    /// @brief 以写后模式转账（调用方需持有双方账户锁）
+    /// @param fromXuid 转出玩家XUID
+    /// @param toXuid 转入玩家XUID
+    /// @param currencyId 币种ID
+    /// @param amount 转账金额
+    /// @param totalAmount 转出玩家扣除的总金额（含手续费）
+    /// @param description 转账描述
+    /// @param failure 业务失败（如余额不足）时写入的异常
+    /// @return 转出、转入玩家操作后的余额，失败时返回空
+    std::optional<std::pair<int, int>> writeBehindTransfer(
+        const std::string&             fromXuid,
+        const std::string&             toXuid,
+        const std::string&             currencyId,
+        int                            amount,
+        int                            totalAmount,
+        const std::string&             description,
+        std::optional<MoneyException>& failure
+    );
+
+    /// @brief 刷新写后模式币种并等待写入完成（调用方需持有 mWriteBehindFlushMutex）
+    /// @return 写入的余额条目数量（含此前已提交、在本次调用中确认的刷新）
+    int64_t flushWriteBehindLocked();
+
+    /// @brief 取出写后存储的脏数据提交给存储后端，不等待写入完成（调用方需持有 mWriteBehindFlushMutex）
+    /// @note 调用前需确认上一次刷新；异步写入模式下事务在写线程上执行，tick 不等待磁盘
+    void submitWriteBehindFlush();
+
+    /// @brief 等待已提交的写后刷新完成并删除已写入的日志段（调用方需持有 mWriteBehindFlushMutex）
+    /// @return 写入的余额条目数量；没有已提交的刷新时返回 0
+    /// @throw DatabaseException 写入失败时（这批余额重新标记为脏，保留在内存中）
+    int64_t finishWriteBehindFlush();
+
+    /// @brief 重放上次运行未写入数据库的重做日志（初始化时调用）
+    void recoverWriteBehindJournal();
+
+    /// @brief 按当前配置打开或关闭写后存储（调用方需锁定全部账户）
+    void configureWriteBehind();
+
+    /// @brief 写操作开始前读取的缓存与排行榜纪元
+    struct WriteEpoch {
+        uint64_t cache       = 0;
+        uint64_t leaderboard = 0;
+    };
+
+    /// @brief 获取当前纪元（写事务开始前调用）
+    [[nodiscard]] WriteEpoch currentWriteEpoch() const;
+
+    /// @brief 把已提交的余额写入缓存与排行榜
+    /// @param epoch 写事务开始前获取的纪元
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @param balance 余额（为空表示余额记录不存在）
+    void publishBalance(
+        const WriteEpoch&  epoch,
+        const std::string& xuid,
+        const std::string& currencyId,
+        std::optional<int> balance
+    );
+
+    /// @brief 确保某币种的内存排行榜可用（未构建或已失效时从数据库重新构建）
+    /// @param currencyId 币种ID
+    void ensureLeaderboard(const std::string& currencyId) const;
+
+    /// @brief 校验批量操作条目（不访问数据库）
+    /// @param op 操作条目
+    /// @return 转账条目返回含手续费的总扣款，其他条目返回 0
+    /// @throw MoneyException 校验失败时
+    int validateMoneyOp(const MoneyOp& op) const;
+
+    /// @brief 在事务中执行批量余额操作
+    /// @param currencyId 操作的币种ID（该币种的缓存余额会失效）
+    /// @param operation 批量操作（在写连接上执行，返回变化的账户数量）
+    /// @return 余额实际变化的账户数量
+    /// @throw DatabaseException 事务执行失败时
+    int64_t runBulkOperation(const std::string& currencyId, const std::function<int64_t()>& operation);
+
+    /// @brief 移出批量操作期间无锁读取回填的该币种余额（缓存与写后存储中未修改的余额）
+    /// @param currencyId 币种ID
+    /// @note 调用方持有全部账户条带
+    void dropBulkReadBalances(const std::string& currencyId);
+
+    /// @brief 构造交易记录（描述为空时按交易类型自动生成）
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @param amount 交易金额
+    /// @param balance 交易后余额
+    /// @param type 交易类型
+    /// @param description 描述
+    /// @param relatedXuid 关联玩家XUID
+    /// @param transferId 转账ID
+    /// @return 交易记录
+    [[nodiscard]] TransactionRecord buildTransactionRecord(
+        const std::string&                xuid,
+        const std::string&                currencyId,
+        int                               amount,
+        int                               balance,
+        TransactionType                   type,
+        const std::string&                description = "",
+        const std::optional<std::string>& relatedXuid = std::nullopt,
+        const std::optional<std::string>& transferId  = std::nullopt
+    ) const;
+
     /// @brief 创建交易记录
     /// @param xuid 玩家XUID
     /// @param currencyId 币种ID
@@ -226,9 +642,26 @@ class EconomyManager {
     /// @return 是否有效
     [[nodiscard]] bool isValidCurrency(const std::string& currencyId) const;
 
-    PlayerDAO      mPlayerDAO;
-    TransactionDAO mTransactionDAO;
-    bool           mInitialized = false;
+    /// @brief 获取存储后端
+    /// @throw DatabaseException 尚未初始化时
+    [[nodiscard]] StorageBackend& storage() const;
+
+    /// @brief 已提交给存储后端、尚未确认的写后刷新
+    struct PendingFlush {
+        std::shared_ptr<WriteBehindStore::FlushBatch> batch;  // 刷新的数据（写入完成前由事务函数共享）
+        std::shared_future<bool>                      handle; // 写入完成句柄
+    };
+
+    std::unique_ptr<StorageBackend> mStorage;                  // 存储后端（initialize() 时按配置创建）
+    mutable AccountLockTable        mAccountLocks;              // 账户条带锁，串行化同一账户上的写操作与缓存填充
+    mutable BalanceCache            mBalanceCache;              // 在线玩家余额缓存
+    mutable Leaderboard             mLeaderboard;               // 各币种的内存排行榜
+    mutable WriteBehindStore        mWriteBehind;               // 写后模式币种的内存余额与重做日志
+    std::mutex                      mWriteBehindFlushMutex;     // 串行化写后刷新
+    std::optional<PendingFlush>     mPendingFlush;              // 已提交、尚未确认的写后刷新（由上一把锁保护）
+    std::atomic<int64_t>            mLastWriteBehindFlushMs{0}; // 上次写后刷新的时间（steady_clock 毫秒）
+    std::mutex                      mInitMutex;                 // 串行化 initialize()
+    std::atomic<bool>               mInitialized = false;
 };
 
 } // namespace rlx_money
\ No newline at end of file
@@ -0,0 +1,286 @@
+#include "mod/economy/Leaderboard.h"
+#include <mutex>
+#include <utility>
+
+
+namespace rlx_money {
+
+/// @brief 树堆节点
+struct LeaderboardNode {
+    std::string                      xuid;
+    int                              balance  = 0;
+    uint32_t                         priority = 0;
+    size_t                           size     = 1; // 子树节点数量
+    std::unique_ptr<LeaderboardNode> left;
+    std::unique_ptr<LeaderboardNode> right;
+};
+
+namespace {
+
+using NodePtr = std::unique_ptr<LeaderboardNode>;
+
+/// @brief (balanceA, xuidA) 是否排在 (balanceB, xuidB) 之前
+bool ranksBefore(int balanceA, const std::string& xuidA, int balanceB, const std::string& xuidB) {
+    return balanceA != balanceB ? balanceA > balanceB : xuidA < xuidB;
+}
+
+size_t sizeOf(const NodePtr& node) { return node ? node->size : 0; }
+
+void pull(LeaderboardNode& node) { node.size = 1 + sizeOf(node.left) + sizeOf(node.right); }
+
+/// @brief 按键拆分：左树为排在 (balance, xuid) 之前的节点，右树为其余节点
+std::pair<NodePtr, NodePtr> splitByKey(NodePtr node, int balance, const std::string& xuid) {
+    if (!node) {
+        return {};
+    }
+    if (ranksBefore(node->balance, node->xuid, balance, xuid)) {
+        auto [left, right] = splitByKey(std::move(node->right), balance, xuid);
+        node->right        = std::move(left);
+        pull(*node);
+        return {std::move(node), std::move(right)};
+    }
+    auto [left, right] = splitByKey(std::move(node->left), balance, xuid);
+    node->left         = std::move(right);
+    pull(*node);
+    return {std::move(left), std::move(node)};
+}
+
+/// @brief 按名次拆分：左树为前 count 个节点
+std::pair<NodePtr, NodePtr> splitBySize(NodePtr node, size_t count) {
+    if (!node) {
+        return {};
+    }
+    size_t leftSize = sizeOf(node->left);
+    if (count <= leftSize) {
+        auto [left, right] = splitBySize(std::move(node->left), count);
+        node->left         = std::move(right);
+        pull(*node);
+        return {std::move(left), std::move(node)};
+    }
+    auto [left, right] = splitBySize(std::move(node->right), count - leftSize - 1);
+    node->right        = std::move(left);
+    pull(*node);
+    return {std::move(node), std::move(right)};
+}
+
+/// @brief 合并两棵树（left 中的节点全部排在 right 之前）
+NodePtr merge(NodePtr left, NodePtr right) {
+    if (!left) {
+        return right;
+    }
+    if (!right) {
+        return left;
+    }
+    if (left->priority > right->priority) {
+        left->right = merge(std::move(left->right), std::move(right));
+        pull(*left);
+        return left;
+    }
+    right->left = merge(std::move(left), std::move(right->left));
+    pull(*right);
+    return right;
+}
+
+/// @brief 中序遍历，跳过前 skip 个节点后最多访问 remaining 个节点
+template <typename Visitor>
+void collect(const LeaderboardNode* node, size_t& skip, size_t& remaining, Visitor& visit) {
+    if (!node || remaining == 0) {
+        return;
+    }
+    size_t leftSize = sizeOf(node->left);
+    if (skip >= leftSize) {
+        skip -= leftSize;
+    } else {
+        collect(node->left.get(), skip, remaining, visit);
+    }
+    if (remaining == 0) {
+        return;
+    }
+    if (skip > 0) {
+        --skip;
+    } else {
+        visit(*node);
+        --remaining;
+    }
+    size_t rightSize = sizeOf(node->right);
+    if (skip >= rightSize) {
+        skip -= rightSize;
+        return;
+    }
+    collect(node->right.get(), skip, remaining, visit);
+}
+
+} // namespace
+
+Leaderboard::Board::Board()                               = default;
+Leaderboard::Board::~Board()                              = default;
+Leaderboard::Board::Board(Board&&) noexcept               = default;
+Leaderboard::Board& Leaderboard::Board::operator=(Board&&) noexcept = default;
+
+Leaderboard::Leaderboard() : mRandom(std::random_device{}()) {}
+
+Leaderboard::~Leaderboard() = default;
+
+void Leaderboard::ensureBuilt(const std::string& currencyId, const Loader& loader) {
+    {
+        std::shared_lock lock(mMutex);
+        auto             it = mBoards.find(currencyId);
+        if (it != mBoards.end() && isFresh(it->second)) {
+            return;
+        }
+    }
+
+    // 构建期间持有写锁，并发写入在构建完成后再应用，不会被构建覆盖
+    std::unique_lock lock(mMutex);
+    auto             it = mBoards.find(currencyId);
+    if (it != mBoards.end() && isFresh(it->second)) {
+        return;
+    }
+
+    Board board;
+    board.builtEpoch = mEpoch.load(std::memory_order_acquire);
+    for (auto& row : loader()) {
+        if (board.balances.emplace(row.xuid, row.balance).second) {
+            insert(board, row.xuid, row.balance);
+        }
+        mUsernames[row.xuid] = std::move(row.username);
+    }
+    mBoards.insert_or_assign(currencyId, std::move(board));
+}
+
+void Leaderboard::update(
+    const std::string& currencyId,
+    const std::string& xuid,
+    std::optional<int> balance,
+    uint64_t           epoch
+) {
+    std::unique_lock lock(mMutex);
+    auto             it = mBoards.find(currencyId);
+    if (it == mBoards.end() || !isFresh(it->second)) {
+        return; // 下次查询时重新构建
+    }
+
+    auto& board = it->second;
+    if (epoch != board.builtEpoch || (balance && !mUsernames.contains(xuid))) {
+        // 写入期间发生过整体失效，或者是尚未记录用户名的玩家，交给重新构建处理
+        board.stale = true;
+        return;
+    }
+
+    auto existing = board.balances.find(xuid);
+    if (existing != board.balances.end()) {
+        if (balance && existing->second == *balance) {
+            return;
+        }
+        erase(board, xuid, existing->second);
+        board.balances.erase(existing);
+    }
+    if (balance) {
+        insert(board, xuid, *balance);
+        board.balances.emplace(xuid, *balance);
+    }
+}
+
+void Leaderboard::setUsername(const std::string& xuid, const std::string& username) {
+    std::unique_lock lock(mMutex);
+    mUsernames[xuid] = username;
+}
+
+void Leaderboard::invalidateCurrency(const std::string& currencyId) {
+    std::unique_lock lock(mMutex);
+    if (auto it = mBoards.find(currencyId); it != mBoards.end()) {
+        it->second.stale = true;
+    }
+}
+
+void Leaderboard::invalidateAll() { mEpoch.fetch_add(1, std::memory_order_release); }
+
+void Leaderboard::clear() {
+    std::unique_lock lock(mMutex);
+    mEpoch.fetch_add(1, std::memory_order_release);
+    mBoards.clear();
+    mUsernames.clear();
+}
+
+std::optional<int> Leaderboard::rankOf(const std::string& currencyId, const std::string& xuid) const {
+    std::shared_lock lock(mMutex);
+    auto             boardIt = mBoards.find(currencyId);
+    if (boardIt == mBoards.end()) {
+        return std::nullopt;
+    }
+    const auto& board     = boardIt->second;
+    auto        balanceIt = board.balances.find(xuid);
+    if (balanceIt == board.balances.end()) {
+        return std::nullopt;
+    }
+
+    // 自根向下累计排在该玩家之前的节点数量
+    int   balance = balanceIt->second;
+    int   before  = 0;
+    auto* node    = board.root.get();
+    while (node) {
+        if (node->balance == balance && node->xuid == xuid) {
+            return before + static_cast<int>(sizeOf(node->left)) + 1;
+        }
+        if (ranksBefore(node->balance, node->xuid, balance, xuid)) {
+            before += static_cast<int>(sizeOf(node->left)) + 1;
+            node    = node->right.get();
+        } else {
+            node = node->left.get();
+        }
+    }
+    return std::nullopt;
+}
+
+std::vector<TopBalanceEntry> Leaderboard::range(const std::string& currencyId, size_t offset, size_t limit) const {
+    std::shared_lock             lock(mMutex);
+    std::vector<TopBalanceEntry> result;
+    auto                         boardIt = mBoards.find(currencyId);
+    if (boardIt == mBoards.end()) {
+        return result;
+    }
+
+    int  rank  = static_cast<int>(offset);
+    auto visit = [&](const LeaderboardNode& node) {
+        auto usernameIt = mUsernames.find(node.xuid);
+        result.emplace_back(
+            usernameIt != mUsernames.end() ? usernameIt->second : std::string(),
+            node.xuid,
+            currencyId,
+            node.balance,
+            ++rank
+        );
+    };
+    size_t skip      = offset;
+    size_t remaining = limit;
+    collect(boardIt->second.root.get(), skip, remaining, visit);
+    return result;
+}
+
+size_t Leaderboard::size(const std::string& currencyId) const {
+    std::shared_lock lock(mMutex);
+    auto             it = mBoards.find(currencyId);
+    return it != mBoards.end() ? it->second.balances.size() : 0;
+}
+
+bool Leaderboard::isFresh(const Board& board) const {
+    return !board.stale && board.builtEpoch == mEpoch.load(std::memory_order_acquire);
+}
+
+void Leaderboard::insert(Board& board, const std::string& xuid, int balance) {
+    auto node      = std::make_unique<LeaderboardNode>();
+    node->xuid     = xuid;
+    node->balance  = balance;
+    node->priority = static_cast<uint32_t>(mRandom());
+
+    auto [left, right] = splitByKey(std::move(board.root), balance, xuid);
+    board.root         = merge(merge(std::move(left), std::move(node)), std::move(right));
+}
+
+void Leaderboard::erase(Board& board, const std::string& xuid, int balance) {
+    auto [left, right]  = splitByKey(std::move(board.root), balance, xuid);
+    auto [target, rest] = splitBySize(std::move(right), 1);
+    board.root          = merge(std::move(left), std::move(rest));
+}
+
+} // namespace rlx_money
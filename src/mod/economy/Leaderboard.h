@@ -0,0 +1,122 @@
+#pragma once
+
+#include <RLXMoney/data/DataStructures.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace rlx_money {
+
+struct LeaderboardNode;
+
+/// @brief 按币种维护的内存排行榜（顺序统计树）
+/// @note 每个币种一棵按 (余额降序, XUID 升序) 排序、记录子树大小的树堆，排名查询、插入和删除均为 O(log n)。
+///       排名为位置排名：余额相同的玩家按 XUID 排序，名次不并列。
+///       某币种首次查询时从数据库构建；之后由调用方在每次余额写入提交后调用 update() 增量维护。
+///       与 BalanceCache 相同，写入前读取纪元，组提交整组回滚时调用 invalidateAll() 使纪元递增，
+///       所有币种在下次查询时重新构建
+class Leaderboard {
+public:
+    /// @brief 构建排行榜时使用的一行数据
+    struct Row {
+        std::string xuid;
+        std::string username;
+        int         balance = 0;
+    };
+
+    /// @brief 读取某币种全部余额的函数（需要读到尚未提交的组事务中的写入）
+    using Loader = std::function<std::vector<Row>()>;
+
+    Leaderboard();
+    ~Leaderboard();
+
+    Leaderboard(const Leaderboard&)            = delete;
+    Leaderboard& operator=(const Leaderboard&) = delete;
+
+    /// @brief 获取当前纪元（写入前读取，update() 时用于判断期间是否发生过整体失效）
+    [[nodiscard]] uint64_t epoch() const { return mEpoch.load(std::memory_order_acquire); }
+
+    /// @brief 确保某币种的排行榜已构建且未失效，否则调用 loader 重新构建
+    /// @param currencyId 币种ID
+    /// @param loader 读取该币种全部余额的函数（在排行榜写锁内调用）
+    void ensureBuilt(const std::string& currencyId, const Loader& loader);
+
+    /// @brief 写入玩家在某币种的余额（该币种尚未构建或已失效时忽略）
+    /// @param currencyId 币种ID
+    /// @param xuid 玩家XUID
+    /// @param balance 余额（为空表示余额记录不存在）
+    /// @param epoch 开始写入之前获取的纪元；纪元已变化时该币种标记为失效
+    void update(const std::string& currencyId, const std::string& xuid, std::optional<int> balance, uint64_t epoch);
+
+    /// @brief 记录玩家用户名（新玩家或用户名变更时调用）
+    /// @param xuid 玩家XUID
+    /// @param username 用户名
+    void setUsername(const std::string& xuid, const std::string& username);
+
+    /// @brief 使某币种失效，下次查询时重新构建（集合操作之后调用）
+    /// @param currencyId 币种ID
+    void invalidateCurrency(const std::string& currencyId);
+
+    /// @brief 使所有币种失效（只递增纪元，不加锁，可在持有数据库写连接时调用）
+    void invalidateAll();
+
+    /// @brief 清空所有排行榜
+    void clear();
+
+    /// @brief 获取玩家排名
+    /// @param currencyId 币种ID
+    /// @param xuid 玩家XUID
+    /// @return 排名（从 1 开始）；玩家不在排行榜中时返回空
+    [[nodiscard]] std::optional<int> rankOf(const std::string& currencyId, const std::string& xuid) const;
+
+    /// @brief 按名次获取一段排行榜
+    /// @param currencyId 币种ID
+    /// @param offset 跳过的名次数量（0 表示从第一名开始）
+    /// @param limit 最多返回的条目数量
+    /// @return 排行榜条目（rank 为名次）
+    [[nodiscard]] std::vector<TopBalanceEntry> range(const std::string& currencyId, size_t offset, size_t limit) const;
+
+    /// @brief 获取某币种排行榜中的玩家数量
+    /// @param currencyId 币种ID
+    [[nodiscard]] size_t size(const std::string& currencyId) const;
+
+private:
+    /// @brief 单个币种的排行榜
+    struct Board {
+        std::unique_ptr<LeaderboardNode>     root;
+        std::unordered_map<std::string, int> balances;       // XUID -> 当前在树中的余额
+        uint64_t                             builtEpoch = 0; // 构建时的纪元
+        bool                                 stale      = false;
+
+        Board();
+        ~Board();
+        Board(Board&&) noexcept;
+        Board& operator=(Board&&) noexcept;
+    };
+
+    /// @brief 排行榜是否可直接使用（调用方需持有锁）
+    [[nodiscard]] bool isFresh(const Board& board) const;
+
+    /// @brief 把玩家插入树中（调用方需持有写锁）
+    void insert(Board& board, const std::string& xuid, int balance);
+
+    /// @brief 把玩家从树中删除（调用方需持有写锁）
+    static void erase(Board& board, const std::string& xuid, int balance);
+
+    mutable std::shared_mutex                    mMutex;
+    std::unordered_map<std::string, Board>       mBoards;    // 币种ID -> 排行榜
+    std::unordered_map<std::string, std::string> mUsernames; // XUID -> 用户名
+    std::mt19937                                 mRandom;    // 树堆优先级
+    std::atomic<uint64_t>                        mEpoch{0};
+};
+
+} // namespace rlx_money
@@ -0,0 +1,304 @@
+#include "mod/economy/RedoJournal.h"
+#include "mod/exceptions/MoneyException.h"
+#include <RLXMoney/types/Types.h>
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+#include <system_error>
+
+
+namespace rlx_money {
+
+namespace {
+
+/// @brief 可选字段为空时的占位符（转义后的文本中不会出现）
+constexpr std::string_view kNullField = "\\0";
+
+/// @brief 每条记录的字段数量
+constexpr size_t kFieldCount = 10;
+
+/// @brief 转义制表符、换行与反斜杠
+void appendEscaped(std::string& out, std::string_view text) {
+    for (char c : text) {
+        switch (c) {
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        case '\r':
+            out += "\\r";
+            break;
+        default:
+            out += c;
+            break;
+        }
+    }
+}
+
+/// @brief 反转义字段
+/// @return 反转义后的文本；转义序列无效时返回空
+std::optional<std::string> unescape(std::string_view field) {
+    std::string out;
+    out.reserve(field.size());
+    for (size_t i = 0; i < field.size(); ++i) {
+        if (field[i] != '\\') {
+            out += field[i];
+            continue;
+        }
+        if (++i == field.size()) {
+            return std::nullopt;
+        }
+        switch (field[i]) {
+        case '\\':
+            out += '\\';
+            break;
+        case 't':
+            out += '\t';
+            break;
+        case 'n':
+            out += '\n';
+            break;
+        case 'r':
+            out += '\r';
+            break;
+        default:
+            return std::nullopt;
+        }
+    }
+    return out;
+}
+
+void appendOptional(std::string& out, const std::optional<std::string>& value) {
+    if (value) {
+        appendEscaped(out, *value);
+    } else {
+        out += kNullField;
+    }
+}
+
+template <typename T>
+bool parseNumber(std::string_view text, T& value) {
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return error == std::errc() && end == text.data() + text.size();
+}
+
+/// @brief 解析一行日志
+/// @return 解析结果；格式无效时返回空
+std::optional<JournalEntry> parseLine(std::string_view line) {
+    std::vector<std::string_view> fields;
+    size_t                        start = 0;
+    while (fields.size() < kFieldCount) {
+        size_t end = line.find('\t', start);
+        if (end == std::string_view::npos) {
+            fields.push_back(line.substr(start));
+            break;
+        }
+        fields.push_back(line.substr(start, end - start));
+        start = end + 1;
+    }
+    if (fields.size() != kFieldCount) {
+        return std::nullopt;
+    }
+
+    JournalEntry entry;
+    auto&        record = entry.record;
+    if (!parseNumber(fields[0], entry.sequence) || !parseNumber(fields[3], record.amount)
+        || !parseNumber(fields[4], record.balance) || !parseNumber(fields[6], record.timestamp)) {
+        return std::nullopt;
+    }
+
+    auto xuid        = unescape(fields[1]);
+    auto currencyId  = unescape(fields[2]);
+    auto description = unescape(fields[9]);
+    if (!xuid || !currencyId || !description) {
+        return std::nullopt;
+    }
+    record.xuid        = std::move(*xuid);
+    record.currencyId  = std::move(*currencyId);
+    record.description = std::move(*description);
+    record.type        = stringToTransactionType(std::string(fields[5]));
+
+    for (auto [field, target] : {
+             std::pair{fields[7], &record.relatedXuid},
+             std::pair{fields[8], &record.transferId}
+    }) {
+        if (field == kNullField) {
+            target->reset();
+            continue;
+        }
+        auto value = unescape(field);
+        if (!value) {
+            return std::nullopt;
+        }
+        *target = std::move(*value);
+    }
+    return entry;
+}
+
+/// @brief 从段文件名中解析段号
+/// @return 段号；文件不属于该日志时返回空
+std::optional<uint64_t> segmentIndexOf(const std::filesystem::path& file, const std::string& prefix) {
+    std::string name = file.filename().string();
+    if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0) {
+        return std::nullopt;
+    }
+    uint64_t index = 0;
+    if (!parseNumber(std::string_view(name).substr(prefix.size()), index)) {
+        return std::nullopt;
+    }
+    return index;
+}
+
+std::string segmentPath(const std::string& basePath, uint64_t index) {
+    std::ostringstream path;
+    path << basePath << '.' << std::setw(6) << std::setfill('0') << index;
+    return path.str();
+}
+
+} // namespace
+
+RedoJournal::~RedoJournal() { close(); }
+
+std::vector<std::string> RedoJournal::listSegments(const std::string& basePath) {
+    std::filesystem::path base(basePath);
+    std::filesystem::path directory = base.parent_path().empty() ? std::filesystem::path(".") : base.parent_path();
+    std::string           prefix    = base.filename().string() + ".";
+
+    std::vector<std::pair<uint64_t, std::string>> found;
+    std::error_code                               error;
+    for (const auto& file : std::filesystem::directory_iterator(directory, error)) {
+        if (auto index = segmentIndexOf(file.path(), prefix)) {
+            found.emplace_back(*index, file.path().string());
+        }
+    }
+    std::sort(found.begin(), found.end());
+
+    std::vector<std::string> segments;
+    segments.reserve(found.size());
+    for (auto& [index, path] : found) {
+        segments.push_back(std::move(path));
+    }
+    return segments;
+}
+
+std::vector<JournalEntry> RedoJournal::readSegments(const std::vector<std::string>& segments) {
+    std::vector<JournalEntry> entries;
+    for (const auto& segment : segments) {
+        std::ifstream     input(segment, std::ios::binary);
+        std::stringstream content;
+        content << input.rdbuf();
+        std::string text = content.str();
+
+        size_t start = 0;
+        while (start < text.size()) {
+            size_t end = text.find('\n', start);
+            if (end == std::string::npos) {
+                break; // 末尾不完整的一行：写入时进程中断
+            }
+            auto entry = parseLine(std::string_view(text).substr(start, end - start));
+            if (!entry) {
+                throw DatabaseException("重做日志已损坏: " + segment);
+            }
+            entries.push_back(std::move(*entry));
+            start = end + 1;
+        }
+    }
+    return entries;
+}
+
+void RedoJournal::removeSegments(const std::vector<std::string>& segments) {
+    for (const auto& segment : segments) {
+        std::error_code error;
+        std::filesystem::remove(segment, error);
+    }
+}
+
+void RedoJournal::open(const std::string& basePath) {
+    close();
+    mBasePath = basePath;
+
+    uint64_t lastIndex = 0;
+    std::string prefix = std::filesystem::path(basePath).filename().string() + ".";
+    for (const auto& segment : listSegments(basePath)) {
+        lastIndex = std::max(lastIndex, segmentIndexOf(segment, prefix).value_or(0));
+    }
+    openSegment(lastIndex + 1);
+}
+
+void RedoJournal::close() {
+    if (mStream.is_open()) {
+        mStream.close();
+        // 没有写入任何记录的段直接删除
+        if (mSegmentBytes == 0) {
+            removeSegments({mSegmentPath});
+        }
+    }
+    mSegmentBytes = 0;
+}
+
+void RedoJournal::append(const std::vector<JournalEntry>& entries) {
+    if (!mStream.is_open()) {
+        throw DatabaseException("重做日志未打开");
+    }
+
+    std::string lines;
+    for (const auto& entry : entries) {
+        const auto& record  = entry.record;
+        lines              += std::to_string(entry.sequence);
+        lines              += '\t';
+        appendEscaped(lines, record.xuid);
+        lines += '\t';
+        appendEscaped(lines, record.currencyId);
+        lines += '\t';
+        lines += std::to_string(record.amount);
+        lines += '\t';
+        lines += std::to_string(record.balance);
+        lines += '\t';
+        lines += transactionTypeToString(record.type);
+        lines += '\t';
+        lines += std::to_string(record.timestamp);
+        lines += '\t';
+        appendOptional(lines, record.relatedXuid);
+        lines += '\t';
+        appendOptional(lines, record.transferId);
+        lines += '\t';
+        appendEscaped(lines, record.description);
+        lines += '\n';
+    }
+
+    mStream.write(lines.data(), static_cast<std::streamsize>(lines.size()));
+    mStream.flush();
+    if (!mStream) {
+        throw DatabaseException("写入重做日志失败: " + mSegmentPath);
+    }
+    mSegmentBytes += lines.size();
+}
+
+std::optional<std::string> RedoJournal::rotate() {
+    if (!mStream.is_open() || mSegmentBytes == 0) {
+        return std::nullopt;
+    }
+    std::string sealed = mSegmentPath;
+    mStream.close();
+    openSegment(mSegmentIndex + 1);
+    return sealed;
+}
+
+void RedoJournal::openSegment(uint64_t index) {
+    mSegmentIndex = index;
+    mSegmentPath  = segmentPath(mBasePath, index);
+    mSegmentBytes = 0;
+    mStream.open(mSegmentPath, std::ios::binary | std::ios::app);
+    if (!mStream.is_open()) {
+        throw DatabaseException("无法创建重做日志: " + mSegmentPath);
+    }
+}
+
+} // namespace rlx_money
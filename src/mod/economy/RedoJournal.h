@@ -0,0 +1,75 @@
+#pragma once
+
+#include <RLXMoney/data/DataStructures.h>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+
+namespace rlx_money {
+
+/// @brief 重做日志条目：一条尚未写入 transactions 表的交易记录
+struct JournalEntry {
+    uint64_t          sequence = 0; // 全局递增序号
+    TransactionRecord record;       // 交易记录（balance 为交易后余额，重放时直接作为账户余额）
+};
+
+/// @brief 写后模式的本地重做日志
+/// @note 日志按段存放在 <basePath>.<段号> 文件中，每行一条记录，字段以制表符分隔。
+///       每次追加后立即 flush，进程崩溃时已追加的记录不会丢失；末尾不完整的一行在读取时被忽略。
+///       刷新到数据库时先封存当前段并切换到新段，刷新成功后再删除已封存的段
+class RedoJournal {
+public:
+    ~RedoJournal();
+
+    /// @brief 列出已存在的日志段（按段号升序）
+    /// @param basePath 日志基础路径
+    /// @return 日志段文件路径
+    [[nodiscard]] static std::vector<std::string> listSegments(const std::string& basePath);
+
+    /// @brief 读取日志段中的全部条目
+    /// @param segments 日志段文件路径（按段号升序）
+    /// @return 日志条目（按写入顺序）
+    /// @throw DatabaseException 日志内容损坏时
+    [[nodiscard]] static std::vector<JournalEntry> readSegments(const std::vector<std::string>& segments);
+
+    /// @brief 删除日志段
+    /// @param segments 日志段文件路径
+    static void removeSegments(const std::vector<std::string>& segments);
+
+    /// @brief 打开日志（在已存在的最大段号之后新建一个段）
+    /// @param basePath 日志基础路径
+    /// @throw DatabaseException 无法创建日志文件时
+    void open(const std::string& basePath);
+
+    /// @brief 关闭日志（不删除任何文件）
+    void close();
+
+    /// @brief 日志是否已打开
+    [[nodiscard]] bool isOpen() const { return mStream.is_open(); }
+
+    /// @brief 追加条目并立即 flush
+    /// @param entries 日志条目
+    /// @throw DatabaseException 写入失败时
+    void append(const std::vector<JournalEntry>& entries);
+
+    /// @brief 封存当前段并切换到新段
+    /// @return 被封存的段路径；当前段为空时返回空
+    /// @throw DatabaseException 无法创建新段时
+    std::optional<std::string> rotate();
+
+private:
+    /// @brief 打开指定段号的段文件
+    void openSegment(uint64_t index);
+
+    std::string   mBasePath;
+    std::ofstream mStream;
+    std::string   mSegmentPath;
+    uint64_t      mSegmentIndex = 0;
+    size_t        mSegmentBytes = 0;
+};
+
+} // namespace rlx_money
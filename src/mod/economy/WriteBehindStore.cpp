@@ -0,0 +1,181 @@
+#include "mod/economy/WriteBehindStore.h"
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
+
+namespace rlx_money {
+
+void WriteBehindStore::open(const std::string& journalBasePath, uint64_t nextSequence) {
+    std::lock_guard lock(mMutex);
+    mJournal.open(journalBasePath);
+    mNextSequence = std::max<uint64_t>(nextSequence, 1);
+    mOpen.store(true, std::memory_order_release);
+}
+
+void WriteBehindStore::close() {
+    std::lock_guard lock(mMutex);
+    mOpen.store(false, std::memory_order_release);
+    mGeneration.fetch_add(1, std::memory_order_release);
+    mJournal.close();
+    mEntries.clear();
+    mPending.clear();
+    mSealedSegments.clear();
+    mDirtyCount = 0;
+}
+
+std::optional<int> WriteBehindStore::get(const std::string& xuid, const std::string& currencyId) const {
+    std::lock_guard lock(mMutex);
+    auto            it = mEntries.find(Key(xuid, currencyId));
+    if (it == mEntries.end()) {
+        return std::nullopt;
+    }
+    return it->second.balance;
+}
+
+std::vector<std::pair<std::string, int>> WriteBehindStore::getPlayerBalances(const std::string& xuid) const {
+    std::lock_guard                          lock(mMutex);
+    std::vector<std::pair<std::string, int>> balances;
+    for (auto it = mEntries.lower_bound(Key(xuid, "")); it != mEntries.end() && it->first.first == xuid; ++it) {
+        balances.emplace_back(it->first.second, it->second.balance);
+    }
+    return balances;
+}
+
+std::vector<std::pair<std::string, int>> WriteBehindStore::getCurrencyBalances(const std::string& currencyId) const {
+    std::lock_guard                          lock(mMutex);
+    std::vector<std::pair<std::string, int>> balances;
+    for (const auto& [key, entry] : mEntries) {
+        if (key.second == currencyId) {
+            balances.emplace_back(key.first, entry.balance);
+        }
+    }
+    return balances;
+}
+
+void WriteBehindStore::load(const std::string& xuid, const std::string& currencyId, int balance, uint64_t generation) {
+    std::lock_guard lock(mMutex);
+    if (generation != mGeneration.load(std::memory_order_relaxed)) {
+        return;
+    }
+    mEntries.try_emplace(Key(xuid, currencyId), Entry{balance, false});
+}
+
+void WriteBehindStore::commit(const std::vector<TransactionRecord>& records) {
+    std::lock_guard lock(mMutex);
+
+    std::vector<JournalEntry> entries;
+    entries.reserve(records.size());
+    for (const auto& record : records) {
+        entries.push_back(JournalEntry{mNextSequence + entries.size(), record});
+    }
+
+    // 先落日志，写入失败时内存保持不变
+    mJournal.append(entries);
+    mNextSequence += entries.size();
+
+    for (auto& entry : entries) {
+        auto& target = mEntries[Key(entry.record.xuid, entry.record.currencyId)];
+        if (!target.dirty) {
+            target.dirty = true;
+            ++mDirtyCount;
+        }
+        target.balance = entry.record.balance;
+        mPending.push_back(std::move(entry));
+    }
+}
+
+WriteBehindStore::FlushBatch WriteBehindStore::beginFlush() {
+    std::lock_guard lock(mMutex);
+    FlushBatch      batch;
+    mGeneration.fetch_add(1, std::memory_order_release);
+
+    int64_t now =
+        std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    for (auto it = mEntries.begin(); it != mEntries.end();) {
+        if (!it->second.dirty) {
+            // 一个刷新周期内未被修改，移出内存，下次访问时从数据库重新载入
+            it = mEntries.erase(it);
+            continue;
+        }
+        PlayerBalance balance;
+        balance.xuid       = it->first.first;
+        balance.currencyId = it->first.second;
+        balance.balance    = it->second.balance;
+        balance.updatedAt  = now;
+        batch.balances.push_back(std::move(balance));
+        it->second.dirty = false;
+        ++it;
+    }
+    mDirtyCount = 0;
+
+    batch.entries.swap(mPending);
+    if (!batch.entries.empty()) {
+        batch.lastSequence = batch.entries.back().sequence;
+        if (auto sealed = mJournal.rotate()) {
+            mSealedSegments.push_back(std::move(*sealed));
+        }
+    }
+    batch.sealedSegments = mSealedSegments;
+    return batch;
+}
+
+void WriteBehindStore::finishFlush(const FlushBatch& batch) {
+    std::lock_guard lock(mMutex);
+    RedoJournal::removeSegments(batch.sealedSegments);
+    std::erase_if(mSealedSegments, [&](const std::string& segment) {
+        return std::find(batch.sealedSegments.begin(), batch.sealedSegments.end(), segment)
+            != batch.sealedSegments.end();
+    });
+    ++mFlushes;
+}
+
+void WriteBehindStore::abortFlush(FlushBatch batch) {
+    std::lock_guard lock(mMutex);
+    for (const auto& balance : batch.balances) {
+        auto it = mEntries.find(Key(balance.xuid, balance.currencyId));
+        if (it != mEntries.end() && !it->second.dirty) {
+            it->second.dirty = true;
+            ++mDirtyCount;
+        }
+    }
+    // 本次取出的记录排在刷新期间新追加的记录之前
+    batch.entries.insert(
+        batch.entries.end(),
+        std::make_move_iterator(mPending.begin()),
+        std::make_move_iterator(mPending.end())
+    );
+    mPending.swap(batch.entries);
+}
+
+void WriteBehindStore::dropCurrency(const std::string& currencyId) {
+    std::lock_guard lock(mMutex);
+    mGeneration.fetch_add(1, std::memory_order_release);
+    std::erase_if(mEntries, [&](const auto& item) { return !item.second.dirty && item.first.second == currencyId; });
+}
+
+void WriteBehindStore::dropPlayer(const std::string& xuid) {
+    std::lock_guard lock(mMutex);
+    mGeneration.fetch_add(1, std::memory_order_release);
+    for (auto it = mEntries.lower_bound(Key(xuid, "")); it != mEntries.end() && it->first.first == xuid;) {
+        it = it->second.dirty ? std::next(it) : mEntries.erase(it);
+    }
+}
+
+void WriteBehindStore::dropClean() {
+    std::lock_guard lock(mMutex);
+    mGeneration.fetch_add(1, std::memory_order_release);
+    std::erase_if(mEntries, [](const auto& item) { return !item.second.dirty; });
+}
+
+WriteBehindStats WriteBehindStore::getStats() const {
+    std::lock_guard  lock(mMutex);
+    WriteBehindStats stats;
+    stats.entries        = mEntries.size();
+    stats.dirtyEntries   = mDirtyCount;
+    stats.pendingRecords = mPending.size();
+    stats.flushes        = mFlushes;
+    return stats;
+}
+
+} // namespace rlx_money
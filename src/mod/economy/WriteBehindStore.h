@@ -0,0 +1,131 @@
+#pragma once
+
+#include "mod/economy/RedoJournal.h"
+#include <RLXMoney/data/DataStructures.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace rlx_money {
+
+/// @brief 写后存储统计
+struct WriteBehindStats {
+    size_t   entries        = 0; // 内存中的余额条目数量
+    size_t   dirtyEntries   = 0; // 尚未刷新到数据库的余额条目数量
+    size_t   pendingRecords = 0; // 尚未写入 transactions 表的交易记录数量
+    uint64_t flushes        = 0; // 成功刷新的次数
+};
+
+/// @brief 写后模式币种的内存余额存储
+/// @note 余额以内存为准，变更先追加到重做日志再更新内存并标记为脏；刷新时取出脏余额与待写入的交易记录，
+///       由调用方在一个事务中写入数据库。调用方负责对账户加锁，并保证同一时刻只有一次刷新
+class WriteBehindStore {
+public:
+    /// @brief 待刷新的数据
+    struct FlushBatch {
+        std::vector<PlayerBalance> balances;       // 脏余额
+        std::vector<JournalEntry>  entries;        // 待写入的交易记录
+        std::vector<std::string>   sealedSegments; // 刷新成功后可删除的日志段
+        uint64_t                   lastSequence = 0;
+
+        [[nodiscard]] bool empty() const { return balances.empty() && entries.empty(); }
+    };
+
+    /// @brief 打开存储
+    /// @param journalBasePath 重做日志基础路径
+    /// @param nextSequence 下一条日志的序号
+    /// @throw DatabaseException 无法创建日志文件时
+    void open(const std::string& journalBasePath, uint64_t nextSequence);
+
+    /// @brief 关闭存储并丢弃内存中的余额（未刷新的变更仍保留在日志中）
+    void close();
+
+    /// @brief 存储是否已打开
+    [[nodiscard]] bool isOpen() const { return mOpen.load(std::memory_order_acquire); }
+
+    /// @brief 获取内存中的余额
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @return 余额；未载入时返回空
+    [[nodiscard]] std::optional<int> get(const std::string& xuid, const std::string& currencyId) const;
+
+    /// @brief 获取玩家在内存中的全部余额
+    /// @param xuid 玩家XUID
+    /// @return (币种ID, 余额) 列表
+    [[nodiscard]] std::vector<std::pair<std::string, int>> getPlayerBalances(const std::string& xuid) const;
+
+    /// @brief 获取某币种在内存中的全部余额
+    /// @param currencyId 币种ID
+    /// @return (XUID, 余额) 列表
+    [[nodiscard]] std::vector<std::pair<std::string, int>> getCurrencyBalances(const std::string& currencyId) const;
+
+    /// @brief 获取移出版本（每次有余额移出内存时递增；读取数据库之前获取，载入时用于判断期间是否有余额被移出）
+    [[nodiscard]] uint64_t generation() const { return mGeneration.load(std::memory_order_acquire); }
+
+    /// @brief 载入从数据库读取的余额（已存在时忽略）
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @param balance 余额
+    /// @param generation 读取数据库之前获取的移出版本；版本已变化时读到的值可能早于被移出的余额，放弃载入
+    void load(const std::string& xuid, const std::string& currencyId, int balance, uint64_t generation);
+
+    /// @brief 提交一次余额变更：追加日志后更新内存余额（每条记录的 balance 即账户的新余额）
+    /// @param records 交易记录
+    /// @throw DatabaseException 写入日志失败时（内存余额保持不变）
+    void commit(const std::vector<TransactionRecord>& records);
+
+    /// @brief 开始刷新：取出脏余额与待写入的记录并封存当前日志段；上次刷新以来未被修改的条目移出内存
+    /// @return 待刷新的数据
+    FlushBatch beginFlush();
+
+    /// @brief 刷新成功：删除已封存的日志段
+    /// @param batch beginFlush() 返回的数据
+    void finishFlush(const FlushBatch& batch);
+
+    /// @brief 刷新失败：把余额重新标记为脏，交易记录放回待写入队列
+    /// @param batch beginFlush() 返回的数据
+    void abortFlush(FlushBatch batch);
+
+    /// @brief 移出某币种已刷新的余额
+    /// @param currencyId 币种ID
+    void dropCurrency(const std::string& currencyId);
+
+    /// @brief 移出某玩家已刷新的余额
+    /// @param xuid 玩家XUID
+    void dropPlayer(const std::string& xuid);
+
+    /// @brief 移出所有已刷新的余额
+    void dropClean();
+
+    /// @brief 获取统计信息
+    [[nodiscard]] WriteBehindStats getStats() const;
+
+private:
+    using Key = std::pair<std::string, std::string>; // (xuid, 币种ID)
+
+    /// @brief 内存余额
+    struct Entry {
+        int  balance = 0;
+        bool dirty   = false;
+    };
+
+    mutable std::mutex         mMutex;
+    std::atomic<bool>          mOpen{false};
+    RedoJournal                mJournal;
+    std::map<Key, Entry>       mEntries;
+    std::vector<JournalEntry>  mPending;        // 已写入日志、尚未写入数据库的记录
+    std::vector<std::string>   mSealedSegments; // 已封存、尚未确认写入数据库的日志段
+    uint64_t                   mNextSequence = 1;
+    size_t                     mDirtyCount   = 0;
+    uint64_t                   mFlushes      = 0;
+    std::atomic<uint64_t>      mGeneration{0};
+};
+
+} // namespace rlx_money
@@ -1,11 +1,10 @@
 #include "mod/events/PlayerEventListener.h"
-#include "mod/dao/PlayerDAO.h"
-#include "mod/database/DatabaseManager.h"
 #include "mod/economy/EconomyManager.h"
 #include "mod/exceptions/MoneyException.h"
 
 
 #include <ll/api/event/EventBus.h>
+#include <ll/api/event/player/PlayerDisconnectEvent.h>
 #include <ll/api/event/player/PlayerJoinEvent.h>
 #include <ll/api/mod/NativeMod.h>
 #include <mc/server/ServerPlayer.h>
@@ -14,7 +13,8 @@
 
 namespace rlx_money {
 
-static ll::event::ListenerPtr gPlayerJoinListener = nullptr;
+static ll::event::ListenerPtr gPlayerJoinListener       = nullptr;
+static ll::event::ListenerPtr gPlayerDisconnectListener = nullptr;
 
 void PlayerEventListener::registerListeners() {
     auto& eventBus = ll::event::EventBus::getInstance();
@@ -39,13 +39,15 @@ void PlayerEventListener::registerListeners() {
                     }
                 } else {
                     // 如果玩家已存在，更新用户名（以防用户名变更）
-                    PlayerDAO playerDAO(DatabaseManager::getInstance());
-                    auto      existingPlayer = playerDAO.getPlayerByXuid(xuid);
+                    auto existingPlayer = EconomyManager::getInstance().getPlayer(xuid);
                     if (existingPlayer.has_value() && existingPlayer->username != username) {
-                        playerDAO.updateUsername(xuid, username);
+                        EconomyManager::getInstance().updateUsername(xuid, username);
                         logger.debug("更新玩家 {} 的用户名为 {}", xuid, username);
                     }
                 }
+
+                // 在线期间余额常驻缓存
+                EconomyManager::getInstance().cachePlayerBalances(xuid);
             } catch (const MoneyException& e) {
                 // 如果玩家已存在，忽略异常（这是正常情况）
                 if (e.getErrorCode() != ErrorCode::PLAYER_ALREADY_EXISTS) {
@@ -57,6 +59,18 @@ void PlayerEventListener::registerListeners() {
             }
         });
 
+    // 监听玩家离开事件
+    gPlayerDisconnectListener = eventBus.emplaceListener<ll::event::player::PlayerDisconnectEvent>(
+        [](ll::event::player::PlayerDisconnectEvent& event) {
+            // 玩家下线后移出余额缓存，并把写后模式的余额刷新到数据库
+            try {
+                EconomyManager::getInstance().evictPlayerBalances(event.self().getXuid());
+            } catch (const std::exception& e) {
+                ll::mod::NativeMod::current()->getLogger().error("处理玩家离开事件时发生异常: {}", e.what());
+            }
+        }
+    );
+
     logger.info("玩家事件监听器已注册");
 }
 
@@ -66,6 +80,11 @@ void PlayerEventListener::unregisterListeners() {
         eventBus.removeListener(gPlayerJoinListener);
         gPlayerJoinListener = nullptr;
     }
+    if (gPlayerDisconnectListener) {
+        auto& eventBus = ll::event::EventBus::getInstance();
+        eventBus.removeListener(gPlayerDisconnectListener);
+        gPlayerDisconnectListener = nullptr;
+    }
 }
 
 } // namespace rlx_money
@@ -0,0 +1,317 @@
+#include "mod/storage/LedgerSegment.h"
+#include "mod/exceptions/MoneyException.h"
+#include <algorithm>
+#include <cstring>
+#include <system_error>
+#include <type_traits>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace rlx_money {
+
+namespace {
+
+constexpr char     kLedgerMagic[8] = {'R', 'L', 'X', 'L', 'E', 'D', 'G', 'R'};
+constexpr uint32_t kLedgerVersion  = 1;
+
+// 条目内各字段的偏移（0-3 为校验和）
+constexpr size_t kKindOffset      = 4;
+constexpr size_t kTypeOffset      = 5;
+constexpr size_t kFlagsOffset     = 6;
+constexpr size_t kSequenceOffset  = 8;
+constexpr size_t kTimestampOffset = 16;
+constexpr size_t kExtraOffset     = 24; // Record 在此处保存 12 字节的转账ID
+constexpr size_t kAccountOffset   = 36;
+constexpr size_t kCurrencyOffset  = 40;
+constexpr size_t kTextOffset      = 44;
+constexpr size_t kRelatedOffset   = 48;
+constexpr size_t kAmountOffset    = 52;
+constexpr size_t kBalanceOffset   = 56;
+
+/// @brief 按小端序写入整数
+template <typename T>
+void storeLittle(char* out, T value) {
+    auto bits = static_cast<std::make_unsigned_t<T>>(value);
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        out[i] = static_cast<char>((bits >> (i * 8)) & 0xFF);
+    }
+}
+
+/// @brief 按小端序读取整数
+template <typename T>
+T loadLittle(const char* in) {
+    std::make_unsigned_t<T> bits = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        bits |= static_cast<std::make_unsigned_t<T>>(static_cast<unsigned char>(in[i])) << (i * 8);
+    }
+    return static_cast<T>(bits);
+}
+
+/// @brief 条目校验和（FNV-1a，覆盖校验和字段之后的全部字节）
+uint32_t entryChecksum(const char* data) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = kKindOffset; i < kLedgerEntrySize; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+} // namespace
+
+void encodeLedgerEntry(const LedgerEntry& entry, char* out) {
+    std::memset(out, 0, kLedgerEntrySize);
+    out[kKindOffset]  = static_cast<char>(entry.kind);
+    out[kTypeOffset]  = static_cast<char>(entry.type);
+    out[kFlagsOffset] = static_cast<char>(entry.flags);
+    storeLittle(out + kSequenceOffset, entry.sequence);
+    storeLittle(out + kTimestampOffset, entry.timestamp);
+    if (entry.kind == LedgerEntryKind::Record) {
+        std::memcpy(out + kExtraOffset, entry.transfer.data(), entry.transfer.size());
+    } else {
+        storeLittle(out + kExtraOffset, entry.extra);
+    }
+    storeLittle(out + kAccountOffset, entry.account);
+    storeLittle(out + kCurrencyOffset, entry.currency);
+    storeLittle(out + kTextOffset, entry.text);
+    storeLittle(out + kRelatedOffset, entry.related);
+    storeLittle(out + kAmountOffset, entry.amount);
+    storeLittle(out + kBalanceOffset, entry.balance);
+    storeLittle(out, entryChecksum(out));
+}
+
+std::optional<LedgerEntry> decodeLedgerEntry(const char* data) {
+    auto kind = static_cast<uint8_t>(data[kKindOffset]);
+    if (loadLittle<uint32_t>(data) != entryChecksum(data) || kind < static_cast<uint8_t>(LedgerEntryKind::Player)
+        || kind > static_cast<uint8_t>(LedgerEntryKind::Commit)) {
+        return std::nullopt;
+    }
+
+    LedgerEntry entry;
+    entry.kind      = static_cast<LedgerEntryKind>(kind);
+    entry.type      = static_cast<uint8_t>(data[kTypeOffset]);
+    entry.flags     = static_cast<uint8_t>(data[kFlagsOffset]);
+    entry.sequence  = loadLittle<int64_t>(data + kSequenceOffset);
+    entry.timestamp = loadLittle<int64_t>(data + kTimestampOffset);
+    if (entry.kind == LedgerEntryKind::Record) {
+        std::memcpy(entry.transfer.data(), data + kExtraOffset, entry.transfer.size());
+    } else {
+        entry.extra = loadLittle<int64_t>(data + kExtraOffset);
+    }
+    entry.account  = loadLittle<uint32_t>(data + kAccountOffset);
+    entry.currency = loadLittle<uint32_t>(data + kCurrencyOffset);
+    entry.text     = loadLittle<uint32_t>(data + kTextOffset);
+    entry.related  = loadLittle<uint32_t>(data + kRelatedOffset);
+    entry.amount   = loadLittle<int32_t>(data + kAmountOffset);
+    entry.balance  = loadLittle<int32_t>(data + kBalanceOffset);
+    return entry;
+}
+
+std::string encodeLedgerHeader(uint64_t id, uint32_t level) {
+    std::string header(kLedgerHeaderSize, '\0');
+    std::memcpy(header.data(), kLedgerMagic, sizeof(kLedgerMagic));
+    storeLittle(header.data() + 8, kLedgerVersion);
+    storeLittle(header.data() + 12, level);
+    storeLittle(header.data() + 16, id);
+    return header;
+}
+
+void syncLedgerFile(const std::filesystem::path& path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileW(
+        path.c_str(),
+        GENERIC_WRITE,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr
+    );
+    bool synced = file != INVALID_HANDLE_VALUE && FlushFileBuffers(file);
+    if (file != INVALID_HANDLE_VALUE) {
+        CloseHandle(file);
+    }
+#else
+    int  descriptor = ::open(path.c_str(), O_RDONLY);
+    bool synced     = descriptor >= 0 && ::fsync(descriptor) == 0;
+    if (descriptor >= 0) {
+        ::close(descriptor);
+    }
+#endif
+    if (!synced) {
+        throw DatabaseException("无法同步账本文件: " + path.string());
+    }
+}
+
+MappedFile::~MappedFile() { close(); }
+
+void MappedFile::open(const std::filesystem::path& path) {
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileW(
+        path.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr
+    );
+    if (file == INVALID_HANDLE_VALUE) {
+        throw DatabaseException("无法打开账本文件: " + path.string());
+    }
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        throw DatabaseException("无法读取账本文件大小: " + path.string());
+    }
+    if (size.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void*  view    = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (mapping != nullptr) {
+            CloseHandle(mapping);
+        }
+        if (view == nullptr) {
+            CloseHandle(file);
+            throw DatabaseException("无法映射账本文件: " + path.string());
+        }
+        mData = static_cast<const char*>(view);
+        mSize = static_cast<size_t>(size.QuadPart);
+    }
+    CloseHandle(file);
+#else
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        throw DatabaseException("无法打开账本文件: " + path.string());
+    }
+    struct stat status {};
+    if (::fstat(descriptor, &status) != 0) {
+        ::close(descriptor);
+        throw DatabaseException("无法读取账本文件大小: " + path.string());
+    }
+    if (status.st_size > 0) {
+        void* view = ::mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_SHARED, descriptor, 0);
+        if (view == MAP_FAILED) {
+            ::close(descriptor);
+            throw DatabaseException("无法映射账本文件: " + path.string());
+        }
+        mData = static_cast<const char*>(view);
+        mSize = static_cast<size_t>(status.st_size);
+    }
+    ::close(descriptor);
+#endif
+}
+
+void MappedFile::close() {
+    if (mData != nullptr) {
+#ifdef _WIN32
+        UnmapViewOfFile(mData);
+#else
+        ::munmap(const_cast<char*>(mData), mSize);
+#endif
+    }
+    mData = nullptr;
+    mSize = 0;
+}
+
+LedgerSegment::~LedgerSegment() {
+    mFile.close();
+    if (mObsolete) {
+        std::error_code error;
+        std::filesystem::remove(mPath, error);
+    }
+}
+
+std::shared_ptr<LedgerSegment> LedgerSegment::open(const std::filesystem::path& path, bool recoverTail) {
+    std::shared_ptr<LedgerSegment> segment(new LedgerSegment());
+    segment->mPath = path;
+    segment->mFile.open(path);
+
+    const char* data = segment->mFile.data();
+    size_t      size = segment->mFile.size();
+    if (size < kLedgerHeaderSize || std::memcmp(data, kLedgerMagic, sizeof(kLedgerMagic)) != 0
+        || loadLittle<uint32_t>(data + 8) != kLedgerVersion) {
+        throw DatabaseException("账本分段文件头无效: " + path.string());
+    }
+    segment->mLevel = loadLittle<uint32_t>(data + 12);
+    segment->mId    = loadLittle<uint64_t>(data + 16);
+
+    // 有效内容止于最后一个提交标记；之后的条目属于写到一半的事务
+    size_t total     = (size - kLedgerHeaderSize) / kLedgerEntrySize;
+    size_t committed = 0;
+    for (size_t i = 0; i < total; ++i) {
+        auto entry = decodeLedgerEntry(data + kLedgerHeaderSize + i * kLedgerEntrySize);
+        if (!entry) {
+            break;
+        }
+        if (entry->kind == LedgerEntryKind::Commit) {
+            committed = i + 1;
+        }
+    }
+    size_t validSize = kLedgerHeaderSize + committed * kLedgerEntrySize;
+    if (validSize != size) {
+        if (!recoverTail) {
+            throw DatabaseException("账本分段已损坏: " + path.string());
+        }
+        segment->mFile.close();
+        std::filesystem::resize_file(path, validSize);
+        segment->mFile.open(path);
+        data = segment->mFile.data();
+    }
+    segment->mEntryCount = committed;
+
+    // 稀疏索引：只读取类型与玩家字段，不解码整个条目
+    for (size_t i = 0; i < committed; ++i) {
+        const char* raw = data + kLedgerHeaderSize + i * kLedgerEntrySize;
+        if (static_cast<LedgerEntryKind>(raw[kKindOffset]) != LedgerEntryKind::Record) {
+            continue;
+        }
+        auto& blocks = segment->mBlocks[loadLittle<uint32_t>(raw + kAccountOffset)];
+        auto  block  = static_cast<uint32_t>(i / kLedgerBlockEntries);
+        if (blocks.empty() || blocks.back() != block) {
+            blocks.push_back(block);
+        }
+    }
+    return segment;
+}
+
+LedgerEntry LedgerSegment::entryAt(size_t index) const {
+    auto entry = decodeLedgerEntry(mFile.data() + kLedgerHeaderSize + index * kLedgerEntrySize);
+    if (!entry) {
+        throw DatabaseException("账本分段已损坏: " + mPath.string());
+    }
+    return *entry;
+}
+
+void LedgerSegment::forEachEntry(const std::function<void(const LedgerEntry&)>& visit) const {
+    for (size_t i = 0; i < mEntryCount; ++i) {
+        visit(entryAt(i));
+    }
+}
+
+void LedgerSegment::forEachRecord(uint32_t account, const std::function<void(const LedgerEntry&)>& visit) const {
+    auto it = mBlocks.find(account);
+    if (it == mBlocks.end()) {
+        return;
+    }
+    for (uint32_t block : it->second) {
+        size_t end = std::min(mEntryCount, static_cast<size_t>(block + 1) * kLedgerBlockEntries);
+        for (size_t i = static_cast<size_t>(block) * kLedgerBlockEntries; i < end; ++i) {
+            const char* raw = mFile.data() + kLedgerHeaderSize + i * kLedgerEntrySize;
+            if (static_cast<LedgerEntryKind>(raw[kKindOffset]) == LedgerEntryKind::Record
+                && loadLittle<uint32_t>(raw + kAccountOffset) == account) {
+                visit(entryAt(i));
+            }
+        }
+    }
+}
+
+} // namespace rlx_money
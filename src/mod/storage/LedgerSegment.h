@@ -0,0 +1,150 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace rlx_money {
+
+/// @brief 账本条目类型
+enum class LedgerEntryKind : uint8_t {
+    Player     = 1, // 玩家信息（创建或修改用户名时写入完整信息）
+    Balance    = 2, // 余额的最新值
+    Record     = 3, // 交易记录
+    Checkpoint = 4, // 重做日志检查点
+    Archive    = 5, // 归档标记：记录ID不大于 sequence 且时间早于 timestamp 的记录视为已归档
+    Commit     = 6, // 提交标记：之前的条目均属于已提交的事务
+};
+
+/// @brief 账本条目的标志位
+enum LedgerEntryFlags : uint8_t {
+    kLedgerTransferPacked = 0x01, // transfer 为压缩的 12 字节转账ID
+    kLedgerTransferText   = 0x02, // transfer 前 4 字节为转账ID文本在字符串表中的编号
+    kLedgerHasRelated     = 0x04, // related 有效（关联玩家XUID可能为空字符串）
+};
+
+/// @brief 账本条目（磁盘上固定为 kLedgerEntrySize 字节，字符串字段保存为字符串表中的编号，0 表示空）
+/// @note 各类型使用的字段：
+///       Player：account、text（用户名）、timestamp（创建时间）、sequence（更新时间）、extra（首次加入时间）；
+///       Balance：account、currency、balance、timestamp（更新时间）；
+///       Record：sequence（记录ID）及其余全部字段；Checkpoint：sequence；Archive：sequence、timestamp
+struct LedgerEntry {
+    LedgerEntryKind               kind      = LedgerEntryKind::Commit;
+    uint8_t                       type      = 0; // 交易类型
+    uint8_t                       flags     = 0; // LedgerEntryFlags
+    int64_t                       sequence  = 0;
+    int64_t                       timestamp = 0;
+    int64_t                       extra     = 0; // 与 transfer 共用磁盘空间，Record 以外的类型使用
+    std::array<unsigned char, 12> transfer{};    // 转账ID，仅 Record 使用
+    uint32_t                      account   = 0; // 玩家XUID
+    uint32_t                      currency  = 0; // 币种ID
+    uint32_t                      text      = 0; // 用户名或交易描述
+    uint32_t                      related   = 0; // 关联玩家XUID
+    int32_t                       amount    = 0; // 交易金额
+    int32_t                       balance   = 0; // 余额或交易后余额
+};
+
+constexpr size_t kLedgerEntrySize    = 64;  // 条目大小（字节）
+constexpr size_t kLedgerHeaderSize   = 64;  // 分段文件头大小（字节），条目从文件头之后开始
+constexpr size_t kLedgerBlockEntries = 128; // 稀疏索引的块大小（条目数）
+
+/// @brief 编码账本条目
+/// @param entry 条目
+/// @param out 输出位置（kLedgerEntrySize 字节）
+void encodeLedgerEntry(const LedgerEntry& entry, char* out);
+
+/// @brief 解码账本条目
+/// @param data 条目数据（kLedgerEntrySize 字节）
+/// @return 条目；校验和不符或类型无效时返回空
+std::optional<LedgerEntry> decodeLedgerEntry(const char* data);
+
+/// @brief 编码分段文件头
+/// @param id 分段编号
+/// @param level 合并层级（新写入的分段为 0，每合并一次加 1）
+std::string encodeLedgerHeader(uint64_t id, uint32_t level);
+
+/// @brief 把文件内容同步到磁盘
+/// @throw DatabaseException 同步失败时
+void syncLedgerFile(const std::filesystem::path& path);
+
+/// @brief 以只读方式映射到内存的文件
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /// @brief 映射整个文件（映射建立后不再持有文件句柄）
+    /// @throw DatabaseException 无法打开或映射文件时
+    void open(const std::filesystem::path& path);
+
+    /// @brief 解除映射
+    void close();
+
+    [[nodiscard]] const char* data() const { return mData; }
+    [[nodiscard]] size_t      size() const { return mSize; }
+
+private:
+    const char* mData = nullptr;
+    size_t      mSize = 0;
+};
+
+/// @brief 已封存的账本分段（只读，通过内存映射访问）
+/// @note 打开时校验全部条目并按块建立稀疏索引：记录每名玩家的交易记录出现在哪些块中，
+///       查询玩家历史时只扫描这些块。合并后的分段按玩家聚集，每名玩家通常只占一两个块
+class LedgerSegment {
+public:
+    ~LedgerSegment();
+
+    LedgerSegment(const LedgerSegment&)            = delete;
+    LedgerSegment& operator=(const LedgerSegment&) = delete;
+
+    /// @brief 打开分段
+    /// @param path 分段文件路径
+    /// @param recoverTail 是否截掉最后一个提交标记之后的条目（进程中断时未写完的事务）
+    /// @return 分段
+    /// @throw DatabaseException 文件头无效，或不允许截断时存在未提交的条目
+    static std::shared_ptr<LedgerSegment> open(const std::filesystem::path& path, bool recoverTail);
+
+    [[nodiscard]] uint64_t                     getId() const { return mId; }
+    [[nodiscard]] uint32_t                     getLevel() const { return mLevel; }
+    [[nodiscard]] size_t                       getEntryCount() const { return mEntryCount; }
+    [[nodiscard]] const std::filesystem::path& getPath() const { return mPath; }
+
+    /// @brief 读取条目
+    /// @param index 条目序号（小于 getEntryCount()）
+    [[nodiscard]] LedgerEntry entryAt(size_t index) const;
+
+    /// @brief 按顺序遍历全部条目
+    void forEachEntry(const std::function<void(const LedgerEntry&)>& visit) const;
+
+    /// @brief 遍历玩家的交易记录（按写入顺序）
+    /// @param account 玩家XUID在字符串表中的编号
+    void forEachRecord(uint32_t account, const std::function<void(const LedgerEntry&)>& visit) const;
+
+    /// @brief 标记为已被合并，最后一个引用释放时删除文件
+    void markObsolete() { mObsolete = true; }
+
+private:
+    LedgerSegment() = default;
+
+    std::filesystem::path                               mPath;
+    MappedFile                                          mFile;
+    uint64_t                                            mId         = 0;
+    uint32_t                                            mLevel      = 0;
+    size_t                                              mEntryCount = 0;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> mBlocks; // 玩家 -> 含其交易记录的块
+    bool                                                mObsolete   = false;
+};
+
+} // namespace rlx_money
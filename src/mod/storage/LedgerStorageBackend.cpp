@@ -0,0 +1,829 @@
+#include "mod/storage/LedgerStorageBackend.h"
+#include "mod/config/ConfigStructures.h"
+#include "mod/exceptions/MoneyException.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <iterator>
+#include <map>
+#include <set>
+#include <tuple>
+
+
+namespace rlx_money {
+
+namespace {
+
+constexpr std::string_view kStringsFile  = "strings.dat";
+constexpr std::string_view kManifestFile = "MANIFEST";
+
+int64_t currentTimestamp() {
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+void storeUint32(unsigned char* out, uint32_t value) {
+    for (size_t i = 0; i < 4; ++i) {
+        out[i] = static_cast<unsigned char>((value >> (i * 8)) & 0xFF);
+    }
+}
+
+uint32_t loadUint32(const unsigned char* in) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        value |= static_cast<uint32_t>(in[i]) << (i * 8);
+    }
+    return value;
+}
+
+std::filesystem::path segmentPath(const std::filesystem::path& directory, uint64_t id) {
+    std::string name = std::to_string(id);
+    name.insert(0, name.size() < 6 ? 6 - name.size() : 0, '0');
+    return directory / ("segment-" + name + ".log");
+}
+
+/// @brief 从分段文件名解析分段编号
+std::optional<uint64_t> parseSegmentId(const std::string& name) {
+    constexpr std::string_view prefix = "segment-";
+    constexpr std::string_view suffix = ".log";
+    if (name.size() <= prefix.size() + suffix.size() || !name.starts_with(prefix) || !name.ends_with(suffix)) {
+        return std::nullopt;
+    }
+    uint64_t    id    = 0;
+    const char* begin = name.data() + prefix.size();
+    const char* end   = name.data() + name.size() - suffix.size();
+    auto [ptr, error] = std::from_chars(begin, end, id);
+    if (error != std::errc() || ptr != end) {
+        return std::nullopt;
+    }
+    return id;
+}
+
+/// @brief 编码一组条目并在末尾追加提交标记
+std::string encodeCommitted(const LedgerEntry* entries, size_t count) {
+    std::string buffer((count + 1) * kLedgerEntrySize, '\0');
+    for (size_t i = 0; i < count; ++i) {
+        encodeLedgerEntry(entries[i], buffer.data() + i * kLedgerEntrySize);
+    }
+    encodeLedgerEntry(LedgerEntry{}, buffer.data() + count * kLedgerEntrySize);
+    return buffer;
+}
+
+/// @brief 追加写入文件；失败时截回写入前的长度，文件末尾不会残留不完整的内容
+/// @param size 写入前的文件长度，成功后加上写入的字节数
+/// @throw DatabaseException 写入失败时
+void appendToFile(
+    std::ofstream&               stream,
+    const std::filesystem::path& path,
+    uint64_t&                    size,
+    std::string_view             data,
+    bool                         flush
+) {
+    stream.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (flush) {
+        stream.flush();
+    }
+    if (!stream) {
+        stream.close();
+        std::error_code error;
+        std::filesystem::resize_file(path, size, error);
+        stream.open(path, std::ios::binary | std::ios::app);
+        throw DatabaseException("无法写入账本文件: " + path.string());
+    }
+    size += data.size();
+}
+
+} // namespace
+
+LedgerStorageBackend::~LedgerStorageBackend() { close(); }
+
+std::filesystem::path LedgerStorageBackend::directoryFor(const std::string& databasePath) {
+    std::filesystem::path directory(databasePath);
+    directory.replace_extension(".ledger");
+    return directory;
+}
+
+bool LedgerStorageBackend::open(const DatabaseConfig& config) {
+    std::lock_guard lock(mMutex);
+    if (isOpen()) {
+        return true;
+    }
+
+    mDirectory = directoryFor(config.path);
+    mSegmentEntries =
+        (static_cast<size_t>(config.ledgerSegmentKB) * 1024 - kLedgerHeaderSize) / kLedgerEntrySize;
+    mCompactThreshold = static_cast<size_t>(config.ledgerCompactSegments);
+    mGroupCommit      = config.groupCommit;
+    try {
+        std::filesystem::create_directories(mDirectory);
+        loadStrings();
+        loadSegments();
+        if (!mActiveStream.is_open()) {
+            openActiveSegment();
+        }
+    } catch (const std::exception& e) {
+        close();
+        throw DatabaseException("无法打开账本: " + std::string(e.what()));
+    }
+
+    MemoryStorageBackend::open(config);
+    scheduleCompaction();
+    return true;
+}
+
+void LedgerStorageBackend::close() {
+    {
+        std::lock_guard lock(mMutex);
+        mStopping = true;
+    }
+    waitForCompaction();
+
+    std::lock_guard lock(mMutex);
+    mStopping = false;
+    mStringStream.close();
+    if (mActiveStream.is_open()) {
+        mActiveStream.close();
+        // 没有写入任何条目的分段不保留；打开失败时不改动 MANIFEST
+        if (isOpen() && mActiveFileEntries == 0) {
+            std::error_code error;
+            std::filesystem::remove(segmentPath(mDirectory, mActiveId), error);
+            try {
+                writeManifest(false);
+            } catch (const std::exception&) {
+                // MANIFEST 仍列出该分段时下次打开会重新创建，不影响数据
+            }
+        }
+    }
+
+    mStrings.clear();
+    mStringIds.clear();
+    mPendingStrings.clear();
+    mStringsSize = 0;
+    mSegments.clear();
+    mNextSegmentId = 1;
+    mActiveId      = 0;
+    mActiveSize    = 0;
+    mActiveEntries.clear();
+    mActiveWritten     = 0;
+    mActiveFileEntries = 0;
+    mActiveRecords.clear();
+    mArchiveMarkers.clear();
+    mRecordCounts.clear();
+    mCommittedRecordId = 0;
+    MemoryStorageBackend::close();
+}
+
+void LedgerStorageBackend::flushCommits() {
+    std::lock_guard lock(mMutex);
+    if (mGroupCommit && mActiveStream.is_open()) {
+        mActiveStream.flush();
+        if (!mActiveStream) {
+            throw DatabaseException("无法写入账本文件: " + segmentPath(mDirectory, mActiveId).string());
+        }
+    }
+}
+
+std::string LedgerStorageBackend::getJournalBasePath() const {
+    std::lock_guard lock(mMutex);
+    return mDirectory.empty() ? std::string() : (mDirectory / "money.redo").string();
+}
+
+// ==================== 字符串表 ====================
+
+void LedgerStorageBackend::loadStrings() {
+    auto path = mDirectory / kStringsFile;
+    mStrings.assign(1, std::string());
+    mStringIds.clear();
+
+    std::string content;
+    if (std::ifstream input{path, std::ios::binary}) {
+        content.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    }
+    size_t offset = 0;
+    while (content.size() - offset >= 4) {
+        uint32_t length = loadUint32(reinterpret_cast<const unsigned char*>(content.data() + offset));
+        if (content.size() - offset - 4 < length) {
+            break;
+        }
+        mStringIds.emplace(content.substr(offset + 4, length), static_cast<uint32_t>(mStrings.size()));
+        mStrings.push_back(content.substr(offset + 4, length));
+        offset += 4 + length;
+    }
+    // 字符串总在引用它的条目之前写入，末尾写到一半的字符串不会被任何已提交的条目引用
+    if (offset != content.size()) {
+        std::filesystem::resize_file(path, offset);
+    }
+    mStringsSize = offset;
+
+    mStringStream.open(path, std::ios::binary | std::ios::app);
+    if (!mStringStream) {
+        throw DatabaseException("无法打开账本字符串表: " + path.string());
+    }
+}
+
+uint32_t LedgerStorageBackend::intern(std::string_view text) {
+    if (text.empty()) {
+        return 0;
+    }
+    auto it = mStringIds.find(std::string(text));
+    if (it != mStringIds.end()) {
+        return it->second;
+    }
+    // 回滚的事务新增的字符串同样保留，之后的写入可以继续使用
+    auto id = static_cast<uint32_t>(mStrings.size());
+    mStrings.emplace_back(text);
+    mStringIds.emplace(mStrings.back(), id);
+    unsigned char length[4];
+    storeUint32(length, static_cast<uint32_t>(text.size()));
+    mPendingStrings.append(reinterpret_cast<const char*>(length), sizeof(length));
+    mPendingStrings.append(text);
+    return id;
+}
+
+std::optional<uint32_t> LedgerStorageBackend::findString(const std::string& text) const {
+    auto it = mStringIds.find(text);
+    if (it == mStringIds.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+const std::string& LedgerStorageBackend::lookup(uint32_t id) const {
+    if (id >= mStrings.size()) {
+        throw DatabaseException("账本字符串表已损坏: 编号 " + std::to_string(id) + " 不存在");
+    }
+    return mStrings[id];
+}
+
+// ==================== 分段 ====================
+
+void LedgerStorageBackend::loadSegments() {
+    std::map<uint64_t, std::filesystem::path> files;
+    for (const auto& item : std::filesystem::directory_iterator(mDirectory)) {
+        if (auto id = parseSegmentId(item.path().filename().string())) {
+            files.emplace(*id, item.path());
+        }
+    }
+
+    // MANIFEST 按重放顺序列出有效的分段；没有 MANIFEST 时按编号顺序使用全部分段
+    std::vector<uint64_t> order;
+    if (std::ifstream manifest{mDirectory / kManifestFile}) {
+        for (uint64_t id = 0; manifest >> id;) {
+            order.push_back(id);
+        }
+    } else {
+        for (const auto& [id, path] : files) {
+            order.push_back(id);
+        }
+    }
+    for (uint64_t id : order) {
+        mNextSegmentId = std::max(mNextSegmentId, id + 1);
+    }
+    if (!files.empty()) {
+        mNextSegmentId = std::max(mNextSegmentId, files.rbegin()->first + 1);
+    }
+
+    // 未列出的分段是已合并的输入或未完成的合并输出
+    std::set<uint64_t> listed(order.begin(), order.end());
+    for (const auto& [id, path] : files) {
+        if (!listed.contains(id)) {
+            std::filesystem::remove(path);
+        }
+    }
+
+    // 只有最后一个分段可能以未写完的事务结尾
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (!files.contains(order[i])) {
+            throw DatabaseException("账本分段缺失: " + segmentPath(mDirectory, order[i]).string());
+        }
+        mSegments.push_back(LedgerSegment::open(files[order[i]], i + 1 == order.size()));
+    }
+
+    // 先重放全部条目再统计记录数：归档标记可能位于它覆盖的记录之后
+    for (const auto& segment : mSegments) {
+        segment->forEachEntry([this](const LedgerEntry& entry) { replay(entry); });
+    }
+    mCommittedRecordId = mLastRecordId;
+
+    // 最后一个未合并过的分段继续作为当前分段追加写入
+    if (!mSegments.empty() && mSegments.back()->getLevel() == 0) {
+        auto tail = std::move(mSegments.back());
+        mSegments.pop_back();
+        mActiveId = tail->getId();
+        tail->forEachEntry([this](const LedgerEntry& entry) {
+            if (entry.kind == LedgerEntryKind::Record) {
+                mActiveRecords[entry.account].push_back(static_cast<uint32_t>(mActiveEntries.size()));
+            }
+            if (entry.kind != LedgerEntryKind::Commit && entry.kind != LedgerEntryKind::Archive) {
+                mActiveEntries.push_back(entry);
+            }
+        });
+        mActiveWritten     = mActiveEntries.size();
+        mActiveFileEntries = tail->getEntryCount();
+        mActiveSize        = kLedgerHeaderSize + tail->getEntryCount() * kLedgerEntrySize;
+        auto path          = tail->getPath();
+        tail.reset(); // 先解除映射再以追加方式打开
+        mActiveStream.open(path, std::ios::binary | std::ios::app);
+        if (!mActiveStream) {
+            throw DatabaseException("无法打开账本分段: " + path.string());
+        }
+    }
+
+    forEachStoredRecord([this](const LedgerEntry& entry) {
+        if (!isArchived(entry)) {
+            ++mRecordCounts[entry.account];
+        }
+    });
+}
+
+void LedgerStorageBackend::replay(const LedgerEntry& entry) {
+    switch (entry.kind) {
+    case LedgerEntryKind::Player: {
+        PlayerData player(lookup(entry.account), lookup(entry.text), entry.extra);
+        player.createdAt      = entry.timestamp;
+        player.updatedAt      = entry.sequence;
+        mPlayers[player.xuid] = std::move(player);
+        break;
+    }
+    case LedgerEntryKind::Balance: {
+        const auto& currencyId  = lookup(entry.currency);
+        auto&       row         = mBalances[currencyId][lookup(entry.account)];
+        mWealth[currencyId]    += static_cast<int64_t>(entry.balance) - row.balance;
+        row                     = BalanceRow{entry.balance, entry.timestamp};
+        break;
+    }
+    case LedgerEntryKind::Record:
+        mLastRecordId = std::max(mLastRecordId, entry.sequence);
+        break;
+    case LedgerEntryKind::Checkpoint:
+        mCheckpoint = static_cast<uint64_t>(entry.sequence);
+        break;
+    case LedgerEntryKind::Archive:
+        mArchiveMarkers.emplace_back(entry.timestamp, entry.sequence);
+        break;
+    case LedgerEntryKind::Commit:
+        break;
+    }
+}
+
+void LedgerStorageBackend::openActiveSegment() {
+    mActiveId   = mNextSegmentId++;
+    auto path   = segmentPath(mDirectory, mActiveId);
+    auto header = encodeLedgerHeader(mActiveId, 0);
+    mActiveStream.open(path, std::ios::binary | std::ios::trunc);
+    mActiveStream.write(header.data(), static_cast<std::streamsize>(header.size()));
+    mActiveStream.flush();
+    if (!mActiveStream) {
+        mActiveStream.close();
+        throw DatabaseException("无法创建账本分段: " + path.string());
+    }
+    try {
+        writeManifest(true);
+    } catch (...) {
+        // MANIFEST 没有列出的分段会在打开时被删除，不能继续写入
+        mActiveStream.close();
+        std::error_code ignored;
+        std::filesystem::remove(path, ignored);
+        throw;
+    }
+    mActiveSize = header.size();
+}
+
+void LedgerStorageBackend::sealActiveSegment() {
+    auto path     = segmentPath(mDirectory, mActiveId);
+    auto sealedId = mActiveId;
+    mActiveStream.close();
+    std::shared_ptr<LedgerSegment> segment;
+    try {
+        // 分段引用的字符串先于分段落盘，分段落盘后才写入 MANIFEST
+        syncLedgerFile(mDirectory / kStringsFile);
+        syncLedgerFile(path);
+        segment = LedgerSegment::open(path, false);
+    } catch (...) {
+        mActiveStream.open(path, std::ios::binary | std::ios::app);
+        throw;
+    }
+
+    mSegments.push_back(std::move(segment));
+    try {
+        openActiveSegment();
+    } catch (...) {
+        // 新分段没有写入 MANIFEST，继续追加到 MANIFEST 中列出的当前分段
+        mSegments.pop_back();
+        mActiveId = sealedId;
+        mActiveStream.open(path, std::ios::binary | std::ios::app);
+        throw;
+    }
+    mActiveEntries.clear();
+    mActiveWritten     = 0;
+    mActiveFileEntries = 0;
+    mActiveRecords.clear();
+    scheduleCompaction();
+}
+
+void LedgerStorageBackend::writeManifest(bool includeActive) {
+    auto path      = mDirectory / kManifestFile;
+    auto temporary = mDirectory / (std::string(kManifestFile) + ".tmp");
+    {
+        std::ofstream output(temporary, std::ios::trunc);
+        for (const auto& segment : mSegments) {
+            output << segment->getId() << '\n';
+        }
+        if (includeActive) {
+            output << mActiveId << '\n';
+        }
+        output.flush();
+        if (!output) {
+            throw DatabaseException("无法写入账本清单: " + temporary.string());
+        }
+    }
+    syncLedgerFile(temporary);
+    std::filesystem::rename(temporary, path);
+}
+
+// ==================== 写入 ====================
+
+void LedgerStorageBackend::pushEntry(const LedgerEntry& entry) {
+    if (entry.kind == LedgerEntryKind::Record) {
+        mActiveRecords[entry.account].push_back(static_cast<uint32_t>(mActiveEntries.size()));
+    }
+    mActiveEntries.push_back(entry);
+    recordUndo([this]() {
+        if (mActiveEntries.back().kind == LedgerEntryKind::Record) {
+            mActiveRecords[mActiveEntries.back().account].pop_back();
+        }
+        mActiveEntries.pop_back();
+    });
+}
+
+void LedgerStorageBackend::onPlayerWritten(const PlayerData& player) {
+    LedgerEntry entry;
+    entry.kind      = LedgerEntryKind::Player;
+    entry.account   = intern(player.xuid);
+    entry.text      = intern(player.username);
+    entry.timestamp = player.createdAt;
+    entry.sequence  = player.updatedAt;
+    entry.extra     = player.firstJoinTime;
+    pushEntry(entry);
+}
+
+void LedgerStorageBackend::onBalanceWritten(
+    const std::string& xuid,
+    const std::string& currencyId,
+    const BalanceRow&  row
+) {
+    LedgerEntry entry;
+    entry.kind      = LedgerEntryKind::Balance;
+    entry.account   = intern(xuid);
+    entry.currency  = intern(currencyId);
+    entry.balance   = row.balance;
+    entry.timestamp = row.updatedAt;
+    pushEntry(entry);
+}
+
+void LedgerStorageBackend::onCheckpointWritten(uint64_t sequence) {
+    LedgerEntry entry;
+    entry.kind     = LedgerEntryKind::Checkpoint;
+    entry.sequence = static_cast<int64_t>(sequence);
+    pushEntry(entry);
+}
+
+void LedgerStorageBackend::storeRecord(TransactionRecord record) {
+    LedgerEntry entry;
+    entry.kind      = LedgerEntryKind::Record;
+    entry.type      = static_cast<uint8_t>(record.type);
+    entry.sequence  = record.id;
+    entry.timestamp = record.timestamp;
+    entry.account   = intern(record.xuid);
+    entry.currency  = intern(record.currencyId);
+    entry.text      = intern(record.description);
+    entry.amount    = record.amount;
+    entry.balance   = record.balance;
+    if (record.relatedXuid) {
+        entry.flags   |= kLedgerHasRelated;
+        entry.related  = intern(*record.relatedXuid);
+    }
+    if (record.transferId) {
+        if (auto packed = packTransferId(*record.transferId)) {
+            entry.flags    |= kLedgerTransferPacked;
+            entry.transfer  = *packed;
+        } else {
+            entry.flags |= kLedgerTransferText;
+            storeUint32(entry.transfer.data(), intern(*record.transferId));
+        }
+    }
+    pushEntry(entry);
+
+    ++mRecordCounts[entry.account];
+    recordUndo([this, account = entry.account]() { --mRecordCounts[account]; });
+}
+
+void LedgerStorageBackend::commitWrites() {
+    if (mActiveEntries.size() == mActiveWritten) {
+        return;
+    }
+
+    // 字符串先于引用它的条目写入文件
+    if (!mPendingStrings.empty()) {
+        appendToFile(mStringStream, mDirectory / kStringsFile, mStringsSize, mPendingStrings, true);
+        mPendingStrings.clear();
+    }
+    size_t count  = mActiveEntries.size() - mActiveWritten;
+    auto   buffer = encodeCommitted(mActiveEntries.data() + mActiveWritten, count);
+    appendToFile(mActiveStream, segmentPath(mDirectory, mActiveId), mActiveSize, buffer, !mGroupCommit);
+    mActiveWritten      = mActiveEntries.size();
+    mActiveFileEntries += count + 1;
+    mCommittedRecordId  = mLastRecordId;
+
+    if (mActiveFileEntries >= mSegmentEntries) {
+        try {
+            sealActiveSegment();
+        } catch (const std::exception&) {
+            // 事务已经写入，封存失败时继续写入当前分段，下次提交时重试
+        }
+    }
+}
+
+void LedgerStorageBackend::writeCommitted(const std::vector<LedgerEntry>& entries) {
+    auto buffer = encodeCommitted(entries.data(), entries.size());
+    appendToFile(mActiveStream, segmentPath(mDirectory, mActiveId), mActiveSize, buffer, true);
+    mActiveFileEntries += entries.size() + 1;
+}
+
+// ==================== 交易记录 ====================
+
+bool LedgerStorageBackend::isArchived(const LedgerEntry& entry) const {
+    return std::any_of(mArchiveMarkers.begin(), mArchiveMarkers.end(), [&](const auto& marker) {
+        return entry.timestamp < marker.first && entry.sequence <= marker.second;
+    });
+}
+
+TransactionRecord LedgerStorageBackend::toRecord(const LedgerEntry& entry) const {
+    TransactionRecord record;
+    record.id          = entry.sequence;
+    record.xuid        = lookup(entry.account);
+    record.currencyId  = lookup(entry.currency);
+    record.amount      = entry.amount;
+    record.balance     = entry.balance;
+    record.type        = static_cast<TransactionType>(entry.type);
+    record.description = lookup(entry.text);
+    record.timestamp   = entry.timestamp;
+    if (entry.flags & kLedgerHasRelated) {
+        record.relatedXuid = lookup(entry.related);
+    }
+    if (entry.flags & kLedgerTransferPacked) {
+        record.transferId = unpackTransferId(entry.transfer.data(), entry.transfer.size());
+    } else if (entry.flags & kLedgerTransferText) {
+        record.transferId = lookup(loadUint32(entry.transfer.data()));
+    }
+    return record;
+}
+
+void LedgerStorageBackend::forEachStoredRecord(const std::function<void(const LedgerEntry&)>& visit) const {
+    for (const auto& segment : mSegments) {
+        segment->forEachEntry([&](const LedgerEntry& entry) {
+            if (entry.kind == LedgerEntryKind::Record) {
+                visit(entry);
+            }
+        });
+    }
+    for (const auto& entry : mActiveEntries) {
+        if (entry.kind == LedgerEntryKind::Record) {
+            visit(entry);
+        }
+    }
+}
+
+void LedgerStorageBackend::forEachRecord(
+    const std::string&                                   xuid,
+    bool                                                 includeArchived,
+    const std::function<void(const TransactionRecord&)>& visit
+) const {
+    auto account = findString(xuid);
+    if (!account) {
+        return;
+    }
+    auto visitEntry = [&](const LedgerEntry& entry) {
+        if (includeArchived || !isArchived(entry)) {
+            visit(toRecord(entry));
+        }
+    };
+    for (const auto& segment : mSegments) {
+        segment->forEachRecord(*account, visitEntry);
+    }
+    if (auto it = mActiveRecords.find(*account); it != mActiveRecords.end()) {
+        for (uint32_t index : it->second) {
+            visitEntry(mActiveEntries[index]);
+        }
+    }
+}
+
+int LedgerStorageBackend::getPlayerTransactionCount(const std::string& xuid) const {
+    std::lock_guard lock(mMutex);
+    auto            account = findString(xuid);
+    if (!account) {
+        return 0;
+    }
+    auto it = mRecordCounts.find(*account);
+    return it != mRecordCounts.end() ? it->second : 0;
+}
+
+int64_t LedgerStorageBackend::archiveOldTransactions(int daysToKeep, std::stop_token /*stopToken*/) {
+    if (daysToKeep < 1) {
+        throw InvalidArgumentException("保留天数必须大于 0");
+    }
+    int64_t cutoffTime = currentTimestamp() - static_cast<int64_t>(daysToKeep) * 24 * 60 * 60;
+
+    // 归档只追加一个标记：记录ID不大于已提交的最大ID且早于截止时间的记录此后视为已归档。
+    // 与其他后端一样独立生效，不随所在事务回滚
+    std::lock_guard                   lock(mMutex);
+    std::unordered_map<uint32_t, int> archivedCounts;
+    int64_t                           archived = 0;
+    forEachStoredRecord([&](const LedgerEntry& entry) {
+        if (entry.sequence <= mCommittedRecordId && entry.timestamp < cutoffTime && !isArchived(entry)) {
+            ++archivedCounts[entry.account];
+            ++archived;
+        }
+    });
+    if (archived == 0) {
+        return 0;
+    }
+
+    LedgerEntry marker;
+    marker.kind      = LedgerEntryKind::Archive;
+    marker.sequence  = mCommittedRecordId;
+    marker.timestamp = cutoffTime;
+    writeCommitted({marker});
+    mArchiveMarkers.emplace_back(cutoffTime, mCommittedRecordId);
+    for (const auto& [account, count] : archivedCounts) {
+        mRecordCounts[account] -= count;
+    }
+    return archived;
+}
+
+// ==================== 合并 ====================
+
+void LedgerStorageBackend::scheduleCompaction() {
+    if (mCompacting || mStopping || !pickCompaction()) {
+        return;
+    }
+    if (mCompactionThread.joinable()) {
+        mCompactionThread.join(); // 上一个后台线程已经退出循环
+    }
+    mCompacting       = true;
+    mCompactionThread = std::thread([this]() { runCompactions(); });
+}
+
+std::optional<LedgerStorageBackend::CompactionPlan> LedgerStorageBackend::pickCompaction() {
+    std::optional<CompactionPlan> plan;
+    for (size_t begin = 0, end = 0; begin < mSegments.size(); begin = end) {
+        uint32_t level = mSegments[begin]->getLevel();
+        for (end = begin + 1; end < mSegments.size() && mSegments[end]->getLevel() == level; ++end) {}
+        if (end - begin < mCompactThreshold || (plan && plan->inputs.front()->getLevel() <= level)) {
+            continue;
+        }
+        plan.emplace();
+        plan->inputs.assign(mSegments.begin() + begin, mSegments.begin() + end);
+    }
+    return plan;
+}
+
+void LedgerStorageBackend::runCompactions() {
+    while (true) {
+        std::optional<CompactionPlan> plan;
+        {
+            std::lock_guard lock(mMutex);
+            if (!mStopping) {
+                plan = pickCompaction();
+            }
+            if (!plan) {
+                mCompacting = false;
+                return;
+            }
+            plan->outputId = mNextSegmentId++;
+        }
+
+        try {
+            compact(*plan);
+        } catch (const std::exception&) {
+            // 合并失败不影响已有分段，删除未完成的输出，下次封存分段时重试
+            std::error_code error;
+            std::filesystem::remove(segmentPath(mDirectory, plan->outputId), error);
+            std::lock_guard lock(mMutex);
+            mCompacting = false;
+            return;
+        }
+    }
+}
+
+void LedgerStorageBackend::compact(const CompactionPlan& plan) {
+    // 输入分段只读，合并期间不持有锁，完成后再替换到分段列表中
+    std::map<std::pair<uint32_t, uint32_t>, LedgerEntry> balances; // (玩家, 币种) -> 最新余额
+    std::map<uint32_t, LedgerEntry>                      players;  // 玩家 -> 最新信息
+    std::optional<LedgerEntry>                           checkpoint;
+    std::vector<LedgerEntry>                             markers;
+    std::vector<std::tuple<uint32_t, size_t, size_t>>    records; // (玩家, 输入序号, 条目序号)
+    for (size_t input = 0; input < plan.inputs.size(); ++input) {
+        const auto& segment = *plan.inputs[input];
+        for (size_t index = 0; index < segment.getEntryCount(); ++index) {
+            auto entry = segment.entryAt(index);
+            switch (entry.kind) {
+            case LedgerEntryKind::Player:
+                players[entry.account] = entry;
+                break;
+            case LedgerEntryKind::Balance:
+                balances[{entry.account, entry.currency}] = entry;
+                break;
+            case LedgerEntryKind::Record:
+                records.emplace_back(entry.account, input, index);
+                break;
+            case LedgerEntryKind::Checkpoint:
+                checkpoint = entry;
+                break;
+            case LedgerEntryKind::Archive:
+                markers.push_back(entry);
+                break;
+            case LedgerEntryKind::Commit:
+                break;
+            }
+        }
+    }
+    // 同一玩家的交易记录相邻存放，保持写入顺序
+    std::stable_sort(records.begin(), records.end(), [](const auto& a, const auto& b) {
+        return std::get<0>(a) < std::get<0>(b);
+    });
+
+    std::vector<LedgerEntry> entries;
+    entries.reserve(players.size() + balances.size() + markers.size() + records.size() + 1);
+    for (const auto& [account, entry] : players) {
+        entries.push_back(entry);
+    }
+    for (const auto& [key, entry] : balances) {
+        entries.push_back(entry);
+    }
+    if (checkpoint) {
+        entries.push_back(*checkpoint);
+    }
+    entries.insert(entries.end(), markers.begin(), markers.end());
+    for (const auto& [account, input, index] : records) {
+        entries.push_back(plan.inputs[input]->entryAt(index));
+    }
+
+    auto path   = segmentPath(mDirectory, plan.outputId);
+    auto header = encodeLedgerHeader(plan.outputId, plan.inputs.front()->getLevel() + 1);
+    {
+        std::ofstream output(path, std::ios::binary | std::ios::trunc);
+        output.write(header.data(), static_cast<std::streamsize>(header.size()));
+        auto buffer = encodeCommitted(entries.data(), entries.size());
+        output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        output.flush();
+        if (!output) {
+            throw DatabaseException("无法写入账本分段: " + path.string());
+        }
+    }
+    // 输入分段引用的字符串已经写入文件，合并结果落盘前先让字符串表落盘
+    syncLedgerFile(mDirectory / kStringsFile);
+    syncLedgerFile(path);
+    auto merged = LedgerSegment::open(path, false);
+
+    std::lock_guard lock(mMutex);
+    auto            first = std::find(mSegments.begin(), mSegments.end(), plan.inputs.front());
+    if (first == mSegments.end() || mSegments.end() - first < static_cast<ptrdiff_t>(plan.inputs.size())
+        || !std::equal(plan.inputs.begin(), plan.inputs.end(), first)) {
+        merged->markObsolete();
+        return;
+    }
+    auto position = mSegments.erase(first, first + static_cast<ptrdiff_t>(plan.inputs.size()));
+    mSegments.insert(position, merged);
+    try {
+        writeManifest(true);
+    } catch (...) {
+        // MANIFEST 未更新时仍使用输入分段
+        position = std::find(mSegments.begin(), mSegments.end(), merged);
+        position = mSegments.erase(position);
+        mSegments.insert(position, plan.inputs.begin(), plan.inputs.end());
+        merged->markObsolete();
+        throw;
+    }
+    for (const auto& input : plan.inputs) {
+        input->markObsolete();
+    }
+}
+
+void LedgerStorageBackend::waitForCompaction() {
+    std::thread worker;
+    {
+        std::lock_guard lock(mMutex);
+        worker = std::move(mCompactionThread);
+    }
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+size_t LedgerStorageBackend::getSegmentCount() const {
+    std::lock_guard lock(mMutex);
+    return mSegments.size() + (mActiveStream.is_open() ? 1 : 0);
+}
+
+} // namespace rlx_money
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "mod/storage/LedgerSegment.h"
+#include "mod/storage/MemoryStorageBackend.h"
+#include <fstream>
+#include <thread>
+
+
+namespace rlx_money {
+
+/// @brief 追加式账本存储后端
+/// @note 所有写入都以固定长度的条目追加到账本目录（数据库路径换成 .ledger 扩展名）下的分段文件，
+///       事务提交时一次写入该事务的全部条目并追加提交标记，打开时忽略最后一个提交标记之后的条目；
+///       字符串（XUID、币种、描述等）只在 strings.dat 中保存一次，条目中保存其编号。
+///       玩家与余额在内存中物化（沿用 MemoryStorageBackend 的数据结构与事务语义），打开时按顺序重放全部分段重建。
+///       交易记录只保存在分段中：当前分段的条目同时保留在内存，写满 ledgerSegmentKB 后封存，
+///       已封存的分段以内存映射方式只读访问，并按块建立以玩家为键的稀疏索引。
+///       同一层级的已封存分段达到 ledgerCompactSegments 个时由后台线程合并为上一层级的一个分段：
+///       每个余额与玩家只保留最新值，交易记录按玩家聚集，合并结果通过重写 MANIFEST 原子生效
+class LedgerStorageBackend : public MemoryStorageBackend {
+public:
+    ~LedgerStorageBackend() override;
+
+    /// @brief 由数据库路径得到账本目录
+    /// @param databasePath 配置中的数据库路径
+    /// @return 账本目录
+    [[nodiscard]] static std::filesystem::path directoryFor(const std::string& databasePath);
+
+    bool                           open(const DatabaseConfig& config) override;
+    void                           close() override;
+    [[nodiscard]] std::string_view getName() const override { return "ledger"; }
+
+    void                      flushCommits() override;
+    [[nodiscard]] std::string getJournalBasePath() const override;
+
+    [[nodiscard]] int getPlayerTransactionCount(const std::string& xuid) const override;
+    int64_t           archiveOldTransactions(int daysToKeep, std::stop_token stopToken = {}) override;
+
+    /// @brief 等待后台合并完成
+    void waitForCompaction();
+
+    /// @brief 获取分段数量（包含当前写入的分段）
+    [[nodiscard]] size_t getSegmentCount() const;
+
+protected:
+    void commitWrites() override;
+    void onPlayerWritten(const PlayerData& player) override;
+    void onBalanceWritten(const std::string& xuid, const std::string& currencyId, const BalanceRow& row) override;
+    void onCheckpointWritten(uint64_t sequence) override;
+    void storeRecord(TransactionRecord record) override;
+    void forEachRecord(
+        const std::string&                                   xuid,
+        bool                                                 includeArchived,
+        const std::function<void(const TransactionRecord&)>& visit
+    ) const override;
+
+private:
+    /// @brief 一次合并：连续的同层级分段
+    struct CompactionPlan {
+        std::vector<std::shared_ptr<LedgerSegment>> inputs;
+        uint64_t                                    outputId = 0;
+    };
+
+    /// @brief 读取字符串表，截掉末尾不完整的字符串
+    void loadStrings();
+
+    /// @brief 取得字符串的编号（不存在时追加到字符串表）
+    uint32_t intern(std::string_view text);
+
+    /// @brief 查找字符串的编号
+    /// @return 编号；字符串表中没有时返回空
+    [[nodiscard]] std::optional<uint32_t> findString(const std::string& text) const;
+
+    /// @brief 按编号读取字符串
+    /// @throw DatabaseException 编号超出字符串表时
+    [[nodiscard]] const std::string& lookup(uint32_t id) const;
+
+    /// @brief 按 MANIFEST 打开已有分段并重放，重建玩家、余额与交易记录数
+    void loadSegments();
+
+    /// @brief 把一个已提交的条目应用到内存状态
+    void replay(const LedgerEntry& entry);
+
+    /// @brief 新建当前分段并更新 MANIFEST
+    void openActiveSegment();
+
+    /// @brief 封存当前分段并新建下一个分段
+    void sealActiveSegment();
+
+    /// @brief 原子地重写 MANIFEST（先写临时文件再改名）
+    void writeManifest(bool includeActive);
+
+    /// @brief 追加条目到当前分段的内存部分（回滚时撤销）
+    void pushEntry(const LedgerEntry& entry);
+
+    /// @brief 立即写入一组条目并追加提交标记（不经过事务）
+    void writeCommitted(const std::vector<LedgerEntry>& entries);
+
+    /// @brief 交易记录是否已归档
+    [[nodiscard]] bool isArchived(const LedgerEntry& entry) const;
+
+    /// @brief 把交易记录条目还原为交易记录
+    [[nodiscard]] TransactionRecord toRecord(const LedgerEntry& entry) const;
+
+    /// @brief 遍历全部交易记录条目（已封存的分段与当前分段）
+    void forEachStoredRecord(const std::function<void(const LedgerEntry&)>& visit) const;
+
+    /// @brief 有需要合并的分段且后台线程空闲时启动后台合并
+    void scheduleCompaction();
+
+    /// @brief 选出下一次合并（层级最低、数量达到阈值的一组连续分段）
+    [[nodiscard]] std::optional<CompactionPlan> pickCompaction();
+
+    /// @brief 后台线程：依次执行合并直到没有需要合并的分段
+    void runCompactions();
+
+    /// @brief 合并一组分段并替换到分段列表中
+    void compact(const CompactionPlan& plan);
+
+    std::filesystem::path mDirectory;                // 账本目录
+    size_t                mSegmentEntries   = 0;     // 每个分段的条目数上限
+    size_t                mCompactThreshold = 0;     // 触发合并的同层级分段数量
+    bool                  mGroupCommit      = false; // 是否只在 flushCommits() 时把提交写到文件
+
+    std::vector<std::string>                  mStrings;         // 编号 -> 字符串（编号 0 为空字符串）
+    std::unordered_map<std::string, uint32_t> mStringIds;       // 字符串 -> 编号
+    std::string                               mPendingStrings;  // 尚未写入字符串表文件的内容
+    std::ofstream                             mStringStream;    // 字符串表文件
+    uint64_t                                  mStringsSize = 0; // 字符串表文件的长度（字节）
+
+    std::vector<std::shared_ptr<LedgerSegment>>         mSegments;             // 已封存的分段（按重放顺序）
+    uint64_t                                            mNextSegmentId     = 1;
+    uint64_t                                            mActiveId          = 0; // 当前分段编号
+    std::ofstream                                       mActiveStream;         // 当前分段文件
+    uint64_t                                            mActiveSize        = 0; // 当前分段文件的长度（字节）
+    std::vector<LedgerEntry>                            mActiveEntries;        // 当前分段的数据条目（含未提交的）
+    size_t                                              mActiveWritten     = 0; // 已写入文件的数据条目数
+    size_t                                              mActiveFileEntries = 0; // 文件中的条目数（含提交标记）
+    std::unordered_map<uint32_t, std::vector<uint32_t>> mActiveRecords; // 玩家 -> 当前分段中的交易记录位置
+
+    std::vector<std::pair<int64_t, int64_t>> mArchiveMarkers;        // (截止时间, 最大记录ID)
+    std::unordered_map<uint32_t, int>        mRecordCounts;          // 玩家 -> 未归档的交易记录数
+    int64_t                                  mCommittedRecordId = 0; // 已提交的最大记录ID
+
+    std::thread mCompactionThread;
+    bool        mCompacting = false; // 后台合并是否在运行（受 mMutex 保护）
+    bool        mStopping   = false; // 关闭时通知后台线程不再开始新的合并
+};
+
+} // namespace rlx_money
@@ -0,0 +1,568 @@
+#include "mod/storage/MemoryStorageBackend.h"
+#include "mod/exceptions/MoneyException.h"
+#include <algorithm>
+#include <chrono>
+#include <tuple>
+
+
+namespace rlx_money {
+
+namespace {
+
+int64_t currentTimestamp() {
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+/// @brief 按 (timestamp, id) 倒序排列
+bool newerFirst(const TransactionRecord& a, const TransactionRecord& b) {
+    return std::tie(a.timestamp, a.id) > std::tie(b.timestamp, b.id);
+}
+
+} // namespace
+
+bool MemoryStorageBackend::open(const DatabaseConfig&) {
+    mOpen.store(true, std::memory_order_release);
+    return true;
+}
+
+void MemoryStorageBackend::close() {
+    std::lock_guard lock(mMutex);
+    mOpen.store(false, std::memory_order_release);
+    mPlayers.clear();
+    mBalances.clear();
+    mWealth.clear();
+    mLedger.clear();
+    mArchive.clear();
+    mLastRecordId = 0;
+    mCheckpoint   = 0;
+}
+
+bool MemoryStorageBackend::runTransaction(const std::function<bool()>& transaction) {
+    std::lock_guard lock(mMutex);
+    if (!isOpen()) {
+        throw DatabaseException("数据库未初始化");
+    }
+    if (mTransactionDepth > 0) {
+        return runNested(transaction);
+    }
+
+    ++mTransactionDepth;
+    mNestedReleased = false;
+    auto rollback   = [this]() {
+        rollbackTo(0);
+        --mTransactionDepth;
+        if (mNestedReleased && mRollbackListener) {
+            mRollbackListener();
+        }
+        mNestedReleased = false;
+    };
+
+    try {
+        if (transaction()) {
+            commitWrites();
+            mUndoLog.clear();
+            --mTransactionDepth;
+            return true;
+        }
+        rollback();
+        return false;
+
+    } catch (const std::exception& e) {
+        rollback();
+        throw DatabaseException("事务执行失败: " + std::string(e.what()));
+    } catch (...) {
+        rollback();
+        throw;
+    }
+}
+
+bool MemoryStorageBackend::runNested(const std::function<bool()>& transaction) {
+    // 撤销日志的当前位置即保存点，回滚只撤销本次调用内的写入
+    size_t mark           = mUndoLog.size();
+    bool   releasedBefore = mNestedReleased;
+    mNestedReleased       = false;
+    ++mTransactionDepth;
+
+    auto rollback = [&]() {
+        rollbackTo(mark);
+        --mTransactionDepth;
+        // 本次调用内已提交的嵌套事务被一并撤销，调用方据此更新过的内存状态需要失效
+        if (mNestedReleased && mRollbackListener) {
+            mRollbackListener();
+        }
+        mNestedReleased = releasedBefore;
+    };
+
+    try {
+        if (transaction()) {
+            --mTransactionDepth;
+            mNestedReleased = true;
+            return true;
+        }
+        rollback();
+        return false;
+
+    } catch (const std::exception& e) {
+        rollback();
+        throw DatabaseException("事务执行失败: " + std::string(e.what()));
+    } catch (...) {
+        rollback();
+        throw;
+    }
+}
+
+void MemoryStorageBackend::rollbackTo(size_t mark) {
+    while (mUndoLog.size() > mark) {
+        auto undo = std::move(mUndoLog.back());
+        mUndoLog.pop_back();
+        undo();
+    }
+}
+
+void MemoryStorageBackend::recordUndo(std::function<void()> undo) {
+    if (mTransactionDepth > 0) {
+        mUndoLog.push_back(std::move(undo));
+    }
+}
+
+void MemoryStorageBackend::setRollbackListener(std::function<void()> listener) {
+    std::lock_guard lock(mMutex);
+    mRollbackListener = std::move(listener);
+}
+
+bool MemoryStorageBackend::createPlayer(const PlayerData& playerData) {
+    return runWrite([&]() {
+        if (!mPlayers.emplace(playerData.xuid, playerData).second) {
+            throw DatabaseException("玩家已存在: " + playerData.xuid);
+        }
+        recordUndo([this, xuid = playerData.xuid]() { mPlayers.erase(xuid); });
+        onPlayerWritten(playerData);
+        return true;
+    });
+}
+
+std::optional<PlayerData> MemoryStorageBackend::getPlayerByXuid(const std::string& xuid) const {
+    std::lock_guard lock(mMutex);
+    auto            it = mPlayers.find(xuid);
+    if (it == mPlayers.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+bool MemoryStorageBackend::playerExists(const std::string& xuid) const {
+    std::lock_guard lock(mMutex);
+    return mPlayers.contains(xuid);
+}
+
+bool MemoryStorageBackend::updateUsername(const std::string& xuid, const std::string& username) {
+    return runWrite([&]() {
+        auto it = mPlayers.find(xuid);
+        if (it == mPlayers.end()) {
+            return false;
+        }
+        recordUndo([this, previous = it->second]() { mPlayers[previous.xuid] = previous; });
+        it->second.username  = username;
+        it->second.updatedAt = currentTimestamp();
+        onPlayerWritten(it->second);
+        return true;
+    });
+}
+
+int MemoryStorageBackend::getPlayerCount() const {
+    std::lock_guard lock(mMutex);
+    return static_cast<int>(mPlayers.size());
+}
+
+std::optional<int> MemoryStorageBackend::getBalance(const std::string& xuid, const std::string& currencyId) const {
+    std::lock_guard lock(mMutex);
+    auto            table = mBalances.find(currencyId);
+    if (table == mBalances.end()) {
+        return std::nullopt;
+    }
+    auto row = table->second.find(xuid);
+    if (row == table->second.end()) {
+        return std::nullopt;
+    }
+    return row->second.balance;
+}
+
+std::vector<PlayerBalance> MemoryStorageBackend::getAllBalances(const std::string& xuid) const {
+    std::lock_guard            lock(mMutex);
+    std::vector<PlayerBalance> result;
+    for (const auto& [currencyId, table] : mBalances) {
+        auto row = table.find(xuid);
+        if (row == table.end()) {
+            continue;
+        }
+        PlayerBalance balance;
+        balance.xuid       = xuid;
+        balance.currencyId = currencyId;
+        balance.balance    = row->second.balance;
+        balance.updatedAt  = row->second.updatedAt;
+        result.push_back(std::move(balance));
+    }
+    return result;
+}
+
+void MemoryStorageBackend::writeBalance(
+    const std::string& xuid,
+    const std::string& currencyId,
+    int                balance,
+    int64_t            now
+) {
+    auto& table = mBalances[currencyId];
+    auto  row   = table.find(xuid);
+    if (row == table.end()) {
+        table.emplace(xuid, BalanceRow{balance, now});
+        mWealth[currencyId] += balance;
+        recordUndo([this, xuid, currencyId, balance]() {
+            mBalances[currencyId].erase(xuid);
+            mWealth[currencyId] -= balance;
+        });
+    } else {
+        BalanceRow previous  = row->second;
+        mWealth[currencyId] += static_cast<int64_t>(balance) - previous.balance;
+        row->second          = BalanceRow{balance, now};
+        recordUndo([this, xuid, currencyId, balance, previous]() {
+            mBalances[currencyId][xuid]  = previous;
+            mWealth[currencyId]         -= static_cast<int64_t>(balance) - previous.balance;
+        });
+    }
+    onBalanceWritten(xuid, currencyId, BalanceRow{balance, now});
+}
+
+bool MemoryStorageBackend::initializeBalance(
+    const std::string& xuid,
+    const std::string& currencyId,
+    int                initialBalance
+) {
+    return runWrite([&]() {
+        if (!getBalance(xuid, currencyId)) {
+            writeBalance(xuid, currencyId, initialBalance, currentTimestamp());
+        }
+        return true;
+    });
+}
+
+std::optional<int> MemoryStorageBackend::applyBalanceDelta(
+    const std::string& xuid,
+    const std::string& currencyId,
+    int64_t            delta,
+    int64_t            minBalance,
+    int64_t            maxBalance,
+    std::optional<int> initialBalance
+) {
+    return runWrite([&]() -> std::optional<int> {
+        if (!mPlayers.contains(xuid)) {
+            return std::nullopt;
+        }
+
+        // 已有记录在原值上加 delta；没有记录时仅在允许创建时以初始余额为原值
+        auto current = getBalance(xuid, currencyId);
+        if (!current) {
+            current = initialBalance;
+        }
+        if (!current) {
+            return std::nullopt;
+        }
+        int64_t result = *current + delta;
+        if (result < minBalance || result > maxBalance) {
+            return std::nullopt;
+        }
+        writeBalance(xuid, currencyId, static_cast<int>(result), currentTimestamp());
+        return static_cast<int>(result);
+    });
+}
+
+std::optional<int>
+MemoryStorageBackend::assignBalance(const std::string& xuid, const std::string& currencyId, int balance) {
+    return runWrite([&]() -> std::optional<int> {
+        if (!mPlayers.contains(xuid)) {
+            return std::nullopt;
+        }
+        writeBalance(xuid, currencyId, balance, currentTimestamp());
+        return balance;
+    });
+}
+
+std::vector<TopBalanceEntry> MemoryStorageBackend::getCurrencyBalanceList(const std::string& currencyId) const {
+    std::lock_guard              lock(mMutex);
+    std::vector<TopBalanceEntry> result;
+    auto                         table = mBalances.find(currencyId);
+    if (table == mBalances.end()) {
+        return result;
+    }
+    for (const auto& [xuid, row] : table->second) {
+        auto player = mPlayers.find(xuid);
+        if (player == mPlayers.end()) {
+            continue;
+        }
+        TopBalanceEntry entry;
+        entry.username   = player->second.username;
+        entry.xuid       = xuid;
+        entry.currencyId = currencyId;
+        entry.balance    = row.balance;
+        result.push_back(std::move(entry));
+    }
+    return result;
+}
+
+int64_t MemoryStorageBackend::getTotalWealth(const std::string& currencyId) const {
+    std::lock_guard lock(mMutex);
+    auto            it = mWealth.find(currencyId);
+    return it != mWealth.end() ? it->second : 0;
+}
+
+int64_t MemoryStorageBackend::addToAllBalances(
+    const std::string& currencyId,
+    int                amount,
+    int                maxBalance,
+    const std::string& description
+) {
+    return applyBulkUpdate(
+        currencyId,
+        [&](int64_t balance) { return std::min<int64_t>(balance + amount, std::max<int64_t>(balance, maxBalance)); },
+        false,
+        description
+    );
+}
+
+int64_t MemoryStorageBackend::scaleAllBalances(
+    const std::string& currencyId,
+    int64_t            rateMicros,
+    bool               roundUp,
+    int                maxBalance,
+    const std::string& description
+) {
+    // 余额非负，整数除法即向下取整；向上取整时先加上 999999
+    int64_t rounding = roundUp ? 999999 : 0;
+    return applyBulkUpdate(
+        currencyId,
+        [&](int64_t balance) {
+            int64_t scaled = (balance * rateMicros + rounding) / 1000000;
+            return std::min<int64_t>(scaled, std::max<int64_t>(balance, maxBalance));
+        },
+        false,
+        description
+    );
+}
+
+int64_t
+MemoryStorageBackend::assignAllBalances(const std::string& currencyId, int balance, const std::string& description) {
+    return applyBulkUpdate(currencyId, [&](int64_t) { return static_cast<int64_t>(balance); }, true, description);
+}
+
+int64_t
+MemoryStorageBackend::clampAllBalances(const std::string& currencyId, int maxBalance, const std::string& description) {
+    return applyBulkUpdate(
+        currencyId,
+        [&](int64_t balance) { return std::min<int64_t>(balance, maxBalance); },
+        true,
+        description
+    );
+}
+
+int64_t MemoryStorageBackend::applyBulkUpdate(
+    const std::string&                      currencyId,
+    const std::function<int64_t(int64_t)>& newBalance,
+    bool                                    recordAsSet,
+    const std::string&                      description
+) {
+    return runWrite([&]() -> int64_t {
+        auto table = mBalances.find(currencyId);
+        if (table == mBalances.end()) {
+            return 0;
+        }
+
+        // 先计算全部变化再写入，遍历期间不修改余额表
+        std::vector<std::pair<std::string, int>> changes;
+        for (const auto& [xuid, row] : table->second) {
+            auto balance = static_cast<int>(newBalance(row.balance));
+            if (balance != row.balance) {
+                changes.emplace_back(xuid, balance);
+            }
+        }
+
+        int64_t now = currentTimestamp();
+        for (const auto& [xuid, balance] : changes) {
+            int               previous = *getBalance(xuid, currencyId);
+            TransactionRecord record;
+            record.xuid        = xuid;
+            record.currencyId  = currencyId;
+            record.amount      = recordAsSet ? balance : balance - previous;
+            record.balance     = balance;
+            record.type        = TransactionType::SET;
+            if (!recordAsSet) {
+                record.type = balance > previous ? TransactionType::ADD : TransactionType::REDUCE;
+            }
+            record.description = description;
+            record.timestamp   = now;
+            appendRecord(std::move(record));
+            writeBalance(xuid, currencyId, balance, now);
+        }
+        return static_cast<int64_t>(changes.size());
+    });
+}
+
+void MemoryStorageBackend::appendRecord(TransactionRecord record) {
+    record.id = ++mLastRecordId;
+    recordUndo([this, id = record.id]() { mLastRecordId = id - 1; });
+    storeRecord(std::move(record));
+}
+
+void MemoryStorageBackend::storeRecord(TransactionRecord record) {
+    auto& records = mLedger[record.xuid];
+    records.push_back(std::move(record));
+    recordUndo([this, xuid = records.back().xuid, id = records.back().id]() {
+        // 通常就是最后一条；事务中途执行过归档时按ID查找
+        auto& records = mLedger[xuid];
+        auto  it      = std::find_if(records.rbegin(), records.rend(), [&](const auto& item) { return item.id == id; });
+        if (it != records.rend()) {
+            records.erase(std::next(it).base());
+        }
+    });
+}
+
+void MemoryStorageBackend::forEachRecord(
+    const std::string&                                   xuid,
+    bool                                                 includeArchived,
+    const std::function<void(const TransactionRecord&)>& visit
+) const {
+    auto visitAll = [&](const auto& ledger) {
+        if (auto it = ledger.find(xuid); it != ledger.end()) {
+            std::for_each(it->second.begin(), it->second.end(), visit);
+        }
+    };
+    visitAll(mLedger);
+    if (includeArchived) {
+        visitAll(mArchive);
+    }
+}
+
+bool MemoryStorageBackend::createTransaction(const TransactionRecord& record) {
+    return runWrite([&]() {
+        appendRecord(record);
+        return true;
+    });
+}
+
+std::vector<TransactionRecord> MemoryStorageBackend::getPlayerTransactions(
+    const std::string& xuid,
+    const std::string& currencyId,
+    int                page,
+    int                pageSize
+) const {
+    std::lock_guard                lock(mMutex);
+    std::vector<TransactionRecord> records;
+    forEachRecord(xuid, false, [&](const TransactionRecord& record) {
+        if (currencyId.empty() || record.currencyId == currencyId) {
+            records.push_back(record);
+        }
+    });
+    std::sort(records.begin(), records.end(), newerFirst);
+
+    // 与 SQL 的 LIMIT/OFFSET 一致：负的偏移量按 0 处理，负的数量表示不限
+    size_t offset = static_cast<size_t>(std::max<int64_t>(static_cast<int64_t>(page - 1) * pageSize, 0));
+    records.erase(records.begin(), records.begin() + static_cast<ptrdiff_t>(std::min(offset, records.size())));
+    if (pageSize >= 0 && records.size() > static_cast<size_t>(pageSize)) {
+        records.resize(static_cast<size_t>(pageSize));
+    }
+    return records;
+}
+
+TransactionPage MemoryStorageBackend::getPlayerTransactionsPage(
+    const std::string&       xuid,
+    const TransactionFilter& filter,
+    const std::string&       cursor,
+    int                      pageSize
+) const {
+    std::optional<std::pair<int64_t, int64_t>> position;
+    if (!cursor.empty()) {
+        position = decodeTransactionCursor(cursor);
+        if (!position) {
+            throw InvalidArgumentException("无效的分页游标: " + cursor);
+        }
+    }
+
+    auto matches = [&](const TransactionRecord& record) {
+        return (filter.currencyId.empty() || record.currencyId == filter.currencyId)
+            && (!filter.type || record.type == *filter.type)
+            && (!filter.startTime || record.timestamp >= *filter.startTime)
+            && (!filter.endTime || record.timestamp <= *filter.endTime)
+            && (!position || std::pair{record.timestamp, record.id} < *position);
+    };
+
+    std::lock_guard                lock(mMutex);
+    std::vector<TransactionRecord> records;
+    forEachRecord(xuid, filter.includeArchived, [&](const TransactionRecord& record) {
+        if (matches(record)) {
+            records.push_back(record);
+        }
+    });
+
+    // 多取一条用于判断是否还有下一页
+    size_t limit = static_cast<size_t>(pageSize) + 1;
+    if (records.size() > limit) {
+        std::partial_sort(records.begin(), records.begin() + static_cast<ptrdiff_t>(limit), records.end(), newerFirst);
+        records.resize(limit);
+    } else {
+        std::sort(records.begin(), records.end(), newerFirst);
+    }
+
+    TransactionPage page;
+    if (records.size() == limit) {
+        records.pop_back();
+        const auto& last = records.back();
+        page.nextCursor  = encodeTransactionCursor(last.timestamp, last.id);
+    }
+    page.records = std::move(records);
+    return page;
+}
+
+int MemoryStorageBackend::getPlayerTransactionCount(const std::string& xuid) const {
+    std::lock_guard lock(mMutex);
+    auto            it = mLedger.find(xuid);
+    return it != mLedger.end() ? static_cast<int>(it->second.size()) : 0;
+}
+
+int64_t MemoryStorageBackend::archiveOldTransactions(int daysToKeep, std::stop_token /*stopToken*/) {
+    if (daysToKeep < 1) {
+        throw InvalidArgumentException("保留天数必须大于 0");
+    }
+    int64_t cutoffTime = currentTimestamp() - static_cast<int64_t>(daysToKeep) * 24 * 60 * 60;
+
+    // 与 SQLite 后端的分段文件一样，归档独立生效，不随所在事务回滚
+    std::lock_guard lock(mMutex);
+    int64_t         archived = 0;
+    for (auto& [xuid, records] : mLedger) {
+        auto old = std::stable_partition(records.begin(), records.end(), [&](const TransactionRecord& record) {
+            return record.timestamp >= cutoffTime;
+        });
+        if (old == records.end()) {
+            continue;
+        }
+        auto& target = mArchive[xuid];
+        target.insert(target.end(), std::make_move_iterator(old), std::make_move_iterator(records.end()));
+        archived += records.end() - old;
+        records.erase(old, records.end());
+    }
+    return archived;
+}
+
+uint64_t MemoryStorageBackend::getJournalCheckpoint() const {
+    std::lock_guard lock(mMutex);
+    return mCheckpoint;
+}
+
+void MemoryStorageBackend::setJournalCheckpoint(uint64_t sequence) {
+    runWrite([&]() {
+        recordUndo([this, previous = mCheckpoint]() { mCheckpoint = previous; });
+        mCheckpoint = sequence;
+        onCheckpointWritten(sequence);
+        return true;
+    });
+}
+
+} // namespace rlx_money
@@ -0,0 +1,183 @@
+#pragma once
+
+#include "mod/storage/StorageBackend.h"
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+
+namespace rlx_money {
+
+/// @brief 纯内存存储后端
+/// @note 玩家与余额保存在哈希表中，交易记录按玩家追加到向量，不读写任何文件，进程退出后数据丢失，
+///       用于测试与没有持久化需求的场景。语义与 SQLite 后端一致：事务内的每次写入都记录撤销操作，
+///       回滚时逆序执行；嵌套事务以撤销日志的位置作为保存点。事务期间持有后端的互斥锁，
+///       其他线程的读写在事务结束后进行，不会读到未提交的数据。
+///       派生类可通过受保护的扩展点把写入持久化（见 LedgerStorageBackend）
+class MemoryStorageBackend : public StorageBackend {
+public:
+    bool                           open(const DatabaseConfig& config) override;
+    void                           close() override;
+    [[nodiscard]] bool             isOpen() const override { return mOpen.load(std::memory_order_acquire); }
+    [[nodiscard]] std::string_view getName() const override { return "memory"; }
+
+    bool                      runTransaction(const std::function<bool()>& transaction) override;
+    void                      flushCommits() override {}
+    void                      setRollbackListener(std::function<void()> listener) override;
+    [[nodiscard]] std::string getJournalBasePath() const override { return {}; }
+
+    bool                                    createPlayer(const PlayerData& playerData) override;
+    [[nodiscard]] std::optional<PlayerData> getPlayerByXuid(const std::string& xuid) const override;
+    [[nodiscard]] bool                      playerExists(const std::string& xuid) const override;
+    bool updateUsername(const std::string& xuid, const std::string& username) override;
+    [[nodiscard]] int                       getPlayerCount() const override;
+
+    [[nodiscard]] std::optional<int> getBalance(const std::string& xuid, const std::string& currencyId) const override;
+    [[nodiscard]] std::vector<PlayerBalance> getAllBalances(const std::string& xuid) const override;
+    bool initializeBalance(const std::string& xuid, const std::string& currencyId, int initialBalance) override;
+    std::optional<int> applyBalanceDelta(
+        const std::string& xuid,
+        const std::string& currencyId,
+        int64_t            delta,
+        int64_t            minBalance,
+        int64_t            maxBalance,
+        std::optional<int> initialBalance
+    ) override;
+    std::optional<int> assignBalance(const std::string& xuid, const std::string& currencyId, int balance) override;
+    [[nodiscard]] std::vector<TopBalanceEntry> getCurrencyBalanceList(const std::string& currencyId) const override;
+    [[nodiscard]] int64_t                      getTotalWealth(const std::string& currencyId) const override;
+
+    int64_t addToAllBalances(
+        const std::string& currencyId,
+        int                amount,
+        int                maxBalance,
+        const std::string& description
+    ) override;
+    int64_t scaleAllBalances(
+        const std::string& currencyId,
+        int64_t            rateMicros,
+        bool               roundUp,
+        int                maxBalance,
+        const std::string& description
+    ) override;
+    int64_t assignAllBalances(const std::string& currencyId, int balance, const std::string& description) override;
+    int64_t clampAllBalances(const std::string& currencyId, int maxBalance, const std::string& description) override;
+
+    bool createTransaction(const TransactionRecord& record) override;
+    [[nodiscard]] std::vector<TransactionRecord>
+    getPlayerTransactions(const std::string& xuid, const std::string& currencyId, int page, int pageSize)
+        const override;
+    [[nodiscard]] TransactionPage getPlayerTransactionsPage(
+        const std::string&       xuid,
+        const TransactionFilter& filter,
+        const std::string&       cursor,
+        int                      pageSize
+    ) const override;
+    [[nodiscard]] int      getPlayerTransactionCount(const std::string& xuid) const override;
+    int64_t                archiveOldTransactions(int daysToKeep, std::stop_token stopToken = {}) override;
+    [[nodiscard]] uint64_t getJournalCheckpoint() const override;
+    void                   setJournalCheckpoint(uint64_t sequence) override;
+
+protected:
+    /// @brief 余额行
+    struct BalanceRow {
+        int     balance   = 0;
+        int64_t updatedAt = 0;
+    };
+
+    using BalanceTable = std::unordered_map<std::string, BalanceRow>; // XUID -> 余额
+
+    /// @brief 执行单个写操作；不在事务中时把该操作作为一次独立的事务提交，失败时撤销其全部写入
+    /// @return 写操作的返回值
+    template <typename Operation>
+    auto runWrite(Operation&& operation) -> decltype(operation()) {
+        std::lock_guard lock(mMutex);
+        if (mTransactionDepth > 0) {
+            return operation();
+        }
+        ++mTransactionDepth;
+        try {
+            auto result = operation();
+            commitWrites();
+            mUndoLog.clear();
+            --mTransactionDepth;
+            return result;
+        } catch (...) {
+            rollbackTo(0);
+            --mTransactionDepth;
+            throw;
+        }
+    }
+
+    /// @brief 最外层事务提交前调用（内存中的写入均已完成，撤销日志仍然有效）
+    /// @throw 抛出异常时整个事务回滚
+    virtual void commitWrites() {}
+
+    /// @brief 玩家信息写入后调用
+    virtual void onPlayerWritten(const PlayerData&) {}
+
+    /// @brief 余额写入后调用
+    virtual void onBalanceWritten(const std::string&, const std::string&, const BalanceRow&) {}
+
+    /// @brief 重做日志检查点写入后调用
+    virtual void onCheckpointWritten(uint64_t) {}
+
+    /// @brief 保存一条已分配记录ID的交易记录
+    virtual void storeRecord(TransactionRecord record);
+
+    /// @brief 遍历玩家的交易记录（顺序不限）
+    /// @param includeArchived 是否包含已归档的记录
+    virtual void forEachRecord(
+        const std::string&                                   xuid,
+        bool                                                 includeArchived,
+        const std::function<void(const TransactionRecord&)>& visit
+    ) const;
+
+    /// @brief 在事务中时记录一条撤销操作（事务外的写入立即生效，不记录）
+    void recordUndo(std::function<void()> undo);
+
+    /// @brief 撤销当前事务中位于 mark 之后的全部写入
+    void rollbackTo(size_t mark);
+
+    mutable std::recursive_mutex mMutex; // 保护全部数据；事务期间由执行事务的线程持有
+
+    std::unordered_map<std::string, PlayerData>   mPlayers;          // XUID -> 玩家
+    std::unordered_map<std::string, BalanceTable> mBalances;         // 币种ID -> 余额表
+    std::unordered_map<std::string, int64_t>      mWealth;           // 币种ID -> 余额总和
+    int64_t                                       mLastRecordId = 0; // 最近分配的记录ID
+    uint64_t                                      mCheckpoint   = 0; // 重做日志检查点
+
+    int                                mTransactionDepth = 0; // 当前事务的嵌套层数
+    std::vector<std::function<void()>> mUndoLog;              // 当前事务的撤销操作（按写入顺序）
+
+private:
+    /// @brief 在嵌套保存点内执行事务（以撤销日志的当前位置为保存点）
+    /// @return 是否提交
+    bool runNested(const std::function<bool()>& transaction);
+
+    /// @brief 写入余额行并维护币种总额
+    void writeBalance(const std::string& xuid, const std::string& currencyId, int balance, int64_t now);
+
+    /// @brief 集合操作的公共实现
+    /// @param newBalance 由原余额计算新余额
+    /// @param recordAsSet 是否记为 SET（否则按变化方向记为 ADD/REDUCE）
+    int64_t applyBulkUpdate(
+        const std::string&                      currencyId,
+        const std::function<int64_t(int64_t)>& newBalance,
+        bool                                    recordAsSet,
+        const std::string&                      description
+    );
+
+    /// @brief 分配记录ID并保存交易记录
+    void appendRecord(TransactionRecord record);
+
+    std::atomic<bool> mOpen{false};
+
+    std::unordered_map<std::string, std::vector<TransactionRecord>> mLedger;  // XUID -> 交易记录（按写入顺序）
+    std::unordered_map<std::string, std::vector<TransactionRecord>> mArchive; // XUID -> 已归档的交易记录
+
+    bool                  mNestedReleased = false; // 当前层是否有嵌套事务已提交
+    std::function<void()> mRollbackListener;
+};
+
+} // namespace rlx_money
@@ -0,0 +1,156 @@
+#include "mod/storage/SqliteStorageBackend.h"
+
+
+namespace rlx_money {
+
+SqliteStorageBackend::SqliteStorageBackend()
+: mDbManager(DatabaseManager::getInstance()),
+  mPlayerDAO(mDbManager),
+  mTransactionDAO(mDbManager) {}
+
+bool SqliteStorageBackend::open(const DatabaseConfig& config) {
+    // 数据库可能已由插件入口或其他组件打开，此时沿用已有连接
+    return mDbManager.isInitialized() || mDbManager.initialize(config);
+}
+
+void SqliteStorageBackend::close() { mDbManager.close(); }
+
+bool SqliteStorageBackend::isOpen() const { return mDbManager.isInitialized(); }
+
+bool SqliteStorageBackend::runTransaction(const std::function<bool()>& transaction) {
+    return mDbManager.executeTransaction([&](SQLite::Database&) { return transaction(); });
+}
+
+std::shared_future<bool> SqliteStorageBackend::submitTransaction(std::function<bool()> transaction) {
+    return mDbManager.submitTransaction(
+        [transaction = std::move(transaction)](SQLite::Database&) { return transaction(); },
+        false
+    );
+}
+
+void SqliteStorageBackend::flushCommits() { mDbManager.flushGroupCommit(); }
+
+void SqliteStorageBackend::setRollbackListener(std::function<void()> listener) {
+    mDbManager.setGroupRollbackListener(std::move(listener));
+}
+
+std::string SqliteStorageBackend::getJournalBasePath() const { return mDbManager.getDatabasePath() + ".redo"; }
+
+bool SqliteStorageBackend::createPlayer(const PlayerData& playerData) { return mPlayerDAO.createPlayer(playerData); }
+
+std::optional<PlayerData> SqliteStorageBackend::getPlayerByXuid(const std::string& xuid) const {
+    return mPlayerDAO.getPlayerByXuid(xuid);
+}
+
+bool SqliteStorageBackend::playerExists(const std::string& xuid) const { return mPlayerDAO.playerExists(xuid); }
+
+bool SqliteStorageBackend::updateUsername(const std::string& xuid, const std::string& username) {
+    return mPlayerDAO.updateUsername(xuid, username);
+}
+
+int SqliteStorageBackend::getPlayerCount() const { return mPlayerDAO.getPlayerCount(); }
+
+std::optional<int> SqliteStorageBackend::getBalance(const std::string& xuid, const std::string& currencyId) const {
+    return mPlayerDAO.getBalance(xuid, currencyId);
+}
+
+std::vector<PlayerBalance> SqliteStorageBackend::getAllBalances(const std::string& xuid) const {
+    return mPlayerDAO.getAllBalances(xuid);
+}
+
+bool SqliteStorageBackend::initializeBalance(
+    const std::string& xuid,
+    const std::string& currencyId,
+    int                initialBalance
+) {
+    return mPlayerDAO.initializeBalance(xuid, currencyId, initialBalance);
+}
+
+std::optional<int> SqliteStorageBackend::applyBalanceDelta(
+    const std::string& xuid,
+    const std::string& currencyId,
+    int64_t            delta,
+    int64_t            minBalance,
+    int64_t            maxBalance,
+    std::optional<int> initialBalance
+) {
+    return mPlayerDAO.applyBalanceDelta(xuid, currencyId, delta, minBalance, maxBalance, initialBalance);
+}
+
+std::optional<int>
+SqliteStorageBackend::assignBalance(const std::string& xuid, const std::string& currencyId, int balance) {
+    return mPlayerDAO.assignBalance(xuid, currencyId, balance);
+}
+
+std::vector<TopBalanceEntry> SqliteStorageBackend::getCurrencyBalanceList(const std::string& currencyId) const {
+    return mPlayerDAO.getCurrencyBalanceList(currencyId);
+}
+
+int64_t SqliteStorageBackend::getTotalWealth(const std::string& currencyId) const {
+    return mPlayerDAO.getTotalWealth(currencyId);
+}
+
+int64_t SqliteStorageBackend::addToAllBalances(
+    const std::string& currencyId,
+    int                amount,
+    int                maxBalance,
+    const std::string& description
+) {
+    return mPlayerDAO.addToAllBalances(currencyId, amount, maxBalance, description);
+}
+
+int64_t SqliteStorageBackend::scaleAllBalances(
+    const std::string& currencyId,
+    int64_t            rateMicros,
+    bool               roundUp,
+    int                maxBalance,
+    const std::string& description
+) {
+    return mPlayerDAO.scaleAllBalances(currencyId, rateMicros, roundUp, maxBalance, description);
+}
+
+int64_t
+SqliteStorageBackend::assignAllBalances(const std::string& currencyId, int balance, const std::string& description) {
+    return mPlayerDAO.assignAllBalances(currencyId, balance, description);
+}
+
+int64_t
+SqliteStorageBackend::clampAllBalances(const std::string& currencyId, int maxBalance, const std::string& description) {
+    return mPlayerDAO.clampAllBalances(currencyId, maxBalance, description);
+}
+
+bool SqliteStorageBackend::createTransaction(const TransactionRecord& record) {
+    return mTransactionDAO.createTransaction(record);
+}
+
+std::vector<TransactionRecord> SqliteStorageBackend::getPlayerTransactions(
+    const std::string& xuid,
+    const std::string& currencyId,
+    int                page,
+    int                pageSize
+) const {
+    return mTransactionDAO.getPlayerTransactions(xuid, currencyId, page, pageSize);
+}
+
+TransactionPage SqliteStorageBackend::getPlayerTransactionsPage(
+    const std::string&       xuid,
+    const TransactionFilter& filter,
+    const std::string&       cursor,
+    int                      pageSize
+) const {
+    return mTransactionDAO.getPlayerTransactionsPage(xuid, filter, cursor, pageSize);
+}
+
+int SqliteStorageBackend::getPlayerTransactionCount(const std::string& xuid) const {
+    return mTransactionDAO.getPlayerTransactionCount(xuid);
+}
+
+int64_t SqliteStorageBackend::archiveOldTransactions(int daysToKeep, std::stop_token stopToken) {
+    return mTransactionDAO.archiveOldTransactions(daysToKeep, std::move(stopToken));
+}
+
+uint64_t SqliteStorageBackend::getJournalCheckpoint() const { return mTransactionDAO.getJournalCheckpoint(); }
+
+void SqliteStorageBackend::setJournalCheckpoint(uint64_t sequence) { mTransactionDAO.setJournalCheckpoint(sequence); }
+
+} // namespace rlx_money
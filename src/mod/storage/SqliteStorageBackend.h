@@ -0,0 +1,86 @@
+#pragma once
+
+#include "mod/dao/PlayerDAO.h"
+#include "mod/dao/TransactionDAO.h"
+#include "mod/storage/StorageBackend.h"
+
+
+namespace rlx_money {
+
+/// @brief SQLite 存储后端（默认）
+/// @note 通过 PlayerDAO 与 TransactionDAO 读写 DatabaseManager 管理的数据库，
+///       事务、组提交与嵌套保存点均由 DatabaseManager 提供
+class SqliteStorageBackend : public StorageBackend {
+public:
+    SqliteStorageBackend();
+
+    bool                           open(const DatabaseConfig& config) override;
+    void                           close() override;
+    [[nodiscard]] bool             isOpen() const override;
+    [[nodiscard]] std::string_view getName() const override { return "sqlite"; }
+
+    bool                      runTransaction(const std::function<bool()>& transaction) override;
+    std::shared_future<bool>  submitTransaction(std::function<bool()> transaction) override;
+    void                      flushCommits() override;
+    void                      setRollbackListener(std::function<void()> listener) override;
+    [[nodiscard]] std::string getJournalBasePath() const override;
+
+    bool                                    createPlayer(const PlayerData& playerData) override;
+    [[nodiscard]] std::optional<PlayerData> getPlayerByXuid(const std::string& xuid) const override;
+    [[nodiscard]] bool                      playerExists(const std::string& xuid) const override;
+    bool updateUsername(const std::string& xuid, const std::string& username) override;
+    [[nodiscard]] int                       getPlayerCount() const override;
+
+    [[nodiscard]] std::optional<int> getBalance(const std::string& xuid, const std::string& currencyId) const override;
+    [[nodiscard]] std::vector<PlayerBalance> getAllBalances(const std::string& xuid) const override;
+    bool initializeBalance(const std::string& xuid, const std::string& currencyId, int initialBalance) override;
+    std::optional<int> applyBalanceDelta(
+        const std::string& xuid,
+        const std::string& currencyId,
+        int64_t            delta,
+        int64_t            minBalance,
+        int64_t            maxBalance,
+        std::optional<int> initialBalance
+    ) override;
+    std::optional<int> assignBalance(const std::string& xuid, const std::string& currencyId, int balance) override;
+    [[nodiscard]] std::vector<TopBalanceEntry> getCurrencyBalanceList(const std::string& currencyId) const override;
+    [[nodiscard]] int64_t                      getTotalWealth(const std::string& currencyId) const override;
+
+    int64_t addToAllBalances(
+        const std::string& currencyId,
+        int                amount,
+        int                maxBalance,
+        const std::string& description
+    ) override;
+    int64_t scaleAllBalances(
+        const std::string& currencyId,
+        int64_t            rateMicros,
+        bool               roundUp,
+        int                maxBalance,
+        const std::string& description
+    ) override;
+    int64_t assignAllBalances(const std::string& currencyId, int balance, const std::string& description) override;
+    int64_t clampAllBalances(const std::string& currencyId, int maxBalance, const std::string& description) override;
+
+    bool createTransaction(const TransactionRecord& record) override;
+    [[nodiscard]] std::vector<TransactionRecord>
+    getPlayerTransactions(const std::string& xuid, const std::string& currencyId, int page, int pageSize)
+        const override;
+    [[nodiscard]] TransactionPage getPlayerTransactionsPage(
+        const std::string&       xuid,
+        const TransactionFilter& filter,
+        const std::string&       cursor,
+        int                      pageSize
+    ) const override;
+    [[nodiscard]] int      getPlayerTransactionCount(const std::string& xuid) const override;
+    int64_t                archiveOldTransactions(int daysToKeep, std::stop_token stopToken = {}) override;
+    [[nodiscard]] uint64_t getJournalCheckpoint() const override;
+    void                   setJournalCheckpoint(uint64_t sequence) override;
+
+private:
+    DatabaseManager& mDbManager;
+    PlayerDAO        mPlayerDAO;
+    TransactionDAO   mTransactionDAO;
+};
+
+} // namespace rlx_money
@@ -0,0 +1,86 @@
+#include "mod/storage/StorageBackend.h"
+#include "mod/config/ConfigStructures.h"
+#include "mod/exceptions/MoneyException.h"
+#include "mod/storage/LedgerStorageBackend.h"
+#include "mod/storage/MemoryStorageBackend.h"
+#include "mod/storage/SqliteStorageBackend.h"
+#include <charconv>
+
+
+namespace rlx_money {
+
+std::unique_ptr<StorageBackend> createStorageBackend(const DatabaseConfig& config) {
+    if (config.backend == "sqlite") {
+        return std::make_unique<SqliteStorageBackend>();
+    }
+    if (config.backend == "memory") {
+        return std::make_unique<MemoryStorageBackend>();
+    }
+    if (config.backend == "ledger") {
+        return std::make_unique<LedgerStorageBackend>();
+    }
+    throw InvalidArgumentException("未知的存储后端: " + config.backend);
+}
+
+std::shared_future<bool> StorageBackend::submitTransaction(std::function<bool()> transaction) {
+    std::promise<bool> promise;
+    try {
+        promise.set_value(runTransaction(transaction));
+    } catch (...) {
+        promise.set_exception(std::current_exception());
+    }
+    return promise.get_future().share();
+}
+
+std::string encodeTransactionCursor(int64_t timestamp, int64_t id) {
+    char  buffer[40];
+    char* end = std::to_chars(buffer, buffer + sizeof(buffer), static_cast<uint64_t>(timestamp), 16).ptr;
+    *end++    = '.';
+    end       = std::to_chars(end, buffer + sizeof(buffer), static_cast<uint64_t>(id), 16).ptr;
+    return std::string(buffer, end);
+}
+
+std::optional<std::pair<int64_t, int64_t>> decodeTransactionCursor(std::string_view cursor) {
+    size_t separator = cursor.find('.');
+    if (separator == std::string_view::npos) {
+        return std::nullopt;
+    }
+    uint64_t parts[2] = {};
+    for (auto [text, value] : {
+             std::pair{cursor.substr(0, separator), &parts[0]},
+             std::pair{cursor.substr(separator + 1), &parts[1]}
+    }) {
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), *value, 16);
+        if (text.empty() || error != std::errc() || end != text.data() + text.size()) {
+            return std::nullopt;
+        }
+    }
+    return std::pair{static_cast<int64_t>(parts[0]), static_cast<int64_t>(parts[1])};
+}
+
+std::optional<std::array<unsigned char, 12>> packTransferId(std::string_view transferId) {
+    if (transferId.size() != 24) {
+        return std::nullopt;
+    }
+    std::array<unsigned char, 12> bytes{};
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        auto [end, error] = std::from_chars(transferId.data() + i * 2, transferId.data() + i * 2 + 2, bytes[i], 16);
+        if (error != std::errc() || end != transferId.data() + i * 2 + 2) {
+            return std::nullopt;
+        }
+    }
+    return bytes;
+}
+
+std::string unpackTransferId(const unsigned char* bytes, size_t size) {
+    static constexpr char kHex[] = "0123456789abcdef";
+    std::string           text;
+    text.reserve(size * 2);
+    for (size_t i = 0; i < size; ++i) {
+        text += kHex[bytes[i] >> 4];
+        text += kHex[bytes[i] & 0x0F];
+    }
+    return text;
+}
+
+} // namespace rlx_money
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <RLXMoney/data/DataStructures.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+
+namespace rlx_money {
+
+struct DatabaseConfig;
+
+/// @brief 经济数据的存储后端
+/// @note EconomyManager 通过该接口读写玩家、余额与交易记录，不直接依赖具体的存储实现。
+///       各实现必须保持相同的语义：余额写入在 runTransaction() 内执行且整体提交或回滚，
+///       交易记录按 (timestamp, id) 倒序返回，记录ID单调递增，分页游标格式一致。
+///       写操作由调用方持有账户锁，实现只需保证自身数据结构的线程安全
+class StorageBackend {
+public:
+    virtual ~StorageBackend() = default;
+
+    // ==================== 生命周期 ====================
+
+    /// @brief 打开存储
+    /// @param config 数据库配置
+    /// @return 是否打开成功（已打开时直接返回 true）
+    virtual bool open(const DatabaseConfig& config) = 0;
+
+    /// @brief 关闭存储
+    virtual void close() = 0;
+
+    /// @brief 存储是否已打开
+    [[nodiscard]] virtual bool isOpen() const = 0;
+
+    /// @brief 后端名称（与配置项 database.backend 的取值一致）
+    [[nodiscard]] virtual std::string_view getName() const = 0;
+
+    // ==================== 事务 ====================
+
+    /// @brief 在事务中执行操作
+    /// @param transaction 事务操作，返回 true 提交，返回 false 或抛出异常时回滚
+    /// @return 是否提交成功
+    /// @throw DatabaseException 事务执行失败时
+    /// @note 在事务中再次调用时在嵌套的保存点内执行，返回 false 只回滚本次调用的写入
+    virtual bool runTransaction(const std::function<bool()>& transaction) = 0;
+
+    /// @brief 提交事务但不等待其完成
+    /// @param transaction 事务操作（可能在其他线程上执行，捕获的数据需在完成前保持有效）
+    /// @return 完成句柄：提交后为 true，回滚后为 false，失败时 get() 抛出异常
+    /// @note 调用方随后的读取不等待该事务，只用于结果仍保存在内存中的写入（如写后刷新）。
+    ///       默认实现同步执行并返回已就绪的句柄
+    virtual std::shared_future<bool> submitTransaction(std::function<bool()> transaction);
+
+    /// @brief 确保此前返回成功的事务已经持久化（组提交模式下提交当前组）
+    virtual void flushCommits() = 0;
+
+    /// @brief 设置嵌套事务的写入被外层回滚时的回调
+    /// @param listener 回调（调用方据此使已更新的内存状态失效）
+    virtual void setRollbackListener(std::function<void()> listener) = 0;
+
+    /// @brief 写后模式重做日志的基础路径
+    /// @return 路径；为空表示后端不支持写后模式
+    [[nodiscard]] virtual std::string getJournalBasePath() const = 0;
+
+    // ==================== 玩家 ====================
+
+    /// @brief 创建玩家
+    /// @param playerData 玩家数据
+    /// @return 是否创建成功
+    /// @throw DatabaseException 玩家已存在或写入失败时
+    virtual bool createPlayer(const PlayerData& playerData) = 0;
+
+    /// @brief 根据XUID获取玩家
+    /// @param xuid 玩家XUID
+    /// @return 玩家数据
+    [[nodiscard]] virtual std::optional<PlayerData> getPlayerByXuid(const std::string& xuid) const = 0;
+
+    /// @brief 玩家是否存在
+    /// @param xuid 玩家XUID
+    [[nodiscard]] virtual bool playerExists(const std::string& xuid) const = 0;
+
+    /// @brief 更新玩家用户名
+    /// @param xuid 玩家XUID
+    /// @param username 新用户名
+    /// @return 玩家不存在时返回 false
+    virtual bool updateUsername(const std::string& xuid, const std::string& username) = 0;
+
+    /// @brief 获取玩家总数
+    [[nodiscard]] virtual int getPlayerCount() const = 0;
+
+    // ==================== 余额 ====================
+
+    /// @brief 获取玩家余额
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @return 余额；没有余额记录时返回空
+    [[nodiscard]] virtual std::optional<int>
+    getBalance(const std::string& xuid, const std::string& currencyId) const = 0;
+
+    /// @brief 获取玩家的全部余额
+    /// @param xuid 玩家XUID
+    [[nodiscard]] virtual std::vector<PlayerBalance> getAllBalances(const std::string& xuid) const = 0;
+
+    /// @brief 初始化余额（已存在时不修改）
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @param initialBalance 初始余额
+    /// @return 是否成功
+    virtual bool initializeBalance(const std::string& xuid, const std::string& currencyId, int initialBalance) = 0;
+
+    /// @brief 在原余额上加 delta，结果不在 [minBalance, maxBalance] 内时不修改
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @param delta 变化量
+    /// @param minBalance 允许的最小余额
+    /// @param maxBalance 允许的最大余额
+    /// @param initialBalance 没有余额记录时以该值为原余额创建记录（为空时不创建）
+    /// @return 新余额；玩家不存在、没有记录且不允许创建或结果越界时返回空
+    virtual std::optional<int> applyBalanceDelta(
+        const std::string& xuid,
+        const std::string& currencyId,
+        int64_t            delta,
+        int64_t            minBalance,
+        int64_t            maxBalance,
+        std::optional<int> initialBalance = std::nullopt
+    ) = 0;
+
+    /// @brief 把余额设置为指定值（没有记录时创建）
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID
+    /// @param balance 新余额
+    /// @return 新余额；玩家不存在时返回空
+    virtual std::optional<int> assignBalance(const std::string& xuid, const std::string& currencyId, int balance) = 0;
+
+    /// @brief 获取某币种的全部余额（含用户名）
+    /// @param currencyId 币种ID
+    [[nodiscard]] virtual std::vector<TopBalanceEntry> getCurrencyBalanceList(const std::string& currencyId) const = 0;
+
+    /// @brief 获取某币种的余额总和
+    /// @param currencyId 币种ID
+    [[nodiscard]] virtual int64_t getTotalWealth(const std::string& currencyId) const = 0;
+
+    // ==================== 集合操作 ====================
+    // 只修改余额实际变化的账户，并为每个账户写入一条交易记录：
+    // 加减与比例调整记为 ADD/REDUCE（金额为变化量），统一设置与截断记为 SET（金额为新余额）
+
+    /// @brief 所有余额加上 amount，结果不超过 max(原余额, maxBalance)
+    /// @return 修改的账户数量
+    virtual int64_t
+    addToAllBalances(const std::string& currencyId, int amount, int maxBalance, const std::string& description) = 0;
+
+    /// @brief 所有余额乘以 rateMicros / 1000000，结果不超过 max(原余额, maxBalance)
+    /// @return 修改的账户数量
+    virtual int64_t scaleAllBalances(
+        const std::string& currencyId,
+        int64_t            rateMicros,
+        bool               roundUp,
+        int                maxBalance,
+        const std::string& description
+    ) = 0;
+
+    /// @brief 所有余额设置为 balance
+    /// @return 修改的账户数量
+    virtual int64_t assignAllBalances(const std::string& currencyId, int balance, const std::string& description) = 0;
+
+    /// @brief 超过 maxBalance 的余额截断为 maxBalance
+    /// @return 修改的账户数量
+    virtual int64_t clampAllBalances(const std::string& currencyId, int maxBalance, const std::string& description) = 0;
+
+    // ==================== 交易记录 ====================
+
+    /// @brief 写入交易记录（记录ID由后端分配）
+    /// @param record 交易记录
+    /// @return 是否写入成功
+    virtual bool createTransaction(const TransactionRecord& record) = 0;
+
+    /// @brief 按页码获取玩家交易记录
+    /// @param xuid 玩家XUID
+    /// @param currencyId 币种ID（为空表示所有币种）
+    /// @param page 页码（从 1 开始）
+    /// @param pageSize 每页数量
+    [[nodiscard]] virtual std::vector<TransactionRecord>
+    getPlayerTransactions(const std::string& xuid, const std::string& currencyId, int page, int pageSize) const = 0;
+
+    /// @brief 按游标分页获取玩家交易记录
+    /// @param xuid 玩家XUID
+    /// @param filter 过滤条件
+    /// @param cursor 上一页返回的游标（为空表示第一页）
+    /// @param pageSize 每页数量
+    /// @throw InvalidArgumentException 游标无效时
+    [[nodiscard]] virtual TransactionPage getPlayerTransactionsPage(
+        const std::string&       xuid,
+        const TransactionFilter& filter,
+        const std::string&       cursor,
+        int                      pageSize
+    ) const = 0;
+
+    /// @brief 获取玩家交易记录总数（不含已归档的记录）
+    /// @param xuid 玩家XUID
+    [[nodiscard]] virtual int getPlayerTransactionCount(const std::string& xuid) const = 0;
+
+    /// @brief 归档早于保留期的交易记录
+    /// @param daysToKeep 保留天数
+    /// @param stopToken 分批归档的后端在批次之间检查，请求停止时保留已完成的批次并返回
+    /// @return 归档的记录数量
+    /// @throw InvalidArgumentException 保留天数小于 1 时
+    virtual int64_t archiveOldTransactions(int daysToKeep, std::stop_token stopToken = {}) = 0;
+
+    /// @brief 获取已写入的重做日志序号
+    [[nodiscard]] virtual uint64_t getJournalCheckpoint() const = 0;
+
+    /// @brief 更新已写入的重做日志序号
+    /// @param sequence 序号
+    virtual void setJournalCheckpoint(uint64_t sequence) = 0;
+};
+
+/// @brief 根据配置创建存储后端（未打开）
+/// @param config 数据库配置
+/// @return 存储后端
+/// @throw InvalidArgumentException 后端名称无效时
+std::unique_ptr<StorageBackend> createStorageBackend(const DatabaseConfig& config);
+
+/// @brief 编码交易记录分页游标：十六进制时间戳与记录ID，以 '.' 分隔
+/// @param timestamp 本页最后一条记录的时间戳
+/// @param id 本页最后一条记录的ID
+std::string encodeTransactionCursor(int64_t timestamp, int64_t id);
+
+/// @brief 解析交易记录分页游标
+/// @param cursor 游标
+/// @return (时间戳, 记录ID)；格式无效时返回空
+std::optional<std::pair<int64_t, int64_t>> decodeTransactionCursor(std::string_view cursor);
+
+/// @brief 把 24 位十六进制转账ID压缩为 12 字节
+/// @return 压缩结果；格式不符时返回空（按原文本存储）
+std::optional<std::array<unsigned char, 12>> packTransferId(std::string_view transferId);
+
+/// @brief 还原压缩的转账ID（小写十六进制）
+/// @param bytes 压缩后的字节
+/// @param size 字节数
+std::string unpackTransferId(const unsigned char* bytes, size_t size);
+
+} // namespace rlx_money
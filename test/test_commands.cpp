@@ -1,6 +1,7 @@
 #include "common/ConfigManager.hpp"
 #include "mod/config/ConfigStructures.h"
 #include "mocks/MockLeviLaminaAPI.h"
+#include "mod/database/DatabaseManager.h"
 #include "mod/economy/EconomyManager.h"
 #include "utils/CommandTestHelper.h"
 #include "utils/TestTempManager.h"
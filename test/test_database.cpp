@@ -2,10 +2,25 @@
 #include "mod/dao/TransactionDAO.h"
 #include <RLXMoney/data/DataStructures.h>
 #include "mod/database/DatabaseManager.h"
+#include "mod/database/DatabaseRestore.h"
+#include "mod/exceptions/MoneyException.h"
+#include "mod/storage/LedgerStorageBackend.h"
+#include "mod/storage/MemoryStorageBackend.h"
+#include "mod/storage/SqliteStorageBackend.h"
 #include "utils/TestTempManager.h"
+#include <SQLiteCpp/Transaction.h>
 #include <catch2/catch_all.hpp>
 #include <chrono>
 #include <filesystem>
+#include <fstream>
+#include <future>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <sqlite3.h>
+#include <stop_token>
+#include <thread>
+#include <vector>
 
 
 // ============================================================================
@@ -56,6 +71,394 @@ TEST_CASE("DatabaseManager 测试", "[database][manager]") {
         // 关闭连接（文件会自动清理）
         manager.close();
     }
+
+    SECTION("预编译语句缓存") {
+        auto& manager = rlx_money::DatabaseManager::getInstance();
+        REQUIRE(manager.initialize(testDbPath));
+
+        rlx_money::PlayerDAO playerDAO(manager);
+        auto                 before = manager.getStatementCacheStats();
+
+        // 同一条查询重复执行：首次编译，之后全部命中缓存
+        for (int i = 0; i < 5; ++i) {
+            REQUIRE_FALSE(playerDAO.playerExists("nobody"));
+        }
+        auto after = manager.getStatementCacheStats();
+        REQUIRE(after.misses == before.misses + 1);
+        REQUIRE(after.hits == before.hits + 4);
+
+        // 复用的语句必须重新绑定参数，不能残留上一次的结果
+        REQUIRE(playerDAO.createPlayer(rlx_money::PlayerData("cache1", "cacheplayer", 1600000000)));
+        REQUIRE(playerDAO.playerExists("cache1"));
+        REQUIRE_FALSE(playerDAO.playerExists("cache2"));
+
+        // 嵌套借出同一条 SQL 时使用临时语句，互不干扰
+        {
+            auto outer = manager.prepareCached("SELECT xuid FROM players WHERE xuid = ?");
+            outer->bind(1, "cache1");
+            REQUIRE(outer->executeStep());
+            auto inner = manager.prepareCached("SELECT xuid FROM players WHERE xuid = ?");
+            inner->bind(1, "cache2");
+            REQUIRE_FALSE(inner->executeStep());
+            REQUIRE(outer->getColumn(0).getString() == "cache1");
+        }
+
+        // 关闭连接后缓存失效
+        manager.close();
+        REQUIRE(manager.getStatementCacheStats().entries == 0);
+    }
+
+    SECTION("WAL 模式与只读连接池") {
+        auto& manager = rlx_money::DatabaseManager::getInstance();
+
+        rlx_money::DatabaseConfig config;
+        config.path         = testDbPath;
+        config.journalMode  = "WAL";
+        config.readPoolSize = 2;
+        REQUIRE(manager.initialize(config));
+        REQUIRE(manager.isWalEnabled());
+        REQUIRE(manager.getReadPoolSize() == 2);
+
+        rlx_money::PlayerDAO playerDAO(manager);
+        REQUIRE(playerDAO.createPlayer(rlx_money::PlayerData("wal1", "walplayer", 1600000000)));
+        REQUIRE(playerDAO.initializeBalance("wal1", "gold", 100));
+
+        // 只读连接能读到写连接已提交的数据
+        REQUIRE(playerDAO.playerExists("wal1"));
+        REQUIRE(playerDAO.getBalance("wal1", "gold") == 100);
+
+        // 只读连接上的未完成查询不阻塞写入
+        {
+            auto reader = manager.prepareRead(
+                "SELECT balance FROM player_balances WHERE account_id = (SELECT id FROM accounts WHERE xuid = ?)"
+            );
+            reader->bind(1, "wal1");
+            REQUIRE(reader->executeStep());
+            REQUIRE(playerDAO.updateBalance("wal1", "gold", 200));
+            REQUIRE(reader->getColumn(0).getInt() == 100);
+        }
+        REQUIRE(playerDAO.getBalance("wal1", "gold") == 200);
+
+        // 构建排行榜的全表扫描不等待写连接
+        {
+            std::optional writer  = manager.prepareCached("SELECT 1");
+            auto          scanned = std::async(std::launch::async, [&]() {
+                return playerDAO.getCurrencyBalanceList("gold").size();
+            });
+            bool finished = scanned.wait_for(std::chrono::seconds(5)) == std::future_status::ready;
+            writer.reset();
+            REQUIRE(finished);
+            REQUIRE(scanned.get() == 1);
+        }
+
+        // 事务内的读取走写连接，能看到本事务未提交的修改
+        REQUIRE_FALSE(manager.executeTransaction([&](SQLite::Database&) {
+            REQUIRE(playerDAO.updateBalance("wal1", "gold", 300));
+            REQUIRE(playerDAO.getBalance("wal1", "gold") == 300);
+            return false; // 回滚
+        }));
+        REQUIRE(playerDAO.getBalance("wal1", "gold") == 200);
+
+        // 检查点
+        auto result = manager.checkpoint(rlx_money::CheckpointMode::Truncate);
+        REQUIRE_FALSE(result.busy);
+        REQUIRE(result.logFrames == 0);
+
+        manager.close();
+        REQUIRE(manager.getReadPoolSize() == 0);
+        REQUIRE_FALSE(manager.isWalEnabled());
+    }
+
+    SECTION("异步写线程") {
+        auto& manager = rlx_money::DatabaseManager::getInstance();
+
+        rlx_money::DatabaseConfig config;
+        config.path        = testDbPath;
+        config.journalMode = "WAL";
+        config.asyncWriter = true;
+        REQUIRE(manager.initialize(config));
+        REQUIRE(manager.isAsyncWriterEnabled());
+
+        rlx_money::PlayerDAO playerDAO(manager);
+        REQUIRE(playerDAO.createPlayer(rlx_money::PlayerData("async1", "asyncplayer", 1600000000)));
+        REQUIRE(playerDAO.initializeBalance("async1", "gold", 0));
+
+        // 多个线程并发投递，写线程按顺序提交
+        constexpr int            threadCount = 4;
+        constexpr int            perThread   = 25;
+        std::vector<std::thread> producers;
+        for (int t = 0; t < threadCount; ++t) {
+            producers.emplace_back([&manager] {
+                for (int i = 0; i < perThread; ++i) {
+                    (void)manager.submitTransaction([](SQLite::Database& db) {
+                        db.exec(
+                            "UPDATE player_balances SET balance = balance + 1 "
+                            "WHERE account_id = (SELECT id FROM accounts WHERE xuid = 'async1')"
+                        );
+                        return true;
+                    });
+                }
+            });
+        }
+        for (auto& producer : producers) {
+            producer.join();
+        }
+        manager.flushWrites();
+        REQUIRE(playerDAO.getBalance("async1", "gold") == threadCount * perThread);
+
+        // 同一线程投递后立即读取，能读到自己的写入
+        auto handle = manager.submitTransaction([&](SQLite::Database&) {
+            return playerDAO.updateBalance("async1", "gold", 500);
+        });
+        REQUIRE(playerDAO.getBalance("async1", "gold") == 500);
+        REQUIRE(handle.get());
+
+        // 回滚与异常通过句柄返回
+        auto rolledBack = manager.submitTransaction([](SQLite::Database& db) {
+            db.exec(
+                "UPDATE player_balances SET balance = 0 "
+                "WHERE account_id = (SELECT id FROM accounts WHERE xuid = 'async1')"
+            );
+            return false;
+        });
+        REQUIRE_FALSE(rolledBack.get());
+        auto failed = manager.submitTransaction([](SQLite::Database& db) {
+            db.exec("UPDATE no_such_table SET x = 1");
+            return true;
+        });
+        REQUIRE_THROWS_AS(failed.get(), rlx_money::DatabaseException);
+
+        // 同步事务接口在异步模式下仍然可用
+        REQUIRE(manager.executeTransaction([&](SQLite::Database&) {
+            return playerDAO.updateBalance("async1", "gold", 600);
+        }));
+        REQUIRE(playerDAO.getBalance("async1", "gold") == 600);
+
+        // 关闭前会提交队列中剩余的事务
+        for (int i = 0; i < 10; ++i) {
+            (void)manager.submitTransaction([](SQLite::Database& db) {
+                db.exec(
+                    "UPDATE player_balances SET balance = balance + 1 "
+                    "WHERE account_id = (SELECT id FROM accounts WHERE xuid = 'async1')"
+                );
+                return true;
+            });
+        }
+        manager.close();
+        REQUIRE_FALSE(manager.isAsyncWriterEnabled());
+        REQUIRE(manager.initialize(testDbPath));
+        REQUIRE(playerDAO.getBalance("async1", "gold") == 610);
+        manager.close();
+    }
+
+    SECTION("组提交") {
+        auto& manager = rlx_money::DatabaseManager::getInstance();
+
+        rlx_money::DatabaseConfig config;
+        config.path        = testDbPath;
+        config.journalMode = "WAL";
+        config.groupCommit = true;
+        REQUIRE(manager.initialize(config));
+        REQUIRE(manager.isGroupCommitEnabled());
+
+        rlx_money::PlayerDAO playerDAO(manager);
+        REQUIRE(playerDAO.createPlayer(rlx_money::PlayerData("group1", "groupplayer", 1600000000)));
+        REQUIRE(playerDAO.initializeBalance("group1", "gold", 0));
+
+        // 同一 tick 内的多个写事务合并为一个组事务
+        for (int i = 0; i < 50; ++i) {
+            REQUIRE(manager.executeTransaction([](SQLite::Database& db) {
+                db.exec(
+                    "UPDATE player_balances SET balance = balance + 1 "
+                    "WHERE account_id = (SELECT id FROM accounts WHERE xuid = 'group1')"
+                );
+                return true;
+            }));
+        }
+
+        // 失败的操作只回滚自己的保存点
+        REQUIRE_FALSE(manager.executeTransaction([](SQLite::Database& db) {
+            db.exec(
+                "UPDATE player_balances SET balance = 0 "
+                "WHERE account_id = (SELECT id FROM accounts WHERE xuid = 'group1')"
+            );
+            return false;
+        }));
+        REQUIRE_THROWS_AS(
+            manager.executeTransaction([](SQLite::Database& db) {
+                db.exec(
+                    "UPDATE player_balances SET balance = -1 "
+                    "WHERE account_id = (SELECT id FROM accounts WHERE xuid = 'group1')"
+                );
+                db.exec("UPDATE no_such_table SET x = 1");
+                return true;
+            }),
+            rlx_money::DatabaseException
+        );
+
+        // 提交前的读取能看到组内已完成的操作
+        REQUIRE(manager.getGroupCommitStats().commits == 0);
+        REQUIRE(playerDAO.getBalance("group1", "gold") == 50);
+
+        manager.flushGroupCommit();
+        auto stats = manager.getGroupCommitStats();
+        REQUIRE(stats.commits == 1);
+        REQUIRE(stats.operations == 52);
+        REQUIRE(stats.failedOperations == 2);
+
+        // 关闭时提交未结束的组事务
+        REQUIRE(manager.executeTransaction([&](SQLite::Database&) {
+            return playerDAO.updateBalance("group1", "gold", 77);
+        }));
+        manager.close();
+        REQUIRE(manager.initialize(testDbPath));
+        REQUIRE(playerDAO.getBalance("group1", "gold") == 77);
+        manager.close();
+    }
+
+    SECTION("异步写线程按批组提交") {
+        auto& manager = rlx_money::DatabaseManager::getInstance();
+        manager.resetForTesting();
+
+        rlx_money::DatabaseConfig config;
+        config.path        = testDbPath;
+        config.journalMode = "WAL";
+        config.asyncWriter = true;
+        config.groupCommit = true;
+        REQUIRE(manager.initialize(config));
+
+        rlx_money::PlayerDAO playerDAO(manager);
+        REQUIRE(playerDAO.createPlayer(rlx_money::PlayerData("group2", "groupplayer2", 1600000000)));
+        REQUIRE(playerDAO.initializeBalance("group2", "gold", 0));
+
+        // 先让写线程阻塞在一个事务上，使后续请求在队列中堆积
+        std::promise<void> release;
+        auto               gate = manager.submitTransaction([opened = release.get_future().share()](SQLite::Database&) {
+            opened.wait();
+            return true;
+        });
+
+        std::vector<rlx_money::WriteHandle> handles;
+        for (int i = 0; i < 200; ++i) {
+            handles.push_back(manager.submitTransaction([](SQLite::Database& db) {
+                db.exec(
+                    "UPDATE player_balances SET balance = balance + 1 "
+                    "WHERE account_id = (SELECT id FROM accounts WHERE xuid = 'group2')"
+                );
+                return true;
+            }));
+        }
+        auto failed = manager.submitTransaction([](SQLite::Database& db) {
+            db.exec("UPDATE no_such_table SET x = 1");
+            return true;
+        });
+        release.set_value();
+        REQUIRE(gate.get());
+        for (auto& handle : handles) {
+            REQUIRE(handle.get());
+        }
+        REQUIRE_THROWS_AS(failed.get(), rlx_money::DatabaseException);
+
+        REQUIRE(playerDAO.getBalance("group2", "gold") == 200);
+        REQUIRE(manager.getGroupCommitStats().commits <= 2);
+        manager.close();
+    }
+
+    SECTION("日志模式配置校验") {
+        rlx_money::DatabaseConfig config;
+        REQUIRE_NOTHROW(config.validate());
+
+        config.journalMode = "MEMORY";
+        REQUIRE_THROWS_AS(config.validate(), std::invalid_argument);
+
+        config.journalMode  = "WAL";
+        config.readPoolSize = -1;
+        REQUIRE_THROWS_AS(config.validate(), std::invalid_argument);
+    }
+
+    SECTION("SQLite 参数配置") {
+        auto& manager = rlx_money::DatabaseManager::getInstance();
+        manager.resetForTesting();
+
+        auto pragma = [](SQLite::Database& db, const std::string& name) {
+            return db.execAndGet("PRAGMA " + name).getInt64();
+        };
+
+        rlx_money::DatabaseConfig config;
+        config.path              = testDbPath;
+        config.synchronous       = "FULL";
+        config.pageSize          = 8192;
+        config.cacheSizeKB       = 4096;
+        config.mmapSizeMB        = 0;
+        config.busyTimeoutMs     = 2500;
+        config.walAutocheckpoint = 500;
+        REQUIRE(manager.initialize(config));
+
+        auto& db = manager.getConnection();
+        REQUIRE(pragma(db, "synchronous") == 2);
+        REQUIRE(pragma(db, "page_size") == 8192);
+        REQUIRE(pragma(db, "cache_size") == -4096);
+        REQUIRE(pragma(db, "mmap_size") == 0);
+        REQUIRE(pragma(db, "busy_timeout") == 2500);
+        REQUIRE(pragma(db, "wal_autocheckpoint") == 500);
+        REQUIRE(manager.getCacheSizeKB() == 4096);
+
+        // 自动模式：小数据库按最小缓存分配
+        manager.close();
+        config.cacheSizeKB    = 0;
+        config.memoryBudgetMB = 64;
+        REQUIRE(manager.initialize(config));
+        REQUIRE(manager.getCacheSizeKB() == 2048);
+        REQUIRE(pragma(manager.getConnection(), "cache_size") == -2048);
+
+        // 数据库增大后按文件大小分配，超过预算时以预算为上限（WAL 模式下由写连接与只读连接平分）
+        manager.getConnection().exec(
+            "CREATE TABLE filler(data BLOB);"
+            "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 2000) "
+            "INSERT INTO filler SELECT zeroblob(4096) FROM n"
+        );
+        manager.close();
+        auto fileKB = static_cast<int64_t>(std::filesystem::file_size(testDbPath) / 1024);
+        REQUIRE(manager.initialize(config));
+        REQUIRE(manager.getCacheSizeKB() == fileKB + fileKB / 4);
+
+        manager.close();
+        config.journalMode    = "WAL";
+        config.readPoolSize   = 3;
+        config.memoryBudgetMB = 8;
+        REQUIRE(manager.initialize(config));
+        REQUIRE(manager.getCacheSizeKB() == 8 * 1024 / 4);
+        manager.close();
+    }
+
+    SECTION("SQLite 参数配置校验") {
+        rlx_money::DatabaseConfig config;
+        config.synchronous = "FAST";
+        REQUIRE_THROWS_AS(config.validate(), std::invalid_argument);
+
+        config          = rlx_money::DatabaseConfig();
+        config.pageSize = 3000;
+        REQUIRE_THROWS_AS(config.validate(), std::invalid_argument);
+        config.pageSize = 131072;
+        REQUIRE_THROWS_AS(config.validate(), std::invalid_argument);
+
+        config                = rlx_money::DatabaseConfig();
+        config.memoryBudgetMB = 0;
+        REQUIRE_THROWS_AS(config.validate(), std::invalid_argument);
+
+        config               = rlx_money::DatabaseConfig();
+        config.busyTimeoutMs = -1;
+        REQUIRE_THROWS_AS(config.validate(), std::invalid_argument);
+
+        config                   = rlx_money::DatabaseConfig();
+        config.walAutocheckpoint = -1;
+        REQUIRE_THROWS_AS(config.validate(), std::invalid_argument);
+
+        config             = rlx_money::DatabaseConfig();
+        config.synchronous = "EXTRA";
+        config.pageSize    = 65536;
+        REQUIRE_NOTHROW(config.validate());
+    }
 }
 
 // ============================================================================
@@ -181,6 +584,1527 @@ TEST_CASE("PlayerDAO 测试", "[database][dao][player]") {
         dbManager.close();
         // 文件会自动清理
     }
+
+    SECTION("原子余额调整") {
+        auto& dbManager = rlx_money::DatabaseManager::getInstance();
+        REQUIRE(dbManager.initialize(testDbPath));
+
+        rlx_money::PlayerDAO playerDAO(dbManager);
+
+        rlx_money::PlayerData player("12345", "testplayer", 1600000000);
+        REQUIRE(playerDAO.createPlayer(player));
+
+        // 余额记录不存在且未提供初始余额时不创建记录
+        REQUIRE_FALSE(playerDAO.applyBalanceDelta("12345", "gold", 100, 0, 10000).has_value());
+        REQUIRE_FALSE(playerDAO.getBalance("12345", "gold").has_value());
+
+        // 以初始余额为基础创建记录
+        auto created = playerDAO.applyBalanceDelta("12345", "gold", 100, 0, 10000, 500);
+        REQUIRE(created.has_value());
+        REQUIRE(created.value() == 600);
+
+        // 在已有余额上调整
+        auto reduced = playerDAO.applyBalanceDelta("12345", "gold", -200, 0, 10000);
+        REQUIRE(reduced.has_value());
+        REQUIRE(reduced.value() == 400);
+
+        // 超出范围时不做修改
+        REQUIRE_FALSE(playerDAO.applyBalanceDelta("12345", "gold", -401, 0, 10000).has_value());
+        REQUIRE_FALSE(playerDAO.applyBalanceDelta("12345", "gold", 9601, 0, 10000).has_value());
+        REQUIRE(playerDAO.getBalance("12345", "gold").value() == 400);
+
+        // 玩家不存在时不创建记录
+        REQUIRE_FALSE(playerDAO.applyBalanceDelta("nonexistent", "gold", 100, 0, 10000, 500).has_value());
+        REQUIRE_FALSE(playerDAO.getBalance("nonexistent", "gold").has_value());
+
+        // 直接设置余额
+        auto assigned = playerDAO.assignBalance("12345", "gold", 7000);
+        REQUIRE(assigned.has_value());
+        REQUIRE(assigned.value() == 7000);
+        auto assignedNew = playerDAO.assignBalance("12345", "silver", 30);
+        REQUIRE(assignedNew.has_value());
+        REQUIRE(assignedNew.value() == 30);
+        REQUIRE_FALSE(playerDAO.assignBalance("nonexistent", "gold", 1).has_value());
+
+        dbManager.close();
+    }
+}
+
+// ============================================================================
+// 汇总表测试
+// ============================================================================
+
+TEST_CASE("汇总表测试", "[database][aggregates]") {
+    auto&             tempManager = rlx_money::test::TestTempManager::getInstance();
+    const std::string testDbPath  = tempManager.makeUniquePath("test_aggregates", ".db");
+    tempManager.registerFile(testDbPath);
+
+    auto& dbManager = rlx_money::DatabaseManager::getInstance();
+    REQUIRE(dbManager.initialize(testDbPath));
+
+    rlx_money::PlayerDAO      playerDAO(dbManager);
+    rlx_money::TransactionDAO transactionDAO(dbManager);
+
+    REQUIRE(playerDAO.createPlayer(rlx_money::PlayerData("agg1", "player1", 1600000000)));
+    REQUIRE(playerDAO.createPlayer(rlx_money::PlayerData("agg2", "player2", 1600000000)));
+    REQUIRE(playerDAO.createPlayer(rlx_money::PlayerData("agg3", "player3", 1600000000)));
+
+    SECTION("触发器同步维护汇总值") {
+        REQUIRE(playerDAO.getPlayerCount() == 3);
+        REQUIRE(playerDAO.getTotalWealth("gold") == 0);
+
+        // 总财富超过 int 范围时不溢出
+        REQUIRE(playerDAO.initializeBalance("agg1", "gold", 2000000000));
+        REQUIRE(playerDAO.initializeBalance("agg2", "gold", 1500000000));
+        REQUIRE(playerDAO.initializeBalance("agg3", "silver", 10));
+        REQUIRE(playerDAO.getTotalWealth("gold") == 3500000000LL);
+        REQUIRE(playerDAO.getTotalWealth("silver") == 10);
+
+        // 余额修改与删除
+        REQUIRE(playerDAO.updateBalance("agg2", "gold", 500));
+        REQUIRE(playerDAO.getTotalWealth("gold") == 2000000500LL);
+        REQUIRE(playerDAO.applyBalanceDelta("agg1", "gold", -1000000000, 0, 2000000000).has_value());
+        REQUIRE(playerDAO.getTotalWealth("gold") == 1000000500LL);
+
+        // 直接执行的 SQL 同样会被触发器计入
+        REQUIRE(dbManager.executeTransaction([](SQLite::Database& db) {
+            db.exec(
+                "UPDATE player_balances SET currency_key = (SELECT id FROM currency_keys WHERE code = 'silver') "
+                "WHERE account_id = (SELECT id FROM accounts WHERE xuid = 'agg2')"
+            );
+            db.exec("DELETE FROM players WHERE xuid = 'agg3'");
+            db.exec("DELETE FROM player_balances WHERE account_id = (SELECT id FROM accounts WHERE xuid = 'agg3')");
+            return true;
+        }));
+        REQUIRE(playerDAO.getPlayerCount() == 2);
+        REQUIRE(playerDAO.getTotalWealth("gold") == 1000000000LL);
+        REQUIRE(playerDAO.getTotalWealth("silver") == 500);
+
+        // 交易记录数量
+        for (int i = 0; i < 3; ++i) {
+            REQUIRE(transactionDAO.createTransaction(rlx_money::TransactionRecord(
+                0,
+                "agg1",
+                "gold",
+                1,
+                1,
+                rlx_money::TransactionType::ADD,
+                "汇总",
+                1600000000 + i
+            )));
+        }
+        REQUIRE(transactionDAO.createTransaction(
+            rlx_money::TransactionRecord(0, "agg2", "gold", 1, 1, rlx_money::TransactionType::ADD, "汇总", 1600000000)
+        ));
+        REQUIRE(transactionDAO.getPlayerTransactionCount("agg1") == 3);
+        REQUIRE(transactionDAO.getPlayerTransactionCount("agg2") == 1);
+        REQUIRE(transactionDAO.getPlayerTransactionCount("nobody") == 0);
+        REQUIRE(transactionDAO.getTotalTransactionCount() == 4);
+
+        REQUIRE(dbManager.executeTransaction([](SQLite::Database& db) {
+            db.exec(
+                "DELETE FROM transactions WHERE account_id = (SELECT id FROM accounts WHERE xuid = 'agg1') "
+                "AND timestamp < 1600000002"
+            );
+            return true;
+        }));
+        REQUIRE(transactionDAO.getPlayerTransactionCount("agg1") == 1);
+        REQUIRE(transactionDAO.getTotalTransactionCount() == 2);
+        REQUIRE(transactionDAO.getTransactionCountByType(rlx_money::TransactionType::ADD) == 2);
+        REQUIRE(transactionDAO.getTransactionCountByType(rlx_money::TransactionType::SET) == 0);
+
+        // 回滚的事务不影响汇总值
+        REQUIRE_FALSE(dbManager.executeTransaction([](SQLite::Database& db) {
+            db.exec("DELETE FROM player_balances");
+            db.exec("DELETE FROM transactions");
+            return false;
+        }));
+        REQUIRE(playerDAO.getTotalWealth("gold") == 1000000000LL);
+        REQUIRE(transactionDAO.getTotalTransactionCount() == 2);
+
+        REQUIRE(dbManager.verifyAggregates().consistent());
+    }
+
+    SECTION("校验与修复") {
+        REQUIRE(playerDAO.initializeBalance("agg1", "gold", 100));
+        REQUIRE(playerDAO.initializeBalance("agg2", "gold", 200));
+        REQUIRE(transactionDAO.createTransaction(
+            rlx_money::TransactionRecord(0, "agg1", "gold", 1, 1, rlx_money::TransactionType::ADD, "汇总", 1600000000)
+        ));
+        REQUIRE(dbManager.verifyAggregates().consistent());
+
+        // 人为篡改汇总表
+        REQUIRE(dbManager.executeTransaction([](SQLite::Database& db) {
+            db.exec("UPDATE currency_aggregates SET total_wealth = 1");
+            db.exec("UPDATE player_aggregates SET transaction_count = 9");
+            db.exec("UPDATE global_aggregates SET player_count = 99");
+            db.exec("UPDATE type_aggregates SET transaction_count = 5");
+            return true;
+        }));
+
+        auto detected = dbManager.verifyAggregates();
+        REQUIRE_FALSE(detected.consistent());
+        REQUIRE(detected.mismatchedCurrencies == 1);
+        REQUIRE(detected.mismatchedPlayers == 1);
+        REQUIRE(detected.mismatchedTypes == 1);
+        REQUIRE(detected.globalMismatch);
+        REQUIRE_FALSE(detected.repaired);
+        REQUIRE(playerDAO.getTotalWealth("gold") == 1);
+
+        auto repaired = dbManager.verifyAggregates(true);
+        REQUIRE(repaired.repaired);
+        REQUIRE(dbManager.verifyAggregates().consistent());
+        REQUIRE(playerDAO.getTotalWealth("gold") == 300);
+        REQUIRE(transactionDAO.getTransactionCountByType(rlx_money::TransactionType::ADD) == 1);
+        REQUIRE(playerDAO.getPlayerCount() == 3);
+        REQUIRE(transactionDAO.getPlayerTransactionCount("agg1") == 1);
+    }
+
+    SECTION("升级时回填汇总表") {
+        REQUIRE(playerDAO.initializeBalance("agg1", "gold", 100));
+        REQUIRE(playerDAO.initializeBalance("agg3", "gold", 50));
+        REQUIRE(transactionDAO.createTransaction(
+            rlx_money::TransactionRecord(0, "agg3", "gold", 1, 1, rlx_money::TransactionType::ADD, "汇总", 1600000000)
+        ));
+
+        // 模拟没有汇总表的旧数据库
+        REQUIRE(dbManager.executeTransaction([](SQLite::Database& db) {
+            db.exec("DROP TABLE currency_aggregates");
+            db.exec("DROP TABLE player_aggregates");
+            db.exec("DROP TABLE global_aggregates");
+            return true;
+        }));
+        dbManager.close();
+
+        REQUIRE(dbManager.initialize(testDbPath));
+        REQUIRE(playerDAO.getPlayerCount() == 3);
+        REQUIRE(playerDAO.getTotalWealth("gold") == 150);
+        REQUIRE(transactionDAO.getPlayerTransactionCount("agg3") == 1);
+        REQUIRE(transactionDAO.getTotalTransactionCount() == 1);
+        REQUIRE(dbManager.verifyAggregates().consistent());
+    }
+
+    dbManager.close();
+}
+
+// ============================================================================
+// 数据库结构迁移测试
+// ============================================================================
+
+namespace {
+
+/// @brief 创建第 1 版结构（文本键、文本交易类型）的数据库
+void createLegacyDatabase(const std::string& path) {
+    SQLite::Database db(path, SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE);
+    db.exec(R"(
+        CREATE TABLE players (
+            xuid TEXT PRIMARY KEY, username TEXT NOT NULL, first_join_time INTEGER NOT NULL,
+            created_at INTEGER NOT NULL, updated_at INTEGER NOT NULL
+        );
+        CREATE TABLE player_balances (
+            xuid TEXT NOT NULL, currency_id TEXT NOT NULL, balance INTEGER NOT NULL DEFAULT 0,
+            updated_at INTEGER NOT NULL, PRIMARY KEY (xuid, currency_id),
+            FOREIGN KEY (xuid) REFERENCES players(xuid) ON DELETE CASCADE
+        );
+        CREATE TABLE transactions (
+            id INTEGER PRIMARY KEY AUTOINCREMENT, xuid TEXT NOT NULL, currency_id TEXT NOT NULL,
+            amount INTEGER NOT NULL, balance INTEGER NOT NULL, type TEXT NOT NULL, description TEXT,
+            timestamp INTEGER NOT NULL, related_xuid TEXT, transfer_id TEXT
+        );
+        CREATE INDEX idx_player_balances_xuid ON player_balances(xuid);
+        CREATE INDEX idx_player_balances_currency ON player_balances(currency_id);
+        CREATE INDEX idx_player_balances_balance ON player_balances(balance);
+        CREATE INDEX idx_transactions_xuid ON transactions(xuid);
+        CREATE INDEX idx_transactions_currency ON transactions(currency_id);
+        CREATE INDEX idx_transactions_timestamp ON transactions(timestamp);
+        CREATE INDEX idx_transactions_type ON transactions(type);
+        CREATE INDEX idx_transactions_related_xuid ON transactions(related_xuid);
+        CREATE INDEX idx_transactions_transfer_id ON transactions(transfer_id);
+    )");
+}
+
+/// @brief 像 tick 任务一样反复推进交易记录结构迁移，直到迁移结束
+/// @return 最终的迁移进度
+rlx_money::MigrationProgress finishMigration(rlx_money::DatabaseManager& dbManager) {
+    auto progress = dbManager.stepMigration();
+    while (progress.state == rlx_money::MigrationState::Running) {
+        // 异步写入模式下步骤由写线程执行，之后的 tick 才取回结果
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        progress = dbManager.stepMigration();
+    }
+    return progress;
+}
+
+} // namespace
+
+TEST_CASE("数据库结构迁移测试", "[database][migration]") {
+    auto&             tempManager = rlx_money::test::TestTempManager::getInstance();
+    const std::string testDbPath  = tempManager.makeUniquePath("test_migration", ".db");
+    tempManager.registerFile(testDbPath);
+
+    auto& dbManager = rlx_money::DatabaseManager::getInstance();
+
+    SECTION("旧版本数据就地迁移") {
+        createLegacyDatabase(testDbPath);
+        {
+            SQLite::Database db(testDbPath, SQLite::OPEN_READWRITE);
+            db.exec(R"(
+                INSERT INTO players VALUES ('1001', 'alice', 1600000000, 1600000000, 1600000000);
+                INSERT INTO players VALUES ('1002', 'bob', 1600000000, 1600000000, 1600000000);
+                INSERT INTO player_balances VALUES ('1001', 'gold', 100, 1600000000);
+                INSERT INTO player_balances VALUES ('1001', 'silver', 5, 1600000000);
+                INSERT INTO player_balances VALUES ('1002', 'gold', 2000000000, 1600000000);
+                INSERT INTO transactions VALUES (1, '1001', 'gold', 0, 0, 'initial', '初始', 1600000000, NULL, NULL);
+                INSERT INTO transactions VALUES (2, '1001', 'gold', 150, 150, 'add', '奖励', 1600000001, NULL, NULL);
+                INSERT INTO transactions VALUES
+                    (3, '1001', 'gold', -50, 100, 'transfer', '转出', 1600000002, '1002', 'abcdef0123456789abcdef01');
+                INSERT INTO transactions VALUES
+                    (4, '1002', 'gold', 50, 2000000000, 'transfer', '转入', 1600000002, '1001', 'abcdef0123456789abcdef01');
+                INSERT INTO transactions VALUES (5, '1001', 'silver', 5, 5, 'set', '', 1600000003, NULL, 'legacy-id');
+                INSERT INTO transactions VALUES (6, '9999', 'gold', -1, 0, 'reduce', '已删除的玩家', 1600000004, NULL, NULL);
+                INSERT INTO transactions VALUES (50, '1001', 'gold', 0, 0, 'set', '', 1600000005, NULL, NULL);
+                DELETE FROM transactions WHERE id = 50;
+            )");
+        }
+
+        // 启动时只转换结构与余额，交易记录留在旧表中，由之后的 tick 移入新表
+        REQUIRE(dbManager.initialize(testDbPath));
+        auto& db = dbManager.getConnection();
+        REQUIRE(db.execAndGet("PRAGMA user_version").getInt() == 3);
+        auto balancesSql = db.execAndGet("SELECT sql FROM sqlite_master WHERE name = 'player_balances'").getString();
+        REQUIRE(balancesSql.find("WITHOUT ROWID") != std::string::npos);
+        REQUIRE(db.execAndGet("SELECT COUNT(*) FROM transactions").getInt() == 0);
+        REQUIRE(db.execAndGet("SELECT COUNT(*) FROM transactions_v1").getInt() == 6);
+        REQUIRE(dbManager.getMigrationProgress().state == rlx_money::MigrationState::Running);
+        REQUIRE(dbManager.getMigrationProgress().lastId == 6);
+
+        rlx_money::PlayerDAO      playerDAO(dbManager);
+        rlx_money::TransactionDAO transactionDAO(dbManager);
+
+        REQUIRE(playerDAO.getBalance("1001", "gold") == 100);
+        REQUIRE(playerDAO.getBalance("1001", "silver") == 5);
+        REQUIRE(playerDAO.getBalance("1002", "gold") == 2000000000);
+        REQUIRE(playerDAO.getAllBalances("1001").size() == 2);
+        REQUIRE(playerDAO.getTotalWealth("gold") == 2000000100LL);
+        REQUIRE(playerDAO.getPlayerCount() == 2);
+        REQUIRE(playerDAO.getTopBalanceList("gold", 10).front().username == "bob");
+
+        auto history = transactionDAO.getPlayerTransactions("1001", "", 1, 10);
+        REQUIRE(history.size() == 4);
+        REQUIRE(history[0].type == rlx_money::TransactionType::SET);
+        REQUIRE(history[0].transferId == "legacy-id");
+        REQUIRE(history[1].id == 3);
+        REQUIRE(history[1].type == rlx_money::TransactionType::TRANSFER);
+        REQUIRE(history[1].relatedXuid == "1002");
+        REQUIRE(history[1].transferId == "abcdef0123456789abcdef01");
+        REQUIRE(history[1].description == "转出");
+        REQUIRE(history[3].type == rlx_money::TransactionType::INITIAL);
+        REQUIRE(transactionDAO.getPlayerTransactions("9999", "gold", 1, 10).size() == 1);
+        REQUIRE(transactionDAO.getPlayerTransactionCount("1001") == 4);
+        REQUIRE(transactionDAO.getTotalTransactionCount() == 6);
+        REQUIRE(transactionDAO.getTransactionCountByType(rlx_money::TransactionType::TRANSFER) == 2);
+        REQUIRE(dbManager.verifyAggregates().consistent());
+
+        // 自增序号延续旧表，已删除的ID不会被重新分配
+        REQUIRE(transactionDAO.createTransaction(
+            rlx_money::TransactionRecord(0, "1002", "gold", 1, 1, rlx_money::TransactionType::ADD, "", 1600000006)
+        ));
+        REQUIRE(transactionDAO.getPlayerTransactions("1002", "", 1, 1).front().id == 51);
+        auto recent = transactionDAO.getRecentTransactions(3);
+        REQUIRE(recent.size() == 3);
+        REQUIRE(recent[0].id == 51);
+        REQUIRE(recent[1].id == 6);
+        REQUIRE(recent[2].id == 5);
+
+        // 迁移完成前不按时间范围删除记录
+        REQUIRE_THROWS_AS(transactionDAO.cleanupOldTransactions(1), rlx_money::DatabaseException);
+        REQUIRE_THROWS_AS(transactionDAO.archiveOldTransactions(1), rlx_money::DatabaseException);
+
+        auto progress = finishMigration(dbManager);
+        REQUIRE(progress.state == rlx_money::MigrationState::Completed);
+        REQUIRE(progress.movedRecords == 6);
+        REQUIRE(dbManager.getLegacyTransactions() == nullptr);
+        REQUIRE(db.execAndGet("SELECT COUNT(*) FROM sqlite_master WHERE name LIKE '%_v1'").getInt() == 0);
+        REQUIRE(db.execAndGet("SELECT typeof(type) FROM transactions WHERE id = 1").getString() == "integer");
+        REQUIRE(db.execAndGet("SELECT typeof(transfer_id) FROM transactions WHERE id = 3").getString() == "blob");
+        history = transactionDAO.getPlayerTransactions("1001", "", 1, 10);
+        REQUIRE(history.size() == 4);
+        REQUIRE(history[1].transferId == "abcdef0123456789abcdef01");
+        REQUIRE(transactionDAO.getTotalTransactionCount() == 7);
+        REQUIRE(transactionDAO.getTransactionCountByType(rlx_money::TransactionType::TRANSFER) == 2);
+        REQUIRE(dbManager.verifyAggregates().consistent());
+
+        // 再次打开不会重复迁移
+        dbManager.close();
+        REQUIRE(dbManager.initialize(testDbPath));
+        REQUIRE(dbManager.getMigrationProgress().state == rlx_money::MigrationState::Idle);
+        REQUIRE(playerDAO.getBalance("1002", "gold") == 2000000000);
+        REQUIRE(transactionDAO.getTotalTransactionCount() == 7);
+        dbManager.close();
+    }
+
+    SECTION("中断的迁移重新启动后继续") {
+        createLegacyDatabase(testDbPath);
+        {
+            SQLite::Database db(testDbPath, SQLite::OPEN_READWRITE);
+            db.exec("INSERT INTO players VALUES ('1001', 'alice', 1600000000, 1600000000, 1600000000)");
+            db.exec("INSERT INTO player_balances VALUES ('1001', 'gold', 100, 1600000000)");
+            SQLite::Transaction transaction(db);
+            SQLite::Statement   insert(
+                db,
+                "INSERT INTO transactions VALUES (?, '1001', 'gold', 1, 100, ?, '', ?, NULL, NULL)"
+            );
+            for (int id = 1; id <= 2501; ++id) {
+                insert.bind(1, id);
+                insert.bind(2, id == 2501 ? "unknown" : "add");
+                insert.bind(3, static_cast<int64_t>(1600000000 + id));
+                insert.exec();
+                insert.reset();
+            }
+            transaction.commit();
+        }
+
+        // 无法识别的交易类型在转换结构前拒绝加载，数据库保持原样
+        REQUIRE_THROWS_AS(dbManager.initialize(testDbPath), rlx_money::DatabaseException);
+        {
+            SQLite::Database db(testDbPath, SQLite::OPEN_READWRITE);
+            REQUIRE(db.execAndGet("SELECT COUNT(*) FROM sqlite_master WHERE name LIKE '%_v1'").getInt() == 0);
+            REQUIRE(db.execAndGet("SELECT COUNT(*) FROM transactions").getInt() == 2501);
+            db.exec("UPDATE transactions SET type = 'set' WHERE id = 2501");
+        }
+
+        // 时间预算为 0 时每个 tick 只移动一批
+        rlx_money::DatabaseConfig config;
+        config.path              = testDbPath;
+        config.retentionBudgetMs = 0;
+        REQUIRE(dbManager.initialize(config));
+        auto progress = dbManager.stepMigration();
+        REQUIRE(progress.state == rlx_money::MigrationState::Running);
+        REQUIRE(progress.movedId == 1000);
+        REQUIRE(progress.movedRecords == 1000);
+
+        // 迁移中途的读取合并新旧两表，记录不重复也不遗漏
+        rlx_money::TransactionDAO transactionDAO(dbManager);
+        auto history = transactionDAO.getPlayerTransactions("1001", "", 1, 3000);
+        REQUIRE(history.size() == 2501);
+        REQUIRE(history.front().id == 2501);
+        REQUIRE(history.front().type == rlx_money::TransactionType::SET);
+        REQUIRE(history.back().id == 1);
+        REQUIRE(transactionDAO.getTotalTransactionCount() == 2501);
+        REQUIRE(dbManager.verifyAggregates().consistent());
+        dbManager.close();
+
+        // 每批的移动与进度在同一事务中提交，重新启动后从下一批继续
+        {
+            SQLite::Database db(testDbPath, SQLite::OPEN_READWRITE);
+            REQUIRE(db.execAndGet("SELECT copied_id FROM migration_progress").getInt() == 1000);
+            REQUIRE(db.execAndGet("SELECT COUNT(*) FROM transactions").getInt() == 1000);
+            REQUIRE(db.execAndGet("SELECT COUNT(*) FROM transactions_v1").getInt() == 1501);
+            REQUIRE(db.execAndGet("SELECT COUNT(*) FROM player_balances").getInt() == 1);
+        }
+
+        REQUIRE(dbManager.initialize(config));
+        REQUIRE(dbManager.getMigrationProgress().movedId == 1000);
+        progress = finishMigration(dbManager);
+        REQUIRE(progress.state == rlx_money::MigrationState::Completed);
+        REQUIRE(progress.movedRecords == 1501);
+        auto&       db = dbManager.getConnection();
+        const char* leftoverSql =
+            "SELECT COUNT(*) FROM sqlite_master WHERE name LIKE '%_v1' OR name = 'migration_progress'";
+        REQUIRE(db.execAndGet(leftoverSql).getInt() == 0);
+
+        rlx_money::PlayerDAO playerDAO(dbManager);
+        REQUIRE(playerDAO.getBalance("1001", "gold") == 100);
+        REQUIRE(transactionDAO.getTotalTransactionCount() == 2501);
+        REQUIRE(transactionDAO.getPlayerTransactions("1001", "", 1, 1).front().type == rlx_money::TransactionType::SET);
+        REQUIRE(dbManager.verifyAggregates().consistent());
+        dbManager.close();
+    }
+
+    SECTION("迁移后数据库文件缩小") {
+        createLegacyDatabase(testDbPath);
+        {
+            SQLite::Database db(testDbPath, SQLite::OPEN_READWRITE);
+            SQLite::Transaction transaction(db);
+            for (int i = 0; i < 200; ++i) {
+                std::string xuid = std::to_string(2535400000000000LL + i);
+                db.exec(
+                    "INSERT INTO players VALUES ('" + xuid + "', 'player" + std::to_string(i)
+                    + "', 1600000000, 1600000000, 1600000000)"
+                );
+                db.exec("INSERT INTO player_balances VALUES ('" + xuid + "', 'gold', 1000, 1600000000)");
+            }
+            SQLite::Statement insert(
+                db,
+                "INSERT INTO transactions VALUES (NULL, ?, 'gold', 10, 1000, 'transfer', '', ?, ?, ?)"
+            );
+            for (int i = 0; i < 5000; ++i) {
+                insert.bind(1, std::to_string(2535400000000000LL + i % 200));
+                insert.bind(2, static_cast<int64_t>(1600000000 + i));
+                insert.bind(3, std::to_string(2535400000000000LL + (i + 1) % 200));
+                insert.bind(4, "0123456789abcdef" + std::to_string(10000000 + i));
+                insert.exec();
+                insert.reset();
+            }
+            transaction.commit();
+            db.exec("VACUUM");
+        }
+        auto legacySize = std::filesystem::file_size(testDbPath);
+
+        // 迁移不整理文件，旧表释放的空间在手动整理后归还
+        REQUIRE(dbManager.initialize(testDbPath));
+        REQUIRE(finishMigration(dbManager).state == rlx_money::MigrationState::Completed);
+        REQUIRE(std::filesystem::file_size(testDbPath) >= legacySize);
+        REQUIRE(dbManager.convertToIncrementalVacuum());
+        dbManager.close();
+        auto migratedSize = std::filesystem::file_size(testDbPath);
+        REQUIRE(migratedSize * 4 < legacySize * 3);
+    }
+}
+
+// ============================================================================
+// 交易记录聚簇存储测试
+// ============================================================================
+
+namespace {
+
+/// @brief 创建第 2 版结构（交易记录表为自增ID的 rowid 表）的数据库
+void createSchemaV2Database(const std::string& path) {
+    SQLite::Database db(path, SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE);
+    db.exec(R"(
+        CREATE TABLE players (
+            xuid TEXT PRIMARY KEY, username TEXT NOT NULL, first_join_time INTEGER NOT NULL,
+            created_at INTEGER NOT NULL, updated_at INTEGER NOT NULL
+        );
+        CREATE TABLE accounts (id INTEGER PRIMARY KEY, xuid TEXT NOT NULL UNIQUE);
+        CREATE TABLE currency_keys (id INTEGER PRIMARY KEY, code TEXT NOT NULL UNIQUE);
+        CREATE TABLE player_balances (
+            account_id INTEGER NOT NULL, currency_key INTEGER NOT NULL, balance INTEGER NOT NULL DEFAULT 0,
+            updated_at INTEGER NOT NULL, PRIMARY KEY (account_id, currency_key)
+        ) WITHOUT ROWID;
+        CREATE TABLE transactions (
+            id INTEGER PRIMARY KEY AUTOINCREMENT, account_id INTEGER NOT NULL, currency_key INTEGER NOT NULL,
+            amount INTEGER NOT NULL, balance INTEGER NOT NULL, type INTEGER NOT NULL, description TEXT,
+            timestamp INTEGER NOT NULL, related_account_id INTEGER, transfer_id BLOB
+        );
+        CREATE TABLE currency_aggregates (
+            currency_key INTEGER PRIMARY KEY, total_wealth INTEGER NOT NULL DEFAULT 0,
+            account_count INTEGER NOT NULL DEFAULT 0
+        );
+        CREATE TABLE player_aggregates (account_id INTEGER PRIMARY KEY, transaction_count INTEGER NOT NULL DEFAULT 0);
+        CREATE TABLE global_aggregates (
+            id INTEGER PRIMARY KEY CHECK (id = 1), player_count INTEGER NOT NULL DEFAULT 0,
+            transaction_count INTEGER NOT NULL DEFAULT 0
+        );
+        INSERT INTO global_aggregates VALUES (1, 0, 0);
+        CREATE TRIGGER trg_transactions_insert AFTER INSERT ON transactions
+        BEGIN
+            INSERT INTO player_aggregates (account_id, transaction_count) VALUES (NEW.account_id, 1)
+            ON CONFLICT(account_id) DO UPDATE SET transaction_count = transaction_count + 1;
+            UPDATE global_aggregates SET transaction_count = transaction_count + 1 WHERE id = 1;
+        END;
+        CREATE TRIGGER trg_transactions_delete AFTER DELETE ON transactions
+        BEGIN
+            UPDATE player_aggregates SET transaction_count = transaction_count - 1 WHERE account_id = OLD.account_id;
+            UPDATE global_aggregates SET transaction_count = transaction_count - 1 WHERE id = 1;
+        END;
+        CREATE INDEX idx_transactions_account_time ON transactions(account_id, timestamp);
+        CREATE INDEX idx_transactions_timestamp ON transactions(timestamp);
+        INSERT INTO currency_keys VALUES (1, 'gold');
+        PRAGMA user_version = 2;
+    )");
+}
+
+/// @brief 按时间顺序为 accountCount 个玩家交替写入交易记录（同一玩家的记录在写入顺序上相互分散）
+void fillInterleavedTransactions(SQLite::Database& db, int accountCount, int rowsPerAccount) {
+    SQLite::Transaction transaction(db);
+    for (int i = 1; i <= accountCount; ++i) {
+        db.exec(
+            "INSERT INTO accounts (id, xuid) VALUES (" + std::to_string(i) + ", '"
+            + std::to_string(2535400000000000LL + i) + "')"
+        );
+    }
+    SQLite::Statement insert(
+        db,
+        "INSERT INTO transactions (id, account_id, currency_key, amount, balance, type, description, timestamp, "
+        "related_account_id, transfer_id) VALUES (?, ?, 1, 10, 1000, 3, '玩家之间的转账', ?, ?, randomblob(12))"
+    );
+    for (int i = 0; i < accountCount * rowsPerAccount; ++i) {
+        insert.bind(1, static_cast<int64_t>(i + 1));
+        insert.bind(2, i % accountCount + 1);
+        insert.bind(3, static_cast<int64_t>(1600000000 + i));
+        insert.bind(4, (i + 1) % accountCount + 1);
+        insert.exec();
+        insert.reset();
+    }
+    transaction.commit();
+}
+
+/// @brief 冷缓存下查询 sampleCount 名玩家最近的交易记录
+/// @return (读取的页数, 耗时微秒)
+std::pair<int, int64_t> measureColdHistory(const std::string& path, int accountCount, int sampleCount, int limit) {
+    // 新连接的页缓存为空，页缓存未命中次数即读取文件的页数
+    SQLite::Database  db(path, SQLite::OPEN_READONLY);
+    SQLite::Statement query(
+        db,
+        "SELECT id, amount, balance, type, description, timestamp, related_account_id, transfer_id "
+        "FROM transactions WHERE account_id = ? ORDER BY timestamp DESC, id DESC LIMIT ?"
+    );
+    auto start = std::chrono::steady_clock::now();
+    for (int account = 1; account <= accountCount; account += accountCount / sampleCount) {
+        query.bind(1, account);
+        query.bind(2, limit);
+        int rows = 0;
+        while (query.executeStep()) {
+            ++rows;
+        }
+        REQUIRE(rows == limit);
+        query.reset();
+    }
+    auto elapsed =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+    int misses    = 0;
+    int highwater = 0;
+    sqlite3_db_status(db.getHandle(), SQLITE_DBSTATUS_CACHE_MISS, &misses, &highwater, 0);
+    return {misses, elapsed};
+}
+
+} // namespace
+
+TEST_CASE("交易记录聚簇存储测试", "[database][clustered]") {
+    auto&             tempManager = rlx_money::test::TestTempManager::getInstance();
+    const std::string testDbPath  = tempManager.makeUniquePath("test_clustered", ".db");
+    tempManager.registerFile(testDbPath);
+
+    auto& dbManager = rlx_money::DatabaseManager::getInstance();
+
+    SECTION("按玩家聚簇存储与记录ID分配") {
+        REQUIRE(dbManager.initialize(testDbPath));
+        auto& db = dbManager.getConnection();
+        auto  transactionsSql =
+            db.execAndGet("SELECT sql FROM sqlite_master WHERE name = 'transactions'").getString();
+        REQUIRE(transactionsSql.find("WITHOUT ROWID") != std::string::npos);
+
+        rlx_money::PlayerDAO      playerDAO(dbManager);
+        rlx_money::TransactionDAO transactionDAO(dbManager);
+        for (int i = 0; i < 6; ++i) {
+            REQUIRE(transactionDAO.createTransaction(rlx_money::TransactionRecord(
+                0,
+                i % 2 == 0 ? "c1" : "c2",
+                "gold",
+                10,
+                10 * (i + 1),
+                rlx_money::TransactionType::ADD,
+                "",
+                1600000000 + i
+            )));
+        }
+
+        // 记录ID全局递增，不随聚簇键变化
+        auto history = transactionDAO.getPlayerTransactions("c2", "", 1, 10);
+        REQUIRE(history.size() == 3);
+        REQUIRE(history[0].id == 6);
+        REQUIRE(history[1].id == 4);
+        REQUIRE(history[2].id == 2);
+
+        // 删除最新的记录后ID不会被重新分配
+        db.exec("DELETE FROM transactions WHERE id = 6");
+        REQUIRE(transactionDAO.createTransaction(
+            rlx_money::TransactionRecord(0, "c1", "gold", 1, 1, rlx_money::TransactionType::ADD, "", 1600000010)
+        ));
+        REQUIRE(transactionDAO.getPlayerTransactions("c1", "", 1, 1).front().id == 7);
+
+        // 批量操作一次写入多条记录，ID 连续且不重复
+        REQUIRE(playerDAO.initializeBalance("c1", "gold", 100));
+        REQUIRE(playerDAO.initializeBalance("c2", "gold", 200));
+        REQUIRE(playerDAO.assignAllBalances("gold", 50, "批量设置") == 2);
+        REQUIRE(db.execAndGet("SELECT MAX(id) FROM transactions").getInt64() == 9);
+        REQUIRE(db.execAndGet("SELECT COUNT(DISTINCT id) FROM transactions").getInt() == 8);
+        REQUIRE(db.execAndGet("SELECT seq FROM transaction_sequence").getInt64() == 9);
+
+        // 玩家历史直接按主键范围读取，不需要排序
+        std::string plan;
+        SQLite::Statement explain(
+            db,
+            "EXPLAIN QUERY PLAN SELECT id FROM transactions WHERE account_id = 1 "
+            "ORDER BY timestamp DESC, id DESC LIMIT 10"
+        );
+        while (explain.executeStep()) {
+            plan += explain.getColumn(3).getString() + "\n";
+        }
+        REQUIRE(plan.find("USING PRIMARY KEY") != std::string::npos);
+        REQUIRE(plan.find("TEMP B-TREE") == std::string::npos);
+        REQUIRE(dbManager.verifyAggregates().consistent());
+        dbManager.close();
+    }
+
+    SECTION("第 2 版交易记录表升级") {
+        createSchemaV2Database(testDbPath);
+        {
+            SQLite::Database db(testDbPath, SQLite::OPEN_READWRITE);
+            fillInterleavedTransactions(db, 3, 4);
+            // 序号大于现存最大ID：末尾的记录已被删除
+            db.exec("UPDATE sqlite_sequence SET seq = 100 WHERE name = 'transactions'");
+            db.exec("DELETE FROM transactions WHERE id = 12");
+        }
+
+        // 启动时只改名旧表，旧索引保留到迁移完成，用于读取旧表
+        REQUIRE(dbManager.initialize(testDbPath));
+        auto&       db = dbManager.getConnection();
+        const char* legacyIndexSql =
+            "SELECT COUNT(*) FROM sqlite_master WHERE name = 'idx_transactions_account_time' "
+            "AND tbl_name = 'transactions_v2'";
+        REQUIRE(db.execAndGet("PRAGMA user_version").getInt() == 3);
+        REQUIRE(db.execAndGet(legacyIndexSql).getInt() == 1);
+        REQUIRE(db.execAndGet("SELECT COUNT(*) FROM sqlite_master WHERE tbl_name = 'transactions_v2' "
+                              "AND type = 'trigger'")
+                    .getInt()
+                == 0);
+
+        rlx_money::TransactionDAO transactionDAO(dbManager);
+        REQUIRE(transactionDAO.getTotalTransactionCount() == 11);
+        auto history = transactionDAO.getPlayerTransactions("2535400000000001", "", 1, 10);
+        REQUIRE(history.size() == 4);
+        REQUIRE(history[0].id == 10);
+        REQUIRE(history[0].relatedXuid == "2535400000000002");
+        REQUIRE(history[0].transferId.has_value());
+        REQUIRE(history[3].id == 1);
+        REQUIRE(dbManager.verifyAggregates().consistent());
+
+        REQUIRE(transactionDAO.createTransaction(rlx_money::TransactionRecord(
+            0,
+            "2535400000000001",
+            "gold",
+            1,
+            1,
+            rlx_money::TransactionType::ADD,
+            "",
+            1700000000
+        )));
+        REQUIRE(transactionDAO.getPlayerTransactions("2535400000000001", "", 1, 1).front().id == 101);
+        REQUIRE(transactionDAO.getPlayerTransactionCount("2535400000000001") == 5);
+        REQUIRE(dbManager.verifyAggregates().consistent());
+
+        REQUIRE(finishMigration(dbManager).state == rlx_money::MigrationState::Completed);
+        REQUIRE(db.execAndGet("SELECT COUNT(*) FROM sqlite_master WHERE name LIKE '%_v2'").getInt() == 0);
+        REQUIRE(
+            db.execAndGet("SELECT COUNT(*) FROM sqlite_master WHERE name = 'idx_transactions_account_time'").getInt()
+            == 0
+        );
+        history = transactionDAO.getPlayerTransactions("2535400000000001", "", 1, 10);
+        REQUIRE(history.size() == 5);
+        REQUIRE(history[1].id == 10);
+        REQUIRE(transactionDAO.getTotalTransactionCount() == 12);
+        REQUIRE(dbManager.verifyAggregates().consistent());
+        dbManager.close();
+    }
+
+    SECTION("分批移动中断后继续") {
+        createSchemaV2Database(testDbPath);
+        {
+            SQLite::Database db(testDbPath, SQLite::OPEN_READWRITE);
+            fillInterleavedTransactions(db, 101, 100);
+        }
+
+        // 时间预算为 0 时每个 tick 只移动一批
+        rlx_money::DatabaseConfig config;
+        config.path              = testDbPath;
+        config.retentionBudgetMs = 0;
+        REQUIRE(dbManager.initialize(config));
+        for (int tick = 0; tick < 3; ++tick) {
+            REQUIRE(dbManager.stepMigration().state == rlx_money::MigrationState::Running);
+        }
+        REQUIRE(dbManager.getMigrationProgress().movedId == 3000);
+
+        // 汇总值在移动前后保持不变，读取合并新旧两表
+        rlx_money::TransactionDAO transactionDAO(dbManager);
+        REQUIRE(transactionDAO.getTotalTransactionCount() == 10100);
+        REQUIRE(transactionDAO.getPlayerTransactionCount("2535400000000001") == 100);
+        REQUIRE(transactionDAO.getPlayerTransactions("2535400000000001", "", 1, 1).front().id == 10000);
+        REQUIRE(transactionDAO.getPlayerTransactions("2535400000000001", "", 1, 200).size() == 100);
+        rlx_money::TransactionFilter filter;
+        filter.endTime = 1600003000;
+        auto page      = transactionDAO.getPlayerTransactionsPage("2535400000000001", filter, "", 20);
+        REQUIRE(page.records.size() == 20);
+        REQUIRE(page.records.front().id == 2930);
+        REQUIRE(transactionDAO.getPlayerTransactionsPage("2535400000000001", filter, page.nextCursor, 20)
+                    .records.front()
+                    .id
+                == 910);
+        REQUIRE(dbManager.verifyAggregates().consistent());
+        dbManager.close();
+
+        {
+            SQLite::Database db(testDbPath, SQLite::OPEN_READWRITE);
+            REQUIRE(db.execAndGet("SELECT copied_id FROM migration_progress").getInt() == 3000);
+            REQUIRE(db.execAndGet("SELECT COUNT(*) FROM transactions").getInt() == 3000);
+            REQUIRE(db.execAndGet("SELECT COUNT(*) FROM transactions_v2").getInt() == 7100);
+        }
+
+        REQUIRE(dbManager.initialize(testDbPath));
+        REQUIRE(finishMigration(dbManager).state == rlx_money::MigrationState::Completed);
+        auto&       db = dbManager.getConnection();
+        const char* leftoverSql =
+            "SELECT COUNT(*) FROM sqlite_master WHERE name LIKE '%_v2' OR name = 'migration_progress'";
+        REQUIRE(db.execAndGet("PRAGMA user_version").getInt() == 3);
+        REQUIRE(db.execAndGet(leftoverSql).getInt() == 0);
+
+        REQUIRE(transactionDAO.getTotalTransactionCount() == 10100);
+        REQUIRE(transactionDAO.getPlayerTransactionCount("2535400000000001") == 100);
+        REQUIRE(transactionDAO.getPlayerTransactions("2535400000000001", "", 1, 1).front().id == 10000);
+        REQUIRE(dbManager.verifyAggregates().consistent());
+        dbManager.close();
+    }
+
+    SECTION("异步写入模式下由写线程移动") {
+        createSchemaV2Database(testDbPath);
+        {
+            SQLite::Database db(testDbPath, SQLite::OPEN_READWRITE);
+            fillInterleavedTransactions(db, 50, 100);
+        }
+
+        rlx_money::DatabaseConfig config;
+        config.path        = testDbPath;
+        config.asyncWriter = true;
+        REQUIRE(dbManager.initialize(config));
+        rlx_money::TransactionDAO transactionDAO(dbManager);
+        // 迁移期间的写入与移动交替提交
+        REQUIRE(transactionDAO.createTransaction(rlx_money::TransactionRecord(
+            0,
+            "2535400000000001",
+            "gold",
+            1,
+            1,
+            rlx_money::TransactionType::ADD,
+            "",
+            1700000000
+        )));
+
+        auto progress = finishMigration(dbManager);
+        REQUIRE(progress.state == rlx_money::MigrationState::Completed);
+        REQUIRE(progress.movedRecords == 5000);
+        REQUIRE(transactionDAO.getTotalTransactionCount() == 5001);
+        REQUIRE(transactionDAO.getPlayerTransactions("2535400000000001", "", 1, 1).front().id == 5001);
+        REQUIRE(dbManager.verifyAggregates().consistent());
+        dbManager.close();
+    }
+
+    SECTION("冷缓存历史查询基准") {
+        constexpr int kAccounts       = 2000;
+        constexpr int kRowsPerAccount = 25;
+        constexpr int kSamples        = 20;
+        constexpr int kHistoryLimit   = 20;
+
+        // 旧布局：按自增ID存储，(account_id, timestamp) 二级索引
+        const std::string legacyPath = tempManager.makeUniquePath("test_clustered_v2", ".db");
+        tempManager.registerFile(legacyPath);
+        createSchemaV2Database(legacyPath);
+        {
+            SQLite::Database db(legacyPath, SQLite::OPEN_READWRITE);
+            fillInterleavedTransactions(db, kAccounts, kRowsPerAccount);
+        }
+
+        // 新布局：同样按时间顺序逐条写入（不经过迁移时的排序与 VACUUM）
+        REQUIRE(dbManager.initialize(testDbPath));
+        dbManager.close();
+        {
+            SQLite::Database db(testDbPath, SQLite::OPEN_READWRITE);
+            db.exec("INSERT INTO currency_keys (id, code) VALUES (1, 'gold')");
+            fillInterleavedTransactions(db, kAccounts, kRowsPerAccount);
+        }
+
+        auto [legacyPages, legacyMicros]       = measureColdHistory(legacyPath, kAccounts, kSamples, kHistoryLimit);
+        auto [clusteredPages, clusteredMicros] = measureColdHistory(testDbPath, kAccounts, kSamples, kHistoryLimit);
+        WARN(
+            "冷缓存历史查询（" << kSamples << " 名玩家，每次 " << kHistoryLimit << " 条）: 旧布局读取 "
+                              << legacyPages << " 页 / " << legacyMicros << " us，聚簇布局读取 " << clusteredPages
+                              << " 页 / " << clusteredMicros << " us"
+        );
+        REQUIRE(clusteredPages * 3 < legacyPages);
+    }
+}
+
+// ============================================================================
+// 查询计划测试
+// ============================================================================
+
+namespace {
+
+/// @brief 记录连接上执行过的语句（未展开参数的原始 SQL）
+int collectStatement(unsigned, void* context, void* statement, void*) {
+    auto* statements = static_cast<std::set<std::string>*>(context);
+    if (const char* sql = sqlite3_sql(static_cast<sqlite3_stmt*>(statement))) {
+        statements->insert(sql);
+    }
+    return 0;
+}
+
+/// @brief 获取语句的查询计划中出现的全表扫描与临时排序
+/// @return 问题描述；没有问题时为空
+std::vector<std::string> findPlanProblems(SQLite::Database& db, const std::string& sql) {
+    // 带 LIMIT 的排序查询沿索引顺序扫描，读到足够的行即停止，不视为全表扫描
+    bool limitedOrderedScan = sql.find("ORDER BY") != std::string::npos && sql.find("LIMIT") != std::string::npos;
+
+    std::vector<std::string> problems;
+    SQLite::Statement        explain(db, "EXPLAIN QUERY PLAN " + sql);
+    while (explain.executeStep()) {
+        std::string detail = explain.getColumn(3).getString();
+        // 扫描子查询或协程的中间结果不读取表
+        bool fullScan = detail.rfind("SCAN ", 0) == 0 && detail.rfind("SCAN (", 0) != 0
+                     && detail.rfind("SCAN CONSTANT ROW", 0) != 0 && detail.find("subquery") == std::string::npos
+                     && !(limitedOrderedScan && detail.find(" INDEX ") != std::string::npos);
+        if (fullScan || detail.find("TEMP B-TREE") != std::string::npos) {
+            problems.push_back(detail);
+        }
+    }
+    return problems;
+}
+
+} // namespace
+
+TEST_CASE("查询计划测试", "[database][query_plan]") {
+    auto&             tempManager = rlx_money::test::TestTempManager::getInstance();
+    const std::string testDbPath  = tempManager.makeUniquePath("test_query_plan", ".db");
+    tempManager.registerFile(testDbPath);
+
+    auto& dbManager = rlx_money::DatabaseManager::getInstance();
+    REQUIRE(dbManager.initialize(testDbPath));
+    auto& db = dbManager.getConnection();
+
+    rlx_money::PlayerDAO      playerDAO(dbManager);
+    rlx_money::TransactionDAO transactionDAO(dbManager);
+
+    // 准备数据后收集统计信息，查询计划与定期 ANALYZE 后的生产环境一致
+    for (int i = 0; i < 50; ++i) {
+        std::string xuid = "qp" + std::to_string(i);
+        REQUIRE(playerDAO.createPlayer(rlx_money::PlayerData(xuid, "player" + std::to_string(i), 1600000000)));
+        REQUIRE(playerDAO.initializeBalance(xuid, "gold", 100 + i));
+        REQUIRE(playerDAO.initializeBalance(xuid, "silver", 10));
+        for (int j = 0; j < 10; ++j) {
+            REQUIRE(transactionDAO.createTransaction(rlx_money::TransactionRecord(
+                0,
+                xuid,
+                j % 2 == 0 ? "gold" : "silver",
+                1,
+                100 + j,
+                j % 3 == 0 ? rlx_money::TransactionType::TRANSFER : rlx_money::TransactionType::ADD,
+                "",
+                1600000000 + i * 10 + j,
+                "qp0",
+                "0123456789abcdef01234567"
+            )));
+        }
+    }
+    db.exec("ANALYZE");
+
+    // 依次调用每个 DAO 方法，记录执行的全部语句
+    std::set<std::string> statements;
+    sqlite3_trace_v2(db.getHandle(), SQLITE_TRACE_STMT, collectStatement, &statements);
+    {
+        REQUIRE(playerDAO.createPlayer(rlx_money::PlayerData("qp-new", "newcomer", 1600000000)));
+        REQUIRE(playerDAO.getPlayerByXuid("qp1").has_value());
+        REQUIRE(playerDAO.getPlayerByUsername("player2").has_value());
+        REQUIRE(playerDAO.updateUsername("qp3", "renamed"));
+        REQUIRE(playerDAO.playerExists("qp4"));
+        REQUIRE(playerDAO.getPlayerCount() == 51);
+        REQUIRE(playerDAO.getBalance("qp1", "gold").has_value());
+        REQUIRE(playerDAO.updateBalance("qp1", "gold", 500));
+        REQUIRE(playerDAO.initializeBalance("qp-new", "gold", 100));
+        REQUIRE(playerDAO.getAllBalances("qp1").size() == 2);
+        REQUIRE(playerDAO.getTopBalanceList("gold", 10).size() == 10);
+        REQUIRE(playerDAO.getCurrencyBalanceList("gold").size() == 51);
+        REQUIRE(playerDAO.getTotalWealth("gold") > 0);
+        REQUIRE(dbManager.executeTransaction([&](SQLite::Database&) {
+            REQUIRE(playerDAO.applyBalanceDelta("qp1", "gold", 10, 0, 1000000).has_value());
+            REQUIRE(playerDAO.applyBalanceDelta("qp-new", "silver", 10, 0, 1000000, 0).has_value());
+            REQUIRE(playerDAO.assignBalance("qp2", "gold", 300).has_value());
+            REQUIRE(playerDAO.addToAllBalances("silver", 1, 1000000, "批量增加") > 0);
+            REQUIRE(playerDAO.scaleAllBalances("silver", 2000000, false, 1000000, "批量缩放") > 0);
+            REQUIRE(playerDAO.assignAllBalances("silver", 5, "批量设置") > 0);
+            REQUIRE(playerDAO.clampAllBalances("gold", 120, "批量截断") > 0);
+            return true;
+        }));
+
+        REQUIRE(transactionDAO.getPlayerTransactions("qp1").size() == 10);
+        REQUIRE_FALSE(transactionDAO.getPlayerTransactions("qp1", "gold").empty());
+        REQUIRE(transactionDAO.getPlayerTransactionsByType("qp1", rlx_money::TransactionType::TRANSFER).size() == 4);
+        REQUIRE(transactionDAO.getPlayerTransactionsByTimeRange("qp1", 1600000010, 1600000015).size() == 6);
+        REQUIRE(transactionDAO.getRecentTransactions(5).size() == 5);
+        REQUIRE(transactionDAO.getPlayerTransactionCount("qp1") > 0);
+        REQUIRE(transactionDAO.getTotalTransactionCount() > 0);
+        REQUIRE(transactionDAO.getTransactionCountByType(rlx_money::TransactionType::TRANSFER) > 0);
+
+        rlx_money::TransactionFilter filter;
+        auto                         page = transactionDAO.getPlayerTransactionsPage("qp1", filter, "", 3);
+        REQUIRE(page.hasMore());
+        REQUIRE(transactionDAO.getPlayerTransactionsPage("qp1", filter, page.nextCursor, 3).records.size() == 3);
+        filter.currencyId = "gold";
+        filter.type       = rlx_money::TransactionType::ADD;
+        filter.startTime  = 1600000000;
+        filter.endTime    = 1700000000;
+        REQUIRE_FALSE(transactionDAO.getPlayerTransactionsPage("qp1", filter, page.nextCursor, 3).records.empty());
+        filter.type.reset();
+        REQUIRE_FALSE(transactionDAO.getPlayerTransactionsPage("qp1", filter, "", 3).records.empty());
+
+        transactionDAO.setJournalCheckpoint(7);
+        REQUIRE(transactionDAO.getJournalCheckpoint() == 7);
+        REQUIRE(transactionDAO.cleanupOldTransactions(3650) == 0);
+    }
+    sqlite3_trace_v2(db.getHandle(), 0, nullptr, nullptr);
+
+    int checked = 0;
+    for (const auto& sql : statements) {
+        // 事务控制与保存点语句没有查询计划
+        if (sql.rfind("SELECT", 0) != 0 && sql.rfind("INSERT", 0) != 0 && sql.rfind("UPDATE", 0) != 0
+            && sql.rfind("DELETE", 0) != 0) {
+            continue;
+        }
+        auto problems = findPlanProblems(db, sql);
+        INFO(sql);
+        CHECK(problems == std::vector<std::string>{});
+        ++checked;
+    }
+    REQUIRE(checked >= 30);
+
+    dbManager.close();
+}
+
+TEST_CASE("在线备份测试", "[database][backup]") {
+    auto&             tempManager = rlx_money::test::TestTempManager::getInstance();
+    const std::string testDbPath  = tempManager.makeUniquePath("test_backup", ".db");
+    const std::string backupDir   = tempManager.makeUniquePath("test_backup_dir", "");
+    tempManager.registerFile(testDbPath);
+    tempManager.registerDirectory(backupDir);
+
+    auto& dbManager = rlx_money::DatabaseManager::getInstance();
+
+    rlx_money::DatabaseConfig config;
+    config.path               = testDbPath;
+    config.journalMode        = "WAL";
+    config.backupDir          = backupDir;
+    config.backupPagesPerTick = 4;
+
+    // 推进备份直到结束，返回调用次数
+    auto runToEnd = [&]() {
+        int ticks = 0;
+        while (dbManager.getBackupProgress().state == rlx_money::BackupState::Running && ticks < 10000) {
+            dbManager.stepBackup();
+            ++ticks;
+        }
+        return ticks;
+    };
+
+    auto countBackups = [&](const std::string& stem) {
+        int count = 0;
+        for (const auto& file : std::filesystem::directory_iterator(backupDir)) {
+            std::string name = file.path().filename().string();
+            count += name.rfind(stem + "-", 0) == 0 && name.ends_with(".db") ? 1 : 0;
+        }
+        return count;
+    };
+
+    SECTION("逐 tick 分批复制并包含复制期间的写入") {
+        REQUIRE(dbManager.initialize(config));
+        rlx_money::PlayerDAO playerDAO(dbManager);
+        for (int i = 0; i < 200; ++i) {
+            std::string xuid = "bk" + std::to_string(i);
+            REQUIRE(playerDAO.createPlayer(rlx_money::PlayerData(xuid, "backup_" + xuid, 1600000000)));
+            REQUIRE(playerDAO.initializeBalance(xuid, "gold", i));
+        }
+
+        std::string path = dbManager.startBackup();
+        REQUIRE(std::filesystem::exists(path + ".partial"));
+        REQUIRE_THROWS_AS(dbManager.startBackup(), rlx_money::DatabaseException);
+
+        // 每次只复制配置的页数
+        auto progress = dbManager.stepBackup();
+        REQUIRE(progress.state == rlx_money::BackupState::Running);
+        REQUIRE(progress.totalPages > 8);
+        REQUIRE(progress.remainingPages == progress.totalPages - 4);
+
+        // 复制期间经写连接提交的修改同步到备份
+        REQUIRE(playerDAO.createPlayer(rlx_money::PlayerData("bk_late", "late_player", 1600000001)));
+        REQUIRE(playerDAO.initializeBalance("bk_late", "gold", 777));
+
+        REQUIRE(runToEnd() >= progress.remainingPages / 4);
+        progress = dbManager.getBackupProgress();
+        REQUIRE(progress.state == rlx_money::BackupState::Completed);
+        REQUIRE(progress.percent() == 100.0);
+        REQUIRE(progress.path == path);
+        REQUIRE(std::filesystem::exists(path));
+        REQUIRE_FALSE(std::filesystem::exists(path + ".partial"));
+        dbManager.close();
+
+        SQLite::Database backup(path, SQLite::OPEN_READONLY);
+        REQUIRE(backup.execAndGet("PRAGMA integrity_check").getString() == "ok");
+        REQUIRE(backup.execAndGet("SELECT COUNT(*) FROM players").getInt() == 201);
+        REQUIRE(
+            backup.execAndGet("SELECT balance FROM player_balances WHERE account_id = "
+                              "(SELECT id FROM accounts WHERE xuid = 'bk_late')")
+                .getInt()
+            == 777
+        );
+    }
+
+    SECTION("写连接有未提交的事务时跳过本 tick") {
+        config.groupCommit = true;
+        REQUIRE(dbManager.initialize(config));
+        rlx_money::PlayerDAO playerDAO(dbManager);
+
+        dbManager.startBackup();
+        REQUIRE(dbManager.executeTransaction([&](SQLite::Database&) {
+            return playerDAO.createPlayer(rlx_money::PlayerData("bk_group", "group_player", 1600000000));
+        }));
+        auto progress = dbManager.stepBackup();
+        REQUIRE(progress.state == rlx_money::BackupState::Running);
+        REQUIRE(progress.totalPages == 0);
+
+        dbManager.flushGroupCommit();
+        runToEnd();
+        progress = dbManager.getBackupProgress();
+        REQUIRE(progress.state == rlx_money::BackupState::Completed);
+        dbManager.close();
+
+        SQLite::Database backup(progress.path, SQLite::OPEN_READONLY);
+        REQUIRE(backup.execAndGet("SELECT COUNT(*) FROM players WHERE xuid = 'bk_group'").getInt() == 1);
+    }
+
+    SECTION("保留数量与取消") {
+        config.backupKeep = 2;
+        REQUIRE(dbManager.initialize(config));
+
+        // 预先放入两个较旧的备份与一个无关文件
+        std::string stem = std::filesystem::path(testDbPath).stem().string();
+        std::filesystem::create_directories(backupDir);
+        for (const char* name : {"-20000101-000000-000.db", "-20000101-000000-001.db"}) {
+            std::ofstream(std::filesystem::path(backupDir) / (stem + name)) << "old";
+        }
+        std::ofstream(std::filesystem::path(backupDir) / "unrelated.db") << "keep";
+
+        std::string path = dbManager.startBackup();
+        runToEnd();
+        REQUIRE(dbManager.getBackupProgress().state == rlx_money::BackupState::Completed);
+        REQUIRE(countBackups(stem) == 2);
+        REQUIRE(std::filesystem::exists(path));
+        REQUIRE_FALSE(std::filesystem::exists(std::filesystem::path(backupDir) / (stem + "-20000101-000000-000.db")));
+        REQUIRE(std::filesystem::exists(std::filesystem::path(backupDir) / "unrelated.db"));
+
+        // 取消后删除未完成的文件
+        std::string cancelled = dbManager.startBackup();
+        dbManager.stepBackup();
+        REQUIRE(dbManager.cancelBackup());
+        REQUIRE_FALSE(dbManager.cancelBackup());
+        REQUIRE(dbManager.getBackupProgress().state == rlx_money::BackupState::Failed);
+        REQUIRE_FALSE(std::filesystem::exists(cancelled + ".partial"));
+        REQUIRE(countBackups(stem) == 2);
+        dbManager.close();
+    }
+
+    SECTION("备份配置校验") {
+        REQUIRE_NOTHROW(config.validate());
+        config.backupPagesPerTick = 0;
+        REQUIRE_THROWS_AS(config.validate(), std::invalid_argument);
+        config.backupPagesPerTick = 256;
+        config.backupKeep         = 0;
+        REQUIRE_THROWS_AS(config.validate(), std::invalid_argument);
+    }
+
+    dbManager.resetForTesting();
+}
+
+TEST_CASE("按时间点恢复测试", "[database][restore]") {
+    using rlx_money::TransactionType;
+
+    auto&             tempManager = rlx_money::test::TestTempManager::getInstance();
+    const std::string testDbPath  = tempManager.makeUniquePath("test_restore", ".db");
+    const std::string backupDir   = tempManager.makeUniquePath("test_restore_backups", "");
+    const std::string outputPath  = tempManager.makeUniquePath("test_restored", ".db");
+    tempManager.registerFile(testDbPath);
+    tempManager.registerDirectory(backupDir);
+    tempManager.registerFile(outputPath);
+
+    auto& dbManager = rlx_money::DatabaseManager::getInstance();
+
+    rlx_money::DatabaseConfig config;
+    config.path      = testDbPath;
+    config.backupDir = backupDir;
+    REQUIRE(dbManager.initialize(config));
+
+    rlx_money::PlayerDAO      playerDAO(dbManager);
+    rlx_money::TransactionDAO transactionDAO(dbManager);
+
+    // 按交易类型改写余额并写入交易记录（SET/INITIAL 的金额为新余额，其余为变化量）
+    auto apply = [&](const std::string&                xuid,
+                     int                               amount,
+                     TransactionType                   type,
+                     int64_t                           timestamp,
+                     const std::optional<std::string>& related    = std::nullopt,
+                     const std::optional<std::string>& transferId = std::nullopt) {
+        bool isSet   = type == TransactionType::SET || type == TransactionType::INITIAL;
+        int  balance = isSet ? amount : playerDAO.getBalance(xuid, "gold").value_or(0) + amount;
+        REQUIRE(playerDAO.updateBalance(xuid, "gold", balance));
+        REQUIRE(transactionDAO.createTransaction(
+            rlx_money::TransactionRecord(0, xuid, "gold", amount, balance, type, "", timestamp, related, transferId)
+        ));
+    };
+
+    const int64_t base = 1700000000;
+    for (const char* xuid : {"r1", "r2", "r3"}) {
+        REQUIRE(playerDAO.createPlayer(rlx_money::PlayerData(xuid, std::string("restore_") + xuid, base)));
+        REQUIRE(playerDAO.initializeBalance(xuid, "gold", 0));
+        apply(xuid, 1000, TransactionType::INITIAL, base);
+    }
+
+    std::string backupPath = dbManager.startBackup();
+    while (dbManager.getBackupProgress().state == rlx_money::BackupState::Running) {
+        dbManager.stepBackup();
+    }
+    REQUIRE(dbManager.getBackupProgress().state == rlx_money::BackupState::Completed);
+
+    // 备份之后：正常交易、一笔刷钱转账及其之后的正常支出、新玩家、刷钱账户，以及晚于目标时间点的交易
+    const std::string exploitTransfer = "aaaaaaaaaaaaaaaaaaaaaaaa";
+    apply("r1", 100, TransactionType::ADD, base + 10);
+    apply("r3", -300, TransactionType::TRANSFER, base + 20, "r2", exploitTransfer);
+    apply("r2", 300, TransactionType::TRANSFER, base + 20, "r3", exploitTransfer);
+    apply("r2", -200, TransactionType::REDUCE, base + 25);
+    REQUIRE(playerDAO.createPlayer(rlx_money::PlayerData("r4", "restore_r4", base + 30)));
+    REQUIRE(playerDAO.initializeBalance("r4", "gold", 100));
+    apply("r4", 10, TransactionType::ADD, base + 30);
+    apply("r1", 5000, TransactionType::SET, base + 40);
+    apply("r1", 1, TransactionType::ADD, base + 45);
+    REQUIRE(playerDAO.createPlayer(rlx_money::PlayerData("dupe", "restore_dupe", base + 50)));
+    REQUIRE(playerDAO.initializeBalance("dupe", "gold", 0));
+    apply("dupe", 999999, TransactionType::ADD, base + 50);
+    apply("r1", 7, TransactionType::ADD, base + 100);
+    int64_t sourceSequence = dbManager.getConnection().execAndGet("SELECT seq FROM transaction_sequence").getInt64();
+
+    rlx_money::RestoreOptions options;
+    options.backupPath      = backupPath;
+    options.sourcePath      = testDbPath;
+    options.outputPath      = outputPath;
+    options.untilTimestamp  = base + 60;
+    options.skipXuids       = {"dupe"};
+    options.skipTransferIds = {"AAAAAAAAAAAAAAAAAAAAAAAA"};
+    options.batchSize       = 2; // 让同一账户的 SET 与之后的变化分在不同批次
+
+    SECTION("重放到目标时间点并跳过匹配的记录") {
+        std::vector<std::pair<int64_t, int64_t>> reports;
+        auto result = rlx_money::DatabaseRestore::restore(options, [&](int64_t processed, int64_t total) {
+            reports.emplace_back(processed, total);
+        });
+        REQUIRE(result.replayedRecords == 5);
+        REQUIRE(result.skippedRecords == 3);
+        REQUIRE(result.laterRecords == 1);
+        REQUIRE(result.negativeBalances == 0);
+        REQUIRE(reports.size() == 5);
+        REQUIRE(reports.back() == std::pair<int64_t, int64_t>(9, 9));
+
+        // 源数据库保持不变
+        REQUIRE(playerDAO.getBalance("r2", "gold") == 1100);
+        dbManager.close();
+
+        REQUIRE(dbManager.initialize(outputPath));
+        REQUIRE(playerDAO.getBalance("r1", "gold") == 5001);
+        REQUIRE(playerDAO.getBalance("r2", "gold") == 800);
+        REQUIRE(playerDAO.getBalance("r3", "gold") == 1000);
+        REQUIRE(playerDAO.getBalance("r4", "gold") == 110);
+        REQUIRE_FALSE(playerDAO.getBalance("dupe", "gold").has_value());
+        REQUIRE(playerDAO.playerExists("r4"));
+
+        // 跳过刷钱转账后，之后记录的余额按重新计算的结果写入
+        auto history = transactionDAO.getPlayerTransactions("r2", "gold", 1, 10);
+        REQUIRE(history.size() == 2);
+        REQUIRE(history[0].type == TransactionType::REDUCE);
+        REQUIRE(history[0].balance == 800);
+        REQUIRE(transactionDAO.getPlayerTransactions("r1", "gold", 1, 10).front().balance == 5001);
+
+        // 汇总表与明细一致，记录ID不回退
+        REQUIRE(dbManager.verifyAggregates().consistent());
+        auto& restored = dbManager.getConnection();
+        REQUIRE(restored.execAndGet("SELECT seq FROM transaction_sequence").getInt64() == sourceSequence);
+        dbManager.close();
+    }
+
+    SECTION("无效的恢复请求") {
+        options.untilTimestamp = base - 1;
+        REQUIRE_THROWS_AS(rlx_money::DatabaseRestore::restore(options), rlx_money::InvalidArgumentException);
+        REQUIRE_FALSE(std::filesystem::exists(outputPath));
+
+        options.untilTimestamp = base + 60;
+        options.outputPath     = testDbPath;
+        REQUIRE_THROWS_AS(rlx_money::DatabaseRestore::restore(options), rlx_money::InvalidArgumentException);
+        dbManager.close();
+    }
+
+    SECTION("请求停止时放弃恢复") {
+        // 第一批完成后请求停止，下一批开始前放弃并删除未完成的输出文件
+        std::stop_source stop;
+        options.stopToken = stop.get_token();
+        int batches       = 0;
+        REQUIRE_THROWS_AS(
+            rlx_money::DatabaseRestore::restore(
+                options,
+                [&](int64_t, int64_t) {
+                    ++batches;
+                    stop.request_stop();
+                }
+            ),
+            rlx_money::DatabaseException
+        );
+        REQUIRE(batches == 1);
+        REQUIRE_FALSE(std::filesystem::exists(outputPath));
+        dbManager.close();
+    }
+
+    dbManager.resetForTesting();
+}
+
+TEST_CASE("交易记录清理任务测试", "[database][retention]") {
+    auto&             tempManager = rlx_money::test::TestTempManager::getInstance();
+    const std::string testDbPath  = tempManager.makeUniquePath("test_retention", ".db");
+    tempManager.registerFile(testDbPath);
+
+    auto& dbManager = rlx_money::DatabaseManager::getInstance();
+
+    rlx_money::DatabaseConfig config;
+    config.path               = testDbPath;
+    config.retentionBatchSize = 10;
+    config.retentionBudgetMs  = 1;
+
+    const int64_t nowSec =
+        std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+    // 写入 oldCount 条 60 天前的记录与 5 条最近的记录
+    auto seed = [&](int oldCount) {
+        rlx_money::TransactionDAO transactionDAO(dbManager);
+        REQUIRE(dbManager.executeTransaction([&](SQLite::Database&) {
+            for (int i = 0; i < oldCount + 5; ++i) {
+                int64_t timestamp = i < oldCount ? nowSec - 60LL * 86400 + i : nowSec - 60 + i;
+                transactionDAO.createTransaction(rlx_money::TransactionRecord(
+                    0,
+                    "rt" + std::to_string(i % 7),
+                    "gold",
+                    i,
+                    i,
+                    rlx_money::TransactionType::ADD,
+                    std::string(200, 'x'),
+                    timestamp
+                ));
+            }
+            return true;
+        }));
+    };
+    auto countRecords = [&]() {
+        return dbManager.getConnection().execAndGet("SELECT COUNT(*) FROM transactions").getInt();
+    };
+
+    SECTION("按时间预算分批删除并在重启后继续") {
+        REQUIRE(dbManager.initialize(config));
+        REQUIRE(dbManager.getConnection().execAndGet("PRAGMA auto_vacuum").getInt() == 2);
+        seed(3000);
+
+        auto progress = dbManager.startRetention(30);
+        REQUIRE(progress.state == rlx_money::RetentionState::Running);
+        REQUIRE_THROWS_AS(dbManager.startRetention(30), rlx_money::DatabaseException);
+        REQUIRE_THROWS_AS(dbManager.startRetention(0), rlx_money::InvalidArgumentException);
+
+        // 一个 tick 只删除时间预算内的若干批
+        progress = dbManager.stepRetention();
+        REQUIRE(progress.state == rlx_money::RetentionState::Running);
+        REQUIRE(progress.deletedRecords >= 10);
+        REQUIRE(progress.deletedRecords < 3000);
+        REQUIRE(progress.deletedRecords % 10 == 0);
+        REQUIRE(countRecords() == 3005 - progress.deletedRecords);
+
+        // 重启后从保存的进度继续
+        int64_t deletedBeforeRestart = progress.deletedRecords;
+        int64_t cutoffTime           = progress.cutoffTime;
+        dbManager.close();
+        REQUIRE(dbManager.initialize(config));
+        progress = dbManager.getRetentionProgress();
+        REQUIRE(progress.state == rlx_money::RetentionState::Running);
+        REQUIRE(progress.deletedRecords == deletedBeforeRestart);
+        REQUIRE(progress.cutoffTime == cutoffTime);
+
+        for (int ticks = 0; progress.state == rlx_money::RetentionState::Running && ticks < 10000; ++ticks) {
+            progress = dbManager.stepRetention();
+        }
+        REQUIRE(progress.state == rlx_money::RetentionState::Completed);
+        REQUIRE(progress.deletedRecords == 3000);
+        REQUIRE(countRecords() == 5);
+        REQUIRE(dbManager.verifyAggregates().consistent());
+        REQUIRE(dbManager.getConnection().execAndGet("SELECT COUNT(*) FROM retention_job").getInt() == 0);
+        REQUIRE_FALSE(dbManager.cancelRetention());
+
+        // 之后的空闲 tick 把空闲页归还给文件系统
+        int64_t pageSize  = dbManager.getConnection().execAndGet("PRAGMA page_size").getInt64();
+        int64_t freePages = dbManager.getConnection().execAndGet("PRAGMA freelist_count").getInt64();
+        REQUIRE(freePages > 0);
+        auto sizeBefore = std::filesystem::file_size(testDbPath);
+        for (int ticks = 0; ticks < 10000; ++ticks) {
+            progress = dbManager.stepRetention();
+            if (progress.freeBytes == 0) {
+                break;
+            }
+        }
+        REQUIRE(progress.freeBytes == 0);
+        REQUIRE(progress.reclaimedBytes == freePages * pageSize);
+        REQUIRE(std::filesystem::file_size(testDbPath) < sizeBefore);
+        REQUIRE(dbManager.getConnection().execAndGet("PRAGMA integrity_check").getString() == "ok");
+        dbManager.close();
+    }
+
+    SECTION("已有数据库只在手动整理时切换为增量整理") {
+        {
+            SQLite::Database db(testDbPath, SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE);
+            db.exec("CREATE TABLE unrelated (id INTEGER PRIMARY KEY)");
+        }
+        REQUIRE(dbManager.initialize(config));
+        REQUIRE_FALSE(dbManager.isIncrementalVacuumEnabled());
+        seed(200);
+        dbManager.startRetention(30);
+        auto progress = dbManager.stepRetention();
+        for (int ticks = 0; progress.state == rlx_money::RetentionState::Running && ticks < 10000; ++ticks) {
+            progress = dbManager.stepRetention();
+        }
+        REQUIRE(progress.state == rlx_money::RetentionState::Completed);
+
+        // 未启用增量整理时空闲页留在文件中
+        REQUIRE(dbManager.getConnection().execAndGet("PRAGMA freelist_count").getInt64() > 0);
+        int64_t sizeBefore = dbManager.getDatabaseSizeBytes();
+
+        // 重新打开不会整理，手动转换后空闲页被回收
+        dbManager.close();
+        REQUIRE(dbManager.initialize(config));
+        REQUIRE_FALSE(dbManager.isIncrementalVacuumEnabled());
+        REQUIRE(dbManager.getDatabaseSizeBytes() == sizeBefore);
+
+        // 请求停止时 VACUUM 中止并回滚，数据库保持原样
+        std::stop_source stopped;
+        stopped.request_stop();
+        REQUIRE_THROWS_AS(dbManager.convertToIncrementalVacuum(stopped.get_token()), rlx_money::DatabaseException);
+        REQUIRE_FALSE(dbManager.isIncrementalVacuumEnabled());
+        REQUIRE(dbManager.getDatabaseSizeBytes() == sizeBefore);
+
+        REQUIRE(dbManager.convertToIncrementalVacuum());
+        REQUIRE(dbManager.isIncrementalVacuumEnabled());
+        REQUIRE(dbManager.getDatabaseSizeBytes() < sizeBefore);
+        REQUIRE(dbManager.getConnection().execAndGet("PRAGMA freelist_count").getInt64() == 0);
+        REQUIRE_FALSE(dbManager.convertToIncrementalVacuum());
+        REQUIRE(countRecords() == 5);
+        dbManager.close();
+    }
+
+    SECTION("写连接有未提交的事务时跳过本 tick") {
+        config.groupCommit = true;
+        REQUIRE(dbManager.initialize(config));
+        seed(20);
+        dbManager.flushGroupCommit();
+
+        // 任务记录随组事务提交，提交之前不删除
+        dbManager.startRetention(30);
+        REQUIRE(dbManager.stepRetention().deletedRecords == 0);
+        dbManager.flushGroupCommit();
+        auto progress = dbManager.stepRetention();
+        REQUIRE(progress.deletedRecords > 0);
+        for (int ticks = 0; progress.state == rlx_money::RetentionState::Running && ticks < 100; ++ticks) {
+            progress = dbManager.stepRetention();
+        }
+        REQUIRE(progress.state == rlx_money::RetentionState::Completed);
+        REQUIRE(countRecords() == 5);
+        dbManager.close();
+    }
+
+    SECTION("自动清理与取消") {
+        config.retentionDays = 30;
+        REQUIRE(dbManager.initialize(config));
+        seed(50);
+
+        // 首个 tick 自动开始，当天不再重复开始
+        auto progress = dbManager.stepRetention();
+        REQUIRE(progress.state == rlx_money::RetentionState::Running);
+        REQUIRE(progress.deletedRecords > 0);
+        REQUIRE(dbManager.cancelRetention());
+        REQUIRE(dbManager.getRetentionProgress().state == rlx_money::RetentionState::Idle);
+        int remaining = countRecords();
+        dbManager.stepRetention();
+        REQUIRE(countRecords() == remaining);
+
+        // 取消后重启不会继续
+        dbManager.close();
+        config.retentionDays = 0;
+        REQUIRE(dbManager.initialize(config));
+        REQUIRE(dbManager.getRetentionProgress().state == rlx_money::RetentionState::Idle);
+        dbManager.stepRetention();
+        REQUIRE(countRecords() == remaining);
+        dbManager.close();
+    }
+
+    SECTION("异步写入模式下由写线程删除") {
+        config.asyncWriter   = true;
+        config.retentionDays = 30;
+        REQUIRE(dbManager.initialize(config));
+        seed(200);
+
+        // 写线程阻塞时 tick 只投递删除，不等待；返回前放开写线程以免测试卡住
+        std::promise<void> release;
+        auto               gate = dbManager.submitTransaction(
+            [opened = release.get_future().share()](SQLite::Database&) {
+                opened.wait();
+                return true;
+            }
+        );
+        auto tick     = std::async(std::launch::async, [&] { return dbManager.stepRetention(); });
+        bool returned = tick.wait_for(std::chrono::seconds(5)) == std::future_status::ready;
+        // 上一步尚未完成时后续 tick 也不等待
+        std::optional<rlx_money::RetentionProgress> next;
+        if (returned) {
+            next = dbManager.stepRetention();
+        }
+        release.set_value();
+        REQUIRE(returned);
+        REQUIRE(gate.get());
+        REQUIRE(tick.get().state == rlx_money::RetentionState::Running);
+        REQUIRE(next->deletedRecords == 0);
+        auto progress = *next;
+
+        // 删除结果在之后的 tick 计入进度
+        for (int ticks = 0; progress.state == rlx_money::RetentionState::Running && ticks < 10000; ++ticks) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            progress = dbManager.stepRetention();
+        }
+        REQUIRE(progress.state == rlx_money::RetentionState::Completed);
+        REQUIRE(progress.deletedRecords == 200);
+        REQUIRE(countRecords() == 5);
+        REQUIRE(dbManager.getConnection().execAndGet("SELECT COUNT(*) FROM retention_job").getInt() == 0);
+
+        // 空闲 tick 在写线程上归还空闲页
+        for (int ticks = 0; (progress.reclaimedBytes == 0 || progress.freeBytes != 0) && ticks < 10000; ++ticks) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            progress = dbManager.stepRetention();
+        }
+        REQUIRE(progress.freeBytes == 0);
+        REQUIRE(progress.reclaimedBytes > 0);
+        dbManager.close();
+    }
+
+    SECTION("清理配置校验") {
+        REQUIRE_NOTHROW(config.validate());
+        config.retentionBatchSize = 0;
+        REQUIRE_THROWS_AS(config.validate(), std::invalid_argument);
+        config.retentionBatchSize = 500;
+        config.retentionBudgetMs  = 0;
+        REQUIRE_THROWS_AS(config.validate(), std::invalid_argument);
+        config.retentionBudgetMs  = 5;
+        config.vacuumPagesPerTick = -1;
+        REQUIRE_THROWS_AS(config.validate(), std::invalid_argument);
+        config.vacuumPagesPerTick = 64;
+        config.retentionDays      = -1;
+        REQUIRE_THROWS_AS(config.validate(), std::invalid_argument);
+    }
+
+    dbManager.resetForTesting();
 }
 
 // ============================================================================
@@ -410,6 +2334,9 @@ TEST_CASE("TransactionDAO 测试", "[database][dao][transaction]") {
             newRecord(2, "12345", "gold", 200, 300, rlx_money::TransactionType::ADD, "新交易", nowSec - (24 * 60 * 60));
         REQUIRE(transactionDAO.createTransaction(newRecord));
 
+        // 保留天数换算为秒时超出 int 范围也不会误删
+        REQUIRE(transactionDAO.cleanupOldTransactions(36500) == 0);
+
         // 清理旧记录（保留最近30天的记录）
         int deletedCount = transactionDAO.cleanupOldTransactions(30);
         REQUIRE(deletedCount == 1); // 应该删除1条旧记录
@@ -423,6 +2350,271 @@ TEST_CASE("TransactionDAO 测试", "[database][dao][transaction]") {
         dbManager.close();
         // 文件会自动清理
     }
+
+    SECTION("游标分页查询") {
+        auto& dbManager = rlx_money::DatabaseManager::getInstance();
+        REQUIRE(dbManager.initialize(testDbPath));
+
+        rlx_money::TransactionDAO transactionDAO(dbManager);
+
+        // 每 5 条记录共享同一个时间戳，验证同一秒内的排序稳定
+        for (int i = 1; i <= 47; ++i) {
+            rlx_money::TransactionRecord record(
+                0,
+                "12345",
+                i % 2 == 0 ? "gold" : "silver",
+                i,
+                i,
+                i % 3 == 0 ? rlx_money::TransactionType::REDUCE : rlx_money::TransactionType::ADD,
+                "交易 " + std::to_string(i),
+                1600000000 + i / 5
+            );
+            REQUIRE(transactionDAO.createTransaction(record));
+        }
+        REQUIRE(transactionDAO.createTransaction(
+            rlx_money::TransactionRecord(0, "other", "gold", 1, 1, rlx_money::TransactionType::ADD, "", 1600000005)
+        ));
+
+        // 逐页读取全部记录：不重复、不遗漏，按 (timestamp, id) 倒序
+        auto readAll = [&](const rlx_money::TransactionFilter& filter, int pageSize) {
+            std::vector<rlx_money::TransactionRecord> all;
+            std::string                               cursor;
+            int                                       pages = 0;
+            do {
+                auto page = transactionDAO.getPlayerTransactionsPage("12345", filter, cursor, pageSize);
+                REQUIRE(static_cast<int>(page.records.size()) <= pageSize);
+                all.insert(all.end(), page.records.begin(), page.records.end());
+                cursor = page.nextCursor;
+                ++pages;
+            } while (!cursor.empty());
+            for (size_t i = 1; i < all.size(); ++i) {
+                REQUIRE(
+                    (all[i - 1].timestamp > all[i].timestamp
+                     || (all[i - 1].timestamp == all[i].timestamp && all[i - 1].id > all[i].id))
+                );
+            }
+            return std::pair{all, pages};
+        };
+
+        auto [all, pages] = readAll({}, 10);
+        REQUIRE(all.size() == 47);
+        REQUIRE(pages == 5);
+        REQUIRE(all.front().amount == 47);
+        REQUIRE(all.back().amount == 1);
+
+        // 与 OFFSET 分页结果一致
+        auto offsetPage = transactionDAO.getPlayerTransactions("12345", "", 2, 10);
+        REQUIRE(offsetPage.size() == 10);
+        for (size_t i = 0; i < offsetPage.size(); ++i) {
+            REQUIRE(offsetPage[i].id == all[10 + i].id);
+        }
+
+        // 记录数恰好为页大小的整数倍时，最后一页之后没有游标
+        auto exact = transactionDAO.getPlayerTransactionsPage("12345", {}, "", 47);
+        REQUIRE(exact.records.size() == 47);
+        REQUIRE_FALSE(exact.hasMore());
+
+        // 按币种、类型和时间范围筛选
+        rlx_money::TransactionFilter goldFilter;
+        goldFilter.currencyId = "gold";
+        auto [gold, goldPages] = readAll(goldFilter, 4);
+        REQUIRE(gold.size() == 23);
+        for (const auto& record : gold) {
+            REQUIRE(record.currencyId == "gold");
+        }
+
+        rlx_money::TransactionFilter typeFilter;
+        typeFilter.type           = rlx_money::TransactionType::REDUCE;
+        auto [reduced, typePages] = readAll(typeFilter, 3);
+        REQUIRE(reduced.size() == 15);
+
+        rlx_money::TransactionFilter rangeFilter;
+        rangeFilter.startTime     = 1600000002;
+        rangeFilter.endTime       = 1600000004;
+        auto [ranged, rangePages] = readAll(rangeFilter, 4);
+        REQUIRE(ranged.size() == 15);
+        for (const auto& record : ranged) {
+            REQUIRE(record.timestamp >= 1600000002);
+            REQUIRE(record.timestamp <= 1600000004);
+        }
+
+        // 翻页期间写入的新记录不会影响已返回的游标之后的内容
+        auto first = transactionDAO.getPlayerTransactionsPage("12345", {}, "", 10);
+        REQUIRE(transactionDAO.createTransaction(
+            rlx_money::TransactionRecord(0, "12345", "gold", 99, 99, rlx_money::TransactionType::ADD, "", 1700000000)
+        ));
+        auto second = transactionDAO.getPlayerTransactionsPage("12345", {}, first.nextCursor, 10);
+        REQUIRE(second.records.front().id == all[10].id);
+
+        // 无效游标
+        REQUIRE_THROWS_AS(
+            transactionDAO.getPlayerTransactionsPage("12345", {}, "not-a-cursor", 10),
+            rlx_money::InvalidArgumentException
+        );
+        REQUIRE_THROWS_AS(
+            transactionDAO.getPlayerTransactionsPage("12345", {}, "12.", 10),
+            rlx_money::InvalidArgumentException
+        );
+
+        dbManager.close();
+    }
+
+    SECTION("归档到月度分段文件") {
+        const std::string archiveDir = tempManager.makeUniquePath("test_archive_dir", "");
+        tempManager.registerDirectory(archiveDir);
+
+        auto&                     dbManager = rlx_money::DatabaseManager::getInstance();
+        rlx_money::DatabaseConfig config;
+        config.path       = testDbPath;
+        config.archiveDir = archiveDir;
+        REQUIRE(dbManager.initialize(config));
+
+        rlx_money::TransactionDAO transactionDAO(dbManager);
+
+        const int64_t nowSec =
+            std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch())
+                .count();
+        const int64_t january  = 1704067200; // 2024-01-01 00:00:00 UTC
+        const int64_t february = 1706745600; // 2024-02-01 00:00:00 UTC
+
+        // 2024 年 1 月 3 条（其中一条为转账）、2 月 2 条、最近 4 条
+        const std::string transferId = "0123456789abcdef01234567";
+        for (int i = 0; i < 3; ++i) {
+            rlx_money::TransactionRecord record(
+                0,
+                "12345",
+                "gold",
+                10 + i,
+                10 + i,
+                i == 0 ? rlx_money::TransactionType::TRANSFER : rlx_money::TransactionType::ADD,
+                "一月 " + std::to_string(i),
+                january + 86400 * (i + 1)
+            );
+            if (i == 0) {
+                record.relatedXuid = "other";
+                record.transferId  = transferId;
+            }
+            REQUIRE(transactionDAO.createTransaction(record));
+        }
+        for (int i = 0; i < 2; ++i) {
+            REQUIRE(transactionDAO.createTransaction(rlx_money::TransactionRecord(
+                0,
+                "12345",
+                "silver",
+                20 + i,
+                20 + i,
+                rlx_money::TransactionType::ADD,
+                "二月 " + std::to_string(i),
+                february + 86400 * (i + 1)
+            )));
+        }
+        REQUIRE(transactionDAO.createTransaction(
+            rlx_money::TransactionRecord(0, "other", "gold", 5, 5, rlx_money::TransactionType::ADD, "", january + 60)
+        ));
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE(transactionDAO.createTransaction(rlx_money::TransactionRecord(
+                0,
+                "12345",
+                "gold",
+                30 + i,
+                30 + i,
+                rlx_money::TransactionType::ADD,
+                "最近 " + std::to_string(i),
+                nowSec - 86400 + i
+            )));
+        }
+
+        // 请求停止时不开始下一个月份
+        std::stop_source stopped;
+        stopped.request_stop();
+        REQUIRE(transactionDAO.archiveOldTransactions(30, stopped.get_token()) == 0);
+
+        REQUIRE(transactionDAO.archiveOldTransactions(30) == 6);
+        REQUIRE(transactionDAO.archiveOldTransactions(30) == 0);
+        REQUIRE_THROWS_AS(transactionDAO.archiveOldTransactions(0), rlx_money::InvalidArgumentException);
+
+        std::string stem = std::filesystem::path(testDbPath).stem().string();
+        REQUIRE(std::filesystem::exists(std::filesystem::path(archiveDir) / (stem + "-202401.db")));
+        REQUIRE(std::filesystem::exists(std::filesystem::path(archiveDir) / (stem + "-202402.db")));
+
+        // 热表只保留最近的记录，汇总表随删除同步
+        REQUIRE(transactionDAO.getPlayerTransactions("12345", "", 1, 100).size() == 4);
+        REQUIRE(transactionDAO.getPlayerTransactionCount("12345") == 4);
+        auto live = transactionDAO.getPlayerTransactionsPage("12345", {}, "", 10);
+        REQUIRE(live.records.size() == 4);
+        REQUIRE_FALSE(live.hasMore());
+
+        // 分段文件自带字典表行，可以单独查询
+        {
+            SQLite::Database  segment((std::filesystem::path(archiveDir) / (stem + "-202401.db")).string());
+            SQLite::Statement count(
+                segment,
+                "SELECT COUNT(*) FROM transactions t JOIN accounts a ON a.id = t.account_id "
+                "JOIN currency_keys c ON c.id = t.currency_key"
+            );
+            REQUIRE(count.executeStep());
+            REQUIRE(count.getColumn(0).getInt() == 4);
+        }
+
+        // 跨两层逐页读取：不重复、不遗漏，按 (timestamp, id) 倒序
+        auto readAll = [&](rlx_money::TransactionFilter filter, int pageSize) {
+            filter.includeArchived = true;
+            std::vector<rlx_money::TransactionRecord> all;
+            std::string                               cursor;
+            do {
+                auto page = transactionDAO.getPlayerTransactionsPage("12345", filter, cursor, pageSize);
+                REQUIRE(static_cast<int>(page.records.size()) <= pageSize);
+                all.insert(all.end(), page.records.begin(), page.records.end());
+                cursor = page.nextCursor;
+            } while (!cursor.empty());
+            for (size_t i = 1; i < all.size(); ++i) {
+                REQUIRE(
+                    (all[i - 1].timestamp > all[i].timestamp
+                     || (all[i - 1].timestamp == all[i].timestamp && all[i - 1].id > all[i].id))
+                );
+            }
+            return all;
+        };
+
+        for (int pageSize : {1, 2, 3, 9, 20}) {
+            auto all = readAll({}, pageSize);
+            REQUIRE(all.size() == 9);
+            REQUIRE(all.front().description == "最近 3");
+            REQUIRE(all.back().description == "一月 0");
+            REQUIRE(all.back().relatedXuid == std::optional<std::string>("other"));
+            REQUIRE(all.back().transferId == std::optional<std::string>(transferId));
+        }
+
+        rlx_money::TransactionFilter sinceFebruary;
+        sinceFebruary.startTime = february;
+        REQUIRE(readAll(sinceFebruary, 2).size() == 6);
+
+        rlx_money::TransactionFilter silver;
+        silver.currencyId = "silver";
+        REQUIRE(readAll(silver, 1).size() == 2);
+
+        // 分段已提交而热表删除被回滚时，同一条记录在两层各有一份，查询结果中只出现一次
+        auto archived = readAll({}, 20)[4];
+        REQUIRE(dbManager.executeTransaction([&](SQLite::Database& db) {
+            SQLite::Statement insert(
+                db,
+                "INSERT INTO transactions (account_id, timestamp, id, currency_key, amount, balance, type) "
+                "VALUES ((SELECT id FROM accounts WHERE xuid = '12345'), ?, ?, "
+                "(SELECT id FROM currency_keys WHERE code = 'silver'), ?, ?, 1)"
+            );
+            insert.bind(1, archived.timestamp);
+            insert.bind(2, archived.id);
+            insert.bind(3, archived.amount);
+            insert.bind(4, archived.balance);
+            insert.exec();
+            return true;
+        }));
+        REQUIRE(readAll({}, 2).size() == 9);
+        REQUIRE(transactionDAO.archiveOldTransactions(30) == 1);
+        REQUIRE(readAll({}, 2).size() == 9);
+
+        dbManager.close();
+    }
 }
 
 // ============================================================================
@@ -505,4 +2697,532 @@ TEST_CASE("数据库事务测试", "[database][transaction]") {
         dbManager.close();
         // 文件会自动清理
     }
-}
\ No newline at end of file
+}
+// ============================================================================
+// 存储后端测试
+// ============================================================================
+
+namespace {
+
+/// @brief 在存储后端上执行一组固定操作，并把结果整理为可比较的文本
+/// @note 批量操作写入的记录使用当前时间，因此快照中不包含时间戳
+std::string runStorageScript(rlx_money::StorageBackend& storage) {
+    using rlx_money::TransactionType;
+    std::ostringstream out;
+
+    auto formatOptional = [](const std::optional<int>& value) {
+        return value ? std::to_string(*value) : std::string("null");
+    };
+
+    REQUIRE(storage.createPlayer(rlx_money::PlayerData("1001", "alice", 1600000000)));
+    REQUIRE(storage.createPlayer(rlx_money::PlayerData("1002", "bob", 1600000000)));
+    REQUIRE(storage.createPlayer(rlx_money::PlayerData("1003", "carol", 1600000000)));
+    REQUIRE_THROWS_AS(
+        storage.createPlayer(rlx_money::PlayerData("1001", "alice2", 1600000000)),
+        rlx_money::DatabaseException
+    );
+    REQUIRE(storage.initializeBalance("1001", "gold", 1000));
+    REQUIRE(storage.initializeBalance("1002", "gold", 50));
+    REQUIRE(storage.updateUsername("1003", "carol2"));
+
+    REQUIRE(storage.runTransaction([&]() -> bool {
+        out << "delta:" << formatOptional(storage.applyBalanceDelta("1001", "gold", -300, 0, 10000, std::nullopt));
+        out << ',' << formatOptional(storage.applyBalanceDelta("1002", "gold", -100, 0, 10000, std::nullopt));
+        out << ',' << formatOptional(storage.applyBalanceDelta("1002", "gold", 20000, 0, 10000, std::nullopt));
+        out << ',' << formatOptional(storage.applyBalanceDelta("1003", "gold", 10, 0, 10000, std::nullopt));
+        out << ',' << formatOptional(storage.applyBalanceDelta("1003", "gold", 10, 0, 10000, 500));
+        out << ',' << formatOptional(storage.applyBalanceDelta("9999", "gold", 10, 0, 10000, 500)) << '\n';
+        out << "assign:" << formatOptional(storage.assignBalance("1002", "gold", 70));
+        out << ',' << formatOptional(storage.assignBalance("9999", "gold", 70)) << '\n';
+
+        for (int i = 0; i < 5; ++i) {
+            rlx_money::TransactionRecord
+                record(0, "1001", "gold", 10 + i, 700 + i, TransactionType::ADD, "记录", 1600000000 + i / 2);
+            if (!storage.createTransaction(record)) return false;
+        }
+        return true;
+    }));
+
+    REQUIRE(storage.runTransaction([&]() -> bool {
+        out << "bulk:" << storage.addToAllBalances("gold", 400, 1000, "全体增加");
+        out << ',' << storage.scaleAllBalances("gold", 1'500'000, true, 1000, "全体缩放");
+        out << ',' << storage.clampAllBalances("gold", 800, "上限");
+        out << ',' << storage.assignAllBalances("silver", 5, "空币种") << '\n';
+        return true;
+    }));
+
+    for (const auto* xuid : {"1001", "1002", "1003", "9999"}) {
+        out << xuid << ':' << formatOptional(storage.getBalance(xuid, "gold")) << ':'
+            << storage.getAllBalances(xuid).size() << ':' << storage.getPlayerTransactionCount(xuid) << '\n';
+    }
+    out << "players:" << storage.getPlayerCount() << ",wealth:" << storage.getTotalWealth("gold")
+        << ",name:" << storage.getPlayerByXuid("1003").value_or(rlx_money::PlayerData()).username << '\n';
+
+    // 余额列表不保证顺序，按 XUID 排序后比较
+    std::set<std::string> balanceList;
+    for (const auto& entry : storage.getCurrencyBalanceList("gold")) {
+        balanceList.insert(entry.xuid + '=' + entry.username + '=' + std::to_string(entry.balance));
+    }
+    for (const auto& entry : balanceList) {
+        out << "list:" << entry << '\n';
+    }
+
+    // 按游标翻页直至结束，记录每页内容
+    rlx_money::TransactionFilter filter;
+    filter.type = TransactionType::ADD;
+    std::string cursor;
+    do {
+        auto page = storage.getPlayerTransactionsPage("1001", filter, cursor, 2);
+        out << "page:";
+        for (const auto& record : page.records) {
+            out << record.amount << '/' << record.balance << '/' << static_cast<int>(record.type) << ' ';
+        }
+        out << (page.hasMore() ? "more" : "end") << '\n';
+        cursor = page.nextCursor;
+    } while (!cursor.empty());
+
+    for (const auto& record : storage.getPlayerTransactions("1001", "gold", 2, 3)) {
+        out << "legacy:" << record.amount << '/' << record.description << '\n';
+    }
+    return out.str();
+}
+
+/// @brief 在存储后端上验证嵌套事务与回滚监听的语义
+void checkStorageTransactions(rlx_money::StorageBackend& storage) {
+    int rollbacks = 0;
+    storage.setRollbackListener([&rollbacks]() { ++rollbacks; });
+
+    REQUIRE(storage.createPlayer(rlx_money::PlayerData("2001", "nested", 1600000000)));
+    REQUIRE(storage.initializeBalance("2001", "gold", 100));
+
+    // 外层提交、内层回滚：只撤销内层的写入，未提交过嵌套事务时不通知
+    REQUIRE(storage.runTransaction([&]() -> bool {
+        REQUIRE(storage.applyBalanceDelta("2001", "gold", 10, 0, 10000, std::nullopt) == 110);
+        REQUIRE_FALSE(storage.runTransaction([&]() -> bool {
+            REQUIRE(storage.applyBalanceDelta("2001", "gold", 1000, 0, 10000, std::nullopt) == 1110);
+            return false;
+        }));
+        return true;
+    }));
+    REQUIRE(storage.getBalance("2001", "gold") == 110);
+    REQUIRE(rollbacks == 0);
+
+    // 内层已提交而外层回滚：全部撤销并通知监听器
+    REQUIRE_FALSE(storage.runTransaction([&]() -> bool {
+        REQUIRE(storage.runTransaction([&]() -> bool {
+            return storage.applyBalanceDelta("2001", "gold", 5, 0, 10000, std::nullopt).has_value();
+        }));
+        rlx_money::TransactionRecord record(0, "2001", "gold", 5, 115, rlx_money::TransactionType::ADD, "", 1600000000);
+        REQUIRE(storage.createTransaction(record));
+        return false;
+    }));
+    REQUIRE(storage.getBalance("2001", "gold") == 110);
+    REQUIRE(storage.getPlayerTransactionCount("2001") == 0);
+    REQUIRE(rollbacks == 1);
+
+    // 事务中抛出的异常以 DatabaseException 传出，写入全部撤销
+    REQUIRE_THROWS_AS(
+        storage.runTransaction([&]() -> bool {
+            storage.applyBalanceDelta("2001", "gold", 20, 0, 10000, std::nullopt);
+            throw std::runtime_error("中断");
+        }),
+        rlx_money::DatabaseException
+    );
+    REQUIRE(storage.getBalance("2001", "gold") == 110);
+
+    REQUIRE_THROWS_AS(
+        storage.getPlayerTransactionsPage("2001", rlx_money::TransactionFilter(), "bad-cursor", 10),
+        rlx_money::InvalidArgumentException
+    );
+    storage.setRollbackListener(nullptr);
+}
+
+/// @brief 整理存储后端中指定玩家的全部可读状态（只读，包含已归档的记录）
+std::string describeStorage(const rlx_money::StorageBackend& storage, const std::vector<std::string>& xuids) {
+    std::ostringstream out;
+    out << "players:" << storage.getPlayerCount() << ",wealth:" << storage.getTotalWealth("gold")
+        << ",checkpoint:" << storage.getJournalCheckpoint() << '\n';
+
+    rlx_money::TransactionFilter filter;
+    filter.includeArchived = true;
+    for (const auto& xuid : xuids) {
+        auto player = storage.getPlayerByXuid(xuid).value_or(rlx_money::PlayerData());
+        out << xuid << ':' << player.username << ':' << player.firstJoinTime << ':'
+            << storage.getBalance(xuid, "gold").value_or(-1) << ':' << storage.getPlayerTransactionCount(xuid) << '\n';
+        for (const auto& record : storage.getPlayerTransactionsPage(xuid, filter, "", 100000).records) {
+            out << "  " << record.id << '/' << record.amount << '/' << record.balance << '/'
+                << static_cast<int>(record.type) << '/' << record.description << '/' << record.timestamp << '/'
+                << record.relatedXuid.value_or("-") << '/' << record.transferId.value_or("-") << '\n';
+        }
+    }
+    return out.str();
+}
+
+} // namespace
+
+TEST_CASE("存储后端语义一致性测试", "[database][storage]") {
+    auto&             tempManager = rlx_money::test::TestTempManager::getInstance();
+    const std::string testDbPath  = tempManager.makeUniquePath("test_storage_backend", ".db");
+    tempManager.registerFile(testDbPath);
+    tempManager.registerDirectory(rlx_money::LedgerStorageBackend::directoryFor(testDbPath).string());
+
+    rlx_money::DatabaseConfig config;
+    config.path = testDbPath;
+
+    SECTION("各后端与 SQLite 后端的读写结果一致") {
+        rlx_money::SqliteStorageBackend sqlite;
+        REQUIRE(sqlite.open(config));
+        const std::string expected = runStorageScript(sqlite);
+        sqlite.close();
+
+        config.backend = "memory";
+        auto memory    = rlx_money::createStorageBackend(config);
+        REQUIRE(memory->getName() == "memory");
+        REQUIRE(memory->open(config));
+        REQUIRE(runStorageScript(*memory) == expected);
+        memory->close();
+        REQUIRE_FALSE(memory->isOpen());
+
+        config.backend = "ledger";
+        auto ledger    = rlx_money::createStorageBackend(config);
+        REQUIRE(ledger->getName() == "ledger");
+        REQUIRE(ledger->open(config));
+        REQUIRE(runStorageScript(*ledger) == expected);
+        ledger->close();
+        REQUIRE_FALSE(ledger->isOpen());
+    }
+
+    SECTION("嵌套事务与回滚通知") {
+        rlx_money::SqliteStorageBackend sqlite;
+        REQUIRE(sqlite.open(config));
+        checkStorageTransactions(sqlite);
+        sqlite.close();
+
+        rlx_money::MemoryStorageBackend memory;
+        REQUIRE(memory.open(config));
+        checkStorageTransactions(memory);
+        memory.close();
+
+        rlx_money::LedgerStorageBackend ledger;
+        REQUIRE(ledger.open(config));
+        checkStorageTransactions(ledger);
+        ledger.close();
+    }
+
+    SECTION("内存后端归档与关闭") {
+        rlx_money::MemoryStorageBackend memory;
+        REQUIRE_THROWS_AS(memory.runTransaction([]() { return true; }), rlx_money::DatabaseException);
+        REQUIRE(memory.open(config));
+        REQUIRE(memory.createPlayer(rlx_money::PlayerData("3001", "archiver", 1600000000)));
+
+        const int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+                                std::chrono::system_clock::now().time_since_epoch()
+        )
+                                .count();
+        rlx_money::TransactionRecord
+            oldRecord(0, "3001", "gold", 1, 1, rlx_money::TransactionType::ADD, "旧", 1600000000);
+        rlx_money::TransactionRecord newRecord(0, "3001", "gold", 2, 3, rlx_money::TransactionType::ADD, "新", now);
+        REQUIRE(memory.createTransaction(oldRecord));
+        REQUIRE(memory.createTransaction(newRecord));
+
+        REQUIRE_THROWS_AS(memory.archiveOldTransactions(0), rlx_money::InvalidArgumentException);
+        REQUIRE(memory.archiveOldTransactions(30) == 1);
+        REQUIRE(memory.getPlayerTransactionCount("3001") == 1);
+
+        rlx_money::TransactionFilter filter;
+        REQUIRE(memory.getPlayerTransactionsPage("3001", filter, "", 10).records.size() == 1);
+        filter.includeArchived = true;
+        REQUIRE(memory.getPlayerTransactionsPage("3001", filter, "", 10).records.size() == 2);
+
+        memory.setJournalCheckpoint(42);
+        REQUIRE(memory.getJournalCheckpoint() == 42);
+        memory.close();
+        REQUIRE_FALSE(memory.isOpen());
+    }
+
+    SECTION("未知的存储后端") {
+        config.backend = "unknown";
+        REQUIRE_THROWS_AS(rlx_money::createStorageBackend(config), rlx_money::InvalidArgumentException);
+    }
+}
+
+TEST_CASE("账本存储后端测试", "[database][storage][ledger]") {
+    using rlx_money::TransactionType;
+    auto&             tempManager = rlx_money::test::TestTempManager::getInstance();
+    const std::string testDbPath  = tempManager.makeUniquePath("test_ledger_backend", ".db");
+    const auto        directory   = rlx_money::LedgerStorageBackend::directoryFor(testDbPath);
+    tempManager.registerDirectory(directory.string());
+
+    rlx_money::DatabaseConfig config;
+    config.backend = "ledger";
+    config.path    = testDbPath;
+
+    const std::vector<std::string> xuids = {"4001", "4002", "4003"};
+    const int64_t                  now   = std::chrono::duration_cast<std::chrono::seconds>(
+                                  std::chrono::system_clock::now().time_since_epoch()
+    )
+                                  .count();
+
+    auto countSegmentFiles = [&]() {
+        size_t count = 0;
+        for (const auto& item : std::filesystem::directory_iterator(directory)) {
+            count += item.path().extension() == ".log" ? 1 : 0;
+        }
+        return count;
+    };
+
+    SECTION("重新打开后由分段重建") {
+        std::string expected;
+        {
+            rlx_money::LedgerStorageBackend ledger;
+            REQUIRE(ledger.open(config));
+            REQUIRE(ledger.createPlayer(rlx_money::PlayerData("4001", "甲", 1600000000)));
+            REQUIRE(ledger.createPlayer(rlx_money::PlayerData("4002", "乙", 1600000001)));
+            REQUIRE(ledger.updateUsername("4002", "乙二"));
+
+            REQUIRE(ledger.runTransaction([&]() -> bool {
+                ledger.applyBalanceDelta("4001", "gold", -30, 0, 10000, 100);
+                ledger.applyBalanceDelta("4002", "gold", 30, 0, 10000, 100);
+                rlx_money::TransactionRecord out(0, "4001", "gold", -30, 70, TransactionType::TRANSFER, "转出", now);
+                out.relatedXuid = "4002";
+                out.transferId  = "0123456789abcdef01234567";
+                rlx_money::TransactionRecord in(0, "4002", "gold", 30, 130, TransactionType::TRANSFER, "转入", now);
+                in.relatedXuid = "4001";
+                in.transferId  = "custom-transfer";
+                return ledger.createTransaction(out) && ledger.createTransaction(in);
+            }));
+
+            // 回滚的事务不会写入账本
+            REQUIRE_FALSE(ledger.runTransaction([&]() -> bool {
+                ledger.assignBalance("4001", "gold", 9999);
+                return false;
+            }));
+
+            rlx_money::TransactionRecord old(0, "4001", "gold", 1, 71, TransactionType::ADD, "旧", 1600000000);
+            REQUIRE(ledger.createTransaction(old));
+            REQUIRE(ledger.archiveOldTransactions(30) == 1);
+            ledger.setJournalCheckpoint(7);
+            expected = describeStorage(ledger, xuids);
+        }
+
+        rlx_money::LedgerStorageBackend reopened;
+        REQUIRE(reopened.open(config));
+        REQUIRE(describeStorage(reopened, xuids) == expected);
+        REQUIRE(reopened.getBalance("4001", "gold") == 70);
+        REQUIRE(reopened.getPlayerByXuid("4002")->username == "乙二");
+        REQUIRE(reopened.getPlayerTransactionCount("4001") == 1);
+        REQUIRE(reopened.getJournalCheckpoint() == 7);
+
+        auto incoming = reopened.getPlayerTransactions("4002", "gold", 1, 10);
+        REQUIRE(incoming.size() == 1);
+        REQUIRE(incoming.front().relatedXuid == "4001");
+        REQUIRE(incoming.front().transferId == "custom-transfer");
+        REQUIRE(reopened.getPlayerTransactions("4001", "gold", 1, 10).front().transferId == "0123456789abcdef01234567");
+
+        // 记录ID在重新打开后继续递增
+        rlx_money::TransactionRecord next(0, "4003", "gold", 5, 5, TransactionType::ADD, "新", now);
+        REQUIRE(reopened.createTransaction(next));
+        REQUIRE(reopened.getPlayerTransactions("4003", "gold", 1, 10).front().id == 4);
+    }
+
+    SECTION("丢弃未写完的事务") {
+        {
+            rlx_money::LedgerStorageBackend ledger;
+            REQUIRE(ledger.open(config));
+            REQUIRE(ledger.createPlayer(rlx_money::PlayerData("4001", "甲", 1600000000)));
+            REQUIRE(ledger.initializeBalance("4001", "gold", 100));
+        }
+        REQUIRE(countSegmentFiles() == 1);
+        std::filesystem::path active;
+        for (const auto& item : std::filesystem::directory_iterator(directory)) {
+            if (item.path().extension() == ".log") {
+                active = item.path();
+            }
+        }
+
+        // 模拟写到一半时进程中断：没有提交标记的条目、不完整的条目与不完整的字符串
+        {
+            rlx_money::LedgerEntry entry;
+            entry.kind     = rlx_money::LedgerEntryKind::Balance;
+            entry.account  = 1;
+            entry.currency = 3;
+            entry.balance  = 5000;
+            char raw[rlx_money::kLedgerEntrySize];
+            rlx_money::encodeLedgerEntry(entry, raw);
+            std::ofstream segment(active, std::ios::binary | std::ios::app);
+            segment.write(raw, sizeof(raw));
+            segment.write(raw, 20);
+
+            const char    torn[] = {16, 0, 0, 0, 'a', 'b', 'c'};
+            std::ofstream strings(directory / "strings.dat", std::ios::binary | std::ios::app);
+            strings.write(torn, sizeof(torn));
+        }
+
+        rlx_money::LedgerStorageBackend ledger;
+        REQUIRE(ledger.open(config));
+        REQUIRE(ledger.getBalance("4001", "gold") == 100);
+        REQUIRE(std::filesystem::file_size(active) == rlx_money::kLedgerHeaderSize + 4 * rlx_money::kLedgerEntrySize);
+
+        // 截断后继续追加，新的字符串与条目在再次打开后可读
+        REQUIRE(ledger.applyBalanceDelta("4001", "gold", 1, 0, 10000, std::nullopt) == 101);
+        REQUIRE(ledger.createPlayer(rlx_money::PlayerData("4002", "乙", 1600000000)));
+        ledger.close();
+        REQUIRE(ledger.open(config));
+        REQUIRE(ledger.getBalance("4001", "gold") == 101);
+        REQUIRE(ledger.getPlayerByXuid("4002")->username == "乙");
+        ledger.close();
+
+        // MANIFEST 列出的分段缺失时拒绝打开，不会静默丢弃数据
+        std::ofstream manifest(directory / "MANIFEST", std::ios::app);
+        manifest << 999 << '\n';
+        manifest.close();
+        REQUIRE_THROWS_AS(ledger.open(config), rlx_money::DatabaseException);
+        REQUIRE_FALSE(ledger.isOpen());
+    }
+
+    SECTION("MANIFEST 写入失败时继续写入已列出的分段") {
+        config.ledgerSegmentKB = 4;
+        {
+            rlx_money::LedgerStorageBackend ledger;
+            REQUIRE(ledger.open(config));
+            REQUIRE(ledger.createPlayer(rlx_money::PlayerData("4001", "甲", 1600000000)));
+
+            // 临时清单文件的位置被目录占用，封存时无法更新 MANIFEST
+            std::filesystem::create_directory(directory / "MANIFEST.tmp");
+            for (int i = 0; i < 300; ++i) {
+                rlx_money::TransactionRecord record(0, "4001", "gold", 1, i + 1, TransactionType::ADD, "加", now);
+                REQUIRE(ledger.createTransaction(record));
+            }
+            REQUIRE(ledger.getSegmentCount() == 1);
+            REQUIRE(countSegmentFiles() == 1);
+
+            // 恢复后下一次提交时完成封存
+            std::filesystem::remove(directory / "MANIFEST.tmp");
+            rlx_money::TransactionRecord record(0, "4001", "gold", 1, 301, TransactionType::ADD, "加", now);
+            REQUIRE(ledger.createTransaction(record));
+            REQUIRE(ledger.getSegmentCount() == 2);
+        }
+
+        rlx_money::LedgerStorageBackend reopened;
+        REQUIRE(reopened.open(config));
+        REQUIRE(reopened.getPlayerTransactionCount("4001") == 301);
+    }
+
+    SECTION("封存分段与后台合并") {
+        config.ledgerSegmentKB       = 4;
+        config.ledgerCompactSegments = 2;
+
+        rlx_money::MemoryStorageBackend memory;
+        REQUIRE(memory.open(config));
+        std::string expected;
+        {
+            rlx_money::LedgerStorageBackend ledger;
+            REQUIRE(ledger.open(config));
+            for (rlx_money::StorageBackend* storage : {static_cast<rlx_money::StorageBackend*>(&memory),
+                                                       static_cast<rlx_money::StorageBackend*>(&ledger)}) {
+                for (const auto& xuid : xuids) {
+                    REQUIRE(storage->createPlayer(rlx_money::PlayerData(xuid, "p" + xuid, 1600000000)));
+                }
+                bool committed = true;
+                for (int i = 0; i < 400; ++i) {
+                    const auto& xuid  = xuids[static_cast<size_t>(i) % xuids.size()];
+                    committed        &= storage->runTransaction([&]() -> bool {
+                        auto balance = storage->applyBalanceDelta(xuid, "gold", i % 7, 0, 1000000, 100);
+                        if (!balance) {
+                            return false;
+                        }
+                        return storage->createTransaction(rlx_money::TransactionRecord(
+                            0,
+                            xuid,
+                            "gold",
+                            i % 7,
+                            *balance,
+                            TransactionType::ADD,
+                            "第" + std::to_string(i % 10) + "笔",
+                            1600000000 + i
+                        ));
+                    });
+                }
+                REQUIRE(committed);
+            }
+
+            // 每个分段约 60 个条目，1200 多个条目写满了近 20 个分段，合并后只剩少数几个
+            ledger.waitForCompaction();
+            REQUIRE(ledger.getSegmentCount() < 8);
+            REQUIRE(countSegmentFiles() == ledger.getSegmentCount());
+            expected = describeStorage(memory, xuids);
+            REQUIRE(describeStorage(ledger, xuids) == expected);
+        }
+
+        rlx_money::LedgerStorageBackend reopened;
+        REQUIRE(reopened.open(config));
+        reopened.waitForCompaction();
+        REQUIRE(describeStorage(reopened, xuids) == expected);
+        REQUIRE(countSegmentFiles() == reopened.getSegmentCount());
+    }
+
+    SECTION("账本配置校验") {
+        REQUIRE_NOTHROW(config.validate());
+        config.ledgerSegmentKB = 2;
+        REQUIRE_THROWS_AS(config.validate(), std::invalid_argument);
+        config.ledgerSegmentKB       = 4096;
+        config.ledgerCompactSegments = 1;
+        REQUIRE_THROWS_AS(config.validate(), std::invalid_argument);
+        config.ledgerCompactSegments = 8;
+        config.backend               = "lsm";
+        REQUIRE_THROWS_AS(config.validate(), std::invalid_argument);
+    }
+
+    SECTION("持续追加的吞吐量") {
+        constexpr int kCommits = 2000;
+
+        // 每次提交一条余额更新与一条交易记录，返回耗时（微秒）
+        auto append = [&](rlx_money::StorageBackend& storage) {
+            REQUIRE(storage.createPlayer(rlx_money::PlayerData("4001", "甲", 1600000000)));
+            bool committed = true;
+            auto start     = std::chrono::steady_clock::now();
+            for (int i = 0; i < kCommits; ++i) {
+                committed &= storage.runTransaction([&]() -> bool {
+                    auto balance = storage.applyBalanceDelta("4001", "gold", 1, 0, 1000000, 0);
+                    return balance
+                        && storage.createTransaction(rlx_money::TransactionRecord(
+                            0,
+                            "4001",
+                            "gold",
+                            1,
+                            *balance,
+                            TransactionType::ADD,
+                            "追加",
+                            1600000000 + i
+                        ));
+                });
+            }
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            REQUIRE(committed);
+            REQUIRE(storage.getBalance("4001", "gold") == kCommits);
+            return std::max<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count(), 1);
+        };
+
+        const std::string sqlitePath = tempManager.makeUniquePath("test_ledger_sqlite", ".db");
+        tempManager.registerFile(sqlitePath);
+        rlx_money::DatabaseConfig sqliteConfig;
+        sqliteConfig.path        = sqlitePath;
+        sqliteConfig.journalMode = "WAL";
+        sqliteConfig.synchronous = "NORMAL";
+        rlx_money::SqliteStorageBackend sqlite;
+        REQUIRE(sqlite.open(sqliteConfig));
+        auto sqliteMicros = append(sqlite);
+        sqlite.close();
+
+        rlx_money::LedgerStorageBackend ledger;
+        REQUIRE(ledger.open(config));
+        auto ledgerMicros = append(ledger);
+        ledger.close();
+
+        WARN(
+            "持续追加 " << kCommits << " 次提交（每次一条余额与一条交易记录）: SQLite（WAL, NORMAL）" << sqliteMicros
+                       << " us，账本 " << ledgerMicros << " us"
+        );
+        REQUIRE(ledgerMicros < sqliteMicros);
+    }
+}
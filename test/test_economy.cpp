@@ -1,16 +1,37 @@
 #include "mocks/MockLeviLaminaAPI.h"
 #include "mod/config/ConfigStructures.h"
 #include "common/ConfigManager.hpp"
+#include "mod/core/AdminJobRunner.h"
+#include "mod/core/AsyncExecutor.h"
 #include "mod/core/SystemInitializer.h"
+#include <RLXMoney/api/RLXMoneyAPI.h>
+#include <RLXMoney/api/TxBuilder.h>
 #include <RLXMoney/data/DataStructures.h>
+#include "mod/dao/PlayerDAO.h"
 #include "mod/database/DatabaseManager.h"
+#include "mod/economy/AccountLocks.h"
+#include "mod/economy/BalanceCache.h"
 #include "mod/economy/EconomyManager.h"
+#include "mod/economy/Leaderboard.h"
+#include "mod/economy/RedoJournal.h"
+#include "mod/exceptions/MoneyException.h"
+#include "mod/storage/LedgerStorageBackend.h"
 #include <RLXMoney/types/Types.h>
 #include "utils/TestTempManager.h"
 #include <catch2/catch_all.hpp>
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <cstdlib>
+#include <filesystem>
+#include <future>
+#include <map>
+#include <random>
+#include <thread>
 #include <fstream>
 #include <nlohmann/json.hpp>
 #include <string>
+#include <string_view>
 #include <vector>
 
 
@@ -20,6 +41,16 @@ std::string makeUniquePath(const std::string& prefix, const std::string& extensi
     return rlx_money::test::TestTempManager::getInstance().makeUniquePath(prefix, extension);
 }
 
+// 设置环境变量 RLX_TEST_STORAGE=memory 或 ledger 时，经济管理器测试改用对应的存储后端运行
+std::string testStorageBackend() {
+    const char* storage = std::getenv("RLX_TEST_STORAGE");
+    return storage != nullptr && *storage != '\0' ? storage : "sqlite";
+}
+
+bool usingMemoryStorage() { return testStorageBackend() == "memory"; }
+
+bool usingSqliteStorage() { return testStorageBackend() == "sqlite"; }
+
 // 为每个 TEST_CASE 创建独立配置与数据库，并完成初始化
 std::pair<std::string, std::string> setupIsolatedManager(
     const std::string& caseName,
@@ -43,8 +74,9 @@ std::pair<std::string, std::string> setupIsolatedManager(
     auto dbPath     = makeUniquePath("test_" + caseName, ".db");
 
     nlohmann::json testConfig;
-    testConfig["database"]["path"] = dbPath;
-    testConfig["defaultCurrency"]  = "gold";
+    testConfig["database"]["backend"] = testStorageBackend();
+    testConfig["database"]["path"]    = dbPath;
+    testConfig["defaultCurrency"]     = "gold";
 
     // 创建默认币种配置（新格式：直接是配置对象，不需要 currencyId）
     testConfig["currencies"]["gold"]["currencyId"]          = "gold";
@@ -66,6 +98,9 @@ std::pair<std::string, std::string> setupIsolatedManager(
     // 注册文件以便自动清理
     rlx_money::test::TestTempManager::getInstance().registerFile(configPath);
     rlx_money::test::TestTempManager::getInstance().registerFile(dbPath);
+    rlx_money::test::TestTempManager::getInstance().registerDirectory(
+        rlx_money::LedgerStorageBackend::directoryFor(dbPath).string()
+    );
 
     REQUIRE_NOTHROW(rlx::common::Config<rlx_money::MoneyConfigData>::init(configPath));
     REQUIRE_NOTHROW(rlx::common::Config<rlx_money::MoneyConfigData>::getInstance().reload());
@@ -82,10 +117,31 @@ void cleanupFiles(const std::vector<std::string>& paths) {
     }
 }
 
+// 一个线程不断读取余额，另一个线程反复加 1 后重置全部余额；返回重置之后仍读到旧余额的次数
+int countStaleReadsAfterReset(const std::string& xuid, const std::string& currencyId, int iterations) {
+    auto&             manager = rlx_money::EconomyManager::getInstance();
+    std::atomic<bool> stop{false};
+    std::thread       reader([&]() {
+        while (!stop.load()) {
+            (void)manager.getBalance(xuid, currencyId);
+        }
+    });
+
+    int stale = 0;
+    for (int i = 0; i < iterations; ++i) {
+        manager.addMoney(xuid, currencyId, 1);
+        manager.resetAll(currencyId, rlx_money::OperatorType::ADMIN);
+        stale += manager.getBalance(xuid, currencyId) != 1000 ? 1 : 0;
+    }
+    stop = true;
+    reader.join();
+    return stale;
+}
+
 // 确保数据库和 EconomyManager 已初始化（用于 SECTION 中）
 void ensureDatabaseInitialized() {
     auto& dbManager = rlx_money::DatabaseManager::getInstance();
-    if (!dbManager.isInitialized()) {
+    if (usingSqliteStorage() && !dbManager.isInitialized()) {
         const auto& config = rlx_money::MoneyConfig::getInstance().get();
         REQUIRE(dbManager.initialize(config.database.path));
     }
@@ -95,6 +151,15 @@ void ensureDatabaseInitialized() {
 
 // 清空数据库中的玩家与交易表，确保排行榜空数据场景
 void truncateAllTables() {
+    if (!usingSqliteStorage()) {
+        // 内存后端随经济管理器重新初始化而重新创建，即为空存储；账本后端先删除账本目录
+        auto& manager = rlx_money::EconomyManager::getInstance();
+        manager.resetForTesting();
+        const auto& config = rlx_money::MoneyConfig::getInstance().get();
+        std::filesystem::remove_all(rlx_money::LedgerStorageBackend::directoryFor(config.database.path));
+        REQUIRE(manager.initialize());
+        return;
+    }
     auto& dbm = rlx_money::DatabaseManager::getInstance();
     (void)dbm.executeTransaction([](SQLite::Database& db) {
         db.exec("DELETE FROM transactions;");
@@ -145,6 +210,17 @@ void cleanupSingletonState() {
     rlx_money::LeviLaminaAPI::clearMockPlayers();
 }
 
+// 立即开始、结束时自动销毁的协程，用于测试 co_await 异步句柄
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask        get_return_object() { return {}; }
+        std::suspend_never  initial_suspend() noexcept { return {}; }
+        std::suspend_never  final_suspend() noexcept { return {}; }
+        void                return_void() {}
+        void                unhandled_exception() { std::terminate(); }
+    };
+};
+
 // RAII 清理守卫：在测试用例结束时自动清理单例状态
 // 使用方法：在每个 TEST_CASE 开始时声明 `auto cleanupGuard = SingletonCleanupGuard{};`
 class SingletonCleanupGuard {
@@ -244,9 +320,11 @@ TEST_CASE("EconomyManager 初始化测试", "[economy][manager][init]") {
     // 注册文件以便自动清理
     tempManager.registerFile(testConfigPath);
     tempManager.registerFile(testDbPath);
+    tempManager.registerDirectory(rlx_money::LedgerStorageBackend::directoryFor(testDbPath).string());
 
     // 创建测试配置（新格式：直接是顶层配置）
     nlohmann::json testConfig;
+    testConfig["database"]["backend"]                     = testStorageBackend();
     testConfig["database"]["path"]                        = testDbPath;
     testConfig["database"]["optimization"]["walMode"]     = true;
     testConfig["database"]["optimization"]["cacheSize"]   = 2000;
@@ -316,9 +394,11 @@ TEST_CASE("EconomyManager 玩家管理测试", "[economy][manager][player]") {
     // 注册文件以便自动清理
     tempManager.registerFile(testConfigPath);
     tempManager.registerFile(testDbPath);
+    tempManager.registerDirectory(rlx_money::LedgerStorageBackend::directoryFor(testDbPath).string());
 
     // 创建测试配置（新格式：直接是顶层配置）
     nlohmann::json testConfig;
+    testConfig["database"]["backend"]                     = testStorageBackend();
     testConfig["database"]["path"]                        = testDbPath;
     testConfig["database"]["optimization"]["walMode"]     = true;
     testConfig["database"]["optimization"]["cacheSize"]   = 2000;
@@ -1107,6 +1187,154 @@ TEST_CASE("EconomyManager 排行榜功能测试", "[economy][manager][leaderboar
         REQUIRE(leaderboard[0].balance == 1000);
         REQUIRE(leaderboard[0].rank == 1);
     }
+
+    SECTION("玩家排名与分页") {
+        rlx_money::LeviLaminaAPI::clearMockPlayers();
+        truncateAllTables();
+
+        std::string      currencyId = manager.getDefaultCurrencyId();
+        std::vector<int> balances   = {5000, 3000, 8000, 1000, 6000};
+        for (size_t i = 0; i < balances.size(); ++i) {
+            std::string xuid = "rank" + std::to_string(i + 1);
+            manager.initializeNewPlayer(xuid, "rank_player" + std::to_string(i + 1));
+            manager.setBalance(xuid, currencyId, balances[i]);
+        }
+
+        REQUIRE(manager.getPlayerRank("rank3", currencyId) == 1);
+        REQUIRE(manager.getPlayerRank("rank1", currencyId) == 3);
+        REQUIRE(manager.getPlayerRank("rank4", currencyId) == 5);
+        REQUIRE_FALSE(manager.getPlayerRank("nobody", currencyId).has_value());
+
+        // 写操作之后排名随之更新
+        REQUIRE(manager.addMoney("rank4", currencyId, 7500));
+        REQUIRE(manager.transferMoney("rank3", "rank2", currencyId, 7000));
+        REQUIRE(manager.getPlayerRank("rank2", currencyId) == 1);
+        REQUIRE(manager.getPlayerRank("rank4", currencyId) == 2);
+        REQUIRE(manager.getPlayerRank("rank3", currencyId) == 5);
+
+        auto page = manager.getTopBalanceRange(currencyId, 2, 2);
+        REQUIRE(page.size() == 2);
+        REQUIRE(page[0].xuid == "rank5");
+        REQUIRE(page[0].rank == 3);
+        REQUIRE(page[0].username == "rank_player5");
+        REQUIRE(page[1].xuid == "rank1");
+        REQUIRE(page[1].rank == 4);
+        REQUIRE(manager.getTopBalanceRange(currencyId, 10, 5).empty());
+        REQUIRE_THROWS_AS(manager.getTopBalanceRange(currencyId, -1, 5), rlx_money::InvalidArgumentException);
+        REQUIRE_THROWS_AS(manager.getTopBalanceRange(currencyId, 0, 0), rlx_money::InvalidArgumentException);
+
+        auto neighbors = manager.getRankNeighbors("rank5", currencyId, 1);
+        REQUIRE(neighbors.size() == 3);
+        REQUIRE(neighbors[0].rank == 2);
+        REQUIRE(neighbors[1].xuid == "rank5");
+        REQUIRE(neighbors[2].rank == 4);
+        REQUIRE(manager.getRankNeighbors("rank2", currencyId, 2).size() == 3);
+        REQUIRE(manager.getRankNeighbors("nobody", currencyId, 2).empty());
+
+        // 余额相同的玩家按 XUID 排序
+        REQUIRE(manager.setBalance("rank1", currencyId, 8500));
+        REQUIRE(manager.getPlayerRank("rank1", currencyId) == 2);
+        REQUIRE(manager.getPlayerRank("rank4", currencyId) == 3);
+    }
+
+    SECTION("排行榜与数据库排序一致") {
+        rlx_money::LeviLaminaAPI::clearMockPlayers();
+        truncateAllTables();
+
+        std::string currencyId = manager.getDefaultCurrencyId();
+        for (int i = 0; i < 20; ++i) {
+            manager.initializeNewPlayer("sync" + std::to_string(i), "sync" + std::to_string(i));
+        }
+        REQUIRE(manager.getTopBalanceList(currencyId, 1).size() == 1);
+
+        // 单笔写入、批量操作与集合操作混合执行后，与数据库中的排序逐条比对
+        for (int i = 0; i < 20; ++i) {
+            REQUIRE(manager.setBalance("sync" + std::to_string(i), currencyId, (i * 7919) % 5000));
+        }
+        std::vector<rlx_money::MoneyOp> ops(2);
+        ops[0].type       = rlx_money::TransactionType::TRANSFER;
+        ops[0].xuid       = "sync3";
+        ops[0].toXuid     = "sync4";
+        ops[0].currencyId = currencyId;
+        ops[0].amount     = 100;
+        ops[1].type       = rlx_money::TransactionType::REDUCE;
+        ops[1].xuid       = "sync5";
+        ops[1].currencyId = currencyId;
+        ops[1].amount     = 1000000;
+        (void)manager.applyBatch(ops);
+        REQUIRE(manager.addToAll(currencyId, 10, rlx_money::OperatorType::ADMIN) == 20);
+        REQUIRE(manager.reduceMoney("sync7", currencyId, 5));
+
+        // 以直接查询数据库的结果为参照（其他后端没有数据库，只检查排名与顺序一致）
+        auto actual = manager.getTopBalanceList(currencyId, 100);
+        if (usingSqliteStorage()) {
+            rlx_money::PlayerDAO dao(rlx_money::DatabaseManager::getInstance());
+            auto                 expected = dao.getTopBalanceList(currencyId, 100);
+            REQUIRE(actual.size() == expected.size());
+            for (size_t i = 0; i < actual.size(); ++i) {
+                REQUIRE(actual[i].balance == expected[i].balance);
+            }
+        }
+        for (size_t i = 0; i < actual.size(); ++i) {
+            REQUIRE(manager.getBalance(actual[i].xuid, currencyId) == actual[i].balance);
+            REQUIRE(manager.getPlayerRank(actual[i].xuid, currencyId) == static_cast<int>(i) + 1);
+        }
+    }
+
+    SECTION("顺序统计树") {
+        rlx_money::Leaderboard leaderboard;
+        std::map<std::string, int> reference;
+        leaderboard.ensureBuilt("gold", []() { return std::vector<rlx_money::Leaderboard::Row>{}; });
+
+        // 随机插入、修改、删除后与排序后的参照结果比对
+        std::mt19937 random(42);
+        for (int i = 0; i < 2000; ++i) {
+            std::string xuid = "p" + std::to_string(random() % 300);
+            leaderboard.setUsername(xuid, xuid);
+            if (random() % 5 == 0) {
+                leaderboard.update("gold", xuid, std::nullopt, leaderboard.epoch());
+                reference.erase(xuid);
+            } else {
+                int balance = static_cast<int>(random() % 100);
+                leaderboard.update("gold", xuid, balance, leaderboard.epoch());
+                reference[xuid] = balance;
+            }
+        }
+
+        std::vector<std::pair<int, std::string>> sorted;
+        for (const auto& [xuid, balance] : reference) {
+            sorted.emplace_back(-balance, xuid);
+        }
+        std::sort(sorted.begin(), sorted.end());
+
+        REQUIRE(leaderboard.size("gold") == sorted.size());
+        auto all = leaderboard.range("gold", 0, sorted.size() + 10);
+        REQUIRE(all.size() == sorted.size());
+        for (size_t i = 0; i < sorted.size(); ++i) {
+            REQUIRE(all[i].xuid == sorted[i].second);
+            REQUIRE(all[i].balance == -sorted[i].first);
+            REQUIRE(leaderboard.rankOf("gold", sorted[i].second) == static_cast<int>(i) + 1);
+        }
+
+        // 纪元变化之前开始的写入使排行榜失效，下次查询时重新构建
+        uint64_t staleEpoch = leaderboard.epoch();
+        leaderboard.invalidateAll();
+        leaderboard.ensureBuilt("gold", []() {
+            return std::vector<rlx_money::Leaderboard::Row>{
+                {"a", "a", 10},
+                {"b", "b", 20}
+            };
+        });
+        leaderboard.update("gold", "a", 30, staleEpoch);
+        REQUIRE(leaderboard.rankOf("gold", "a") == 2);
+        leaderboard.ensureBuilt("gold", []() {
+            return std::vector<rlx_money::Leaderboard::Row>{
+                {"a", "a", 30},
+                {"b", "b", 20}
+            };
+        });
+        REQUIRE(leaderboard.rankOf("gold", "a") == 1);
+    }
     cleanupFiles({paths.first, paths.second});
 }
 
@@ -1173,6 +1401,1211 @@ TEST_CASE("EconomyManager 交易历史测试", "[economy][manager][history]") {
         auto emptyPage = manager.getPlayerTransactions("page123", currencyId, 4, 10);
         REQUIRE(emptyPage.empty());
     }
+
+    SECTION("游标分页") {
+        rlx_money::LeviLaminaAPI::clearMockPlayers();
+        rlx_money::LeviLaminaAPI::addMockPlayer("cursor123", "cursor_player");
+
+        manager.initializeNewPlayer("cursor123", "cursor_player");
+        std::string currencyId = manager.getDefaultCurrencyId();
+
+        // 同一秒内的多条记录按记录ID排序，翻页时不会重复或遗漏
+        for (int i = 0; i < 25; ++i) {
+            manager.addMoney("cursor123", currencyId, 10, "交易 " + std::to_string(i + 1));
+        }
+
+        rlx_money::TransactionFilter filter;
+        filter.currencyId = currencyId;
+
+        std::vector<int64_t> ids;
+        std::string          cursor;
+        do {
+            auto page = manager.getPlayerTransactionsPage("cursor123", filter, cursor, 10);
+            for (const auto& record : page.records) {
+                ids.push_back(record.id);
+            }
+            cursor = page.nextCursor;
+        } while (!cursor.empty());
+
+        REQUIRE(ids.size() == 26);
+        REQUIRE(std::is_sorted(ids.rbegin(), ids.rend()));
+
+        // 参数校验
+        REQUIRE_THROWS_AS(
+            manager.getPlayerTransactionsPage("cursor123", filter, "", 0),
+            rlx_money::InvalidArgumentException
+        );
+        REQUIRE_THROWS_AS(
+            manager.getPlayerTransactionsPage("cursor123", filter, "bad", 10),
+            rlx_money::InvalidArgumentException
+        );
+        rlx_money::TransactionFilter badCurrency;
+        badCurrency.currencyId = "no_such_currency";
+        REQUIRE_THROWS_AS(
+            manager.getPlayerTransactionsPage("cursor123", badCurrency, "", 10),
+            rlx_money::InvalidArgumentException
+        );
+        rlx_money::TransactionFilter badRange;
+        badRange.startTime = 2;
+        badRange.endTime   = 1;
+        REQUIRE_THROWS_AS(
+            manager.getPlayerTransactionsPage("cursor123", badRange, "", 10),
+            rlx_money::InvalidArgumentException
+        );
+    }
+    cleanupFiles({paths.first, paths.second});
+}
+
+// ============================================================================
+// EconomyManager 批量操作测试
+// ============================================================================
+
+TEST_CASE("EconomyManager 批量操作测试", "[economy][manager][batch]") {
+    auto  cleanupGuard = SingletonCleanupGuard{};
+    auto  paths        = setupIsolatedManager("economy_batch", 1000, 1000000, 1);
+    auto& manager      = rlx_money::EconomyManager::getInstance();
+
+    SECTION("批量发放与逐条结果") {
+        rlx_money::LeviLaminaAPI::clearMockPlayers();
+        std::string currencyId = manager.getDefaultCurrencyId();
+
+        // 批量发放给 600 名玩家
+        std::vector<rlx_money::MoneyOp> ops;
+        for (int i = 0; i < 600; ++i) {
+            std::string xuid = "batch" + std::to_string(i);
+            manager.initializeNewPlayer(xuid, "batch_player" + std::to_string(i));
+            ops.emplace_back(rlx_money::TransactionType::ADD, xuid, currencyId, 100, "工资");
+        }
+
+        auto results = manager.applyBatch(ops);
+        REQUIRE(results.size() == ops.size());
+        for (const auto& result : results) {
+            REQUIRE(result.success);
+            REQUIRE(result.balance.value() == 1100);
+        }
+        REQUIRE(manager.getBalance("batch599", currencyId).value() == 1100);
+        REQUIRE(manager.getPlayerTransactionCount("batch0") == 2); // 初始金额 + 工资
+    }
+
+    SECTION("混合操作与失败隔离") {
+        rlx_money::LeviLaminaAPI::clearMockPlayers();
+        manager.initializeNewPlayer("mixA", "mixA");
+        manager.initializeNewPlayer("mixB", "mixB");
+        std::string currencyId = manager.getDefaultCurrencyId();
+
+        std::vector<rlx_money::MoneyOp> ops = {
+            {rlx_money::TransactionType::SET, "mixA", currencyId, 500},
+            {rlx_money::TransactionType::REDUCE, "mixA", currencyId, 600},          // 余额不足
+            {rlx_money::TransactionType::TRANSFER, "mixA", currencyId, 200, "", "mixB"},
+            {rlx_money::TransactionType::ADD, "nobody", currencyId, 10},            // 玩家不存在
+            {rlx_money::TransactionType::ADD, "mixB", "no_such_currency", 10},      // 校验失败
+            {rlx_money::TransactionType::TRANSFER, "mixA", currencyId, 10, "", "mixA"}, // 校验失败
+            {rlx_money::TransactionType::INITIAL, "mixA", currencyId, 10},          // 不支持的类型
+            {rlx_money::TransactionType::REDUCE, "mixB", currencyId, 1200},
+        };
+
+        auto results = manager.applyBatch(ops);
+        REQUIRE(results.size() == ops.size());
+
+        REQUIRE(results[0].success);
+        REQUIRE(results[0].balance.value() == 500);
+        REQUIRE_FALSE(results[1].success);
+        REQUIRE(results[1].error == rlx_money::ErrorCode::INSUFFICIENT_BALANCE);
+        REQUIRE(results[2].success);
+        REQUIRE(results[2].balance.value() == 300);
+        REQUIRE_FALSE(results[3].success);
+        REQUIRE(results[3].error == rlx_money::ErrorCode::PLAYER_NOT_FOUND);
+        REQUIRE_FALSE(results[4].success);
+        REQUIRE(results[4].error == rlx_money::ErrorCode::INVALID_AMOUNT);
+        REQUIRE_FALSE(results[5].success);
+        REQUIRE_FALSE(results[6].success);
+        REQUIRE(results[7].success);
+        REQUIRE(results[7].balance.value() == 0);
+
+        REQUIRE(manager.getBalance("mixA", currencyId).value() == 300);
+        REQUIRE(manager.getBalance("mixB", currencyId).value() == 0);
+        REQUIRE_FALSE(manager.playerExists("nobody"));
+    }
+
+    SECTION("空批量") {
+        std::vector<rlx_money::MoneyOp> ops;
+        REQUIRE(manager.applyBatch(ops).empty());
+    }
+
+    SECTION("全体账户集合操作") {
+        rlx_money::LeviLaminaAPI::clearMockPlayers();
+        std::string currencyId = manager.getDefaultCurrencyId();
+        for (int i = 0; i < 5; ++i) {
+            manager.initializeNewPlayer("bulk" + std::to_string(i), "bulk_player" + std::to_string(i));
+        }
+        manager.setBalance("bulk0", currencyId, 0);
+        manager.setBalance("bulk1", currencyId, 999);
+        manager.setBalance("bulk2", currencyId, 999950);
+
+        // 同一秒内的记录按时间戳无法区分先后，按 id 取最新一条
+        auto latestRecord = [&](const std::string& xuid) {
+            auto records = manager.getPlayerTransactions(xuid, currencyId, 1, 100);
+            REQUIRE_FALSE(records.empty());
+            return *std::max_element(records.begin(), records.end(), [](const auto& a, const auto& b) {
+                return a.id < b.id;
+            });
+        };
+
+        // 空投：超过最大余额的部分被截断
+        REQUIRE(manager.addToAll(currencyId, 100, rlx_money::OperatorType::ADMIN, "admin") == 5);
+        REQUIRE(manager.getBalance("bulk0", currencyId).value() == 100);
+        REQUIRE(manager.getBalance("bulk1", currencyId).value() == 1099);
+        REQUIRE(manager.getBalance("bulk2", currencyId).value() == 1000000);
+        REQUIRE(manager.getBalance("bulk3", currencyId).value() == 1100);
+
+        auto record = latestRecord("bulk2");
+        REQUIRE(record.type == rlx_money::TransactionType::ADD);
+        REQUIRE(record.amount == 50);
+        REQUIRE(record.balance == 1000000);
+
+        // 按比例向下/向上取整
+        REQUIRE(
+            manager.scaleAll(currencyId, 0.5, rlx_money::RoundingMode::Floor, rlx_money::OperatorType::ADMIN) == 5
+        );
+        REQUIRE(manager.getBalance("bulk0", currencyId).value() == 50);
+        REQUIRE(manager.getBalance("bulk1", currencyId).value() == 549);
+        REQUIRE(manager.scaleAll(currencyId, 0.1, rlx_money::RoundingMode::Ceil, rlx_money::OperatorType::ADMIN) == 5);
+        REQUIRE(manager.getBalance("bulk0", currencyId).value() == 5);
+        REQUIRE(manager.getBalance("bulk1", currencyId).value() == 55);
+        record = latestRecord("bulk1");
+        REQUIRE(record.type == rlx_money::TransactionType::REDUCE);
+        REQUIRE(record.amount == -494);
+
+        // 比例为 1 时没有账户变化，也不写交易记录
+        int countBefore = manager.getPlayerTransactionCount("bulk1");
+        REQUIRE(manager.scaleAll(currencyId, 1.0, rlx_money::RoundingMode::Floor, rlx_money::OperatorType::ADMIN) == 0);
+        REQUIRE(manager.getPlayerTransactionCount("bulk1") == countBefore);
+
+        REQUIRE_THROWS(manager.scaleAll(currencyId, -1.0, rlx_money::RoundingMode::Floor, rlx_money::OperatorType::ADMIN));
+        REQUIRE_THROWS(manager.addToAll("no_such_currency", 1, rlx_money::OperatorType::ADMIN));
+
+        // 重置为初始余额
+        manager.setBalance("bulk4", currencyId, 1000);
+        REQUIRE(manager.resetAll(currencyId, rlx_money::OperatorType::ADMIN) == 4);
+        for (int i = 0; i < 5; ++i) {
+            REQUIRE(manager.getBalance("bulk" + std::to_string(i), currencyId).value() == 1000);
+        }
+        record = latestRecord("bulk0");
+        REQUIRE(record.type == rlx_money::TransactionType::SET);
+        REQUIRE(record.balance == 1000);
+    }
+
+    SECTION("降到最大余额") {
+        rlx_money::LeviLaminaAPI::clearMockPlayers();
+        std::string currencyId = manager.getDefaultCurrencyId();
+        manager.initializeNewPlayer("clamp0", "clamp0");
+        manager.initializeNewPlayer("clamp1", "clamp1");
+        manager.setBalance("clamp0", currencyId, 900000);
+
+        // 调低上限后，空投不会降低已超过上限的余额，clampAll 负责截断
+        rlx_money::MoneyConfig::getInstance().getWritable().currencies[currencyId].maxBalance = 5000;
+        REQUIRE(manager.addToAll(currencyId, 10, rlx_money::OperatorType::ADMIN) == 1);
+        REQUIRE(manager.getBalance("clamp0", currencyId).value() == 900000);
+        REQUIRE(manager.getBalance("clamp1", currencyId).value() == 1010);
+
+        REQUIRE(manager.clampAll(currencyId, rlx_money::OperatorType::ADMIN) == 1);
+        REQUIRE(manager.getBalance("clamp0", currencyId).value() == 5000);
+        REQUIRE(manager.getBalance("clamp1", currencyId).value() == 1010);
+    }
+    cleanupFiles({paths.first, paths.second});
+}
+
+// ============================================================================
+// EconomyManager 原子事务测试
+// ============================================================================
+
+TEST_CASE("EconomyManager 原子事务测试", "[economy][manager][atomic]") {
+    auto  cleanupGuard = SingletonCleanupGuard{};
+    auto  paths        = setupIsolatedManager("economy_atomic");
+    auto& manager      = rlx_money::EconomyManager::getInstance();
+
+    // 增加第二个币种，用于跨币种的条目
+    auto updateConfig = [&](const std::function<void(nlohmann::json&)>& update) {
+        nlohmann::json config;
+        {
+            std::ifstream input(paths.first);
+            input >> config;
+        }
+        update(config);
+        {
+            std::ofstream output(paths.first);
+            output << config.dump(4);
+        }
+        REQUIRE_NOTHROW(rlx::common::Config<rlx_money::MoneyConfigData>::getInstance().reload());
+        REQUIRE(manager.syncCurrenciesFromConfig());
+    };
+    updateConfig([](nlohmann::json& config) {
+        config["currencies"]["gem"]                   = config["currencies"]["gold"];
+        config["currencies"]["gem"]["name"]           = "宝石";
+        config["currencies"]["gem"]["initialBalance"] = 0;
+    });
+
+    rlx_money::LeviLaminaAPI::clearMockPlayers();
+    manager.initializeNewPlayer("buyer", "buyer");
+    manager.initializeNewPlayer("seller", "seller");
+    manager.initializeNewPlayer("tax", "tax");
+
+    auto balance = [&](const std::string& xuid, const std::string& currencyId) {
+        return manager.getBalance(xuid, currencyId).value_or(-1);
+    };
+    auto recordCount = [&]() {
+        return manager.getPlayerTransactionCount("buyer") + manager.getPlayerTransactionCount("seller")
+             + manager.getPlayerTransactionCount("tax");
+    };
+
+    SECTION("多条目全部提交") {
+        auto result = rlx_money::TxBuilder()
+                          .debit("buyer", "gold", 100, "购买物品")
+                          .credit("seller", "gold", 95, "出售物品")
+                          .credit("tax", "gold", 5, "交易税")
+                          .credit("buyer", "gem", 10, "购物积分")
+                          .transfer("seller", "tax", "gold", 20)
+                          .commit();
+        REQUIRE(result.success);
+        REQUIRE(result.failedLeg == -1);
+        REQUIRE(result.balances == std::vector<int>{900, 1095, 1005, 10, 1075});
+
+        REQUIRE(balance("buyer", "gold") == 900);
+        REQUIRE(balance("buyer", "gem") == 10);
+        REQUIRE(balance("seller", "gold") == 1075);
+        REQUIRE(balance("tax", "gold") == 1025);
+        REQUIRE(manager.getTotalWealth("gold") == 3000);
+    }
+
+    SECTION("任一条目失败时全部回滚") {
+        int countBefore = recordCount();
+
+        // 第三个条目余额不足：前两个条目已执行，随事务一起回滚
+        rlx_money::TxBuilder builder;
+        builder.credit("seller", "gold", 100).credit("buyer", "gem", 10).debit("buyer", "gold", 5000);
+        auto result = builder.commit();
+        REQUIRE_FALSE(result.success);
+        REQUIRE(result.failedLeg == 2);
+        REQUIRE(result.error == rlx_money::ErrorCode::INSUFFICIENT_BALANCE);
+        REQUIRE(result.balances.empty());
+
+        REQUIRE(balance("seller", "gold") == 1000);
+        REQUIRE(balance("buyer", "gem") == 0);
+        REQUIRE(recordCount() == countBefore);
+        REQUIRE(manager.getTopBalanceList("gold", 1).front().balance == 1000);
+
+        // 校验失败的条目在执行前报告，不访问数据库
+        builder.clear();
+        builder.credit("seller", "gold", 1).credit("buyer", "no_such_currency", 1);
+        result = builder.commit();
+        REQUIRE(result.failedLeg == 1);
+        REQUIRE(result.error == rlx_money::ErrorCode::INVALID_AMOUNT);
+
+        builder.clear();
+        builder.credit("seller", "gold", 1).credit("nobody", "gold", 1);
+        result = builder.commit();
+        REQUIRE(result.failedLeg == 1);
+        REQUIRE(result.error == rlx_money::ErrorCode::PLAYER_NOT_FOUND);
+        REQUIRE(balance("seller", "gold") == 1000);
+
+        REQUIRE_FALSE(rlx_money::TxBuilder().commit().success);
+        REQUIRE(recordCount() == countBefore);
+    }
+
+    // 其他后端的嵌套事务由 "存储后端语义一致性测试" 直接覆盖
+    SECTION("在事务中嵌套使用") {
+        if (!usingSqliteStorage()) {
+            return;
+        }
+        auto& dbManager = rlx_money::DatabaseManager::getInstance();
+
+        // 内层失败只回滚内层，外层其余写入正常提交
+        REQUIRE(dbManager.executeTransaction([&](SQLite::Database&) {
+            REQUIRE(rlx_money::TxBuilder().credit("seller", "gold", 10).commit().success);
+            auto failed = rlx_money::TxBuilder().credit("tax", "gold", 1).debit("buyer", "gold", 5000).commit();
+            REQUIRE_FALSE(failed.success);
+            return true;
+        }));
+        REQUIRE(balance("seller", "gold") == 1010);
+        REQUIRE(balance("tax", "gold") == 1000);
+
+        // 外层回滚时撤销已成功的内层事务，排行榜随之重新构建
+        REQUIRE(manager.getTopBalanceList("gold", 1).front().xuid == "seller");
+        REQUIRE_FALSE(dbManager.executeTransaction([&](SQLite::Database&) {
+            REQUIRE(rlx_money::TxBuilder().credit("tax", "gold", 500).commit().success);
+            return false;
+        }));
+        REQUIRE(balance("tax", "gold") == 1000);
+        REQUIRE(manager.getTopBalanceList("gold", 1).front().xuid == "seller");
+
+        // 直接嵌套 executeTransaction 不再重复 BEGIN
+        REQUIRE(dbManager.executeTransaction([&](SQLite::Database&) {
+            return dbManager.executeTransaction([&](SQLite::Database&) { return manager.addMoney("tax", "gold", 1); });
+        }));
+        REQUIRE(balance("tax", "gold") == 1001);
+    }
+
+    SECTION("写后模式币种不支持原子事务") {
+        if (usingMemoryStorage()) {
+            return; // 内存后端不启用写后模式
+        }
+        updateConfig([](nlohmann::json& config) { config["currencies"]["gem"]["writeBehind"] = true; });
+        auto result = rlx_money::TxBuilder().debit("buyer", "gold", 10).credit("buyer", "gem", 10).commit();
+        REQUIRE_FALSE(result.success);
+        REQUIRE(result.failedLeg == 1);
+        REQUIRE(balance("buyer", "gold") == 1000);
+    }
+    cleanupFiles({paths.first, paths.second});
+}
+
+// ============================================================================
+// RLXMoneyAPI 异步接口测试
+// ============================================================================
+
+TEST_CASE("RLXMoneyAPI 异步接口测试", "[economy][api][async]") {
+    auto  cleanupGuard = SingletonCleanupGuard{};
+    auto  paths        = setupIsolatedManager("economy_async");
+    auto& manager      = rlx_money::EconomyManager::getInstance();
+
+    SECTION("同一玩家按提交顺序执行") {
+        rlx_money::LeviLaminaAPI::clearMockPlayers();
+        manager.initializeNewPlayer("async1", "async1");
+        manager.initializeNewPlayer("async2", "async2");
+        std::string currencyId = manager.getDefaultCurrencyId();
+
+        std::vector<rlx_money::AsyncResult<bool>> writes;
+        for (int i = 0; i < 50; ++i) {
+            writes.push_back(rlx_money::RLXMoneyAPI::addMoneyAsync("async1", currencyId, 10));
+        }
+        writes.push_back(rlx_money::RLXMoneyAPI::transferMoneyAsync("async1", "async2", currencyId, 500));
+
+        // 不等待写入完成直接提交读取，读取仍能看到之前提交的写入
+        auto balance1 = rlx_money::RLXMoneyAPI::getBalanceAsync("async1", currencyId);
+        auto balance2 = rlx_money::RLXMoneyAPI::getBalanceAsync("async2", currencyId);
+        REQUIRE(balance1.get().value() == 1000);
+        REQUIRE(balance2.get().value() == 1500);
+        for (auto& write : writes) {
+            REQUIRE(write.get());
+        }
+
+        auto history = rlx_money::RLXMoneyAPI::getPlayerTransactionsAsync("async2", currencyId, 1, 100);
+        REQUIRE(history.get().size() == 2); // 初始金额 + 转入
+        auto top = rlx_money::RLXMoneyAPI::getTopBalanceListAsync(currencyId, 1);
+        REQUIRE(top.get().front().xuid == "async2");
+    }
+
+    SECTION("异常传递") {
+        rlx_money::LeviLaminaAPI::clearMockPlayers();
+        manager.initializeNewPlayer("async_poor", "async_poor");
+        std::string currencyId = manager.getDefaultCurrencyId();
+
+        auto result = rlx_money::RLXMoneyAPI::reduceMoneyAsync("async_poor", currencyId, 5000);
+        REQUIRE_THROWS_AS(result.get(), rlx_money::MoneyException);
+        REQUIRE(rlx_money::RLXMoneyAPI::getBalanceAsync("async_poor", currencyId).get().value() == 1000);
+    }
+
+    SECTION("取消尚未执行的操作") {
+        rlx_money::LeviLaminaAPI::clearMockPlayers();
+        manager.initializeNewPlayer("async_cancel", "async_cancel");
+        std::string currencyId = manager.getDefaultCurrencyId();
+
+        // 用一个阻塞任务占住该玩家所在的分片
+        std::promise<void> gate;
+        auto               gateFuture = gate.get_future().share();
+        rlx_money::AsyncExecutor::getInstance().submit({"async_cancel"}, [gateFuture]() { gateFuture.wait(); });
+
+        auto pending = rlx_money::RLXMoneyAPI::addMoneyAsync("async_cancel", currencyId, 100);
+        REQUIRE(pending.status() == rlx_money::AsyncStatus::Pending);
+        REQUIRE(pending.cancel());
+        REQUIRE(pending.isReady());
+        REQUIRE_THROWS_AS(pending.get(), rlx_money::AsyncCancelledError);
+
+        gate.set_value();
+        auto balance = rlx_money::RLXMoneyAPI::getBalanceAsync("async_cancel", currencyId);
+        REQUIRE(balance.get().value() == 1000);
+        REQUIRE_FALSE(balance.cancel()); // 已完成的操作无法取消
+    }
+
+    SECTION("co_await 在主线程恢复") {
+        rlx_money::LeviLaminaAPI::clearMockPlayers();
+        manager.initializeNewPlayer("async_coro", "async_coro");
+        std::string currencyId = manager.getDefaultCurrencyId();
+
+        std::optional<int> awaited;
+        std::thread::id    resumedOn;
+        bool               finished = false;
+
+        auto coroutine = [](std::string       currency,
+                            std::optional<int>& out,
+                            std::thread::id&    thread,
+                            bool&               done) -> DetachedTask {
+            co_await rlx_money::RLXMoneyAPI::addMoneyAsync("async_coro", currency, 1);
+            out    = co_await rlx_money::RLXMoneyAPI::getBalanceAsync("async_coro", currency);
+            thread = std::this_thread::get_id();
+            done   = true;
+        };
+        coroutine(currencyId, awaited, resumedOn, finished);
+
+        // 模拟游戏线程每 tick 调度
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!finished && std::chrono::steady_clock::now() < deadline) {
+            rlx_money::RLXMoneyAPI::runMainThreadTasks();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        REQUIRE(finished);
+        REQUIRE(awaited.value() == 1001);
+        REQUIRE(resumedOn == std::this_thread::get_id());
+    }
+    cleanupFiles({paths.first, paths.second});
+}
+
+// ============================================================================
+// 管理任务线程测试
+// ============================================================================
+
+TEST_CASE("管理任务线程测试", "[economy][core][admin]") {
+    auto& runner = rlx_money::AdminJobRunner::getInstance();
+
+    // 长任务一直运行到收到停止请求
+    std::promise<void> started;
+    std::atomic<bool>  observedStop{false};
+    REQUIRE(runner.start("长任务", [&](std::stop_token stopToken) {
+        started.set_value();
+        while (!stopToken.stop_requested()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        observedStop = true;
+    }));
+    started.get_future().wait();
+    REQUIRE(runner.getRunningJob() == "长任务");
+
+    // 同一时间只运行一个任务
+    REQUIRE_FALSE(runner.start("第二个任务", [](std::stop_token) {}));
+
+    // 长任务不占用异步执行器的工作线程
+    for (int i = 0; i < 8; ++i) {
+        std::promise<void> done;
+        auto               future = done.get_future();
+        rlx_money::AsyncExecutor::getInstance().submit({"admin_" + std::to_string(i)}, [&done]() { done.set_value(); });
+        REQUIRE(future.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+    }
+
+    // 停止时请求任务退出并等待
+    runner.shutdown();
+    REQUIRE(observedStop);
+    REQUIRE_FALSE(runner.getRunningJob().has_value());
+
+    // 停止后可以再次启动，任务异常不会让运行标记残留
+    std::promise<void> finished;
+    auto               finishedFuture = finished.get_future();
+    REQUIRE(runner.start("失败的任务", [&](std::stop_token) {
+        finished.set_value();
+        throw std::runtime_error("失败");
+    }));
+    REQUIRE(finishedFuture.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+    runner.shutdown();
+    REQUIRE_FALSE(runner.getRunningJob().has_value());
+    REQUIRE(runner.start("结束的任务", [](std::stop_token) {}));
+    runner.shutdown();
+}
+
+// ============================================================================
+// EconomyManager 多线程并发测试
+// ============================================================================
+
+TEST_CASE("EconomyManager 多线程并发测试", "[economy][manager][concurrency]") {
+    auto  cleanupGuard = SingletonCleanupGuard{};
+    auto  paths        = setupIsolatedManager("economy_concurrency");
+    auto& manager      = rlx_money::EconomyManager::getInstance();
+
+    SECTION("条带锁按全局顺序加锁") {
+        rlx_money::AccountLockTable table(8);
+        REQUIRE(table.getStripeCount() == 8);
+        REQUIRE(table.stripeOf("a", "gold") == table.stripeOf("a", "gold"));
+
+        // 同一条带只锁一次，重复账户不会自锁死
+        auto guard = table.lockMany({
+            {"a", "gold"},
+            {"a", "gold"},
+            {"b", "gold"}
+        });
+        REQUIRE(guard.size() <= 2);
+        guard.clear();
+
+        auto all = table.lockAll();
+        REQUIRE(all.size() == 8);
+    }
+
+    SECTION("相向转账与并发增减") {
+        rlx_money::LeviLaminaAPI::clearMockPlayers();
+        std::string currencyId = manager.getDefaultCurrencyId();
+        const int   accounts   = 6;
+        for (int i = 0; i < accounts; ++i) {
+            manager.initializeNewPlayer("conc" + std::to_string(i), "conc" + std::to_string(i));
+        }
+
+        const int                threadCount = 4;
+        const int                iterations  = 200;
+        std::atomic<int>         netAdded{0};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < threadCount; ++t) {
+            threads.emplace_back([&, t]() {
+                for (int i = 0; i < iterations; ++i) {
+                    std::string from = "conc" + std::to_string((t + i) % accounts);
+                    std::string to   = "conc" + std::to_string((t + i + 1 + t % 2) % accounts);
+                    try {
+                        // 奇偶线程方向相反，检验转账加锁顺序
+                        if (t % 2 == 0) {
+                            manager.transferMoney(from, to, currencyId, 3);
+                        } else {
+                            manager.transferMoney(to, from, currencyId, 3);
+                        }
+                        if (manager.addMoney(from, currencyId, 2)) {
+                            netAdded += 2;
+                        }
+                        if (manager.reduceMoney(to, currencyId, 1)) {
+                            netAdded -= 1;
+                        }
+                    } catch (const std::exception&) {
+                        // 余额不足等业务失败不影响总额校验
+                    }
+                    (void)manager.getBalance(from, currencyId);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        int64_t total = 0;
+        for (int i = 0; i < accounts; ++i) {
+            total += manager.getBalance("conc" + std::to_string(i), currencyId).value();
+        }
+        REQUIRE(total == 1000 * accounts + netAdded.load());
+    }
+
+    SECTION("并发初始化同一玩家") {
+        rlx_money::LeviLaminaAPI::clearMockPlayers();
+        std::atomic<int>         created{0};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&]() {
+                try {
+                    if (manager.initializeNewPlayer("conc_init", "conc_init")) {
+                        ++created;
+                    }
+                } catch (const std::exception&) {
+                    // 玩家已存在
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        REQUIRE(created == 1);
+        REQUIRE(manager.getPlayerTransactionCount("conc_init") == 1);
+    }
+    cleanupFiles({paths.first, paths.second});
+}
+
+// ============================================================================
+// EconomyManager 余额缓存测试
+// ============================================================================
+
+TEST_CASE("EconomyManager 余额缓存测试", "[economy][manager][cache]") {
+    auto  cleanupGuard = SingletonCleanupGuard{};
+    auto  paths        = setupIsolatedManager("economy_cache");
+    auto& manager      = rlx_money::EconomyManager::getInstance();
+
+    rlx_money::LeviLaminaAPI::clearMockPlayers();
+    std::string currencyId = manager.getDefaultCurrencyId();
+    manager.initializeNewPlayer("cache_a", "cache_a");
+    manager.initializeNewPlayer("cache_b", "cache_b");
+
+    // 直接读取数据库中的余额，用于和缓存比对
+    auto storedBalance = [&](const std::string& xuid) {
+        for (const auto& balance : manager.getAllBalances(xuid)) {
+            if (balance.currencyId == currencyId) {
+                return balance.balance;
+            }
+        }
+        return -1;
+    };
+
+    SECTION("上线载入后读取命中缓存") {
+        REQUIRE(manager.cachePlayerBalances("cache_a"));
+        auto stats = manager.getBalanceCacheStats();
+        REQUIRE(stats.players == 1);
+        REQUIRE(stats.entries == 1);
+        REQUIRE(stats.budgetBytes == 1024 * 1024);
+
+        for (int i = 0; i < 3; ++i) {
+            REQUIRE(manager.getBalance("cache_a", currencyId) == 1000);
+        }
+        REQUIRE(manager.hasSufficientBalance("cache_a", currencyId, 1000));
+
+        // 不在线的玩家直接查询数据库
+        REQUIRE(manager.getBalance("cache_b", currencyId) == 1000);
+
+        stats = manager.getBalanceCacheStats();
+        REQUIRE(stats.hits == 4);
+        REQUIRE(stats.misses == 1);
+    }
+
+    SECTION("写操作写穿透到缓存") {
+        REQUIRE(manager.cachePlayerBalances("cache_a"));
+        REQUIRE(manager.cachePlayerBalances("cache_b"));
+
+        REQUIRE(manager.addMoney("cache_a", currencyId, 50));
+        REQUIRE(manager.reduceMoney("cache_a", currencyId, 20));
+        REQUIRE_THROWS(manager.reduceMoney("cache_a", currencyId, 100000));
+        REQUIRE(manager.transferMoney("cache_a", "cache_b", currencyId, 30));
+        REQUIRE(manager.setBalance("cache_b", currencyId, 777, rlx_money::OperatorType::ADMIN));
+
+        std::vector<rlx_money::MoneyOp> ops(2);
+        ops[0].type       = rlx_money::TransactionType::TRANSFER;
+        ops[0].xuid       = "cache_b";
+        ops[0].toXuid     = "cache_a";
+        ops[0].currencyId = currencyId;
+        ops[0].amount     = 7;
+        ops[1].type       = rlx_money::TransactionType::REDUCE;
+        ops[1].xuid       = "cache_a";
+        ops[1].currencyId = currencyId;
+        ops[1].amount     = 5000;
+        auto results      = manager.applyBatch(ops);
+        REQUIRE(results[0].success);
+        REQUIRE_FALSE(results[1].success);
+
+        auto before = manager.getBalanceCacheStats();
+        REQUIRE(manager.getBalance("cache_a", currencyId) == storedBalance("cache_a"));
+        REQUIRE(manager.getBalance("cache_b", currencyId) == storedBalance("cache_b"));
+        REQUIRE(manager.getBalance("cache_a", currencyId) == 1007);
+        REQUIRE(manager.getBalance("cache_b", currencyId) == 770);
+
+        auto after = manager.getBalanceCacheStats();
+        REQUIRE(after.hits - before.hits == 4);
+        REQUIRE(after.misses == before.misses);
+    }
+
+    SECTION("集合操作使币种缓存失效") {
+        REQUIRE(manager.cachePlayerBalances("cache_a"));
+        REQUIRE(manager.getBalance("cache_a", currencyId) == 1000);
+
+        REQUIRE(manager.addToAll(currencyId, 10, rlx_money::OperatorType::ADMIN) == 2);
+        REQUIRE(manager.getBalanceCacheStats().entries == 0);
+
+        // 未命中后回填，之后再次命中
+        auto before = manager.getBalanceCacheStats();
+        REQUIRE(manager.getBalance("cache_a", currencyId) == 1010);
+        REQUIRE(manager.getBalance("cache_a", currencyId) == 1010);
+        auto after = manager.getBalanceCacheStats();
+        REQUIRE(after.misses - before.misses == 1);
+        REQUIRE(after.hits - before.hits == 1);
+        REQUIRE(after.entries == 1);
+    }
+
+    SECTION("下线后移出缓存") {
+        REQUIRE(manager.cachePlayerBalances("cache_a"));
+        manager.evictPlayerBalances("cache_a");
+        auto stats = manager.getBalanceCacheStats();
+        REQUIRE(stats.players == 0);
+        REQUIRE(stats.bytes == 0);
+
+        // 不在线时的写入不进入缓存
+        REQUIRE(manager.addMoney("cache_a", currencyId, 1));
+        REQUIRE(manager.getBalance("cache_a", currencyId) == 1001);
+        REQUIRE(manager.getBalanceCacheStats().misses == stats.misses + 1);
+    }
+
+    SECTION("内存预算与淘汰") {
+        rlx_money::BalanceCache cache;
+        std::map<std::string, std::optional<int>> balances{
+            {"gold", 1}
+        };
+        REQUIRE_FALSE(cache.loadPlayer("p0", balances, cache.epoch()));
+
+        cache.setBudget(1);
+        REQUIRE_FALSE(cache.loadPlayer("p0", balances, cache.epoch()));
+
+        // 预算只够容纳两个玩家，载入第三个时淘汰最早载入的玩家
+        cache.setBudget(4096);
+        REQUIRE(cache.loadPlayer("p0", balances, cache.epoch()));
+        size_t perPlayer = cache.getStats().bytes;
+        cache.setBudget(perPlayer * 2);
+        REQUIRE(cache.loadPlayer("p1", balances, cache.epoch()));
+        REQUIRE(cache.loadPlayer("p2", balances, cache.epoch()));
+
+        auto stats = cache.getStats();
+        REQUIRE(stats.players == 2);
+        REQUIRE(stats.evictions == 1);
+        REQUIRE(stats.bytes <= stats.budgetBytes);
+        REQUIRE_FALSE(cache.isResident("p0"));
+        REQUIRE(cache.lookup("p2", "gold").balance == 1);
+    }
+
+    SECTION("整体失效后丢弃过期写入") {
+        rlx_money::BalanceCache cache;
+        cache.setBudget(4096);
+        std::map<std::string, std::optional<int>> balances{
+            {"gold", 1}
+        };
+        REQUIRE(cache.loadPlayer("p0", balances, cache.epoch()));
+
+        uint64_t staleEpoch = cache.epoch();
+        cache.invalidateAll();
+        REQUIRE(cache.lookup("p0", "gold").status == rlx_money::BalanceCache::LookupStatus::Miss);
+
+        // 失效之前开始的写入只会删除条目
+        cache.store("p0", "gold", 99, staleEpoch);
+        REQUIRE(cache.lookup("p0", "gold").status == rlx_money::BalanceCache::LookupStatus::Miss);
+
+        cache.store("p0", "gold", 2, cache.epoch());
+        REQUIRE(cache.lookup("p0", "gold").balance == 2);
+        REQUIRE(cache.isResident("p0"));
+    }
+
+    SECTION("读取期间有写入时放弃回填") {
+        rlx_money::BalanceCache cache;
+        cache.setBudget(4096);
+        REQUIRE(cache.loadPlayer("p0", {}, cache.epoch()));
+
+        // 读取数据库之后发生的写入比读到的值新，回填被丢弃，写入的值保留
+        uint64_t staleVersion = cache.version();
+        cache.store("p0", "gold", 5, cache.epoch());
+        cache.fill("p0", "gold", 1, staleVersion);
+        REQUIRE(cache.lookup("p0", "gold").balance == 5);
+
+        // 失效之后用旧版本回填同样被丢弃
+        staleVersion = cache.version();
+        cache.invalidateCurrency("gold");
+        cache.fill("p0", "gold", 5, staleVersion);
+        REQUIRE(cache.lookup("p0", "gold").status == rlx_money::BalanceCache::LookupStatus::Miss);
+
+        // 版本未变化时回填，已存在的条目不会被回填覆盖
+        cache.fill("p0", "gold", 7, cache.version());
+        REQUIRE(cache.lookup("p0", "gold").balance == 7);
+        cache.fill("p0", "gold", 8, cache.version());
+        REQUIRE(cache.lookup("p0", "gold").balance == 7);
+
+        // 非常驻玩家不回填
+        cache.fill("p1", "gold", 1, cache.version());
+        REQUIRE_FALSE(cache.isResident("p1"));
+    }
+    cleanupFiles({paths.first, paths.second});
+}
+
+TEST_CASE("EconomyManager 写后模式测试", "[economy][manager][writebehind]") {
+    if (usingMemoryStorage()) {
+        WARN("内存存储后端不支持写后模式，跳过");
+        return;
+    }
+    auto  cleanupGuard = SingletonCleanupGuard{};
+    auto  paths        = setupIsolatedManager("economy_write_behind");
+    auto& manager      = rlx_money::EconomyManager::getInstance();
+
+    rlx_money::LeviLaminaAPI::clearMockPlayers();
+    std::string currencyId = manager.getDefaultCurrencyId();
+    manager.initializeNewPlayer("wb_a", "wb_a");
+    manager.initializeNewPlayer("wb_b", "wb_b");
+
+    // 修改配置文件中默认币种的写后开关并重新同步
+    auto setWriteBehind = [&](bool enabled) {
+        nlohmann::json config;
+        {
+            std::ifstream input(paths.first);
+            input >> config;
+        }
+        config["currencies"][currencyId]["writeBehind"] = enabled;
+        {
+            std::ofstream output(paths.first);
+            output << config.dump(4);
+        }
+        REQUIRE_NOTHROW(rlx::common::Config<rlx_money::MoneyConfigData>::getInstance().reload());
+        REQUIRE(manager.syncCurrenciesFromConfig());
+    };
+    setWriteBehind(true);
+    REQUIRE(manager.isWriteBehindCurrency(currencyId));
+
+    // 绕过内存直接读取存储中的余额；经济管理器已重置时账本后端临时打开账本读取
+    rlx_money::PlayerDAO dao(rlx_money::DatabaseManager::getInstance());
+    auto                 storedBalance = [&](const std::string& xuid) {
+        if (usingSqliteStorage()) {
+            return dao.getBalance(xuid, currencyId).value_or(-1);
+        }
+        if (manager.isStorageOpen()) {
+            return manager.getStorageForTesting().getBalance(xuid, currencyId).value_or(-1);
+        }
+        rlx_money::LedgerStorageBackend ledger;
+        ledger.open(rlx_money::MoneyConfig::getInstance().get().database);
+        return ledger.getBalance(xuid, currencyId).value_or(-1);
+    };
+    std::string journalBase   = manager.getStorageForTesting().getJournalBasePath();
+    auto        journalLength = [&]() {
+        return rlx_money::RedoJournal::readSegments(rlx_money::RedoJournal::listSegments(journalBase)).size();
+    };
+
+    SECTION("变更只写内存与日志，刷新后写入数据库") {
+        REQUIRE(manager.addMoney("wb_a", currencyId, 50));
+        REQUIRE(manager.transferMoney("wb_a", "wb_b", currencyId, 30));
+        REQUIRE(manager.getBalance("wb_a", currencyId) == 1020);
+        REQUIRE(manager.getBalance("wb_b", currencyId) == 1030);
+
+        REQUIRE(storedBalance("wb_a") == 1000);
+        REQUIRE(storedBalance("wb_b") == 1000);
+        REQUIRE(journalLength() == 3);
+
+        // 排行榜读取内存余额，刷新之前即包含最新变更
+        REQUIRE(manager.getTopBalanceList(currencyId, 1)[0].xuid == "wb_b");
+        REQUIRE(manager.getPlayerRank("wb_a", currencyId) == 2);
+
+        auto stats = manager.getWriteBehindStats();
+        REQUIRE(stats.dirtyEntries == 2);
+        REQUIRE(stats.pendingRecords == 3);
+
+        REQUIRE(manager.flushWriteBehind() == 2);
+        REQUIRE(storedBalance("wb_a") == 1020);
+        REQUIRE(storedBalance("wb_b") == 1030);
+        // 初始化记录 + 增加 + 转账
+        REQUIRE(manager.getPlayerTransactions("wb_a", currencyId, 1, 10).size() == 3);
+        REQUIRE(journalLength() == 0);
+
+        stats = manager.getWriteBehindStats();
+        REQUIRE(stats.dirtyEntries == 0);
+        REQUIRE(stats.pendingRecords == 0);
+        REQUIRE(stats.flushes == 1);
+
+        // 没有变更时刷新不写数据库，并把空闲的余额移出内存
+        REQUIRE(manager.flushWriteBehind() == 0);
+        REQUIRE(manager.getWriteBehindStats().entries == 0);
+        REQUIRE(manager.getBalance("wb_a", currencyId) == 1020);
+    }
+
+    SECTION("校验规则与同步模式一致") {
+        REQUIRE_THROWS(manager.reduceMoney("wb_a", currencyId, 1001));
+        REQUIRE_THROWS(manager.addMoney("wb_a", currencyId, 1000000));
+        REQUIRE_THROWS(manager.transferMoney("wb_a", "wb_b", currencyId, 5000));
+        REQUIRE_THROWS(manager.addMoney("wb_missing", currencyId, 1));
+        REQUIRE_FALSE(manager.getBalance("wb_missing", currencyId).has_value());
+        REQUIRE(manager.getBalance("wb_a", currencyId) == 1000);
+        REQUIRE(manager.getWriteBehindStats().pendingRecords == 0);
+
+        std::vector<rlx_money::MoneyOp> ops(2);
+        ops[0].type       = rlx_money::TransactionType::ADD;
+        ops[0].xuid       = "wb_a";
+        ops[0].currencyId = currencyId;
+        ops[0].amount     = 7;
+        ops[1].type       = rlx_money::TransactionType::REDUCE;
+        ops[1].xuid       = "wb_b";
+        ops[1].currencyId = currencyId;
+        ops[1].amount     = 5000;
+        auto results      = manager.applyBatch(ops);
+        REQUIRE(results[0].success);
+        REQUIRE(results[0].balance == 1007);
+        REQUIRE_FALSE(results[1].success);
+        REQUIRE(manager.getWriteBehindStats().pendingRecords == 1);
+    }
+
+    SECTION("崩溃后重放日志") {
+        REQUIRE(manager.addMoney("wb_a", currencyId, 50));
+        REQUIRE(manager.reduceMoney("wb_b", currencyId, 10));
+
+        // 不刷新直接丢弃内存状态，模拟进程崩溃
+        manager.resetForTesting();
+        REQUIRE(storedBalance("wb_a") == 1000);
+        REQUIRE(manager.initialize());
+
+        REQUIRE(storedBalance("wb_a") == 1050);
+        REQUIRE(storedBalance("wb_b") == 990);
+        REQUIRE(manager.getPlayerTransactions("wb_a", currencyId, 1, 10).size() == 2);
+        REQUIRE(journalLength() == 0);
+
+        // 序号不大于检查点的日志条目已写入数据库，再次出现时不会重复重放
+        manager.resetForTesting();
+        {
+            rlx_money::RedoJournal journal;
+            journal.open(journalBase);
+            rlx_money::JournalEntry entry;
+            entry.sequence           = 1;
+            entry.record.xuid        = "wb_a";
+            entry.record.currencyId  = currencyId;
+            entry.record.amount      = 50;
+            entry.record.balance     = 1050;
+            entry.record.type        = rlx_money::TransactionType::ADD;
+            entry.record.description = "duplicate";
+            entry.record.timestamp   = 1;
+            journal.append({entry});
+        }
+        REQUIRE(manager.initialize());
+        REQUIRE(manager.getPlayerTransactions("wb_a", currencyId, 1, 10).size() == 2);
+        REQUIRE(journalLength() == 0);
+    }
+
+    SECTION("集合操作与下线前先刷新") {
+        REQUIRE(manager.addMoney("wb_a", currencyId, 5));
+        REQUIRE(manager.addToAll(currencyId, 10, rlx_money::OperatorType::ADMIN) == 2);
+        REQUIRE(manager.getBalance("wb_a", currencyId) == 1015);
+        REQUIRE(manager.getBalance("wb_b", currencyId) == 1010);
+
+        REQUIRE(manager.addMoney("wb_b", currencyId, 1));
+        manager.evictPlayerBalances("wb_b");
+        REQUIRE(storedBalance("wb_b") == 1011);
+        REQUIRE(manager.getWriteBehindStats().dirtyEntries == 0);
+    }
+
+    SECTION("关闭写后模式时刷新并删除日志") {
+        REQUIRE(manager.setBalance("wb_a", currencyId, 321, rlx_money::OperatorType::ADMIN));
+        setWriteBehind(false);
+        REQUIRE_FALSE(manager.isWriteBehindCurrency(currencyId));
+        REQUIRE(storedBalance("wb_a") == 321);
+        REQUIRE(rlx_money::RedoJournal::listSegments(journalBase).empty());
+    }
+
+    manager.resetForTesting();
+    rlx_money::RedoJournal::removeSegments(rlx_money::RedoJournal::listSegments(journalBase));
+    cleanupFiles({paths.first, paths.second});
+}
+
+// ============================================================================
+// EconomyManager 卸载前提交测试
+// ============================================================================
+
+TEST_CASE("EconomyManager 卸载前提交测试", "[economy][manager][shutdown]") {
+    if (!usingSqliteStorage()) {
+        WARN("只有 SQLite 存储后端可以从独立连接观察未提交的组事务，跳过");
+        return;
+    }
+    auto  cleanupGuard = SingletonCleanupGuard{};
+    auto  paths        = setupIsolatedManager("economy_shutdown");
+    auto& manager      = rlx_money::EconomyManager::getInstance();
+    auto& dbManager    = rlx_money::DatabaseManager::getInstance();
+
+    // 开启组提交并增加一个写后模式币种，重新初始化使组提交生效
+    nlohmann::json config;
+    {
+        std::ifstream input(paths.first);
+        input >> config;
+    }
+    config["database"]["groupCommit"]          = true;
+    config["currencies"]["gem"]                = config["currencies"]["gold"];
+    config["currencies"]["gem"]["currencyId"]  = "gem";
+    config["currencies"]["gem"]["name"]        = "宝石";
+    config["currencies"]["gem"]["writeBehind"] = true;
+    {
+        std::ofstream output(paths.first);
+        output << config.dump(4);
+    }
+    manager.resetForTesting();
+    dbManager.close();
+    REQUIRE_NOTHROW(rlx::common::Config<rlx_money::MoneyConfigData>::getInstance().reload());
+    REQUIRE(manager.initialize());
+    REQUIRE(manager.isWriteBehindCurrency("gem"));
+    std::string journalBase = manager.getStorageForTesting().getJournalBasePath();
+
+    // 从独立的只读连接读取已提交的数据
+    auto committedInt = [&](const std::string& sql) {
+        SQLite::Database db(paths.second, SQLite::OPEN_READONLY);
+        return db.execAndGet(sql).getInt64();
+    };
+    auto committedBalance = [&](const std::string& currencyId) {
+        return committedInt(
+            "SELECT b.balance FROM player_balances b JOIN accounts a ON a.id = b.account_id "
+            "JOIN currency_keys c ON c.id = b.currency_key WHERE a.xuid = 'sd_a' AND c.code = '"
+            + currencyId + "'"
+        );
+    };
+
+    manager.initializeNewPlayer("sd_a", "sd_a");
+    REQUIRE(manager.addMoney("sd_a", "gold", 50));
+
+    SECTION("没有写后数据时也提交组事务") {
+        REQUIRE(committedInt("SELECT COUNT(*) FROM players") == 0);
+
+        // 与 RLXMoney::disable() 相同：停止 tick 任务后不会再有 tick 提交组事务
+        manager.flushForShutdown();
+        REQUIRE(committedInt("SELECT COUNT(*) FROM players") == 1);
+        REQUIRE(committedBalance("gold") == 1050);
+        REQUIRE(committedInt("SELECT COUNT(*) FROM transactions") == manager.getPlayerTransactionCount("sd_a"));
+    }
+
+    SECTION("写后刷新的写入与组内写入一起提交") {
+        REQUIRE(manager.addMoney("sd_a", "gem", 7));
+        REQUIRE(committedInt("SELECT COUNT(*) FROM players") == 0);
+
+        manager.flushForShutdown();
+        REQUIRE(committedBalance("gold") == 1050);
+        REQUIRE(committedBalance("gem") == 1007);
+        REQUIRE(committedInt("SELECT COUNT(*) FROM transactions") == manager.getPlayerTransactionCount("sd_a"));
+    }
+
+    manager.resetForTesting();
+    rlx_money::RedoJournal::removeSegments(rlx_money::RedoJournal::listSegments(journalBase));
+    cleanupFiles({paths.first, paths.second});
+}
+
+// ============================================================================
+// EconomyManager 异步写入测试
+// ============================================================================
+
+TEST_CASE("EconomyManager 异步写入测试", "[economy][manager][writebehind][async]") {
+    if (!usingSqliteStorage()) {
+        WARN("只有 SQLite 存储后端有独立的写线程，跳过");
+        return;
+    }
+    auto  cleanupGuard = SingletonCleanupGuard{};
+    auto  paths        = setupIsolatedManager("economy_async_writer");
+    auto& manager      = rlx_money::EconomyManager::getInstance();
+    auto& dbManager    = rlx_money::DatabaseManager::getInstance();
+
+    // 开启写线程并增加一个每 tick 刷新的写后模式币种，重新初始化使写线程生效
+    nlohmann::json config;
+    {
+        std::ifstream input(paths.first);
+        input >> config;
+    }
+    config["database"]["journalMode"]          = "WAL";
+    config["database"]["asyncWriter"]          = true;
+    config["writeBehindFlushMs"]               = 0;
+    config["currencies"]["gem"]                = config["currencies"]["gold"];
+    config["currencies"]["gem"]["currencyId"]  = "gem";
+    config["currencies"]["gem"]["name"]        = "宝石";
+    config["currencies"]["gem"]["writeBehind"] = true;
+    {
+        std::ofstream output(paths.first);
+        output << config.dump(4);
+    }
+    manager.resetForTesting();
+    dbManager.close();
+    REQUIRE_NOTHROW(rlx::common::Config<rlx_money::MoneyConfigData>::getInstance().reload());
+    REQUIRE(manager.initialize());
+    REQUIRE(dbManager.isAsyncWriterEnabled());
+    REQUIRE(manager.isWriteBehindCurrency("gem"));
+    std::string journalBase = manager.getStorageForTesting().getJournalBasePath();
+
+    // 从独立的只读连接读取已提交的余额
+    auto committedGem = [&]() {
+        SQLite::Database db(paths.second, SQLite::OPEN_READONLY);
+        return db
+            .execAndGet(
+                "SELECT b.balance FROM player_balances b JOIN accounts a ON a.id = b.account_id "
+                "JOIN currency_keys c ON c.id = b.currency_key WHERE a.xuid = 'aw_a' AND c.code = 'gem'"
+            )
+            .getInt64();
+    };
+
+    rlx_money::LeviLaminaAPI::clearMockPlayers();
+    manager.initializeNewPlayer("aw_a", "aw_a");
+    manager.flushWriteBehind();
+    REQUIRE(manager.addMoney("aw_a", "gem", 7));
+
+    // 让写线程阻塞在一个事务上，在其他线程上模拟 tick，返回前放开写线程以免测试卡住
+    std::promise<void> release;
+    auto               gate = dbManager.submitTransaction([opened = release.get_future().share()](SQLite::Database&) {
+        opened.wait();
+        return true;
+    });
+    auto returnsWhileWriterBlocked = [&](const std::function<void()>& tick) {
+        auto done     = std::async(std::launch::async, tick);
+        bool returned = done.wait_for(std::chrono::seconds(5)) == std::future_status::ready;
+        release.set_value();
+        REQUIRE(gate.get());
+        done.get();
+        return returned;
+    };
+    // 之后的 tick 确认已提交的刷新
+    auto tickUntilCommitted = [&]() {
+        for (int ticks = 0; committedGem() != 1007 && ticks < 1000; ++ticks) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            manager.flushWriteBehindIfDue();
+        }
+        manager.flushWriteBehindIfDue();
+    };
+
+    SECTION("tick 不等待写后刷新提交") {
+        REQUIRE(returnsWhileWriterBlocked([&] { manager.flushWriteBehindIfDue(); }));
+        // 刷新提交之前余额仍从内存读取
+        REQUIRE(manager.getBalance("aw_a", "gem") == 1007);
+
+        tickUntilCommitted();
+        REQUIRE(committedGem() == 1007);
+        REQUIRE(manager.getWriteBehindStats().dirtyEntries == 0);
+        REQUIRE(rlx_money::RedoJournal::readSegments(rlx_money::RedoJournal::listSegments(journalBase)).empty());
+    }
+
+    SECTION("玩家下线时不等待写线程") {
+        REQUIRE(returnsWhileWriterBlocked([&] { manager.evictPlayerBalances("aw_a"); }));
+        REQUIRE(manager.getBalance("aw_a", "gem") == 1007);
+
+        tickUntilCommitted();
+        REQUIRE(committedGem() == 1007);
+        // 未再修改的余额在下一次刷新开始时移出内存
+        manager.flushWriteBehind();
+        REQUIRE(manager.getWriteBehindStats().entries == 0);
+        REQUIRE(manager.getBalance("aw_a", "gem") == 1007);
+    }
+
+    manager.resetForTesting();
+    rlx_money::RedoJournal::removeSegments(rlx_money::RedoJournal::listSegments(journalBase));
+    cleanupFiles({paths.first, paths.second});
+}
+
+// ============================================================================
+// EconomyManager 集合操作并发读取测试
+// ============================================================================
+
+TEST_CASE("EconomyManager 集合操作并发读取测试", "[economy][manager][batch][concurrency]") {
+    auto  cleanupGuard = SingletonCleanupGuard{};
+    auto  paths        = setupIsolatedManager("economy_bulk_reads");
+    auto& manager      = rlx_money::EconomyManager::getInstance();
+
+    // WAL 模式下余额从只读连接读取，不经过写连接；增加一个写后模式币种后重新初始化
+    nlohmann::json config;
+    {
+        std::ifstream input(paths.first);
+        input >> config;
+    }
+    config["database"]["journalMode"]          = "WAL";
+    config["database"]["readPoolSize"]         = 2;
+    config["currencies"]["gem"]                = config["currencies"]["gold"];
+    config["currencies"]["gem"]["currencyId"]  = "gem";
+    config["currencies"]["gem"]["name"]        = "宝石";
+    config["currencies"]["gem"]["writeBehind"] = true;
+    {
+        std::ofstream output(paths.first);
+        output << config.dump(4);
+    }
+    manager.resetForTesting();
+    rlx_money::DatabaseManager::getInstance().close();
+    REQUIRE_NOTHROW(rlx::common::Config<rlx_money::MoneyConfigData>::getInstance().reload());
+    REQUIRE(manager.initialize());
+    std::string journalBase = manager.getStorageForTesting().getJournalBasePath();
+
+    rlx_money::LeviLaminaAPI::clearMockPlayers();
+    manager.initializeNewPlayer("bulk_read", "bulk_read");
+
+    SECTION("缓存不回填集合操作之前的余额") {
+        REQUIRE(manager.cachePlayerBalances("bulk_read"));
+        REQUIRE(countStaleReadsAfterReset("bulk_read", "gold", 1000) == 0);
+    }
+
+    SECTION("写后存储不载入集合操作之前的余额") {
+        if (usingMemoryStorage()) {
+            WARN("内存存储后端不支持写后模式，跳过");
+            return;
+        }
+        REQUIRE(manager.isWriteBehindCurrency("gem"));
+        REQUIRE(countStaleReadsAfterReset("bulk_read", "gem", 1000) == 0);
+
+        // 重置之后的变更刷新到数据库时不会带回重置前的余额
+        REQUIRE(manager.addMoney("bulk_read", "gem", 1));
+        manager.flushWriteBehind();
+        manager.resetForTesting();
+        REQUIRE(manager.initialize());
+        REQUIRE(manager.getBalance("bulk_read", "gem") == 1001);
+    }
+
+    manager.resetForTesting();
+    rlx_money::RedoJournal::removeSegments(rlx_money::RedoJournal::listSegments(journalBase));
     cleanupFiles({paths.first, paths.second});
 }
 
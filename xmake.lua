@@ -128,10 +128,24 @@ target("tests")
         "test/utils/CommandTestHelper.cpp",
         "test/utils/TestTempManager.cpp",
         "src/mod/database/DatabaseManager.cpp",
+        "src/mod/database/DatabaseRestore.cpp",
+        "src/mod/database/StatementCache.cpp",
         "src/mod/core/SystemInitializer.cpp",
+        "src/mod/core/AdminJobRunner.cpp",
+        "src/mod/core/AsyncExecutor.cpp",
         "src/mod/dao/PlayerDAO.cpp",
         "src/mod/dao/TransactionDAO.cpp",
         "src/mod/economy/EconomyManager.cpp",
+        "src/mod/economy/AccountLocks.cpp",
+        "src/mod/economy/BalanceCache.cpp",
+        "src/mod/economy/Leaderboard.cpp",
+        "src/mod/economy/RedoJournal.cpp",
+        "src/mod/economy/WriteBehindStore.cpp",
+        "src/mod/storage/StorageBackend.cpp",
+        "src/mod/storage/SqliteStorageBackend.cpp",
+        "src/mod/storage/MemoryStorageBackend.cpp",
+        "src/mod/storage/LedgerSegment.cpp",
+        "src/mod/storage/LedgerStorageBackend.cpp",
         "src/mod/api/RLXMoneyAPI.cpp"
     }
     for _, file in ipairs(test_source_files) do